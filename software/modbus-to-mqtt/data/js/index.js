@@ -637,6 +637,15 @@ function renderStats(sys = {}) {
         kv("Devices", sys.devices ?? "—"),
         kv("Datapoints", sys.datapoints ?? "—"),
         kv("Errors", sys.modbusErrorCount ?? "—"),
+        kv("Bus load", (sys.busLoadPct !== undefined)
+            ? `${fmtPct(sys.busLoadPct)} (planned ${fmtPct(sys.busLoadProjectedPct)})` : "—"),
+        kv("Line switches", sys.busLineSwitches ?? "—"),
+        kv("Late datapoints", (sys.lateDatapoints !== undefined)
+            ? (sys.lateDatapoints > 0 ? `${sys.lateDatapoints}: ${(sys.lateDatapointIds || []).join(", ")}` : "0") : "—"),
+        kv("Read cache", (sys.readCacheHits !== undefined)
+            ? `${sys.readCacheHits} hits / ${sys.readCacheMisses} misses` : "—"),
+        kv("Published", (sys.publishedValues !== undefined)
+            ? `${sys.publishedValues} sent / ${sys.suppressedValues} suppressed` : "—"),
     ].join("");
 
     // Storage card
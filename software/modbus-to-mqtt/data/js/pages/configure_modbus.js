@@ -13,7 +13,9 @@ let selection = { kind: "bus", deviceId: null, datapointId: null };
 * * */
 const SERIAL_FORMATS = new Set(["7N1","7N2","7O1","7O2","7E1","7E2","8N1","8N2","8E1","8E2","8O1","8O2"]);
 const REGISTER_SLICES = new Set(["full","low_byte","high_byte"]);
-const WRITE_FUNCTIONS = new Set([5, 6, 16]);
+const WRITE_FUNCTIONS = new Set([5, 6, 15, 16, 23]);
+// Writes that always touch exactly one coil or register.
+const SINGLE_WRITE_FUNCTIONS = new Set([5, 6]);
 function toSerialParts(fmt) {
     const def = { data_bits: 8, parity: "N", stop_bits: 1 };
     if (!fmt || typeof fmt !== "string" || fmt.length < 3) return def;
@@ -40,6 +42,16 @@ function schemaToUi(json) {
         name: "RS485 Bus",
         enabled: Boolean(json?.bus?.enabled),
         baud: Number(json?.bus?.baud) || 9600,
+        read_max_gap: Number(json?.bus?.readMaxGap) || 0,
+        fixed_rate_polling: json?.bus?.fixedRatePolling !== false,
+        tcp_server_enabled: Boolean(json?.bus?.tcpServerEnabled),
+        tcp_server_port: Number(json?.bus?.tcpServerPort) || 502,
+        tcp_server_max_age_ms: Number(json?.bus?.tcpServerMaxAgeMs) || 0,
+        rx_pin: Number.isInteger(json?.bus?.rxPin) ? json.bus.rxPin : -1,
+        tx_pin: Number.isInteger(json?.bus?.txPin) ? json.bus.txPin : -1,
+        de_pin: Number.isInteger(json?.bus?.dePin) ? json.bus.dePin : -1,
+        // Further RS485 buses are not editable here yet; kept as loaded.
+        additional_buses: Array.isArray(json?.additionalBuses) ? json.additionalBuses : [],
         parity: parts.parity,
         stop_bits: parts.stop_bits,
         data_bits: parts.data_bits,
@@ -51,9 +63,19 @@ function schemaToUi(json) {
         id: (typeof d.id === "string" && d.id.trim().length) ? d.id.trim() : `dev_${idx+1}`,
         name: (typeof d.name === "string" && d.name.trim().length) ? d.name.trim() : "device",
         slaveId: Number(d.slaveId) || 1,
+        bus: Number(d.bus) || 0,
+        // Per-device line overrides, write combining and the gateway unit id
+        // are not editable here yet; kept as loaded.
+        gateway_unit_id: Number(d.gatewayUnitId) || 0,
+        baud: Number(d.baud) || 0,
+        serial_format: (typeof d.serialFormat === "string") ? d.serialFormat : "",
+        write_combine_ms: Number(d.writeCombineMs) || 0,
+        host: (typeof d.host === "string") ? d.host.trim() : "",
+        port: Number(d.port) || 502,
         notes: (typeof d.notes === "string") ? d.notes : "",
         mqttEnabled: Boolean(d.mqttEnabled),
         homeassistantDiscoveryEnabled: Boolean(d.homeassistantDiscoveryEnabled),
+        snapshotEnabled: Boolean(d.snapshotEnabled),
         datapoints: Array.isArray(d.dataPoints) ? d.dataPoints.map((p) => {
             const rawAddress = p.address;
             const inferredFormat = (typeof rawAddress === "string" && /^0x/i.test(rawAddress.trim())) ? "hex" : "dec";
@@ -64,6 +86,13 @@ function schemaToUi(json) {
                 address: toModbusAddress(rawAddress),
                 addrFormat: inferredFormat,
                 slice: normalizeRegisterSlice(p.registerSlice),
+                word_order: (typeof p.wordOrder === "string") ? p.wordOrder.toUpperCase() : "ABCD",
+                priority: (p.priority === "fast") ? "fast" : "slow",
+                // Report-by-exception settings are not editable here yet; kept as loaded.
+                deadband: Number(p.deadband) || 0,
+                deadband_type: (p.deadbandType === "percent") ? "percent" : "absolute",
+                heartbeat_ms: Number(p.heartbeatMs) || 0,
+                on_change: p.onChange === true,
                 length: Number(p.numOfRegisters ?? 1) || 1,
                 type: String(p.dataType || "uint16"),
                 scale: Number(p.scale ?? 1) || 1,
@@ -85,23 +114,57 @@ function uiToSchema(uiModel) {
         bus: {
             enabled: Boolean(b.enabled),
             baud: Number(b.baud) || 9600,
-            serialFormat: toSerialFormat(b.data_bits, b.parity, b.stop_bits)
+            serialFormat: toSerialFormat(b.data_bits, b.parity, b.stop_bits),
+            ...(Number(b.read_max_gap) > 0 ? { readMaxGap: Number(b.read_max_gap) } : {}),
+            ...(b.fixed_rate_polling === false ? { fixedRatePolling: false } : {}),
+            ...(b.tcp_server_enabled ? { tcpServerEnabled: true } : {}),
+            ...(Number(b.tcp_server_port) > 0 && Number(b.tcp_server_port) !== 502 ? { tcpServerPort: Number(b.tcp_server_port) } : {}),
+            ...(Number(b.tcp_server_max_age_ms) > 0 ? { tcpServerMaxAgeMs: Number(b.tcp_server_max_age_ms) } : {}),
+            ...(Number(b.rx_pin) >= 0 ? { rxPin: Number(b.rx_pin) } : {}),
+            ...(Number(b.tx_pin) >= 0 ? { txPin: Number(b.tx_pin) } : {}),
+            ...(Number(b.de_pin) >= 0 ? { dePin: Number(b.de_pin) } : {})
         },
+        ...(Array.isArray(b.additional_buses) && b.additional_buses.length ? { additionalBuses: b.additional_buses } : {}),
         devices: (b.devices || []).map(d => {
             const deviceId = (typeof d.id === "string" && d.id.trim().length) ? d.id.trim() : "";
             const device = {
                 name: (typeof d.name === "string" && d.name.trim().length) ? d.name.trim() : "device",
                 slaveId: Number(d.slaveId) || 1
             };
+            if (Number(d.bus) > 0) {
+                device.bus = Number(d.bus);
+            }
+            if (Number(d.gateway_unit_id) > 0) {
+                device.gatewayUnitId = Number(d.gateway_unit_id);
+            }
+            if (Number(d.baud) > 0) {
+                device.baud = Number(d.baud);
+            }
+            if (SERIAL_FORMATS.has(d.serial_format)) {
+                device.serialFormat = d.serial_format;
+            }
+            if (Number(d.write_combine_ms) > 0) {
+                device.writeCombineMs = Number(d.write_combine_ms);
+            }
             if (deviceId.length) {
                 device.id = deviceId;
             }
+            const host = (typeof d.host === "string") ? d.host.trim() : "";
+            if (host.length) {
+                device.host = host;
+                if (Number(d.port) > 0 && Number(d.port) !== 502) {
+                    device.port = Number(d.port);
+                }
+            }
             if (d.mqttEnabled) {
                 device.mqttEnabled = true;
             }
             if (d.homeassistantDiscoveryEnabled) {
                 device.homeassistantDiscoveryEnabled = true;
             }
+            if (d.snapshotEnabled) {
+                device.snapshotEnabled = true;
+            }
             device.dataPoints = (d.datapoints || []).map(p => {
                 const topic = (typeof p.topic === "string") ? p.topic.trim() : "";
                 const slice = normalizeRegisterSlice(p.slice);
@@ -119,6 +182,24 @@ function uiToSchema(uiModel) {
                 if (slice !== "full") {
                     dp.registerSlice = slice;
                 }
+                if (p.word_order && p.word_order !== "ABCD") {
+                    dp.wordOrder = p.word_order;
+                }
+                if (p.priority === "fast") {
+                    dp.priority = "fast";
+                }
+                if (Number(p.deadband) > 0) {
+                    dp.deadband = Number(p.deadband);
+                    if (p.deadband_type === "percent") {
+                        dp.deadbandType = "percent";
+                    }
+                }
+                if (Number(p.heartbeat_ms) > 0) {
+                    dp.heartbeatMs = Number(p.heartbeat_ms);
+                }
+                if (p.on_change) {
+                    dp.onChange = true;
+                }
                 if (topic.length) {
                     dp.topic = topic;
                 }
@@ -130,7 +211,6 @@ function uiToSchema(uiModel) {
 }
 function validateSchemaConfig(cfg) {
     const errors = [];
-    const isWriteFunction = (fn) => fn === 5 || fn === 6 || fn === 16;
     // bus
     if (!cfg.bus || typeof cfg.bus !== "object") {
         errors.push("Missing bus");
@@ -163,6 +243,9 @@ function validateSchemaConfig(cfg) {
         if (d.homeassistantDiscoveryEnabled != null && typeof d.homeassistantDiscoveryEnabled !== "boolean") {
             errors.push(`Device ${d.name||i+1}: homeassistantDiscoveryEnabled must be boolean`);
         }
+        if (d.snapshotEnabled != null && typeof d.snapshotEnabled !== "boolean") {
+            errors.push(`Device ${d.name||i+1}: snapshotEnabled must be boolean`);
+        }
         for (const [j,p] of (d.dataPoints||[]).entries()) {
             if (!p.name) {
                 errors.push(`Datapoint #${j+1} on ${d.name}: name required`);
@@ -176,8 +259,9 @@ function validateSchemaConfig(cfg) {
             if (p.registerSlice && p.registerSlice !== "full" && Number(p.numOfRegisters) !== 1) {
                 errors.push(`Datapoint ${p.id}: registerSlice requires numOfRegisters = 1`);
             }
-            if (!Number.isInteger(p.function) || (p.function < 1) || (p.function > 6 && p.function !== 16)) {
-                errors.push(`Datapoint ${p.id}: function 1-6 or 16`);
+            if (!Number.isInteger(p.function) || (p.function < 1) ||
+                (p.function > 6 && p.function !== 15 && p.function !== 16 && p.function !== 23)) {
+                errors.push(`Datapoint ${p.id}: function 1-6, 15, 16 or 23`);
             }
             if (p.topic != null && typeof p.topic !== "string") {
                 errors.push(`Datapoint ${p.id}: topic must be a string`);
@@ -194,8 +278,8 @@ function validateSchemaConfig(cfg) {
             if (!Number.isInteger(p.numOfRegisters) || p.numOfRegisters < 1 || p.numOfRegisters > 125) {
                 errors.push(`Datapoint ${p.id}: numOfRegisters 1-125`);
             }
-            if (isWriteFunction(p.function) && p.numOfRegisters !== 1) {
-                errors.push(`Datapoint ${p.id}: write functions must use numOfRegisters = 1`);
+            if (SINGLE_WRITE_FUNCTIONS.has(p.function) && p.numOfRegisters !== 1) {
+                errors.push(`Datapoint ${p.id}: functions 5 and 6 must use numOfRegisters = 1`);
             }
             if (typeof p.unit === "string" && p.unit.length > 5) {
                 errors.push(`Datapoint ${p.id}: unit max length 5`);
@@ -461,6 +545,11 @@ function showDeviceEditor() {
         haToggle.checked = Boolean(device.homeassistantDiscoveryEnabled);
     }
 
+    const snapshotToggle = $("#dev-snapshot");
+    if (snapshotToggle) {
+        snapshotToggle.checked = Boolean(device.snapshotEnabled);
+    }
+
     renderDeviceDatapointTable(device);
 
     // No explicit Save button anymore; values are auto-saved via handlers below.
@@ -500,6 +589,11 @@ function showDeviceEditor() {
             device.homeassistantDiscoveryEnabled = Boolean(haToggle.checked);
         };
     }
+    if (snapshotToggle) {
+        snapshotToggle.onchange = () => {
+            device.snapshotEnabled = Boolean(snapshotToggle.checked);
+        };
+    }
 
     $("#btn-dev-delete").onclick = () => {
         if (!confirm("Delete this device and its datapoints?"))
@@ -582,6 +676,7 @@ function showDatapointEditor() {
         const unitEl = $("#dp-unit");
         const pollEl = $("#dp-poll");
         const lenEl = $("#dp-len");
+        const isSingleWrite = SINGLE_WRITE_FUNCTIONS.has(func);
         if (unitEl) {
             unitEl.disabled = isWrite;
             unitEl.classList.toggle("field-disabled", isWrite);
@@ -599,9 +694,9 @@ function showDatapointEditor() {
             }
         }
         if (lenEl) {
-            lenEl.disabled = isWrite;
-            lenEl.classList.toggle("field-disabled", isWrite);
-            if (isWrite) {
+            lenEl.disabled = isSingleWrite;
+            lenEl.classList.toggle("field-disabled", isSingleWrite);
+            if (isSingleWrite) {
                 lenEl.value = 1;
                 datapoint.length = 1;
             }
@@ -701,14 +796,14 @@ function showDatapointEditor() {
         if (Number.isInteger(slaveId) && slaveId > 0) {
             q.set("slave", String(slaveId));
         }
-        if ((func === 5 || func === 6 || func === 16) && writeVal.length) {
+        if (WRITE_FUNCTIONS.has(func) && writeVal.length) {
             q.set('value', writeVal);
         }
 
         const btn = $("#btn-dp-test-read");
         const resEl = $("#dp-test-result");
         btn.disabled = true;
-        resEl.textContent = (func === 5 || func === 6 || func === 16) ? "Writing…" : "Reading…";
+        resEl.textContent = WRITE_FUNCTIONS.has(func) ? "Writing…" : "Reading…";
         try {
             const r = await safeJson(`${API.POST_MODBUS_EXECUTE}?${q.toString()}`, { method: 'POST' });
             const raw = r?.result?.raw;
@@ -998,7 +1093,7 @@ $('#btn-add-device').onclick = () => {
     const b = getBus();
     const id = `dev_${Date.now()}`;
     b.devices = b.devices || [];
-    b.devices.push({ id, name: "device", slaveId: 1, notes: "", mqttEnabled: false, homeassistantDiscoveryEnabled: false, datapoints: [] });
+    b.devices.push({ id, name: "device", slaveId: 1, notes: "", mqttEnabled: false, homeassistantDiscoveryEnabled: false, snapshotEnabled: false, datapoints: [] });
     selection = {
         kind:"device", deviceId:id, datapointId:null
     };
@@ -8,10 +8,24 @@
 #define RS485_DERE_PIN 15
 #endif
 
-// Guard delay around RS485 direction changes (in microseconds)
-// Helps transceiver settle and ensures RX is enabled before responses arrive.
+// RS485 buses the firmware can drive at once, bus n on UART n+1. UART0 is
+// the console, so the ESP32's two free UARTs bound this.
+#ifndef MODBUS_MAX_BUSES
+#define MODBUS_MAX_BUSES 2
+#endif
+
+// Drive DE/RE from the UART's RTS line in RS485 half-duplex mode instead of
+// toggling it around each request frame. RTS must be wired to RS485_DERE_PIN.
+#ifndef RS485_HW_DIRECTION
+#define RS485_HW_DIRECTION 0
+#endif
+
+// Extra transceiver settle time around software direction changes (in
+// microseconds). The t3.5 inter-frame silence is derived from the baud rate
+// separately; raise this only for transceivers slow to switch. Unused with
+// RS485_HW_DIRECTION.
 #ifndef RS485_DIR_GUARD_US
-#define RS485_DIR_GUARD_US 1000
+#define RS485_DIR_GUARD_US 0
 #endif
 
 // Drop one or more leading 0x00 bytes seen immediately at the start of RX.
@@ -52,6 +66,38 @@
 
 #define MODBUS_SLAVE_ID 1
 
+#ifndef DEFAULT_MODBUS_TCP_PORT
+#define DEFAULT_MODBUS_TCP_PORT 502
+#endif
+
+// How long a slave may take to answer a request, matching the ModbusMaster
+// library this replaced. Configured slaves get a timeout learned from their
+// answers, bounded by this and MODBUS_MIN_RESPONSE_TIMEOUT_MS.
+#ifndef MODBUS_RESPONSE_TIMEOUT_MS
+#define MODBUS_RESPONSE_TIMEOUT_MS 2000
+#endif
+
+#ifndef MODBUS_MIN_RESPONSE_TIMEOUT_MS
+#define MODBUS_MIN_RESPONSE_TIMEOUT_MS 20
+#endif
+
+// Expected slave processing time between the end of a request and the start
+// of its response. Only used to budget bus time, not as a timeout.
+#ifndef MODBUS_EXPECTED_TURNAROUND_US
+#define MODBUS_EXPECTED_TURNAROUND_US 3000
+#endif
+
+// Longest a web request waits for the polling tasks to finish their pass
+// before a configuration change, and for an ad-hoc command to run, before
+// it gives up and answers busy.
+#ifndef MODBUS_PAUSE_WAIT_MS
+#define MODBUS_PAUSE_WAIT_MS 5000
+#endif
+
+#ifndef MODBUS_COMMAND_WAIT_MS
+#define MODBUS_COMMAND_WAIT_MS 8000
+#endif
+
 /****************************************************
  * PREFERENCE STORAGE
  ****************************************************/
@@ -62,6 +108,9 @@
  * MQTT
  ****************************************************/
 #define MQTT_RECONNECT_INTERVAL_MS 5000
+// Longest a reading waits for the MQTT client, e.g. while it reconnects;
+// a reading that gives up is retried on its next poll.
+#define MQTT_PUBLISH_WAIT_MS 50
 
 #ifndef MQTT_BUFFER_SIZE
 #define MQTT_BUFFER_SIZE 4096
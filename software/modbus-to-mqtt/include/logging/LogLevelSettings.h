@@ -0,0 +1,30 @@
+#ifndef LOGLEVELSETTINGS_H
+#define LOGLEVELSETTINGS_H
+#pragma once
+
+#include "Logger.h"
+
+// Per-module log levels, kept in NVS so they survive a reboot.
+class LogLevelSettings {
+public:
+    // Applies the stored levels to logger; modules never set stay at LOGLEVEL_DEBUG.
+    static void begin(Logger *logger);
+
+    static LogLevel get(LogModule module);
+
+    // Applies level at once and stores it for the next boot.
+    static void set(LogModule module, LogLevel level);
+
+    // "core", "modbus", "mqtt", "web"; also the NVS keys and JSON fields.
+    static const char *moduleName(LogModule module);
+
+    // "debug", "info", "warn", "error".
+    static const char *levelName(LogLevel level);
+
+    static bool parseLevel(const char *name, LogLevel &out);
+
+private:
+    static Logger *s_logger;
+};
+
+#endif // LOGLEVELSETTINGS_H
@@ -3,13 +3,19 @@
 
 #include <atomic>
 #include <Arduino.h>
-#include "ModbusMaster.h"
+#include "Config.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "modbus/ModbusBusTiming.h"
+#include "modbus/ModbusRtuMaster.h"
 #include "modbus/config_structs/Bus.h"
 #include "utils/TeeStream.h"
 
 class Logger;
 
-class ModbusBus {
+// One RS485 bus: bus n runs on UART n+1. Each bus is driven by its own
+// polling task; the static accessors cover every bus at once.
+class ModbusBus : private ModbusRtuPort {
 public:
     class Guard {
     public:
@@ -25,13 +31,27 @@ public:
         bool _owns;
     };
 
-    explicit ModbusBus(Logger *logger);
+    ModbusBus(Logger *logger, uint8_t index);
 
     bool begin(const Bus &busConfig);
 
+    // Switches the UART to another baud rate and frame format between
+    // transactions, for slaves that differ from the bus's settings. The
+    // caller holds the bus. False if it already runs with them.
+    bool setLine(uint32_t baud, const String &serialFormat);
+
     Guard acquire();
 
-    ModbusMaster &node();
+    // Runs one transaction on the wire; the caller holds the bus. The calling
+    // task sleeps until UART events or the next protocol deadline instead of
+    // spinning on the serial port. Read results land in outWords;
+    // turnaroundUs is ModbusRtuMaster::kNoResponse if the slave stayed silent.
+    uint8_t transact(const ModbusRtuRequest &request,
+                     uint32_t responseTimeoutUs,
+                     uint16_t *outWords,
+                     uint16_t outCapacity,
+                     uint16_t &outCount,
+                     uint32_t &turnaroundUs);
 
     Stream &stream();
 
@@ -47,8 +67,12 @@ public:
 
     String dumpRx() const;
 
+    uint8_t index() const;
+
+    // Summed over every bus.
     static uint32_t getErrorCount();
 
+    // True if any bus is active.
     static bool isEnabled();
 
     static void setEnabled(bool enabled);
@@ -57,28 +81,57 @@ public:
 
     void enableCapture(bool enable);
 
+    const ModbusLineTiming &lineTiming() const;
+
+    const ModbusGuardTimes &guardTimes() const;
+
 private:
     void initializeWiring(const Bus &busConfig);
 
-    void onPreTransmission();
+    static uint32_t serialMode(const String &serialFormat);
+
+    void applyLineTiming(uint32_t baud, const String &serialFormat);
+
+    // ModbusRtuPort
+    int available() override;
+
+    int read() override;
+
+    size_t readAvailable(uint8_t *dst, size_t capacity) override;
+
+    bool takeLineIdle() override;
+
+    void transmit(const uint8_t *frame, size_t length) override;
 
-    void onPostTransmission();
+    bool transmitDone() override;
 
-    static void preTransmitTrampoline();
+    // Blocks for whole ticks and spins only a sub-tick remainder.
+    void waitForLine(uint32_t waitUs);
 
-    static void postTransmitTrampoline();
+    void onLineIdle();
 
     void release();
 
     Logger *_logger;
-    ModbusMaster _node;
+    uint8_t _index;
+    HardwareSerial &_serial;
+    int8_t _dePin{-1};
+    // What the UART currently runs with.
+    uint32_t _baud{0};
+    uint32_t _mode{0};
+    ModbusRtuMaster _master;
+    std::atomic<TaskHandle_t> _waiter{nullptr};
+    // Set from the UART event task when RX went idle for t3.5.
+    std::atomic<bool> _lineIdle{false};
     TeeStream *_tee{nullptr};
     std::atomic<bool> _active{false};
     std::atomic<bool> _initialized{false};
     std::atomic<bool> _busy{false};
     std::atomic<uint32_t> _errorCount{0};
+    ModbusLineTiming _line{};
+    ModbusGuardTimes _guards{};
 
-    static ModbusBus *s_instance;
+    static ModbusBus *s_instances[MODBUS_MAX_BUSES];
 };
 
 #endif
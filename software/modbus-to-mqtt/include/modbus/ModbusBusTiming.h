@@ -0,0 +1,73 @@
+#ifndef MODBUS_BUS_TIMING_H
+#define MODBUS_BUS_TIMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "modbus/ModbusReadPlanner.h"
+#include "modbus/config_structs/ModbusFunctionType.h"
+
+// Character and silence timing of an RTU line at a given baud and format.
+struct ModbusLineTiming {
+    uint32_t charUs;        // one character: start + data + parity + stop bits
+    uint32_t interFrameUs;  // t3.5 silence; fixed at 1750 us above 19200 baud
+};
+
+// Delays the bus driver applies around each request frame.
+struct ModbusGuardTimes {
+    uint32_t interFrameUs;  // minimum silence since the previous frame
+    uint32_t preUs;         // after asserting DE, before the first byte
+    uint32_t postUs;        // after releasing DE
+};
+
+// Fixed per-transaction overheads around the two frames.
+struct ModbusTurnaround {
+    uint32_t guardUs;     // applied before and after every request frame
+    uint32_t responseUs;  // expected slave processing time before it answers
+};
+
+// Wire-time model for RTU transactions, used to budget a poll plan against
+// the bus capacity. Has no Arduino dependencies so it can be exercised from
+// native-test.
+class ModbusBusTiming {
+public:
+    // serialFormat is "8N1" style; unknown formats fall back to 8N1.
+    static ModbusLineTiming lineTiming(uint32_t baud, const char *serialFormat);
+
+    // With hardware direction control the UART switches DE/RE itself, so
+    // only the inter-frame silence remains.
+    static ModbusGuardTimes guardTimes(const ModbusLineTiming &line, bool hardwareDirection, uint32_t settleUs);
+
+    // Part of the inter-frame silence still owed after idleUs without traffic.
+    static uint32_t silenceToWaitUs(uint32_t interFrameUs, uint32_t idleUs);
+
+    // UART RX-timeout threshold, in characters, covering t3.5; at least one
+    // and at most kMaxIdleSymbols.
+    static uint8_t idleSymbols(const ModbusLineTiming &line);
+
+    // Largest RX-timeout the ESP32 UART accepts for 8-bit frames.
+    static constexpr uint8_t kMaxIdleSymbols = 92;
+
+    // RTU frame sizes in bytes including slave id and CRC. count is in bits
+    // for coil/discrete functions and in registers otherwise.
+    static uint16_t requestBytes(ModbusFunctionType function, uint16_t count);
+
+    static uint16_t responseBytes(ModbusFunctionType function, uint16_t count);
+
+    // Request, guards, slave turnaround, response and trailing t3.5.
+    static uint32_t transactionUs(const ModbusLineTiming &line,
+                                  const ModbusTurnaround &turnaround,
+                                  ModbusFunctionType function,
+                                  uint16_t count);
+
+    static uint64_t planUs(const ModbusLineTiming &line,
+                           const ModbusTurnaround &turnaround,
+                           const std::vector<ModbusReadBlock> &blocks);
+
+    // Bus occupancy in permille for busyUs spent within windowUs. Values above
+    // 1000 mean the work does not fit; saturates at UINT16_MAX.
+    static uint16_t permille(uint64_t busyUs, uint64_t windowUs);
+};
+
+#endif
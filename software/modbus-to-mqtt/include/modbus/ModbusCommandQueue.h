@@ -0,0 +1,89 @@
+#ifndef MODBUS_COMMAND_QUEUE_H
+#define MODBUS_COMMAND_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Service order on the bus. Scheduled polls rank below every lane here and
+// only run while the queue is empty.
+enum class ModbusCommandPriority : uint8_t {
+    Write = 0,   // operator writes (MQTT, HTTP)
+    Read,        // ad-hoc reads
+    Count
+};
+
+struct ModbusCommand;
+
+struct ModbusCommandResult {
+    uint8_t status;          // ModbusRtuStatus code
+    uint32_t latencyMs;      // from submit to completion
+    const uint16_t *words;   // read response, valid only during the callback
+    uint16_t count;
+    const char *rxDump;      // captured RX bytes, valid only during the callback
+};
+
+// Where a caller waiting on a command wants its outcome, whether the command
+// completed on the polling task or inline on the caller's.
+struct ModbusCommandReply {
+    uint16_t *outWords;      // nullptr if the caller wants no words back
+    uint16_t outCapacity;
+    uint16_t outCount;
+    uint8_t status;
+
+    // Copies result in, keeping at most outCapacity words.
+    void capture(const ModbusCommandResult &result);
+};
+
+// Runs on the bus's Modbus polling task once the command has completed.
+using ModbusCommandCallback = void (*)(void *context, const ModbusCommand &command,
+                                       const ModbusCommandResult &result);
+
+struct ModbusCommand {
+    // Words carried by one write: 32 registers, or 512 coils packed into words.
+    static constexpr uint16_t kMaxValues = 32;
+
+    uint8_t bus;             // RS485 bus the slave is wired to
+    uint8_t slaveId;
+    uint8_t function;        // Modbus function code
+    uint16_t address;        // FC23: read address
+    uint16_t count;          // items read, or written by FC05/06/15/16
+    uint16_t writeAddress;   // FC23 only
+    uint16_t writeCount;     // FC23 only: registers written
+    // FC05/FC06: values[0]. FC15: count coils packed from the low byte of
+    // values[0] up. FC16: count registers. FC23: writeCount registers.
+    uint16_t values[kMaxValues];
+    // An FC06/FC16 write may be held this long to combine with other writes
+    // to the slave; 0 sends it as soon as it reaches the front.
+    uint16_t combineMs;
+    uint32_t submittedAtMs;
+    ModbusCommandCallback onComplete;
+    void *context;
+};
+
+// Fixed-capacity FIFO per priority lane; pop() drains higher lanes first.
+// Not thread-safe: the owner serialises access. Has no Arduino dependencies
+// so it can be exercised from native-test.
+class ModbusCommandQueue {
+public:
+    static constexpr size_t kLaneCapacity = 8;
+
+    // False if the lane is full.
+    bool push(const ModbusCommand &command, ModbusCommandPriority priority);
+
+    bool pop(ModbusCommand &out);
+
+    size_t size() const;
+
+    bool empty() const;
+
+private:
+    struct Lane {
+        ModbusCommand items[kLaneCapacity];
+        size_t head{0};
+        size_t count{0};
+    };
+
+    Lane _lanes[static_cast<size_t>(ModbusCommandPriority::Count)];
+};
+
+#endif
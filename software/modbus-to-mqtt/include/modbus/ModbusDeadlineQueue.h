@@ -0,0 +1,73 @@
+#ifndef MODBUS_DEADLINE_QUEUE_H
+#define MODBUS_DEADLINE_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One scheduled read datapoint, addressed by its position in the device list.
+struct ModbusDeadline {
+    uint32_t dueAtMs;
+    uint8_t priority;   // lower value wins ties on dueAtMs
+    uint16_t device;
+    uint16_t datapoint;
+};
+
+// Min-heap of poll deadlines across all devices. Deadlines are compared as
+// signed distances, so ordering survives millis() wrapping as long as no two
+// pending deadlines are more than ~24.8 days apart.
+// Has no Arduino dependencies so it can be exercised from native-test.
+class ModbusDeadlineQueue {
+public:
+    static constexpr uint32_t kNoDeadline = UINT32_MAX;
+
+    // True if timestamp a lies before b on the wrapping millis() clock.
+    static bool isBefore(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) < 0;
+    }
+
+    void clear();
+
+    void reserve(size_t capacity);
+
+    size_t size() const;
+
+    bool empty() const;
+
+    void push(const ModbusDeadline &entry);
+
+    // Appends every entry due at nowMs to out, most urgent first.
+    // Returns the number of entries appended.
+    size_t popDue(uint32_t nowMs, std::vector<ModbusDeadline> &out);
+
+    // 0 if the earliest deadline has passed, kNoDeadline if the queue is empty.
+    uint32_t msUntilNext(uint32_t nowMs) const;
+
+    // Next deadline one interval after the ideal one, skipping any slots
+    // already missed so an overrun never causes a catch-up burst.
+    static uint32_t nextFixedRate(uint32_t idealDueMs, uint32_t intervalMs, uint32_t nowMs);
+
+    // Offset of slot `slot` when `slots` groups share one interval, spacing
+    // them evenly across it.
+    static uint32_t phaseOffset(uint32_t intervalMs, size_t slot, size_t slots);
+
+    // Stable-partitions a popped batch into runs of one device each, ordered by
+    // each device's most urgent entry. rankScratch is resized to deviceCount.
+    static void groupByDevice(std::vector<ModbusDeadline> &batch,
+                              size_t deviceCount,
+                              std::vector<uint16_t> &rankScratch);
+
+    // Reorders the device runs left by groupByDevice so devices sharing a
+    // serial line setting are adjacent, those on currentLine first and the
+    // other settings in order of their most urgent device. Runs keep their
+    // order within one setting. deviceLine maps a device to its setting.
+    static void groupByLine(std::vector<ModbusDeadline> &batch,
+                            const std::vector<uint8_t> &deviceLine,
+                            uint8_t currentLine,
+                            std::vector<uint16_t> &rankScratch);
+
+private:
+    std::vector<ModbusDeadline> _heap;
+};
+
+#endif
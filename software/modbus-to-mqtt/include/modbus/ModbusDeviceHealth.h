@@ -0,0 +1,58 @@
+#ifndef MODBUS_DEVICE_HEALTH_H
+#define MODBUS_DEVICE_HEALTH_H
+
+#include <cstdint>
+
+enum class ModbusHealthState : uint8_t {
+    Online,
+    // Stopped answering; polls are held back while single probes go out.
+    Suspect,
+    // Probes keep failing; reported unavailable over MQTT.
+    Offline,
+};
+
+// Tracks whether one slave is answering. A run of timeouts marks it suspect,
+// after which it gets one probe per back-off period, doubling up to a cap,
+// instead of a timeout per due datapoint. Any answer brings it back online.
+// Has no Arduino dependencies so it can be exercised from native-test.
+class ModbusDeviceHealth {
+public:
+    // Consecutive timeouts before an online slave is held back.
+    static constexpr uint8_t kSuspectAfterTimeouts = 2;
+    // Failed probes before a suspect slave is reported offline.
+    static constexpr uint8_t kOfflineAfterProbes = 3;
+    static constexpr uint32_t kFirstProbeDelayMs = 1000;
+    static constexpr uint32_t kMaxProbeDelayMs = 60000;
+
+    // Both return true if the state changed.
+    bool recordAnswer();
+
+    bool recordTimeout(uint32_t nowMs);
+
+    ModbusHealthState state() const;
+
+    bool isOnline() const;
+
+    // False only once the slave is reported offline.
+    bool isAvailable() const;
+
+    // Whether a held-back slave may be probed now; always true while online.
+    bool probeDue(uint32_t nowMs) const;
+
+    uint32_t nextProbeAtMs() const;
+
+    uint32_t probeDelayMs() const;
+
+    static const char *stateName(ModbusHealthState state);
+
+private:
+    void holdBack(uint32_t nowMs);
+
+    ModbusHealthState _state{ModbusHealthState::Online};
+    uint8_t _timeouts{0};
+    uint8_t _failedProbes{0};
+    uint32_t _probeDelayMs{0};
+    uint32_t _nextProbeAtMs{0};
+};
+
+#endif
@@ -8,7 +8,8 @@ inline bool isReadOnlyFunction(const ModbusFunctionType fn) {
 }
 
 inline bool isWriteFunction(const ModbusFunctionType fn) {
-    return fn == WRITE_COIL || fn == WRITE_HOLDING || fn == WRITE_MULTIPLE_HOLDING;
+    return fn == WRITE_COIL || fn == WRITE_HOLDING || fn == WRITE_MULTIPLE_COILS || fn == WRITE_MULTIPLE_HOLDING ||
+           fn == READ_WRITE_MULTIPLE;
 }
 
 #endif
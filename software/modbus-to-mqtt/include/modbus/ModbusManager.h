@@ -1,42 +1,131 @@
 #ifndef MODBUSMANAGER_H
 #define MODBUSMANAGER_H
 #include <Preferences.h>
+#include <atomic>
+#include <memory>
 #include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
+#include "Config.h"
 #include "Logger.h"
 #include "config_structs/ModbusDatapoint.h"
 #include "config_structs/ConfigurationRoot.h"
 #include "modbus/ModbusBus.h"
+#include "modbus/ModbusCommandQueue.h"
 #include "modbus/ModbusMqttBridge.h"
+#include "modbus/ModbusPollScheduler.h"
+#include "modbus/ModbusReadPlanner.h"
+#include "modbus/ModbusShadowImage.h"
+#include "modbus/ModbusTcpConnection.h"
+#include "modbus/ModbusTcpServer.h"
+#include "modbus/ModbusWriteCombiner.h"
 
 class MqttManager;
 
+// Share of RS485 wire time used, in permille (1000 = saturated).
+struct ModbusBusLoad {
+    // What the loaded poll plan needs; above 1000 it cannot keep its intervals.
+    uint16_t projectedPermille;
+    // What was actually spent over the last measurement window, including
+    // UART reconfigurations.
+    uint16_t measuredPermille;
+    // UART reconfigurations for slaves with their own line settings, since boot.
+    uint32_t lineSwitches;
+};
+
+// Reads answered from the shadow image, and those it could not answer.
+struct ModbusReadCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+};
+
+// Datapoint readings sent to MQTT, and those held back by their deadband.
+struct ModbusPublishStats {
+    uint32_t published;
+    uint32_t suppressed;
+};
+
+// Outcome of ModbusManager::reconfigureFromFile().
+enum class ModbusReloadResult : uint8_t {
+    Applied,
+    // The file did not load; every bus is left inactive.
+    Invalid,
+    // The polling tasks did not pause in time; the running configuration
+    // stays in place.
+    Busy,
+};
+
 class ModbusManager {
 public:
     explicit ModbusManager(Logger *logger);
 
+    // Loads the configuration and starts one polling task per configured
+    // bus; a task keeps running, idle, while its bus is inactive.
     bool begin();
 
     bool loadConfiguration();
 
-    void loop();
+    // Wakes the polling tasks ahead of their next deadline, e.g. after a bus
+    // was re-enabled or reconfigured.
+    void wake() const;
+
+    // Milliseconds until the next datapoint falls due on any bus (0 if one
+    // is due now).
+    uint32_t msUntilNextPoll() const;
 
     /**
-     Execute an adhoc Modbus command against a slave.
+     Execute an adhoc Modbus command against a slave on the given bus.
      For read functions (1..4), fills outBuf with up to outBufCap words and sets outCount.
-     For write functions (5,6,16), writeValue is used if hasWriteValue=true; outCount will be 0 on success.
-     Returns ModbusMaster status code (0 on success).
+     Write functions take writeCount words from writeValues: one for 5 and 6, len registers for 16,
+     len coils packed from the low byte of the first word up for 15. Function 23 writes writeCount
+     registers at writeAddr, then reads len registers at addr into outBuf; other writes leave outCount 0.
+     At most ModbusCommand::kMaxValues words are written per command.
+     The command is queued ahead of scheduled polls and this call blocks until the bus's polling task ran it,
+     at most MODBUS_COMMAND_WAIT_MS; after that it returns Busy and the command may still run later.
+     With maxAgeMs > 0 a read is first looked up in the shadow image and answered from there, without
+     queueing, if all of it was read from the bus within maxAgeMs.
+     Returns a ModbusRtuStatus code (0 on success, 0xE4 if the queue is full).
     */
-    uint8_t executeCommand(uint8_t slaveId,
+    uint8_t executeCommand(uint8_t bus,
+                           uint8_t slaveId,
                            int function,
                            uint16_t addr,
                            uint16_t len,
-                           uint16_t writeValue,
-                           bool hasWriteValue,
+                           const uint16_t *writeValues,
+                           uint16_t writeCount,
+                           uint16_t writeAddr,
                            uint16_t *outBuf,
                            uint16_t outBufCap,
                            uint16_t &outCount,
-                           String &rxDump);
+                           String &rxDump,
+                           uint32_t maxAgeMs = 0);
+
+    /**
+     Queue a command for the polling task of command.bus without waiting. It
+     runs at the next transaction boundary, writes before ad-hoc reads before
+     scheduled polls, and command.onComplete is then called on that polling
+     task with the status and latency. Returns false, without calling back,
+     if its lane is full or the bus does not exist.
+    */
+    bool submitCommand(const ModbusCommand &command, ModbusCommandPriority priority);
+
+    /**
+     Answer a read (functions 1..4) from the shadow image of what the bus
+     returned, without a transaction. Succeeds only if every register or bit
+     asked for was read within maxAgeMs; outWords is laid out as from a bus
+     read. Safe to call from any task; counted in getReadCacheStats().
+    */
+    bool readShadow(uint8_t bus,
+                    uint8_t slaveId,
+                    uint8_t function,
+                    uint16_t address,
+                    uint16_t count,
+                    uint32_t maxAgeMs,
+                    uint16_t *outWords,
+                    uint16_t outCapacity,
+                    uint16_t &outCount) const;
 
     uint8_t findSlaveIdByDatapointId(const String &dpId) const;
 
@@ -48,36 +137,259 @@ public:
 
     static String registersToAscii(const uint16_t *buf, uint16_t count);
 
+    // Parses an FC15 write payload: a list of 0/1/true/false, one per coil,
+    // or a single value covering `coils` coils (true/false sets all, an
+    // integer is a bitmask from the first coil up). Packs from the low byte
+    // of words[0] up; returns the coil count, 0 if invalid or too long.
+    static uint16_t coilsFromPayload(const String &payload, uint16_t coils, uint16_t *words, uint16_t capacity);
+
+    // Parses an FC16/FC23 write payload: a list of values, each divided by
+    // scale and laid out as dataType in the given word order so it reads
+    // back as written. TEXT is ASCII, two characters per register,
+    // NUL-padded to textRegisters. Returns the registers filled, 0 if
+    // invalid or too long.
+    static uint16_t registersFromPayload(const String &payload,
+                                         ModbusDataType dataType,
+                                         ModbusWordOrder order,
+                                         float scale,
+                                         uint16_t textRegisters,
+                                         uint16_t *words,
+                                         uint16_t capacity);
+
     // Reload config file at runtime and reinitialize wiring.
-    // Returns true if the new config is loaded and the bus stays active.
-    bool reconfigureFromFile();
+    ModbusReloadResult reconfigureFromFile();
+
+    // Re-resolves the MQTT topics after the root topic may have changed.
+    // Returns false, leaving the old topics, if polling did not pause in time.
+    bool refreshMqttTopics();
 
     static uint16_t sliceRegister(uint16_t word, RegisterSlice slice);
 
     const ConfigurationRoot &getConfiguration() const;
 
+    // The busiest bus.
+    ModbusBusLoad getBusLoad() const;
+
+    ModbusReadCacheStats getReadCacheStats() const;
+
+    ModbusPublishStats getPublishStats() const;
+
     static uint32_t getBusErrorCount();
 
-    static void setModbusEnabled(bool enabled);
+    // Switches every RS485 bus and Modbus TCP polling together.
+    void setModbusEnabled(bool enabled);
 
-    static bool getBusState();
+    bool getBusState() const;
 
 private:
-    bool readModbusDevice(ModbusDevice &dev, const std::vector<ModbusDatapoint *> &dueDatapoints, uint32_t nowMs);
+    // Room for the largest read response the protocol allows.
+    static constexpr uint16_t kBlockBufferWords = ModbusRtuMaster::kMaxWords;
+    // Room for any datapoint's formatted payload: a TEXT spanning a whole
+    // block, or a number.
+    static constexpr size_t kPayloadChars = kBlockBufferWords * 2U + 1U;
+
+    // Baud rate and frame format one or more slaves on a bus talk at.
+    struct SerialLine {
+        uint32_t baud;
+        String serialFormat;
+    };
+
+    // Everything one RS485 bus needs to be polled by its own task.
+    struct BusLane {
+        BusLane(ModbusManager *owner, Logger *logger, uint8_t index);
+
+        ModbusManager *owner;
+        ModbusBus bus;
+        TaskHandle_t pollTaskHandle{nullptr};
+        // Held by the polling task for a whole pass and by
+        // reconfigureFromFile() while it swaps the configuration underneath.
+        SemaphoreHandle_t pollMutex{nullptr};
+        SemaphoreHandle_t commandMutex{nullptr};
+        ModbusCommandQueue commands;
+        // Register writes held back to merge; guarded by commandMutex.
+        ModbusWriteCombiner combiner;
+        ModbusWriteCombiner::Finished combined[ModbusWriteCombiner::kMaxHeld];
+        ModbusPollScheduler scheduler;
+        std::vector<ModbusDeadline> dueBatch;
+        std::vector<ModbusDatapoint *> dueScratch;
+        std::vector<ModbusReadRequest> readRequests;
+        std::vector<ModbusReadBlock> readBlocks;
+        std::vector<size_t> readMembers;
+        uint16_t blockBuffer[kBlockBufferWords]{};
+        uint16_t commandWords[kBlockBufferWords]{};
+        char payload[kPayloadChars]{};
+        // Every successful read on this bus lands here; guarded by
+        // ModbusManager::_shadowMutex.
+        ModbusShadowImage shadow;
+        // Distinct line settings of the bus's slaves; 0 is the bus's own.
+        std::vector<SerialLine> lines;
+        // Index into lines for every device, in device-list order.
+        std::vector<uint8_t> deviceLine;
+        std::vector<uint16_t> lineRank;
+        // The entry of lines the UART runs with.
+        uint8_t currentLine{0};
+        std::atomic<uint32_t> lineSwitches{0};
+        // The last pass that polled anything got an answer.
+        std::atomic<bool> answering{false};
+
+        uint16_t projectedLoadPermille{0};
+        std::atomic<uint16_t> measuredLoadPermille{0};
+        std::atomic<uint32_t> busBusyUs{0};
+        uint32_t busLoadWindowStartMs{0};
+    };
+
+    bool startPollTask(BusLane &lane);
+
+    // Holds every polling task (RS485 and TCP) between passes, so the
+    // configuration and topic table can change underneath them. Returns
+    // false, holding none of them, if they are not all held within wait.
+    bool pausePolling(TickType_t wait);
+
+    void resumePolling();
+
+    [[noreturn]] static void pollTaskRunner(void *param);
+
+    // One polling pass over one bus: runs every due datapoint, then returns.
+    void pollOnce(BusLane &lane);
+
+    // How long the polling task may block before the next pass.
+    uint32_t pollWaitMs(const BusLane &lane) const;
+
+    // A bus with a lane whose index the configuration names.
+    BusLane *laneFor(uint8_t bus) const;
+
+    // The Modbus LED is lit while any bus that polls gets answers.
+    void updateIndicator() const;
+
+    // A queued command, or a combined write whose window has closed.
+    bool hasPendingCommands(const BusLane &lane) const;
+    uint32_t msUntilCombinedWrite(const BusLane &lane) const;
+
+    // Runs every queued command; the caller holds the bus. True if any ran.
+    bool serviceCommands(BusLane &lane);
+
+    // Builds lane.lines and lane.deviceLine from the bus and its devices.
+    void assignLines(BusLane &lane, const Bus &busConfig);
+
+    uint8_t lineOf(const BusLane &lane, const ModbusDevice &dev) const;
+
+    // Reconfigures the UART for a slave's line setting; the caller holds the
+    // bus. Called from transact(), so the time it takes lands in the
+    // caller's recordBusTime() window.
+    void selectLine(BusLane &lane, uint8_t line);
+
+    // Performs one command on the wire; read results land in commandWords.
+    uint8_t runCommand(BusLane &lane, const ModbusCommand &command, uint16_t &outCount);
+
+    bool readModbusDevice(BusLane &lane, ModbusDevice &dev, const std::vector<ModbusDatapoint *> &dueDatapoints,
+                          uint32_t nowMs);
+
+    // For a device that stopped answering: sends one single-register read
+    // once its back-off has elapsed. True if the device is back online.
+    bool probeDevice(BusLane &lane, ModbusDevice &dev, const ModbusDatapoint &dp, uint32_t nowMs);
+
+    uint8_t readBlock(BusLane &lane, uint8_t slaveId, const ModbusReadBlock &block);
+
+    // One request with the slave's learned timeout, retried once on a CRC
+    // error; feeds the outcome back into the slave's estimator and health.
+    uint8_t transact(BusLane &lane, const ModbusRtuRequest &request, uint16_t *outWords, uint16_t outCapacity,
+                     uint16_t &outCount);
+
+    ModbusDevice *findDeviceBySlaveId(uint8_t bus, uint8_t slaveId);
+
+    void noteHealth(ModbusDevice &dev, uint8_t status);
+
+    // Formats into payload, a kPayloadChars scratch buffer owned by the
+    // calling task, so the poll path does not touch the heap.
+    void publishFromBlock(ModbusDevice &dev, ModbusDatapoint &dp, const ModbusReadBlock &block,
+                          const uint16_t *blockWords, char *payload);
+
+    // Publishes what the device's cycle gathered when it is in snapshot mode.
+    void flushSnapshot(ModbusDevice &dev);
+
+    bool startTcpTask();
+
+    [[noreturn]] static void tcpTaskRunner(void *param);
+
+    // One pass over the Modbus TCP devices: collects answers and timeouts,
+    // then sends every due read that fits its connection's window.
+    void tcpPollOnce();
+
+    uint32_t tcpPollWaitMs() const;
+
+    // Groups the datapoints of every TCP device onto one connection per
+    // distinct host and port.
+    void assignTcpConnections();
+
+    void serviceTcpConnection(uint8_t connection, uint32_t nowMs);
+
+    // Sends the blocks planned for dev's due datapoints. Datapoints whose
+    // block did not fit the window are left due.
+    void sendTcpReads(uint16_t devIndex, const std::vector<ModbusDatapoint *> &dueDatapoints, uint32_t nowMs);
+
+    bool tcpProbeInFlight(uint16_t devIndex) const;
 
     static const char *functionToString(ModbusFunctionType fn);
 
-    void incrementBusErrorCount();
+    void incrementBusErrorCount(ModbusBus &bus);
+
+    // maxGap is the bus's readMaxGap; Modbus TCP has no line to save and
+    // reads with no gap.
+    static ModbusReadPlanner::Limits readLimits(uint16_t maxGap);
+
+    // Wire time per second the configured poll plan of one bus needs, as
+    // permille.
+    uint16_t projectBusLoad(BusLane &lane);
+
+    static void recordBusTime(BusLane &lane, uint32_t startedAtUs);
+
+    static void rollBusLoadWindow(BusLane &lane, uint32_t nowMs);
 
 
     std::vector<ModbusDatapoint> _modbusRegisters;
-    ModbusBus _bus;
+    std::unique_ptr<BusLane> _lanes[MODBUS_MAX_BUSES];
     ModbusMqttBridge _mqttBridge;
+    ModbusTcpServer _tcpServer;
     Logger *_logger;
     Preferences preferences;
     ConfigurationRoot _modbusRoot{};
     MqttManager *_mqtt{nullptr};
     bool _mqttConnectedLastLoop{false};
-    std::vector<ModbusDatapoint *> _dueScratch;
+
+    SemaphoreHandle_t _shadowMutex{nullptr};
+    mutable std::atomic<uint32_t> _shadowHits{0};
+    mutable std::atomic<uint32_t> _shadowMisses{0};
+    std::atomic<uint32_t> _publishedValues{0};
+    std::atomic<uint32_t> _suppressedValues{0};
+
+    // A read on the wire to a Modbus TCP device, indexed by connection and
+    // pipeline slot.
+    struct TcpInFlight {
+        bool used{false};
+        uint16_t device{0};
+        ModbusReadBlock block{};
+        uint32_t sentAtUs{0};
+        std::vector<ModbusDatapoint *> members;
+    };
+
+    std::vector<ModbusTcpConnection> _tcpConnections;
+    std::vector<TcpInFlight> _tcpInFlight;
+    TaskHandle_t _tcpTaskHandle{nullptr};
+    // TCP devices poll whether or not any RS485 bus is active; cleared with
+    // the global Modbus switch and while no configuration is loaded.
+    std::atomic<bool> _tcpActive{false};
+    // Held by the TCP polling task for a whole pass and by
+    // reconfigureFromFile() while it swaps the configuration underneath.
+    SemaphoreHandle_t _tcpMutex{nullptr};
+    ModbusPollScheduler _tcpScheduler;
+    std::vector<ModbusDeadline> _tcpDueBatch;
+    std::vector<ModbusDatapoint *> _tcpDueScratch;
+    std::vector<ModbusReadRequest> _tcpReadRequests;
+    std::vector<ModbusReadBlock> _tcpReadBlocks;
+    std::vector<size_t> _tcpReadMembers;
+    uint16_t _tcpWords[kBlockBufferWords]{};
+    char _tcpPayload[kPayloadChars]{};
+
+    static constexpr uint32_t kBusLoadWindowMs = 10000;
 };
 #endif
@@ -4,6 +4,8 @@
 #include <Arduino.h>
 #include <vector>
 
+#include "modbus/ModbusCommandQueue.h"
+#include "modbus/ModbusTopicTable.h"
 #include "modbus/config_structs/ConfigurationRoot.h"
 #include "modbus/config_structs/ModbusDatapoint.h"
 #include "modbus/config_structs/ModbusDevice.h"
@@ -12,6 +14,19 @@ class Logger;
 class MqttManager;
 class ModbusManager;
 
+// What a write topic addresses, captured when its subscription is made.
+struct ModbusWriteTarget {
+    uint8_t bus;
+    uint8_t slaveId;
+    ModbusFunctionType function;
+    uint16_t address;
+    uint8_t numRegs;
+    float scale;
+    ModbusDataType dataType;
+    ModbusWordOrder wordOrder;
+    uint16_t combineMs;
+};
+
 class ModbusMqttBridge {
 public:
     ModbusMqttBridge(Logger *logger, ModbusManager *modbus);
@@ -22,32 +37,49 @@ public:
 
     void onConnectionState(bool connectedNow, bool connectedLast, ConfigurationRoot &root);
 
-    void publishDatapoint(ModbusDevice &device, const ModbusDatapoint &dp, const String &payload) const;
+    // True once the payload has been handed to the broker.
+    bool publishDatapoint(ModbusDevice &device, const ModbusDatapoint &dp, const char *payload) const;
+
+    // Re-resolves every topic if the MQTT root topic has changed since.
+    void onRootTopicChanged(ConfigurationRoot &root);
+
+    // Adds a reading to the device's snapshot as a member keyed by the
+    // datapoint's topic segment; payload is its formatted value.
+    void addToSnapshot(ModbusDevice &device, const ModbusDatapoint &dp, double value, const char *payload) const;
+
+    // Publishes the gathered snapshot, stamped with the cycle's uptime and,
+    // once the clock is set, the time. True once handed to the broker.
+    bool publishSnapshot(ModbusDevice &device) const;
+
+    // Publishes the device's new availability after a health transition.
+    void onAvailabilityChanged(ModbusDevice &device) const;
 
 private:
+    // MQTT is up for the device and its availability and discovery are out.
+    bool readyToPublish(ModbusDevice &device) const;
+
+    // Sizes the device's snapshot buffers for a full cycle, so gathering and
+    // publishing one does not allocate.
+    void reserveSnapshot(ModbusDevice &device) const;
+
     void handleMqttConnected(ConfigurationRoot &root);
 
     static void handleMqttDisconnected(ConfigurationRoot &root);
 
     void rebuildWriteSubscriptions(const ConfigurationRoot &root);
 
-    void handleWriteCommand(const String &topic,
-                            uint8_t slaveId,
-                            ModbusFunctionType fn,
-                            uint16_t addr,
-                            uint8_t numRegs,
-                            float scale,
-                            const String &payload) const;
+    void handleWriteCommand(const String &topic, const ModbusWriteTarget &target, const String &payload) const;
 
-    String buildDatapointTopic(const ModbusDevice &device, const ModbusDatapoint &dp) const;
-    String buildAvailabilityTopic(const ModbusDevice &device) const;
+    static void onWriteComplete(void *context, const ModbusCommand &command, const ModbusCommandResult &result);
 
-    void publishAvailabilityOnline(ModbusDevice &device) const;
+    void publishAvailability(ModbusDevice &device) const;
     void publishHomeAssistantDiscovery(ModbusDevice &device) const;
 
     Logger *_logger;
     ModbusManager *_modbus;
     MqttManager *_mqtt{nullptr};
+    // Only rebuilt while ModbusManager has every polling task paused.
+    ModbusTopicTable _topics;
     std::vector<String> _writeTopics;
 };
 
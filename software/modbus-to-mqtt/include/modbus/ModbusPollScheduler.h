@@ -3,22 +3,72 @@
 
 #include <vector>
 
+#include "modbus/ModbusDeadlineQueue.h"
 #include "modbus/config_structs/ModbusDevice.h"
 #include "modbus/config_structs/ModbusDatapoint.h"
 
+// Keeps every read datapoint of every device in one deadline-ordered index,
+// so a poll pass costs O(log n) per due datapoint instead of a full scan.
 class ModbusPollScheduler {
 public:
     static bool isDue(const ModbusDatapoint &dp, uint32_t nowMs);
 
     static void scheduleNext(ModbusDatapoint &dp, uint32_t nowMs);
 
-    static std::vector<ModbusDatapoint *> dueReadDatapoints(ModbusDevice &device, uint32_t nowMs);
+    // Re-arms one interval after the missed ideal deadline instead of after
+    // nowMs, so the period does not drift by the loop's latency.
+    static void scheduleNextFixedRate(ModbusDatapoint &dp, uint32_t nowMs);
 
-    static bool hasDueReadDatapoints(const ModbusDevice &device, uint32_t nowMs);
+    // Records how late a poll ran against its deadline, then schedules the
+    // next one in the mode chosen at rebuild().
+    void recordPoll(ModbusDatapoint &dp, uint32_t nowMs) const;
 
-    static size_t collectDueReadDatapoints(ModbusDevice &device,
-                                           uint32_t nowMs,
-                                           std::vector<ModbusDatapoint *> &out);
+    // Moves the deadline to atMs without counting a poll, e.g. while the
+    // device is held back until its next probe.
+    static void deferUntil(ModbusDatapoint &dp, uint32_t atMs);
+
+    // Re-indexes the read datapoints of every device on transport (and, for
+    // RTU, on the given RS485 bus). Datapoints
+    // of one device sharing an interval keep one phase so they still coalesce
+    // into block reads; with fixedRate those groups are spread evenly across
+    // their interval, otherwise everything falls due at nowMs.
+    void rebuild(std::vector<ModbusDevice> &devices, uint32_t nowMs, bool fixedRate, ModbusTransport transport,
+                 uint8_t bus = 0);
+
+    // Replaces out with every due entry, grouped per device with the most
+    // urgent device first. Entries must be handed back through requeue().
+    size_t takeDue(uint32_t nowMs, std::vector<ModbusDeadline> &out);
+
+    // Re-inserts an entry from takeDue() at dp.nextDueAtMs.
+    void requeue(const ModbusDeadline &entry, const ModbusDatapoint &dp);
+
+    // How long the caller may sleep before the next datapoint falls due.
+    uint32_t msUntilNextDue(uint32_t nowMs) const;
+
+    size_t size() const;
+
+    // Lateness always tolerated on top of 10 % of the interval; covers loop
+    // jitter and the transactions queued ahead in the same pass.
+    static constexpr uint32_t kLateSlackMs = 100;
+
+private:
+    struct PhaseGroup {
+        uint32_t intervalMs;
+        uint16_t device;
+        uint32_t offsetMs;
+    };
+
+    static bool polls(const ModbusDevice &dev, ModbusTransport transport, uint8_t bus);
+
+    void assignPhases(const std::vector<ModbusDevice> &devices, ModbusTransport transport, uint8_t bus);
+
+    uint32_t phaseOf(uint16_t device, uint32_t intervalMs) const;
+
+    ModbusDeadlineQueue _queue;
+    std::vector<uint16_t> _deviceRank;
+    std::vector<PhaseGroup> _phases;
+    size_t _deviceCount{0};
+    bool _fixedRate{false};
 };
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef MODBUS_PUBLISH_FILTER_H
+#define MODBUS_PUBLISH_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class ModbusDeadbandType : uint8_t {
+    Absolute = 0,
+    // deadband is a percentage of the last published value.
+    Percent
+};
+
+// Report by exception for one datapoint: a reading is published only when it
+// has moved by more than the deadband since the last publish, or when
+// heartbeatMs have passed without one. With none of them configured every
+// reading is published. Has no Arduino dependencies so it can be exercised
+// from native-test.
+class ModbusPublishFilter {
+public:
+    float deadband{0.0f};
+    ModbusDeadbandType deadbandType{ModbusDeadbandType::Absolute};
+    // Longest silence before the value is published unchanged; 0 never.
+    uint32_t heartbeatMs{0};
+    // Publishes any change at all, even with no deadband.
+    bool onChange{false};
+
+    bool reportsByException() const;
+
+    bool shouldPublish(double value, uint32_t nowMs) const;
+
+    // Text datapoints: compares the text itself, which the next published()
+    // then records. Only kept while reporting by exception.
+    bool shouldPublishText(const char *text, size_t length, uint32_t nowMs);
+
+    // Call once value has actually gone out.
+    void published(double value, uint32_t nowMs);
+
+private:
+    bool heartbeatDue(uint32_t nowMs) const;
+
+    bool _hasPublished{false};
+    double _lastValue{0.0};
+    uint32_t _lastPublishedMs{0};
+    std::string _lastText;
+    std::string _pendingText;
+    bool _textPending{false};
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef MODBUS_READ_PLANNER_H
+#define MODBUS_READ_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "modbus/config_structs/ModbusFunctionType.h"
+
+// One due read as seen by the planner: which table, where, and how wide.
+// For coil/discrete functions `count` is in bits, otherwise in registers.
+struct ModbusReadRequest {
+    ModbusFunctionType function;
+    uint16_t address;
+    uint16_t count;
+};
+
+// A single wire transaction covering one or more requests. The requests it
+// serves are members[firstMember .. firstMember + memberCount) of the member
+// list produced alongside the blocks.
+struct ModbusReadBlock {
+    ModbusFunctionType function;
+    uint16_t address;
+    uint16_t count;
+    size_t firstMember;
+    size_t memberCount;
+};
+
+// Groups the due reads of one slave into the fewest legal block reads.
+//
+// Requests are merged when they share a function code, overlap or are
+// separated by at most `maxGap` unused registers/bits, and the merged span
+// stays within the per-transaction limit. Has no Arduino dependencies so the
+// planner can be exercised from native-test.
+class ModbusReadPlanner {
+public:
+    // Protocol limits for FC03/FC04 and FC01/FC02 respectively.
+    static constexpr uint16_t kMaxReadRegisters = 125;
+    static constexpr uint16_t kMaxReadBits = 2000;
+
+    struct Limits {
+        uint16_t maxRegisters{kMaxReadRegisters};
+        uint16_t maxBits{kMaxReadBits};
+        uint16_t maxGap{0};
+    };
+
+    // Plans `count` requests into `blocks`. `members` receives request indexes
+    // ordered so each block's members are contiguous. Both vectors are cleared
+    // first; reserve them up front to keep planning allocation-free.
+    // Requests for other than FC01-FC04 are left out of every block.
+    // Returns the number of blocks.
+    static size_t plan(const ModbusReadRequest *requests,
+                       size_t count,
+                       const Limits &limits,
+                       std::vector<ModbusReadBlock> &blocks,
+                       std::vector<size_t> &members);
+
+    static bool isBitFunction(ModbusFunctionType fn);
+
+    // Copies `count` bits starting at `bitOffset` out of an LSB-first packed
+    // word buffer into `out`, packed the same way a standalone read of just
+    // those bits would have returned them. `out` must hold (count + 15) / 16
+    // words.
+    static void extractBits(const uint16_t *packed, uint16_t bitOffset, uint16_t count, uint16_t *out);
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef MODBUS_RETRY_POLICY_H
+#define MODBUS_RETRY_POLICY_H
+
+#include <cstdint>
+
+#include "modbus/ModbusRtuMaster.h"
+
+// A corrupted frame is line noise and usually succeeds straight away on a
+// second try. A timeout would cost another full timeout, and an exception is
+// the slave's considered answer, so neither is repeated.
+inline bool shouldRetryTransaction(const uint8_t status, const uint8_t attempt) {
+    return attempt == 0 && status == ModbusRtuStatus::InvalidCrc;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef MODBUS_RTU_MASTER_H
+#define MODBUS_RTU_MASTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modbus/ModbusBusTiming.h"
+
+// Transaction outcomes. The values match the ModbusMaster library so
+// ModbusManager::statusToString and logged codes keep their meaning.
+namespace ModbusRtuStatus {
+constexpr uint8_t Success = 0x00;
+constexpr uint8_t IllegalFunction = 0x01;
+constexpr uint8_t IllegalDataAddress = 0x02;
+constexpr uint8_t IllegalDataValue = 0x03;
+constexpr uint8_t SlaveDeviceFailure = 0x04;
+constexpr uint8_t InvalidSlaveId = 0xE0;
+constexpr uint8_t InvalidFunction = 0xE1;
+constexpr uint8_t ResponseTimedOut = 0xE2;
+constexpr uint8_t InvalidCrc = 0xE3;
+constexpr uint8_t Busy = 0xE4;
+}
+
+// Byte transport under the master. No call may block.
+class ModbusRtuPort {
+public:
+    virtual ~ModbusRtuPort() = default;
+
+    virtual int available() = 0;
+
+    virtual int read() = 0;
+
+    // Moves whatever is buffered into dst in one go.
+    virtual size_t readAvailable(uint8_t *dst, size_t capacity);
+
+    // True, once, after the receiver saw the line go idle for t3.5 following
+    // received bytes. Ports without idle detection never report it and
+    // frames end on their byte count or the response timeout.
+    virtual bool takeLineIdle() { return false; }
+
+    // Switches the line to transmit and queues the whole frame.
+    virtual void transmit(const uint8_t *frame, size_t length) = 0;
+
+    // True once the frame has left the wire and the line is back in receive.
+    virtual bool transmitDone() = 0;
+};
+
+struct ModbusRtuRequest {
+    uint8_t slaveId;
+    uint8_t function;        // Modbus function code
+    uint16_t address;        // FC23: read address
+    uint16_t count;          // bits or registers; ignored for FC05/FC06; FC23: registers read
+    // FC05/FC06: one value. FC16: count registers. FC15: count coils packed
+    // from the low byte of values[0] up, as bit reads are returned.
+    // FC23: writeCount registers.
+    const uint16_t *values;
+    uint16_t writeAddress;   // FC23 only
+    uint16_t writeCount;     // FC23 only
+};
+
+// Runs from poll() once the transaction is over; the master is already idle,
+// so the callback may start the next one. words is only valid for the call.
+using ModbusRtuCallback = void (*)(void *context, uint8_t status, const uint16_t *words, uint16_t count);
+
+// Modbus RTU master as a state machine: wait for the inter-frame silence,
+// transmit, await the response, parse, complete. Nothing blocks; the owner
+// calls poll() when bytes arrive or when the returned delay has passed. Has
+// no Arduino dependencies so it can be driven from native-test.
+class ModbusRtuMaster {
+public:
+    enum class State : uint8_t {
+        Idle,
+        Silence,   // request encoded, waiting out t3.5 since the last frame
+        Transmit,  // frame handed to the port, waiting for it to leave
+        Await      // collecting the response until complete or timed out
+    };
+
+    // Largest read response: 125 registers, or 2000 bits packed into words.
+    static constexpr uint16_t kMaxWords = 125;
+    // Largest write one request carries; FC23 writes at most kMaxReadWriteRegisters.
+    static constexpr uint16_t kMaxWriteCoils = 1968;
+    static constexpr uint16_t kMaxWriteRegisters = 123;
+    static constexpr uint16_t kMaxReadWriteRegisters = 121;
+    static constexpr size_t kMaxFrameBytes = 256;
+    static constexpr uint32_t kIdle = UINT32_MAX;
+    static constexpr uint32_t kNoResponse = UINT32_MAX;
+
+    void setPort(ModbusRtuPort *port);
+
+    void setLineTiming(const ModbusLineTiming &line);
+
+    // How long the slave may take to start answering. The time the expected
+    // answer needs on the wire is added per request.
+    void setResponseTimeoutUs(uint32_t timeoutUs);
+
+    // Queues a transaction. Returns Success once accepted, Busy while another
+    // is in flight, IllegalFunction/IllegalDataValue for requests that cannot
+    // be encoded; onComplete is only called for accepted requests.
+    uint8_t start(const ModbusRtuRequest &request, uint32_t nowUs, ModbusRtuCallback onComplete, void *context);
+
+    // Advances as far as possible without blocking. Returns the microseconds
+    // that may pass before the next call, or kIdle with nothing in flight.
+    // Received bytes and idle-line events warrant an earlier call.
+    uint32_t poll(uint32_t nowUs);
+
+    bool busy() const;
+
+    State state() const;
+
+    // Time from the end of the request to the first byte of the last answer,
+    // derived from its completion time and length; kNoResponse if nothing
+    // came back.
+    uint32_t lastTurnaroundUs() const;
+
+    static uint16_t crc16(const uint8_t *data, size_t length);
+
+    // Encodes a request frame including CRC; 0 if it is not supported.
+    static size_t encode(const ModbusRtuRequest &request, uint8_t *out, size_t capacity);
+
+private:
+    void receive();
+
+    // Response length once enough header bytes arrived; 0 if not yet known.
+    size_t expectedResponseBytes() const;
+
+    uint8_t parseResponse(uint16_t &wordCount);
+
+    void complete(uint8_t status, uint16_t wordCount, uint32_t nowUs);
+
+    ModbusRtuPort *_port{nullptr};
+    ModbusLineTiming _line{1042, 3647};
+    uint32_t _responseTimeoutUs{2000000};
+    uint32_t _expectedRxUs{0};
+    uint32_t _lastTurnaroundUs{kNoResponse};
+
+    State _state{State::Idle};
+    uint8_t _slaveId{0};
+    uint8_t _function{0};
+    uint16_t _readCount{0};   // bits or registers the answer must carry
+    ModbusRtuCallback _onComplete{nullptr};
+    void *_context{nullptr};
+
+    uint8_t _tx[kMaxFrameBytes]{};
+    size_t _txLength{0};
+    uint8_t _rx[kMaxFrameBytes]{};
+    size_t _rxLength{0};
+    uint16_t _words[kMaxWords]{};
+
+    uint32_t _stateSinceUs{0};
+    // The line is treated as silent for t3.5 before the first request.
+    uint32_t _lastFrameEndUs{0};
+    bool _lineUsed{false};
+};
+
+#endif
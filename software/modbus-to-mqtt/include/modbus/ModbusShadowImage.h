@@ -0,0 +1,55 @@
+#ifndef MODBUS_SHADOW_IMAGE_H
+#define MODBUS_SHADOW_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Last value read from the bus for every coil, discrete input, holding and
+// input register of every slave, with when it was read. Reads can then be
+// answered without a bus transaction while the data is fresh enough. Items
+// are kept sorted by slave, table and address, so only registers that were
+// actually polled take memory. Not thread-safe. Has no Arduino dependencies
+// so it can be exercised from native-test.
+class ModbusShadowImage {
+public:
+    // About 24 KB once full; later items are not cached.
+    static constexpr size_t kMaxItems = 2048;
+
+    // Records a successful read answer, delivered the way the RTU master
+    // delivers it: one register per word, or bits packed from bit 0.
+    void store(uint8_t slaveId, uint8_t function, uint16_t address, uint16_t count, const uint16_t *words,
+               uint32_t nowMs);
+
+    // Fills outWords like a bus read would, if every item asked for was
+    // read within maxAgeMs. False, leaving outWords untouched, otherwise.
+    bool lookup(uint8_t slaveId, uint8_t function, uint16_t address, uint16_t count, uint32_t nowMs,
+                uint32_t maxAgeMs, uint16_t *outWords, uint16_t outCapacity, uint16_t &outCount) const;
+
+    // Forgets the items a write function touched, so the next read goes to
+    // the bus and sees what the slave actually applied.
+    void invalidate(uint8_t slaveId, uint8_t function, uint16_t address, uint16_t count);
+
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Item {
+        uint32_t key;
+        uint32_t updatedAtMs;
+        uint16_t value;
+        bool valid;
+    };
+
+    // The table a function reads or writes; -1 for anything else.
+    static int tableOf(uint8_t function);
+
+    static uint32_t keyOf(uint8_t slaveId, int table, uint16_t address);
+
+    size_t lowerBound(uint32_t key) const;
+
+    std::vector<Item> _items;
+};
+
+#endif
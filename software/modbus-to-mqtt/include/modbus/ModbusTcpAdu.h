@@ -0,0 +1,93 @@
+#ifndef MODBUS_TCP_ADU_H
+#define MODBUS_TCP_ADU_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Exception codes a gateway answers with on its own behalf; 1..4 are passed
+// through from the slave.
+namespace ModbusTcpException {
+constexpr uint8_t IllegalFunction = 0x01;
+constexpr uint8_t IllegalDataAddress = 0x02;
+constexpr uint8_t IllegalDataValue = 0x03;
+constexpr uint8_t SlaveDeviceFailure = 0x04;
+constexpr uint8_t SlaveDeviceBusy = 0x06;
+constexpr uint8_t GatewayPathUnavailable = 0x0A;
+constexpr uint8_t GatewayTargetFailed = 0x0B;
+}
+
+// One Modbus TCP request, MBAP header and PDU decoded.
+struct ModbusTcpRequest {
+    uint16_t transactionId;
+    uint8_t unitId;
+    uint8_t function;
+    uint16_t address;        // FC23: read address
+    uint16_t count;          // bits or registers; 1 for FC05/FC06; FC23: registers read
+    uint16_t value;          // FC05/FC06 value, or a client's single FC16 register
+    uint16_t writeAddress;   // FC23 only
+    uint16_t writeCount;     // FC23 only: registers written
+    // FC15/16/23 data as it came off the wire; points into the parsed buffer
+    // and is only valid until the ADU is consumed.
+    const uint8_t *writeData;
+};
+
+// A Modbus TCP answer as a polling client sees it.
+struct ModbusTcpResponse {
+    uint16_t transactionId;
+    uint8_t unitId;
+    uint8_t function;        // without the exception bit
+    uint8_t status;          // ModbusRtuStatus code
+    uint16_t count;          // words delivered
+};
+
+enum class ModbusTcpParse : uint8_t {
+    Incomplete,  // wait for more bytes
+    Request,     // out holds a request the gateway can forward
+    Response,    // out holds a server's answer
+    Exception,   // well-framed but refused; answer with exceptionCode
+    Malformed    // not Modbus TCP; drop the connection
+};
+
+// MBAP framing for the Modbus TCP gateway. Has no Arduino dependencies so it
+// can be exercised from native-test.
+class ModbusTcpAdu {
+public:
+    static constexpr uint16_t kDefaultPort = 502;
+    static constexpr size_t kHeaderBytes = 7;
+    static constexpr size_t kMaxAduBytes = 260;
+
+    // Decodes the ADU at the front of buf. consumed is its length for
+    // Request and Exception; out then carries at least the transaction id,
+    // unit id and function.
+    static ModbusTcpParse parse(const uint8_t *buf, size_t length, ModbusTcpRequest &out,
+                                uint8_t &exceptionCode, size_t &consumed);
+
+    // Encodes the answer to request from a bus outcome (a ModbusRtuStatus
+    // code and, for reads, the words the RTU master delivered). Returns the
+    // ADU length, 0 if out is too small.
+    static size_t encodeResponse(const ModbusTcpRequest &request, uint8_t status, const uint16_t *words,
+                                 uint16_t count, uint8_t *out, size_t capacity);
+
+    static size_t encodeException(const ModbusTcpRequest &request, uint8_t code, uint8_t *out, size_t capacity);
+
+    // Exception code reported for a failed bus transaction.
+    static uint8_t exceptionFor(uint8_t rtuStatus);
+
+    // Client side: the request ADU for a poll or write.
+    static size_t encodeRequest(const ModbusTcpRequest &request, uint8_t *out, size_t capacity);
+
+    // Client side: decodes the answer at the front of buf. Read data lands in
+    // words the way the RTU master delivers it, so both transports share the
+    // decoding path. Gateway exceptions (0x0A/0x0B) read as a timeout.
+    static ModbusTcpParse parseResponse(const uint8_t *buf, size_t length, ModbusTcpResponse &out,
+                                        uint16_t *words, uint16_t capacity, size_t &consumed);
+
+    // Copies a parsed write's data into words the way ModbusCommand carries
+    // it: registers in order, coils packed from the low byte up. Returns the
+    // words filled, 0 if they do not fit in capacity.
+    static uint16_t unpackValues(const ModbusTcpRequest &request, uint16_t *words, uint16_t capacity);
+
+    static bool isRead(uint8_t function);
+};
+
+#endif
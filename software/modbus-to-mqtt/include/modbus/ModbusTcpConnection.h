@@ -0,0 +1,59 @@
+#ifndef MODBUS_TCP_CONNECTION_H
+#define MODBUS_TCP_CONNECTION_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "modbus/ModbusTcpAdu.h"
+#include "modbus/ModbusTcpPipeline.h"
+
+// One persistent socket to a Modbus TCP server, shared by every device that
+// targets the same host and port. Requests are pipelined: up to
+// ModbusTcpPipeline::kMaxOutstanding may await their answers at once.
+class ModbusTcpConnection {
+public:
+    ModbusTcpConnection(String host, uint16_t port);
+
+    bool matches(const String &host, uint16_t port) const;
+
+    const String &host() const;
+
+    uint16_t port() const;
+
+    // Opens the socket if it is closed. Attempts are paced so an unreachable
+    // endpoint does not hold up the other connections.
+    bool ensureConnected(uint32_t nowMs);
+
+    bool connected();
+
+    bool full() const;
+
+    // Sends one request; returns its pipeline slot, or kNone if the window is
+    // full or the write failed.
+    uint8_t send(ModbusTcpRequest request, uint32_t nowMs, uint32_t timeoutMs);
+
+    // Decodes the next answer that arrived, if any, into response and words;
+    // slot is the pipeline slot it answers. Answers nobody waits for are
+    // skipped; a corrupt stream closes the socket.
+    bool receive(ModbusTcpResponse &response, uint16_t *words, uint16_t capacity, uint8_t &slot);
+
+    // One request past its timeout, or, once the socket is gone, any request
+    // still outstanding; kNone if there is none.
+    uint8_t takeFailed(uint32_t nowMs);
+
+    size_t outstanding() const;
+
+    void close();
+
+private:
+    String _host;
+    uint16_t _port;
+    WiFiClient _client;
+    ModbusTcpPipeline _pipeline;
+    uint32_t _lastConnectAttemptMs{0};
+    bool _attempted{false};
+    size_t _rxLength{0};
+    uint8_t _rx[ModbusTcpAdu::kMaxAduBytes]{};
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef MODBUS_TCP_GATEWAY_H
+#define MODBUS_TCP_GATEWAY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modbus/ModbusRtuMaster.h"
+#include "modbus/ModbusTcpAdu.h"
+
+// Bookkeeping between Modbus TCP clients and the RS485 bus. Every accepted
+// request waits on a flight, one bus transaction; identical reads that
+// arrive while a flight is still queued or on the wire join it instead of
+// costing another transaction. Completed flights are fanned back out with
+// each client's own transaction id. Fixed capacity, not thread-safe: the
+// owner serialises access. Has no Arduino dependencies so it can be
+// exercised from native-test.
+class ModbusTcpGateway {
+public:
+    static constexpr size_t kMaxClients = 4;
+    static constexpr size_t kMaxFlights = 8;
+    static constexpr size_t kMaxWaiters = 16;
+    // Outstanding requests one client may have before it is told to back off.
+    static constexpr size_t kMaxWaitersPerClient = 4;
+
+    enum class Admission : uint8_t {
+        Submit,  // a new flight; the caller puts it on the bus
+        Joined,  // rides on an identical read already waiting for the bus
+        Busy     // no room; answer SlaveDeviceBusy
+    };
+
+    Admission admit(uint8_t client, const ModbusTcpRequest &request, uint8_t &flight);
+
+    const ModbusTcpRequest &flightRequest(uint8_t flight) const;
+
+    // Stores the bus outcome; every waiter of the flight becomes ready.
+    void complete(uint8_t flight, uint8_t status, const uint16_t *words, uint16_t count);
+
+    // Encodes one ready answer for client into out and forgets it. Returns
+    // its length, 0 if nothing is ready.
+    size_t takeResponse(uint8_t client, uint8_t *out, size_t capacity);
+
+    // Forgets a disconnected client's requests; their flights still run.
+    void dropClient(uint8_t client);
+
+    size_t pendingFor(uint8_t client) const;
+
+    size_t flightsInUse() const;
+
+private:
+    struct Flight {
+        bool used{false};
+        bool done{false};
+        uint8_t waiters{0};
+        uint8_t status{0};
+        uint16_t count{0};
+        ModbusTcpRequest request{};
+        uint16_t words[ModbusRtuMaster::kMaxWords]{};
+    };
+
+    struct Waiter {
+        bool used{false};
+        uint8_t client{0};
+        uint8_t flight{0};
+        uint16_t transactionId{0};
+    };
+
+    static bool sameRead(const ModbusTcpRequest &a, const ModbusTcpRequest &b);
+
+    void releaseWaiter(Waiter &waiter);
+
+    Flight _flights[kMaxFlights];
+    Waiter _waiters[kMaxWaiters];
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef MODBUS_TCP_PIPELINE_H
+#define MODBUS_TCP_PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Outstanding transactions on one Modbus TCP connection. Several requests
+// may be on the wire at once; answers are matched back by transaction id
+// whatever order they arrive in. Not thread-safe. Has no Arduino
+// dependencies so it can be exercised from native-test.
+class ModbusTcpPipeline {
+public:
+    static constexpr uint8_t kMaxOutstanding = 4;
+    static constexpr uint8_t kNone = 0xFF;
+
+    // Reserves a slot for a request sent at nowMs and assigns its
+    // transaction id; kNone when the window is full.
+    uint8_t begin(uint32_t nowMs, uint32_t timeoutMs, uint16_t &transactionId);
+
+    // The slot awaiting transactionId; kNone for an unknown or late answer.
+    uint8_t match(uint16_t transactionId) const;
+
+    void finish(uint8_t slot);
+
+    // Finishes and returns one slot past its timeout, kNone if none is.
+    uint8_t takeExpired(uint32_t nowMs);
+
+    // Finishes and returns any slot, kNone once empty; for a dropped socket.
+    uint8_t takeAny();
+
+    uint32_t sentAtMs(uint8_t slot) const;
+
+    size_t outstanding() const;
+
+    bool full() const;
+
+    void clear();
+
+private:
+    struct Slot {
+        bool used{false};
+        uint16_t transactionId{0};
+        uint32_t sentAtMs{0};
+        uint32_t timeoutMs{0};
+    };
+
+    Slot _slots[kMaxOutstanding];
+    uint16_t _nextTransactionId{1};
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef MODBUS_TCP_SERVER_H
+#define MODBUS_TCP_SERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "modbus/ModbusCommandQueue.h"
+#include "modbus/ModbusTcpAdu.h"
+#include "modbus/ModbusTcpGateway.h"
+#include "modbus/ModbusUnitRoutes.h"
+
+class Logger;
+class ModbusManager;
+struct ModbusDevice;
+
+// Modbus TCP server relaying client requests onto the RS485 buses, each unit
+// id to the bus and slave of the device it names. Reads the
+// polling task fetched recently enough are answered from ModbusManager's
+// shadow image. Everything else is submitted to its command queue, so it
+// runs between scheduled polls like any other ad-hoc command; identical
+// reads in flight are merged by ModbusTcpGateway. Runs on its own task,
+// which only talks to the sockets.
+class ModbusTcpServer {
+public:
+    ModbusTcpServer(Logger *logger, ModbusManager *modbus);
+
+    // Listens on port, or closes every connection when it is 0. Reads are
+    // served from the shadow image when it is younger than maxAgeMs (0 never
+    // does). May be called again after a reconfiguration.
+    void configure(uint16_t port, uint32_t maxAgeMs);
+
+    // Routes each RS485 device's gatewayUnitId to its bus and slave; other
+    // unit ids are answered with GatewayTargetFailed.
+    void mapUnits(const std::vector<ModbusDevice> &devices);
+
+private:
+    struct ClientSlot {
+        WiFiClient client;
+        bool active{false};
+        size_t rxLength{0};
+        uint8_t rx[ModbusTcpAdu::kMaxAduBytes]{};
+    };
+
+    // Lets the completion callback find its way back to a flight.
+    struct FlightTag {
+        ModbusTcpServer *server;
+        uint8_t flight;
+    };
+
+    [[noreturn]] static void taskRunner(void *param);
+
+    void serviceOnce();
+
+    void updateListener();
+
+    void acceptClients();
+
+    void readClient(uint8_t slot);
+
+    void handleRequest(uint8_t slot, const ModbusTcpRequest &request);
+
+    void flushResponses(uint8_t slot);
+
+    void closeClient(uint8_t slot);
+
+    static void onFlightComplete(void *context, const ModbusCommand &command, const ModbusCommandResult &result);
+
+    Logger *_logger;
+    ModbusManager *_modbus;
+    WiFiServer _server;
+    uint16_t _listeningPort{0};
+    uint32_t _lastListenAttemptMs{0};
+    std::atomic<uint16_t> _port{0};
+    std::atomic<uint32_t> _maxAgeMs{0};
+    TaskHandle_t _task{nullptr};
+    // Guards _gateway, shared with the polling task's completions, and
+    // _routes, replaced on a reconfiguration.
+    SemaphoreHandle_t _mutex{nullptr};
+    ModbusTcpGateway _gateway;
+    ModbusUnitRoutes _routes;
+    ClientSlot _clients[ModbusTcpGateway::kMaxClients];
+    FlightTag _tags[ModbusTcpGateway::kMaxFlights];
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef MODBUS_TIMEOUT_ESTIMATOR_H
+#define MODBUS_TIMEOUT_ESTIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Learns how long one slave takes to start answering and derives its
+// response timeout from that: the larger of the smoothed turnaround plus four
+// mean deviations and the bucket holding the 99th percentile. A timeout
+// doubles the next one until the slave answers again. Has no Arduino
+// dependencies so it can be exercised from native-test.
+class ModbusTimeoutEstimator {
+public:
+    // Below this many answers the ceiling applies.
+    static constexpr uint16_t kWarmupSamples = 8;
+    // Log2 buckets from 1 ms up; the last one is open-ended.
+    static constexpr size_t kBuckets = 16;
+    static constexpr uint32_t kFirstBucketUs = 1024;
+    // Histogram counts are halved once they add up to this, so old samples
+    // fade out.
+    static constexpr uint16_t kDecayAt = 256;
+    static constexpr uint8_t kMaxBackoffShift = 4;
+
+    void record(uint32_t turnaroundUs);
+
+    void recordTimeout();
+
+    uint32_t timeoutUs(uint32_t floorUs, uint32_t ceilingUs) const;
+
+    // Upper bound of the bucket reaching the given share of samples.
+    uint32_t percentileUs(uint16_t permille) const;
+
+    uint32_t smoothedUs() const;
+
+    uint32_t deviationUs() const;
+
+    uint16_t samples() const;
+
+    static size_t bucketOf(uint32_t turnaroundUs);
+
+private:
+    uint32_t _smoothedUs{0};
+    uint32_t _deviationUs{0};
+    uint16_t _samples{0};
+    uint16_t _histogramTotal{0};
+    uint16_t _histogram[kBuckets]{};
+    uint8_t _backoffShift{0};
+};
+
+#endif
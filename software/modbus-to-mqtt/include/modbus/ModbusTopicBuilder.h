@@ -4,6 +4,9 @@
 #include "modbus/config_structs/ModbusDevice.h"
 #include "modbus/config_structs/ModbusDatapoint.h"
 
+// Resolves topics from the root topic and device and datapoint names. A
+// datapoint topic may use the {root}, {device} and {dp} placeholders; an
+// empty one is {root}/{device}/{dp}. Used when ModbusTopicTable is rebuilt.
 class ModbusTopicBuilder {
 public:
     explicit ModbusTopicBuilder(String rootTopic);
@@ -12,6 +15,8 @@ public:
 
     String availabilityTopic(const ModbusDevice &device) const;
 
+    String snapshotTopic(const ModbusDevice &device) const;
+
     static String deviceSegment(const ModbusDevice &device);
 
     static String datapointSegment(const ModbusDatapoint &dp);
@@ -19,6 +24,8 @@ public:
     static String friendlyName(const ModbusDevice &device, const ModbusDatapoint &dp);
 
 private:
+    String expand(String pattern, const ModbusDevice &device, const ModbusDatapoint *dp) const;
+
     String _rootTopic;
 };
 
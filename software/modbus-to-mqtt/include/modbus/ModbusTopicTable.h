@@ -0,0 +1,38 @@
+#ifndef MODBUS_TOPIC_TABLE_H
+#define MODBUS_TOPIC_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include <WString.h>
+
+#include "modbus/config_structs/ModbusDevice.h"
+
+// Every MQTT topic and key the bridge uses, resolved once per configuration
+// load or root-topic change. Identical strings are stored once in a single
+// buffer; devices and datapoints hold their ids (see topicId, segmentId and
+// friends), so publishing builds no strings. Id 0 is the empty string.
+class ModbusTopicTable {
+public:
+    ModbusTopicTable();
+
+    // Resolves the topics of every device and datapoint against rootTopic
+    // and stores their ids on them.
+    void rebuild(const String &rootTopic, std::vector<ModbusDevice> &devices);
+
+    const char *at(const uint16_t id) const {
+        return _pool.data() + _offsets[id];
+    }
+
+    const String &rootTopic() const;
+
+    size_t poolBytes() const;
+
+private:
+    uint16_t intern(const String &text);
+
+    String _rootTopic;
+    std::vector<char> _pool;
+    std::vector<uint32_t> _offsets;
+};
+
+#endif
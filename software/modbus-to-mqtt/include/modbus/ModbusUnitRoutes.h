@@ -0,0 +1,31 @@
+#ifndef MODBUS_UNIT_ROUTES_H
+#define MODBUS_UNIT_ROUTES_H
+
+#include <cstdint>
+
+// Which RS485 bus and slave each Modbus TCP unit id reaches through the
+// gateway. Fixed size, not thread-safe: the owner serialises access. Has no
+// Arduino dependencies so it can be exercised from native-test.
+class ModbusUnitRoutes {
+public:
+    static constexpr uint8_t kMaxUnitId = 247;
+
+    struct Route {
+        uint8_t bus;
+        uint8_t slaveId;
+    };
+
+    void clear();
+
+    // False, leaving the table as it was, when unitId is out of range or
+    // already routes to another slave.
+    bool add(uint8_t unitId, uint8_t bus, uint8_t slaveId);
+
+    bool find(uint8_t unitId, Route &out) const;
+
+private:
+    // bus + 1 in the high byte, slave in the low one; 0 for no route.
+    uint16_t _routes[kMaxUnitId + 1]{};
+};
+
+#endif
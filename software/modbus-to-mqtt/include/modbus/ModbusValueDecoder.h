@@ -0,0 +1,50 @@
+#ifndef MODBUS_VALUE_DECODER_H
+#define MODBUS_VALUE_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modbus/config_structs/ModbusDataType.h"
+#include "modbus/config_structs/ModbusWordOrder.h"
+#include "modbus/config_structs/RegisterSlice.h"
+
+// Decodes a datapoint's raw registers (unscaled). `words` must hold at least
+// ModbusValueDecoder::registerCount(dataType) registers.
+using ModbusDecodeFn = double (*)(const uint16_t *words);
+
+// Resolves a specialised decode function per datapoint at config load, so the
+// poll path does a single indirect call with no branching on type or order.
+// Has no Arduino dependencies so it can be exercised from native-test.
+class ModbusValueDecoder {
+public:
+    // Room formatValue() needs, terminator included.
+    static constexpr size_t kValueChars = 24;
+
+    // Returns nullptr for TEXT, which is rendered as ASCII instead.
+    // registerSlice only applies to 16-bit types.
+    static ModbusDecodeFn select(ModbusDataType dataType, ModbusWordOrder order, RegisterSlice slice);
+
+    // Registers occupied by one value of dataType (0 for TEXT).
+    static uint8_t registerCount(ModbusDataType dataType);
+
+    // The inverse for writes: lays value out as dataType's registers in the
+    // given order, rounding and clamping integers to the type's range.
+    // `words` must hold registerCount(dataType) registers. Returns the
+    // registers written (0 for TEXT).
+    static uint8_t encode(ModbusDataType dataType, ModbusWordOrder order, double value, uint16_t *words);
+
+    // Writes value the way it is published, with two decimals (exponent
+    // notation from 1e15 up so it always fits kValueChars), into out.
+    // Returns the length written.
+    static size_t formatValue(double value, char *out, size_t capacity);
+
+    // Writes count registers as ASCII, high byte first, dropping NUL bytes.
+    // Truncates to capacity - 1 characters; returns the length written.
+    static size_t formatText(const uint16_t *words, uint16_t count, char *out, size_t capacity);
+
+    static bool parseWordOrder(const char *text, ModbusWordOrder &out);
+
+    static const char *wordOrderToString(ModbusWordOrder order);
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef MODBUS_WRITE_COMBINER_H
+#define MODBUS_WRITE_COMBINER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "modbus/ModbusCommandQueue.h"
+
+// Holds holding-register writes (FC06/FC16) for a short window per slave so
+// a burst reaches the bus as few transactions as possible: repeated writes
+// to a register collapse to the last value and adjacent registers go out as
+// one FC16. Each held command is finished with the outcome of the
+// transactions that wrote its registers. Fixed capacity, not thread-safe:
+// the owner serialises access. Has no Arduino dependencies so it can be
+// exercised from native-test.
+class ModbusWriteCombiner {
+public:
+    static constexpr size_t kMaxHeld = 8;
+    static constexpr size_t kMaxRegisters = 64;
+    static constexpr uint32_t kNothingHeld = UINT32_MAX;
+
+    struct Finished {
+        ModbusCommand command;
+        uint8_t status;      // first failure among its transactions, else Success
+    };
+
+    static bool combinable(const ModbusCommand &command);
+
+    // Holds command until its slave's window closes, windowMs after the
+    // first write held for that slave. False if it is not combinable or
+    // there is no room; the caller then sends it as usual.
+    bool hold(const ModbusCommand &command, uint32_t nowMs, uint32_t windowMs);
+
+    // Closes slaveId's window now, so its held writes go out ahead of a
+    // command that bypasses the combiner.
+    void expedite(uint8_t slaveId, uint32_t nowMs);
+
+    // Milliseconds until a window closes (0 if one has), kNothingHeld if
+    // nothing is held.
+    uint32_t msUntilDue(uint32_t nowMs) const;
+
+    // The next write to send once a window has closed: the run of adjacent
+    // held registers from the lowest address of that slave, at most
+    // ModbusCommand::kMaxValues long, as FC16 (FC06 for a single register).
+    // False if no window has closed.
+    bool takeDue(uint32_t nowMs, ModbusCommand &out);
+
+    // Settles the write last returned by takeDue(). Held commands with no
+    // registers left to write are copied to out and forgotten; out must have
+    // room for kMaxHeld. Returns how many.
+    size_t complete(uint8_t status, Finished *out);
+
+    size_t heldCount() const;
+
+private:
+    struct Held {
+        bool used{false};
+        ModbusCommand command{};
+        uint16_t remaining{0};   // registers not yet written
+        uint16_t inFlight{0};    // of those, in the write being sent
+        uint8_t status{0};
+    };
+
+    struct Register {
+        bool used{false};
+        uint8_t slaveId{0};
+        uint16_t address{0};
+        uint16_t value{0};
+        uint32_t dueAtMs{0};
+    };
+
+    Register *find(uint8_t slaveId, uint16_t address);
+
+    Held _held[kMaxHeld];
+    Register _registers[kMaxRegisters];
+};
+
+#endif
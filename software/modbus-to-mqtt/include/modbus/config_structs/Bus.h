@@ -6,5 +6,24 @@ struct Bus {
     int baud;
     String serialFormat;
     bool enabled{false};
+    // GPIOs for this bus. -1 takes the board's RS485 wiring, which only the
+    // first bus has.
+    int8_t rxPin{-1};
+    int8_t txPin{-1};
+    int8_t dePin{-1};
+    // Largest run of unused registers/bits a block read may span to merge
+    // two datapoints. 0 only merges overlapping or adjacent datapoints.
+    uint16_t readMaxGap{0};
+    // Re-arm polls from their ideal deadline and spread datapoints sharing an
+    // interval across it; false re-arms from the time the poll actually ran.
+    bool fixedRatePolling{true};
+    // Relay Modbus TCP requests from the network onto this bus. Only read
+    // for the first bus.
+    bool tcpServerEnabled{false};
+    uint16_t tcpServerPort{502};
+    // Reads whose registers were all polled within this many milliseconds
+    // are answered from the shadow image without a bus transaction; 0 sends
+    // every read to the bus.
+    uint32_t tcpServerMaxAgeMs{0};
 };
 #endif
@@ -5,7 +5,18 @@
 
 struct ConfigurationRoot {
     Bus bus;
+    // Further RS485 buses, each polled by its own task. Bus index 1 is
+    // additionalBuses[0].
+    std::vector<Bus> additionalBuses;
     std::vector<ModbusDevice> devices;
+
+    size_t busCount() const {
+        return 1 + additionalBuses.size();
+    }
+
+    const Bus &busAt(const size_t index) const {
+        return index == 0 ? bus : additionalBuses[index - 1];
+    }
 };
 #endif
 
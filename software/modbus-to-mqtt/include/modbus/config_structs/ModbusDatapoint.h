@@ -6,12 +6,11 @@
 #include "ModbusDataType.h"
 #include <Arduino.h>
 #include "ModbusFunctionType.h"
-
-enum class RegisterSlice : uint8_t {
-    Full = 0,
-    LowByte,
-    HighByte
-};
+#include "ModbusPollPriority.h"
+#include "ModbusWordOrder.h"
+#include "RegisterSlice.h"
+#include "modbus/ModbusPublishFilter.h"
+#include "modbus/ModbusValueDecoder.h"
 
 struct ModbusDatapoint {
     String id;
@@ -24,7 +23,24 @@ struct ModbusDatapoint {
     String unit;
     String topic;
     RegisterSlice registerSlice{RegisterSlice::Full};
+    ModbusWordOrder wordOrder{ModbusWordOrder::ABCD};
+    // Resolved once at config load from dataType/wordOrder/registerSlice;
+    // nullptr for TEXT.
+    ModbusDecodeFn decode{nullptr};
     uint32_t pollIntervalMs{0};
+    ModbusPollPriority priority{ModbusPollPriority::Slow};
     uint32_t nextDueAtMs{0};
+    // How far past its deadline the last poll ran; `late` once that exceeds
+    // the scheduler's tolerance, i.e. the achieved period missed pollIntervalMs.
+    uint32_t lastLatenessMs{0};
+    bool late{false};
+    // Deadband and heartbeat from the configuration, plus the last value
+    // published.
+    ModbusPublishFilter publishFilter{};
+    // Into ModbusMqttBridge's topic table, resolved at config load: the
+    // topic it publishes to (or takes writes from), and its topic segment,
+    // which also keys it in snapshots and discovery ids.
+    uint16_t topicId{0};
+    uint16_t segmentId{0};
 };
 #endif
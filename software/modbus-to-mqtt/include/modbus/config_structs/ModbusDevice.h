@@ -4,16 +4,74 @@
 #include <WString.h>
 
 #include "ModbusDatapoint.h"
+#include "modbus/ModbusDeviceHealth.h"
+#include "modbus/ModbusTimeoutEstimator.h"
+
+enum class ModbusTransport : uint8_t {
+    Rtu,
+    Tcp
+};
+
+// A reading waiting in a device's snapshot.
+struct ModbusSnapshotEntry {
+    // Index into the device's datapoints.
+    uint16_t datapoint;
+    double value;
+};
+
+// What one polling cycle of a device read, gathered for a single publish.
+struct ModbusSnapshot {
+    // `"key":value` members, comma separated, without the braces.
+    String fields;
+    // The message publishSnapshot() assembles; kept so its buffer is reused.
+    String payload;
+    std::vector<ModbusSnapshotEntry> entries;
+    uint32_t startedAtMs{0};
+};
 
 struct ModbusDevice {
     String id;
     String name;
+    // RTU slave address, or the unit id for a Modbus TCP device.
     uint8_t slaveId;
+    // Index of the RS485 bus the slave is wired to; see ConfigurationRoot.
+    uint8_t bus{0};
+    // Unit id the Modbus TCP server answers for this slave; slaveId unless
+    // two buses share one.
+    uint8_t gatewayUnitId{0};
+    // Line settings of this slave where they differ from its bus's; 0 and
+    // empty keep the bus's baud and serialFormat.
+    uint32_t baud{0};
+    String serialFormat;
+    // MQTT register writes to this slave are held this long to combine
+    // with one another; 0 sends each at once.
+    uint16_t writeCombineMs{0};
+    // Set for a Modbus TCP device; empty for one on the RS485 bus.
+    String host;
+    uint16_t port{0};
+    // Index into ModbusManager's TCP connection pool, resolved at load.
+    uint8_t tcpConnection{0};
     bool mqttEnabled{false};
     bool homeassistantDiscoveryEnabled{false};
-    bool haAvailabilityOnlinePublished{false};
+    // Publishes each cycle's readings as one JSON object on the snapshot
+    // topic instead of one message per datapoint.
+    bool snapshotEnabled{false};
+    ModbusSnapshot snapshot;
+    // Into ModbusMqttBridge's topic table, resolved at config load.
+    uint16_t segmentId{0};
+    uint16_t availabilityTopicId{0};
+    uint16_t snapshotTopicId{0};
+    // The availability matching health has been published since connecting.
+    bool availabilityPublished{false};
     bool haDiscoveryPublished{false};
     std::vector<ModbusDatapoint> datapoints;
+    // Learned from answers; sets this slave's response timeout.
+    ModbusTimeoutEstimator responseTiming;
+    ModbusDeviceHealth health;
+
+    ModbusTransport transport() const {
+        return host.length() ? ModbusTransport::Tcp : ModbusTransport::Rtu;
+    }
 };
 
 #endif
\ No newline at end of file
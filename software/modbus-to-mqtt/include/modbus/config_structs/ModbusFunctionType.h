@@ -8,6 +8,8 @@ enum ModbusFunctionType {
     READ_INPUT = 4,
     WRITE_COIL = 5,
     WRITE_HOLDING = 6,
+    WRITE_MULTIPLE_COILS = 15,
     WRITE_MULTIPLE_HOLDING = 16,
+    READ_WRITE_MULTIPLE = 23,
 };
 #endif
@@ -0,0 +1,12 @@
+#ifndef MODBUS_TO_MQTT_MODBUSPOLLPRIORITY_H
+#define MODBUS_TO_MQTT_MODBUSPOLLPRIORITY_H
+
+#include <cstdint>
+
+// Breaks ties between datapoints that fall due at the same millisecond.
+enum class ModbusPollPriority : uint8_t {
+    Fast = 0,
+    Slow
+};
+
+#endif
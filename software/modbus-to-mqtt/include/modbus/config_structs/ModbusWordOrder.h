@@ -0,0 +1,15 @@
+#ifndef MODBUS_TO_MQTT_MODBUSWORDORDER_H
+#define MODBUS_TO_MQTT_MODBUSWORDORDER_H
+
+#include <cstdint>
+
+// Register/byte layout of multi-register values, named after where the bytes
+// A (most significant) .. D (least significant) of a 32-bit value land.
+enum class ModbusWordOrder : uint8_t {
+    ABCD = 0, // big-endian words, big-endian bytes (Modbus default)
+    CDAB,     // little-endian words, big-endian bytes
+    BADC,     // big-endian words, byte-swapped
+    DCBA      // little-endian words, byte-swapped
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef MODBUS_TO_MQTT_REGISTERSLICE_H
+#define MODBUS_TO_MQTT_REGISTERSLICE_H
+
+#include <cstdint>
+
+enum class RegisterSlice : uint8_t {
+    Full = 0,
+    LowByte,
+    HighByte
+};
+
+#endif
@@ -4,6 +4,10 @@
 #include <PubSubClient.h>
 #include <mqtt/MqttSubscriptionHandler.h>
 #include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <utility>
+#include <vector>
 
 class MqttManager {
 public:
@@ -29,8 +33,6 @@ public:
 
     void removeSubscriptionHandlers(const std::vector<String> &topics) const;
 
-    void onMqttMessage(const String &topic, const uint8_t *payload, size_t length) const;
-
     auto startMqttTask() -> bool;
 
     auto getMqttBroker() -> char *;
@@ -58,6 +60,12 @@ private:
 
     void setClientId(String clientId);
 
+    // Messages arrive inside loop(), holding the client; they are handled
+    // once it is released.
+    void queueMessage(const char *topic, const byte *payload, unsigned int length);
+
+    void dispatchMessages();
+
     char _mqttBroker[150] = "";
     char _mqttPort[6] = "";
     char _mqttUser[32] = "";
@@ -68,6 +76,11 @@ private:
     PubSubClient *_mqttClient;
     Logger *_logger;
     TaskHandle_t _mqttTaskHandle;
+    // Held for every call on _mqttClient: PubSubClient is not reentrant and
+    // the MQTT task, every polling task and the web handlers all use it.
+    SemaphoreHandle_t _clientMutex;
+    // Only touched by the MQTT task.
+    std::vector<std::pair<String, String>> _inbox;
     MqttSubscriptionHandler *_subscriptionHandler;
     Preferences preferences;
     bool _hasWill{false};
@@ -53,6 +53,11 @@ public:
 
     static void getLogs(AsyncWebServerRequest *req);
 
+    static void handleGetLogSettings(AsyncWebServerRequest *req);
+
+    static void handlePutLogSettingsBody(AsyncWebServerRequest *req, const uint8_t *data, size_t len, size_t index,
+                                         size_t total);
+
     static void handleDeviceReset(const Logger *logger);
 
     static void handleMqttTestConnection(AsyncWebServerRequest *req);
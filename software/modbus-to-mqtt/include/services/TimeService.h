@@ -10,6 +10,9 @@ public:
     static void loop();
     static bool hasValidTime();
     static String nowIso();
+    // Same into out without touching the heap; 0 and an empty string until
+    // the clock is set. 21 characters hold it.
+    static size_t nowIso(char *out, size_t capacity);
     static String formatIso(time_t t);
 };
 
@@ -12,6 +12,10 @@ public:
     void enableCapture(bool en);
     String dumpHex() const;
 
+    // Bulk read of what is already buffered, with the same capture and
+    // leading-zero handling as read(); never waits for more.
+    size_t readAvailable(uint8_t *dst, size_t capacity);
+
     // Stream interface
     int available() override;
     int read() override;
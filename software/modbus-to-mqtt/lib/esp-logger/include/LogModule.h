@@ -0,0 +1,11 @@
+#ifndef LOGMODULE_H
+#define LOGMODULE_H
+// Subsystem a message comes from, so each can be given its own level.
+enum LogModule {
+  LOGMODULE_CORE = 0,    // anything logged without a module
+  LOGMODULE_MODBUS = 1,
+  LOGMODULE_MQTT = 2,
+  LOGMODULE_WEB = 3,
+  LOGMODULE_COUNT
+};
+#endif //LOGMODULE_H
@@ -2,11 +2,45 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <cstddef>
 #include <vector>
 #include "LoggerInterface.h"
+#include "LogLevel.h"
+#include "LogModule.h"
+
+// Messages below this level are compiled out, e.g. -D LOGGER_MIN_LEVEL=1
+// drops every debug call. A plain number so the preprocessor can test it.
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 0
+#endif
+
+// printf-style logging that checks the level before anything is formatted:
+// the arguments are not even evaluated unless the message will be written,
+// so they may build Strings or call into other objects at no cost otherwise.
+//   LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "read %u registers", count);
+#define LOGGER_AT(logger, level, module, ...)                          \
+    do {                                                               \
+        if ((logger)->enabled((level), (module))) {                    \
+            (logger)->logf((level), (module), __VA_ARGS__);            \
+        }                                                              \
+    } while (0)
+
+#if LOGGER_MIN_LEVEL <= 0
+#define LOGGER_DEBUG(logger, module, ...) LOGGER_AT(logger, LOGLEVEL_DEBUG, module, __VA_ARGS__)
+#else
+// Still type-checked, but never generated.
+#define LOGGER_DEBUG(logger, module, ...) \
+    do { if (false) { (logger)->logf(LOGLEVEL_DEBUG, (module), __VA_ARGS__); } } while (0)
+#endif
+#define LOGGER_INFO(logger, module, ...) LOGGER_AT(logger, LOGLEVEL_INFO, module, __VA_ARGS__)
+#define LOGGER_WARN(logger, module, ...) LOGGER_AT(logger, LOGLEVEL_WARN, module, __VA_ARGS__)
+#define LOGGER_ERROR(logger, module, ...) LOGGER_AT(logger, LOGLEVEL_ERROR, module, __VA_ARGS__)
 
 class Logger {
 public:
+    // Longer formatted messages are cut.
+    static constexpr size_t kMaxMessageLength = 255;
+
     void addTarget(LoggerInterface* target);
 
     void logInformation(const char *message) const;
@@ -17,9 +51,28 @@ public:
 
     void logDebug(const char *message) const;
 
+    // Formats on the stack and writes to every target; use the LOGGER_*
+    // macros so nothing is formatted for a message that is filtered out.
+    void logf(LogLevel level, LogModule module, const char *format, ...) const
+        __attribute__((format(printf, 4, 5)));
+
     void useDebug(bool debugEnabled);
+
+    // Lowest level written for module; LOGLEVEL_DEBUG (everything) unless set.
+    // Debug messages additionally need useDebug(true).
+    void setModuleLevel(LogModule module, LogLevel level);
+
+    LogLevel moduleLevel(LogModule module) const;
+
+    bool enabled(const LogLevel level, const LogModule module) const {
+        return static_cast<int>(level) >= LOGGER_MIN_LEVEL && module < LOGMODULE_COUNT &&
+               level >= _moduleLevels[module] && (level != LOGLEVEL_DEBUG || _writeDebug);
+    }
 private:
+    void write(LogLevel level, const char *message) const;
+
     std::vector<LoggerInterface*> _targets;
     bool _writeDebug = false;
+    LogLevel _moduleLevels[LOGMODULE_COUNT]{};
 };
 #endif //LOGGER_H
@@ -1,34 +1,67 @@
 #include "Logger.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+constexpr size_t Logger::kMaxMessageLength;
+
 void Logger::addTarget(LoggerInterface* target) {
     _targets.push_back(target);
 }
 
 void Logger::logInformation(const char *message) const {
-    for (auto *target : _targets) {
-        target->logInformation(message);
-    }
+    if (!enabled(LOGLEVEL_INFO, LOGMODULE_CORE)) return;
+    write(LOGLEVEL_INFO, message);
 }
 
 void Logger::logWarning(const char *message) const {
-    for (auto *target : _targets) {
-        target->logWarning(message);
-    }
+    if (!enabled(LOGLEVEL_WARN, LOGMODULE_CORE)) return;
+    write(LOGLEVEL_WARN, message);
 }
 
 void Logger::logError(const char *message) const {
-    for (auto *target : _targets) {
-        target->logError(message);
-    }
+    if (!enabled(LOGLEVEL_ERROR, LOGMODULE_CORE)) return;
+    write(LOGLEVEL_ERROR, message);
 }
 
 void Logger::logDebug(const char *message) const {
-    if (!_writeDebug) return;
+    if (!enabled(LOGLEVEL_DEBUG, LOGMODULE_CORE)) return;
+    write(LOGLEVEL_DEBUG, message);
+}
 
-    for (auto *target : _targets) {
-        target->logDebug(message);
-    }
+void Logger::logf(const LogLevel level, const LogModule module, const char *format, ...) const {
+    if (!enabled(level, module)) return;
+
+    char message[kMaxMessageLength + 1];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    write(level, message);
 }
 
 void Logger::useDebug(const bool debugEnabled) {
     _writeDebug = debugEnabled;
 }
+
+void Logger::setModuleLevel(const LogModule module, const LogLevel level) {
+    if (module < LOGMODULE_COUNT) {
+        _moduleLevels[module] = level;
+    }
+}
+
+LogLevel Logger::moduleLevel(const LogModule module) const {
+    return module < LOGMODULE_COUNT ? _moduleLevels[module] : LOGLEVEL_DEBUG;
+}
+
+void Logger::write(const LogLevel level, const char *message) const {
+    for (auto *target : _targets) {
+        switch (level) {
+            case LOGLEVEL_ERROR: target->logError(message); break;
+            case LOGLEVEL_WARN: target->logWarning(message); break;
+            case LOGLEVEL_INFO: target->logInformation(message); break;
+            case LOGLEVEL_DEBUG:
+            default: target->logDebug(message); break;
+        }
+    }
+}
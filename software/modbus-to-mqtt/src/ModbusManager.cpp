@@ -2,32 +2,90 @@
 #include "modbus/ModbusManager.h"
 #include "storage/ConfigFs.h"
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
 #include "mqtt/MqttManager.h"
 #include "services/IndicatorService.h"
+#include "modbus/ModbusBusTiming.h"
 #include "modbus/ModbusConfigLoader.h"
+#include "modbus/ModbusFunctionUtils.h"
 #include "modbus/ModbusPollScheduler.h"
+#include "modbus/ModbusReadPlanner.h"
+#include "modbus/ModbusRetryPolicy.h"
+#include "modbus/ModbusValueDecoder.h"
+
+static constexpr auto MODBUS_TASK_STACK = 6144;
+// Above the Arduino loop task so web, OTA and time-sync work cannot delay a
+// due transaction.
+static constexpr auto MODBUS_TASK_PRIORITY = 2;
+// Upper bound on a sleep so MQTT connection changes and the bus-load window
+// are still serviced while nothing is due.
+static constexpr uint32_t MODBUS_TASK_MAX_WAIT_MS = 1000;
+// Below the RS485 task: TCP round trips are spent waiting on the network,
+// not on a shared wire.
+static constexpr auto MODBUS_TCP_TASK_PRIORITY = 1;
+// How often answers are collected while TCP requests are outstanding.
+static constexpr uint32_t MODBUS_TCP_SERVICE_MS = 10;
+
+constexpr uint16_t ModbusManager::kBlockBufferWords;
+constexpr size_t ModbusManager::kPayloadChars;
+constexpr uint32_t ModbusManager::kBusLoadWindowMs;
+
+ModbusManager::BusLane::BusLane(ModbusManager *owner, Logger *logger, const uint8_t index)
+    : owner(owner),
+      bus(logger, index) {
+    pollMutex = xSemaphoreCreateMutex();
+    commandMutex = xSemaphoreCreateMutex();
+}
 
 ModbusManager::ModbusManager(Logger *logger)
-    : _bus(logger),
-      _mqttBridge(logger, this),
+    : _mqttBridge(logger, this),
+      _tcpServer(logger, this),
       _logger(logger) {
+    for (uint8_t i = 0; i < MODBUS_MAX_BUSES; ++i) {
+        _lanes[i].reset(new BusLane(this, logger, i));
+    }
+    _tcpMutex = xSemaphoreCreateMutex();
+    _shadowMutex = xSemaphoreCreateMutex();
 }
 
 bool ModbusManager::begin() {
-    if (loadConfiguration()) {
-        _bus.begin(_modbusRoot.bus);
-        _bus.setActive(_modbusRoot.bus.enabled);
-        _logger->logInformation(_modbusRoot.bus.enabled
-            ? "ModbusManager::begin - RS485 bus is ACTIVE"
-            : "ModbusManager::begin - RS485 bus is INACTIVE");
-        return _modbusRoot.bus.enabled;
-    }
-    _bus.setActive(false);
-    _logger->logInformation("ModbusManager::begin - RS485 bus is INACTIVE");
-    return false;
+    // Tasks started below wait here until the configuration is in place.
+    pausePolling(portMAX_DELAY);
+    // The first bus always has a task so commands have somewhere to run.
+    if (!_lanes[0]->pollTaskHandle && !startPollTask(*_lanes[0])) {
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusManager::begin - failed to start polling task; commands run inline");
+    }
+    const bool loaded = loadConfiguration();
+    _tcpActive.store(loaded, std::memory_order_release);
+    if (!_tcpTaskHandle && !startTcpTask()) {
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusManager::begin - failed to start Modbus TCP polling task");
+    }
+    for (uint8_t i = 0; i < MODBUS_MAX_BUSES; ++i) {
+        BusLane &lane = *_lanes[i];
+        if (!loaded || i >= _modbusRoot.busCount()) {
+            lane.bus.setActive(false);
+            continue;
+        }
+        const Bus &busConfig = _modbusRoot.busAt(i);
+        if (!lane.pollTaskHandle && !startPollTask(lane)) {
+            LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusManager::begin - failed to start polling task for RS485 bus %u",
+                         static_cast<unsigned>(i));
+        }
+        lane.bus.begin(busConfig);
+        lane.currentLine = 0;
+        lane.bus.setActive(busConfig.enabled);
+        LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager::begin - RS485 bus %u is %s", static_cast<unsigned>(i),
+                    busConfig.enabled ? "ACTIVE" : "INACTIVE");
+    }
+    resumePolling();
+    if (!loaded) {
+        LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager::begin - RS485 bus is INACTIVE");
+        return false;
+    }
+    return _modbusRoot.bus.enabled;
 }
 
 bool ModbusManager::loadConfiguration() {
@@ -36,19 +94,153 @@ bool ModbusManager::loadConfiguration() {
         return false;
     }
     _mqttBridge.onConfigurationLoaded(_modbusRoot);
+    _tcpServer.mapUnits(_modbusRoot.devices);
+    _tcpServer.configure(_modbusRoot.bus.tcpServerEnabled ? _modbusRoot.bus.tcpServerPort : 0,
+                         _modbusRoot.bus.tcpServerMaxAgeMs);
+    // Slave ids may now name different devices.
+    xSemaphoreTake(_shadowMutex, portMAX_DELAY);
+    for (auto &lane: _lanes) {
+        lane->shadow.clear();
+    }
+    xSemaphoreGive(_shadowMutex);
 
-    _logger->logInformation((String("Loaded config: ") + String(_modbusRoot.devices.size()) + " devices; baud " +
-                             String(_modbusRoot.bus.baud) + ", format " + _modbusRoot.bus.serialFormat).c_str());
+    size_t maxDatapoints = 0;
+    for (const auto &dev: _modbusRoot.devices) {
+        maxDatapoints = std::max(maxDatapoints, dev.datapoints.size());
+    }
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < MODBUS_MAX_BUSES; ++i) {
+        BusLane &lane = *_lanes[i];
+        // A bus beyond the configured ones keeps an empty plan.
+        const bool configured = i < _modbusRoot.busCount();
+        const bool fixedRate = configured && _modbusRoot.busAt(i).fixedRatePolling;
+        if (configured) {
+            assignLines(lane, _modbusRoot.busAt(i));
+        } else {
+            lane.lines.clear();
+            lane.deviceLine.assign(_modbusRoot.devices.size(), 0);
+        }
+        lane.scheduler.rebuild(_modbusRoot.devices, now, fixedRate, ModbusTransport::Rtu, i);
+        lane.dueBatch.reserve(lane.scheduler.size());
+        lane.dueScratch.reserve(maxDatapoints);
+        lane.readRequests.reserve(maxDatapoints);
+        lane.readBlocks.reserve(maxDatapoints);
+        lane.readMembers.reserve(maxDatapoints);
+    }
+
+    _tcpScheduler.rebuild(_modbusRoot.devices, now, _modbusRoot.bus.fixedRatePolling, ModbusTransport::Tcp);
+    _tcpDueBatch.reserve(_tcpScheduler.size());
+    _tcpDueScratch.reserve(maxDatapoints);
+    _tcpReadRequests.reserve(maxDatapoints);
+    _tcpReadBlocks.reserve(maxDatapoints);
+    _tcpReadMembers.reserve(maxDatapoints);
+    assignTcpConnections();
+    for (auto &flight: _tcpInFlight) {
+        flight.members.reserve(maxDatapoints);
+    }
+
+    LOGGER_INFO(_logger, LOGMODULE_MODBUS,
+                "Loaded config: %u devices; %u RS485 buses, first at baud %lu, format %s; %u Modbus TCP connections",
+                static_cast<unsigned>(_modbusRoot.devices.size()), static_cast<unsigned>(_modbusRoot.busCount()),
+                static_cast<unsigned long>(_modbusRoot.bus.baud), _modbusRoot.bus.serialFormat.c_str(),
+                static_cast<unsigned>(_tcpConnections.size()));
+
+    for (uint8_t i = 0; i < _modbusRoot.busCount() && i < MODBUS_MAX_BUSES; ++i) {
+        BusLane &lane = *_lanes[i];
+        if (lane.lines.size() > 1) {
+            LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager::loadConfiguration - RS485 bus %u switches between %u "
+                        "line settings", static_cast<unsigned>(i), static_cast<unsigned>(lane.lines.size()));
+        }
+        lane.projectedLoadPermille = projectBusLoad(lane);
+        if (lane.projectedLoadPermille > 1000) {
+            LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::loadConfiguration - poll plan of RS485 bus %u needs "
+                        "%u%% of bus time; datapoints will poll late", static_cast<unsigned>(i),
+                        static_cast<unsigned>(lane.projectedLoadPermille / 10U));
+        } else {
+            LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager::loadConfiguration - projected load of RS485 bus %u: "
+                        "%u%%", static_cast<unsigned>(i), static_cast<unsigned>(lane.projectedLoadPermille / 10U));
+        }
+    }
+    for (uint8_t i = _modbusRoot.busCount(); i < MODBUS_MAX_BUSES; ++i) {
+        _lanes[i]->projectedLoadPermille = 0;
+    }
     return true;
 }
 
-void ModbusManager::loop() {
-    const bool mqttConnectedNow = (_mqtt != nullptr) && _mqtt->isConnected();
-    _mqttBridge.onConnectionState(mqttConnectedNow, _mqttConnectedLastLoop, _modbusRoot);
-    _mqttConnectedLastLoop = mqttConnectedNow;
+bool ModbusManager::startPollTask(BusLane &lane) {
+    // "ModbusPoll" for the first bus, "ModbusPoll1" onwards for the others.
+    char name[16] = "ModbusPoll";
+    if (lane.bus.index() > 0) {
+        snprintf(name, sizeof(name), "ModbusPoll%u", static_cast<unsigned>(lane.bus.index()));
+    }
+    const BaseType_t result = xTaskCreatePinnedToCore(
+        pollTaskRunner,
+        name,
+        MODBUS_TASK_STACK,
+        &lane,
+        MODBUS_TASK_PRIORITY,
+        &lane.pollTaskHandle,
+        1
+    );
+    return result == pdPASS;
+}
+
+[[noreturn]] void ModbusManager::pollTaskRunner(void *param) {
+    auto *lane = static_cast<BusLane *>(param);
+    ModbusManager *self = lane->owner;
+    for (;;) {
+        xSemaphoreTake(lane->pollMutex, portMAX_DELAY);
+        self->pollOnce(*lane);
+        const uint32_t waitMs = self->pollWaitMs(*lane);
+        xSemaphoreGive(lane->pollMutex);
+
+        // Always block for at least one tick so interval-0 datapoints cannot
+        // starve the idle task.
+        const TickType_t ticks = pdMS_TO_TICKS(waitMs);
+        ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1);
+    }
+}
+
+void ModbusManager::wake() const {
+    for (const auto &lane: _lanes) {
+        if (lane->pollTaskHandle) {
+            xTaskNotifyGive(lane->pollTaskHandle);
+        }
+    }
+    if (_tcpTaskHandle) {
+        xTaskNotifyGive(_tcpTaskHandle);
+    }
+}
+
+uint32_t ModbusManager::pollWaitMs(const BusLane &lane) const {
+    if (hasPendingCommands(lane)) {
+        return 0;
+    }
+    const uint32_t combinedMs = std::min(msUntilCombinedWrite(lane), MODBUS_TASK_MAX_WAIT_MS);
+    if (!lane.bus.isActive()) {
+        return combinedMs;
+    }
+    return std::min(lane.scheduler.msUntilNextDue(millis()), combinedMs);
+}
+
+void ModbusManager::pollOnce(BusLane &lane) {
+    if (lane.bus.index() == 0) {
+        const bool mqttConnectedNow = (_mqtt != nullptr) && _mqtt->isConnected();
+        _mqttBridge.onConnectionState(mqttConnectedNow, _mqttConnectedLastLoop, _modbusRoot);
+        _mqttConnectedLastLoop = mqttConnectedNow;
+    }
+
+    // Queued commands are serviced even while polling is disabled.
+    {
+        auto guard = lane.bus.acquire();
+        if (guard) {
+            serviceCommands(lane);
+        }
+    }
 
-    if (!_bus.isActive()) {
-        IndicatorService::instance().setModbusConnected(false);
+    if (!lane.bus.isActive()) {
+        lane.answering.store(false, std::memory_order_relaxed);
+        updateIndicator();
         return;
     }
 
@@ -56,140 +248,829 @@ void ModbusManager::loop() {
     bool anyAttempted = false;
 
     const uint32_t now = millis();
-    for (auto &dev: _modbusRoot.devices) {
-        _dueScratch.clear();
-        const size_t dueCount = ModbusPollScheduler::collectDueReadDatapoints(dev, now, _dueScratch);
-        if (dueCount == 0) continue;
+    rollBusLoadWindow(lane, now);
+    lane.scheduler.takeDue(now, lane.dueBatch);
+    if (lane.lines.size() > 1) {
+        ModbusDeadlineQueue::groupByLine(lane.dueBatch, lane.deviceLine, lane.currentLine, lane.lineRank);
+    }
+    size_t runStart = 0;
+    while (runStart < lane.dueBatch.size()) {
+        const uint16_t devIndex = lane.dueBatch[runStart].device;
+        size_t runEnd = runStart;
+        lane.dueScratch.clear();
+        while (runEnd < lane.dueBatch.size() && lane.dueBatch[runEnd].device == devIndex) {
+            lane.dueScratch.push_back(&_modbusRoot.devices[devIndex].datapoints[lane.dueBatch[runEnd].datapoint]);
+            ++runEnd;
+        }
+        ModbusDevice &dev = _modbusRoot.devices[devIndex];
+        if (!dev.health.isOnline() && !probeDevice(lane, dev, *lane.dueScratch.front(), now)) {
+            // Held back: nothing goes out for this device until its next probe.
+            for (size_t i = runStart; i < runEnd; ++i) {
+                ModbusPollScheduler::deferUntil(*lane.dueScratch[i - runStart], dev.health.nextProbeAtMs());
+                lane.scheduler.requeue(lane.dueBatch[i], *lane.dueScratch[i - runStart]);
+            }
+            runStart = runEnd;
+            continue;
+        }
         anyAttempted = true;
-        anySuccess = readModbusDevice(dev, _dueScratch, now) || anySuccess;
+        anySuccess = readModbusDevice(lane, dev, lane.dueScratch, now) || anySuccess;
+        // Datapoints left unread (bus busy) keep their past deadline and are retried next pass.
+        for (size_t i = runStart; i < runEnd; ++i) {
+            lane.scheduler.requeue(lane.dueBatch[i], *lane.dueScratch[i - runStart]);
+        }
+        runStart = runEnd;
     }
     if (anyAttempted) {
-        IndicatorService::instance().setModbusConnected(anySuccess);
+        lane.answering.store(anySuccess, std::memory_order_relaxed);
+        updateIndicator();
+    }
+}
+
+void ModbusManager::updateIndicator() const {
+    bool answering = false;
+    for (const auto &lane: _lanes) {
+        answering = answering || (lane->bus.isActive() && lane->answering.load(std::memory_order_relaxed));
     }
-    if (!anySuccess) {
+    IndicatorService::instance().setModbusConnected(answering);
+}
+
+ModbusManager::BusLane *ModbusManager::laneFor(const uint8_t bus) const {
+    if (bus >= MODBUS_MAX_BUSES || bus >= _modbusRoot.busCount()) {
+        return nullptr;
     }
+    return _lanes[bus].get();
 }
 
-bool ModbusManager::readModbusDevice(ModbusDevice &dev,
+uint32_t ModbusManager::msUntilNextPoll() const {
+    const uint32_t now = millis();
+    uint32_t waitMs = UINT32_MAX;
+    for (const auto &lane: _lanes) {
+        waitMs = std::min(waitMs, lane->scheduler.msUntilNextDue(now));
+    }
+    return waitMs;
+}
+
+bool ModbusManager::readModbusDevice(BusLane &lane,
+                                     ModbusDevice &dev,
                                      const std::vector<ModbusDatapoint *> &dueDatapoints,
                                      const uint32_t now) {
-    auto guard = _bus.acquire();
+    auto guard = lane.bus.acquire();
     if (!guard) {
         return false;
     }
+    const Bus &busConfig = _modbusRoot.busAt(lane.bus.index());
+    const SerialLine &serial = lane.lines[lineOf(lane, dev)];
 
-    ModbusMaster &node = _bus.node();
-    Stream &busStream = _bus.stream();
-    node.begin(dev.slaveId, busStream);
+    lane.readRequests.clear();
+    for (const auto *dpPtr: dueDatapoints) {
+        ModbusReadRequest req{};
+        req.function = dpPtr->function;
+        req.address = dpPtr->address;
+        req.count = dpPtr->numOfRegisters ? dpPtr->numOfRegisters : 1;
+        lane.readRequests.push_back(req);
+    }
+
+    ModbusReadPlanner::plan(lane.readRequests.data(), lane.readRequests.size(), readLimits(busConfig.readMaxGap),
+                            lane.readBlocks, lane.readMembers);
 
-    uint8_t result;
     bool successOnThisDevice = false;
-    for (auto *dpPtr: dueDatapoints) {
-        if (!dpPtr) continue;
-        auto &dp = *dpPtr;
-        _logger->logDebug((String("ModbusManager::readModbusDevice - Sending Command - Func: ") +
-                           String(functionToString(dp.function)) + ", Name: " + String(dp.name) +
-                           ", Addr: " + String(dp.address) + ", Regs: " + String(dp.numOfRegisters) +
-                           ", Slave: " + String(dev.slaveId) + ", Bus: " + String(_modbusRoot.bus.baud) +
-                           "," + _modbusRoot.bus.serialFormat).c_str());
-        switch (dp.function) {
-            case READ_COIL:
-                result = node.readCoils(dp.address, dp.numOfRegisters);
-                break;
-            case READ_DISCRETE:
-                result = node.readDiscreteInputs(dp.address, dp.numOfRegisters);
-                break;
-            case READ_HOLDING:
-                result = node.readHoldingRegisters(dp.address, dp.numOfRegisters);
-                break;
-            case READ_INPUT:
-                result = node.readInputRegisters(dp.address, dp.numOfRegisters);
-                break;
-            case WRITE_COIL:
-            case WRITE_HOLDING:
-                ModbusPollScheduler::scheduleNext(dp, now);
-                continue;
-            default:
-                result = -1;
-                _logger->logError(
-                    ("ModbusManager::readRegisters - Function: " + String(dp.function) + " is not valid in this scope.")
-                    .c_str());
+    for (const auto &block: lane.readBlocks) {
+        if (!dev.health.isOnline()) {
+            // Stopped answering; the remaining blocks wait for a probe.
+            break;
         }
-        if (result == ModbusMaster::ku8MBSuccess) {
-            successOnThisDevice = true;
+        // Writes and ad-hoc reads go ahead of the next scheduled block.
+        serviceCommands(lane);
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS,
+                     "ModbusManager::readModbusDevice - Sending Command - Func: %s, Addr: %u, Regs: %u, "
+                     "Datapoints: %u, Slave: %u, Bus: %u@%lu,%s",
+                     functionToString(block.function), block.address, block.count,
+                     static_cast<unsigned>(block.memberCount), dev.slaveId, lane.bus.index(),
+                     static_cast<unsigned long>(serial.baud), serial.serialFormat.c_str());
 
-            const uint8_t wordsToRead = dp.numOfRegisters ? dp.numOfRegisters : 1;
-            std::vector<uint16_t> words(wordsToRead);
-            for (uint8_t i = 0; i < wordsToRead; ++i) {
-                words[i] = node.getResponseBuffer(i);
+        const uint32_t startedAtUs = micros();
+        const uint8_t result = readBlock(lane, dev.slaveId, block);
+        recordBusTime(lane, startedAtUs);
+        if (result == ModbusRtuStatus::Success) {
+            successOnThisDevice = true;
+            for (size_t m = 0; m < block.memberCount; ++m) {
+                ModbusDatapoint &dp = *dueDatapoints[lane.readMembers[block.firstMember + m]];
+                publishFromBlock(dev, dp, block, lane.blockBuffer, lane.payload);
             }
+        } else {
+            // Captured RX bytes for diagnostics; only dumped when logged.
+            LOGGER_ERROR(_logger, LOGMODULE_MODBUS,
+                         "Modbus ERR - %s: func=%s, addr=%u, regs=%u, datapoints=%u, slave=%u, bus=%u@%lu,%s, "
+                         "code=%u (%s)%s", dev.name.c_str(), functionToString(block.function),
+                         static_cast<unsigned>(block.address), static_cast<unsigned>(block.count),
+                         static_cast<unsigned>(block.memberCount), static_cast<unsigned>(dev.slaveId),
+                         static_cast<unsigned>(lane.bus.index()), static_cast<unsigned long>(serial.baud),
+                         serial.serialFormat.c_str(), static_cast<unsigned>(result), statusToString(result),
+                         lane.bus.dumpRx().c_str());
+            incrementBusErrorCount(lane.bus);
+        }
+        for (size_t m = 0; m < block.memberCount; ++m) {
+            lane.scheduler.recordPoll(*dueDatapoints[lane.readMembers[block.firstMember + m]], now);
+        }
+    }
+    flushSnapshot(dev);
+    return successOnThisDevice;
+}
 
-            String payload;
-            if (dp.dataType == TEXT) {
-                payload = registersToAscii(words.data(), wordsToRead);
-            } else {
-                const uint16_t primary = wordsToRead > 0 ? words[0] : 0;
-                const uint16_t sliced = sliceRegister(primary, dp.registerSlice);
-                const float value = static_cast<float>(sliced) * dp.scale;
-                payload = String(value);
+bool ModbusManager::probeDevice(BusLane &lane, ModbusDevice &dev, const ModbusDatapoint &dp, const uint32_t nowMs) {
+    if (!dev.health.probeDue(nowMs)) {
+        return false;
+    }
+    auto guard = lane.bus.acquire();
+    if (!guard) {
+        return false;
+    }
+    serviceCommands(lane);
+    if (dev.health.isOnline()) {
+        // A queued command already got an answer.
+        return true;
+    }
+
+    const ModbusRtuRequest request{dev.slaveId, static_cast<uint8_t>(dp.function), dp.address, 1, nullptr, 0, 0};
+    uint16_t count = 0;
+    const uint32_t startedAtUs = micros();
+    const uint8_t result = transact(lane, request, lane.blockBuffer, kBlockBufferWords, count);
+    recordBusTime(lane, startedAtUs);
+    LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "ModbusManager::probeDevice - %s, slave=%u, code=%u (%s), state=%s",
+                 dev.name.c_str(), dev.slaveId, result, statusToString(result),
+                 ModbusDeviceHealth::stateName(dev.health.state()));
+    return dev.health.isOnline();
+}
+
+ModbusReadPlanner::Limits ModbusManager::readLimits(const uint16_t maxGap) {
+    ModbusReadPlanner::Limits limits;
+    limits.maxRegisters = std::min<uint16_t>(ModbusReadPlanner::kMaxReadRegisters, kBlockBufferWords);
+    limits.maxBits = std::min<uint16_t>(ModbusReadPlanner::kMaxReadBits, kBlockBufferWords * 16U);
+    limits.maxGap = maxGap;
+    return limits;
+}
+
+uint16_t ModbusManager::projectBusLoad(BusLane &lane) {
+    const Bus &busConfig = _modbusRoot.busAt(lane.bus.index());
+    const ModbusReadPlanner::Limits limits = readLimits(busConfig.readMaxGap);
+
+    // Datapoints sharing an interval fall due together and are planned as one
+    // batch. Interval 0 polls take whatever time is left, so are not budgeted.
+    uint64_t busyUsPerSecond = 0;
+    for (const auto &dev: _modbusRoot.devices) {
+        if (dev.transport() != ModbusTransport::Rtu || dev.bus != lane.bus.index()) continue;
+        // Each slave is costed at its own line setting.
+        const SerialLine &serial = lane.lines[lineOf(lane, dev)];
+        const ModbusLineTiming line = ModbusBusTiming::lineTiming(serial.baud, serial.serialFormat.c_str());
+        const ModbusGuardTimes guards = ModbusBusTiming::guardTimes(line, RS485_HW_DIRECTION != 0,
+                                                                    RS485_DIR_GUARD_US);
+        ModbusTurnaround turnaround{};
+        turnaround.guardUs = guards.preUs;
+        turnaround.responseUs = MODBUS_EXPECTED_TURNAROUND_US;
+        const auto &dps = dev.datapoints;
+        for (size_t i = 0; i < dps.size(); ++i) {
+            if (!isReadOnlyFunction(dps[i].function) || dps[i].pollIntervalMs == 0) continue;
+            bool seen = false;
+            for (size_t j = 0; j < i && !seen; ++j) {
+                seen = isReadOnlyFunction(dps[j].function) && dps[j].pollIntervalMs == dps[i].pollIntervalMs;
             }
+            if (seen) continue;
 
-            String rawSummary;
-            if (dp.dataType == TEXT) {
-                rawSummary.reserve(wordsToRead * 7);
-                for (uint8_t i = 0; i < wordsToRead; ++i) {
-                    if (i > 0) rawSummary += ' ';
-                    char buf[7];
-                    snprintf(buf, sizeof(buf), "0x%04X", words[i]);
-                    rawSummary += buf;
+            lane.readRequests.clear();
+            for (size_t j = i; j < dps.size(); ++j) {
+                if (isReadOnlyFunction(dps[j].function) && dps[j].pollIntervalMs == dps[i].pollIntervalMs) {
+                    ModbusReadRequest req{};
+                    req.function = dps[j].function;
+                    req.address = dps[j].address;
+                    req.count = dps[j].numOfRegisters ? dps[j].numOfRegisters : 1;
+                    lane.readRequests.push_back(req);
                 }
+            }
+            ModbusReadPlanner::plan(lane.readRequests.data(), lane.readRequests.size(), limits, lane.readBlocks,
+                                    lane.readMembers);
+            busyUsPerSecond += ModbusBusTiming::planUs(line, turnaround, lane.readBlocks) * 1000ULL /
+                               dps[i].pollIntervalMs;
+        }
+    }
+    return ModbusBusTiming::permille(busyUsPerSecond, 1000000ULL);
+}
+
+void ModbusManager::assignLines(BusLane &lane, const Bus &busConfig) {
+    lane.lines.clear();
+    lane.lines.push_back(SerialLine{static_cast<uint32_t>(busConfig.baud), busConfig.serialFormat});
+    lane.deviceLine.assign(_modbusRoot.devices.size(), 0);
+    for (size_t d = 0; d < _modbusRoot.devices.size(); ++d) {
+        const ModbusDevice &dev = _modbusRoot.devices[d];
+        if (dev.transport() != ModbusTransport::Rtu || dev.bus != lane.bus.index()) continue;
+        const uint32_t baud = dev.baud ? dev.baud : static_cast<uint32_t>(busConfig.baud);
+        const String &format = dev.serialFormat.length() ? dev.serialFormat : busConfig.serialFormat;
+        size_t l = 0;
+        while (l < lane.lines.size() && !(lane.lines[l].baud == baud && lane.lines[l].serialFormat == format)) {
+            ++l;
+        }
+        if (l == lane.lines.size()) {
+            if (l > UINT8_MAX) {
+                LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::assignLines - too many line settings; %s uses "
+                            "the bus's", dev.name.c_str());
+                continue;
+            }
+            lane.lines.push_back(SerialLine{baud, format});
+        }
+        lane.deviceLine[d] = static_cast<uint8_t>(l);
+    }
+}
+
+uint8_t ModbusManager::lineOf(const BusLane &lane, const ModbusDevice &dev) const {
+    const size_t d = static_cast<size_t>(&dev - _modbusRoot.devices.data());
+    return d < lane.deviceLine.size() ? lane.deviceLine[d] : 0;
+}
+
+void ModbusManager::selectLine(BusLane &lane, const uint8_t line) {
+    if (line == lane.currentLine || line >= lane.lines.size()) {
+        return;
+    }
+    if (lane.bus.setLine(lane.lines[line].baud, lane.lines[line].serialFormat)) {
+        lane.lineSwitches.fetch_add(1, std::memory_order_relaxed);
+    }
+    lane.currentLine = line;
+}
+
+void ModbusManager::recordBusTime(BusLane &lane, const uint32_t startedAtUs) {
+    lane.busBusyUs.fetch_add(micros() - startedAtUs, std::memory_order_relaxed);
+}
+
+void ModbusManager::rollBusLoadWindow(BusLane &lane, const uint32_t nowMs) {
+    const uint32_t elapsedMs = nowMs - lane.busLoadWindowStartMs;
+    if (elapsedMs < kBusLoadWindowMs) {
+        return;
+    }
+    const uint32_t busyUs = lane.busBusyUs.exchange(0, std::memory_order_relaxed);
+    lane.measuredLoadPermille.store(ModbusBusTiming::permille(busyUs, static_cast<uint64_t>(elapsedMs) * 1000ULL),
+                                    std::memory_order_relaxed);
+    lane.busLoadWindowStartMs = nowMs;
+}
+
+ModbusBusLoad ModbusManager::getBusLoad() const {
+    ModbusBusLoad load{};
+    for (const auto &lane: _lanes) {
+        load.projectedPermille = std::max(load.projectedPermille, lane->projectedLoadPermille);
+        load.measuredPermille = std::max(load.measuredPermille,
+                                         lane->measuredLoadPermille.load(std::memory_order_relaxed));
+        load.lineSwitches += lane->lineSwitches.load(std::memory_order_relaxed);
+    }
+    return load;
+}
+
+uint8_t ModbusManager::readBlock(BusLane &lane, const uint8_t slaveId, const ModbusReadBlock &block) {
+    if (!isReadOnlyFunction(block.function)) {
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusManager::readBlock - Function: %u is not valid in this scope.",
+                     static_cast<unsigned>(block.function));
+        return ModbusRtuStatus::IllegalFunction;
+    }
+    const ModbusRtuRequest request{slaveId, static_cast<uint8_t>(block.function), block.address, block.count, nullptr,
+                                   0, 0};
+    uint16_t count = 0;
+    return transact(lane, request, lane.blockBuffer, kBlockBufferWords, count);
+}
+
+uint8_t ModbusManager::transact(BusLane &lane,
+                                const ModbusRtuRequest &request,
+                                uint16_t *outWords,
+                                const uint16_t outCapacity,
+                                uint16_t &outCount) {
+    ModbusDevice *dev = findDeviceBySlaveId(lane.bus.index(), request.slaveId);
+    // A slave the configuration does not know is addressed at the bus's setting.
+    selectLine(lane, dev ? lineOf(lane, *dev) : 0);
+    ModbusTimeoutEstimator *timing = dev ? &dev->responseTiming : nullptr;
+    for (uint8_t attempt = 0;; ++attempt) {
+        const uint32_t timeoutUs = timing
+                                       ? timing->timeoutUs(MODBUS_MIN_RESPONSE_TIMEOUT_MS * 1000UL,
+                                                           MODBUS_RESPONSE_TIMEOUT_MS * 1000UL)
+                                       : MODBUS_RESPONSE_TIMEOUT_MS * 1000UL;
+        uint32_t turnaroundUs = ModbusRtuMaster::kNoResponse;
+        const uint8_t status = lane.bus.transact(request, timeoutUs, outWords, outCapacity, outCount, turnaroundUs);
+        if (status == ModbusRtuStatus::Success) {
+            // Only what was actually delivered: registers, or bits packed 16 to a word.
+            const bool bits = ModbusReadPlanner::isBitFunction(static_cast<ModbusFunctionType>(request.function));
+            const uint32_t delivered = bits ? outCount * 16UL : outCount;
+            const auto items = static_cast<uint16_t>(std::min<uint32_t>(request.count, delivered));
+            xSemaphoreTake(_shadowMutex, portMAX_DELAY);
+            if (request.function == 23) {
+                // The slave writes before it reads, so the answer is current.
+                lane.shadow.invalidate(request.slaveId, request.function, request.writeAddress, request.writeCount);
+                lane.shadow.store(request.slaveId, READ_HOLDING, request.address, items, outWords, millis());
+            } else if (request.function <= 4) {
+                lane.shadow.store(request.slaveId, request.function, request.address, items, outWords, millis());
             } else {
-                const uint16_t primary = wordsToRead > 0 ? words[0] : 0;
-                rawSummary = String(primary);
+                // FC05/FC06 touch one item whatever count says.
+                lane.shadow.invalidate(request.slaveId, request.function, request.address,
+                                   request.function >= 15 ? request.count : 1);
             }
+            xSemaphoreGive(_shadowMutex);
+        }
+        if (timing) {
+            if (status == ModbusRtuStatus::ResponseTimedOut) {
+                timing->recordTimeout();
+            } else if (turnaroundUs != ModbusRtuMaster::kNoResponse && status < ModbusRtuStatus::InvalidSlaveId) {
+                // Only a well-formed answer (data or an exception) says how
+                // fast this slave is.
+                timing->record(turnaroundUs);
+            }
+            noteHealth(*dev, status);
+        }
+        if (!shouldRetryTransaction(status, attempt)) {
+            return status;
+        }
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "ModbusManager::transact - CRC error from slave %u, retrying",
+                     request.slaveId);
+    }
+}
+
+bool ModbusManager::readShadow(const uint8_t bus,
+                               const uint8_t slaveId,
+                               const uint8_t function,
+                               const uint16_t address,
+                               const uint16_t count,
+                               const uint32_t maxAgeMs,
+                               uint16_t *outWords,
+                               const uint16_t outCapacity,
+                               uint16_t &outCount) const {
+    const BusLane *lane = laneFor(bus);
+    if (!lane) {
+        outCount = 0;
+        _shadowMisses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    xSemaphoreTake(_shadowMutex, portMAX_DELAY);
+    const bool hit = lane->shadow.lookup(slaveId, function, address, count, millis(), maxAgeMs, outWords,
+                                         outCapacity, outCount);
+    xSemaphoreGive(_shadowMutex);
+    (hit ? _shadowHits : _shadowMisses).fetch_add(1, std::memory_order_relaxed);
+    return hit;
+}
+
+ModbusReadCacheStats ModbusManager::getReadCacheStats() const {
+    ModbusReadCacheStats stats{};
+    stats.hits = _shadowHits.load(std::memory_order_relaxed);
+    stats.misses = _shadowMisses.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ModbusPublishStats ModbusManager::getPublishStats() const {
+    ModbusPublishStats stats{};
+    stats.published = _publishedValues.load(std::memory_order_relaxed);
+    stats.suppressed = _suppressedValues.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ModbusDevice *ModbusManager::findDeviceBySlaveId(const uint8_t bus, const uint8_t slaveId) {
+    for (auto &dev: _modbusRoot.devices) {
+        if (dev.transport() == ModbusTransport::Rtu && dev.bus == bus && dev.slaveId == slaveId) {
+            return &dev;
+        }
+    }
+    return nullptr;
+}
 
-            _logger->logDebug(("Modbus OK - " + String(dev.name) + ": " + String(dp.name) +
-                               " = " + payload + " (raw=" + rawSummary + ")").c_str());
-            _mqttBridge.publishDatapoint(dev, dp, payload);
+void ModbusManager::noteHealth(ModbusDevice &dev, const uint8_t status) {
+    const bool wasAvailable = dev.health.isAvailable();
+    bool changed = false;
+    if (status < ModbusRtuStatus::InvalidSlaveId) {
+        // Data or an exception: either way the slave is there.
+        changed = dev.health.recordAnswer();
+    } else if (status == ModbusRtuStatus::ResponseTimedOut || !dev.health.isOnline()) {
+        // A garbled frame does not count against an online slave, but it
+        // does not answer a probe either.
+        changed = dev.health.recordTimeout(millis());
+    }
+    if (!changed) {
+        return;
+    }
+    const ModbusHealthState state = dev.health.state();
+    if (state == ModbusHealthState::Online) {
+        LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager - device %s (slave %u) is %s", dev.name.c_str(),
+                    static_cast<unsigned>(dev.slaveId), ModbusDeviceHealth::stateName(state));
+    } else {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager - device %s (slave %u) is %s, next probe in %lums",
+                    dev.name.c_str(), static_cast<unsigned>(dev.slaveId), ModbusDeviceHealth::stateName(state),
+                    static_cast<unsigned long>(dev.health.probeDelayMs()));
+    }
+    if (dev.health.isAvailable() != wasAvailable) {
+        _mqttBridge.onAvailabilityChanged(dev);
+    }
+}
+
+void ModbusManager::publishFromBlock(ModbusDevice &dev,
+                                     ModbusDatapoint &dp,
+                                     const ModbusReadBlock &block,
+                                     const uint16_t *blockWords,
+                                     char *payload) {
+    const uint16_t wordsToRead = std::min<uint16_t>(dp.numOfRegisters ? dp.numOfRegisters : 1, kBlockBufferWords);
+    const uint16_t offset = static_cast<uint16_t>(dp.address - block.address);
+
+    uint16_t words[kBlockBufferWords]{};
+    if (ModbusReadPlanner::isBitFunction(dp.function)) {
+        // A standalone coil read returns the bits packed from bit 0; rebuild
+        // that layout so single-coil datapoints still see 0/1 in words[0].
+        ModbusReadPlanner::extractBits(blockWords, offset, wordsToRead, words);
+    } else {
+        for (uint16_t i = 0; i < wordsToRead && offset + i < kBlockBufferWords; ++i) {
+            words[i] = blockWords[offset + i];
+        }
+    }
+
+    double value = 0.0;
+    size_t textLength = 0;
+    if (dp.decode) {
+        value = dp.decode(words) * dp.scale;
+        ModbusValueDecoder::formatValue(value, payload, kPayloadChars);
+    } else {
+        textLength = ModbusValueDecoder::formatText(words, wordsToRead, payload, kPayloadChars);
+    }
+
+    if (_logger->enabled(LOGLEVEL_DEBUG, LOGMODULE_MODBUS)) {
+        // The registers behind the value; cut short for long text.
+        char raw[64];
+        raw[0] = '\0';
+        const bool text = dp.dataType == TEXT;
+        const uint16_t shown = text ? wordsToRead
+                                    : std::min<uint16_t>(ModbusValueDecoder::registerCount(dp.dataType), wordsToRead);
+        size_t used = 0;
+        for (uint16_t i = 0; i < shown && used < sizeof(raw); ++i) {
+            const int n = snprintf(raw + used, sizeof(raw) - used, text ? "%s0x%04X" : "%s%u", i ? " " : "",
+                                   static_cast<unsigned>(words[i]));
+            if (n < 0) break;
+            used += static_cast<size_t>(n);
+        }
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "Modbus OK - %s: %s = %s (raw=%s)", dev.name.c_str(), dp.name.c_str(),
+                     payload, raw);
+    }
+
+    const uint32_t nowMs = millis();
+    const bool publish = dp.decode ? dp.publishFilter.shouldPublish(value, nowMs)
+                                   : dp.publishFilter.shouldPublishText(payload, textLength, nowMs);
+    if (!publish) {
+        _suppressedValues.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (dev.snapshotEnabled) {
+        // Goes out with the rest of the cycle from flushSnapshot().
+        if (dev.snapshot.entries.empty()) {
+            dev.snapshot.startedAtMs = nowMs;
+        }
+        _mqttBridge.addToSnapshot(dev, dp, value, payload);
+        dev.snapshot.entries.push_back({static_cast<uint16_t>(&dp - dev.datapoints.data()), value});
+        return;
+    }
+    if (_mqttBridge.publishDatapoint(dev, dp, payload)) {
+        dp.publishFilter.published(value, nowMs);
+        _publishedValues.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ModbusManager::flushSnapshot(ModbusDevice &dev) {
+    if (dev.snapshot.entries.empty()) {
+        return;
+    }
+    if (_mqttBridge.publishSnapshot(dev)) {
+        const uint32_t nowMs = millis();
+        for (const auto &entry: dev.snapshot.entries) {
+            dev.datapoints[entry.datapoint].publishFilter.published(entry.value, nowMs);
+        }
+        _publishedValues.fetch_add(dev.snapshot.entries.size(), std::memory_order_relaxed);
+    }
+    dev.snapshot.fields = "";
+    dev.snapshot.entries.clear();
+}
+
+bool ModbusManager::startTcpTask() {
+    const BaseType_t result = xTaskCreatePinnedToCore(
+        tcpTaskRunner,
+        "ModbusTcpPoll",
+        MODBUS_TASK_STACK,
+        this,
+        MODBUS_TCP_TASK_PRIORITY,
+        &_tcpTaskHandle,
+        1
+    );
+    return result == pdPASS;
+}
+
+[[noreturn]] void ModbusManager::tcpTaskRunner(void *param) {
+    auto *self = static_cast<ModbusManager *>(param);
+    for (;;) {
+        xSemaphoreTake(self->_tcpMutex, portMAX_DELAY);
+        self->tcpPollOnce();
+        const uint32_t waitMs = self->tcpPollWaitMs();
+        xSemaphoreGive(self->_tcpMutex);
+
+        const TickType_t ticks = pdMS_TO_TICKS(waitMs);
+        ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1);
+    }
+}
+
+uint32_t ModbusManager::tcpPollWaitMs() const {
+    if (!_tcpActive.load(std::memory_order_acquire) || _tcpConnections.empty()) {
+        return MODBUS_TASK_MAX_WAIT_MS;
+    }
+    for (const auto &connection: _tcpConnections) {
+        if (connection.outstanding()) {
+            return MODBUS_TCP_SERVICE_MS;
+        }
+    }
+    return std::min(_tcpScheduler.msUntilNextDue(millis()), MODBUS_TASK_MAX_WAIT_MS);
+}
+
+void ModbusManager::assignTcpConnections() {
+    for (auto &connection: _tcpConnections) {
+        connection.close();
+    }
+    _tcpConnections.clear();
+    for (auto &dev: _modbusRoot.devices) {
+        if (dev.transport() != ModbusTransport::Tcp) continue;
+        size_t c = 0;
+        while (c < _tcpConnections.size() && !_tcpConnections[c].matches(dev.host, dev.port)) {
+            ++c;
+        }
+        if (c == _tcpConnections.size()) {
+            _tcpConnections.emplace_back(dev.host, dev.port);
+        }
+        dev.tcpConnection = static_cast<uint8_t>(c);
+    }
+    _tcpInFlight.clear();
+    _tcpInFlight.resize(_tcpConnections.size() * ModbusTcpPipeline::kMaxOutstanding);
+}
+
+void ModbusManager::tcpPollOnce() {
+    if (_tcpConnections.empty() || !_tcpActive.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const uint32_t now = millis();
+    for (uint8_t c = 0; c < _tcpConnections.size(); ++c) {
+        serviceTcpConnection(c, now);
+    }
+
+    _tcpScheduler.takeDue(now, _tcpDueBatch);
+    size_t runStart = 0;
+    while (runStart < _tcpDueBatch.size()) {
+        const uint16_t devIndex = _tcpDueBatch[runStart].device;
+        size_t runEnd = runStart;
+        _tcpDueScratch.clear();
+        while (runEnd < _tcpDueBatch.size() && _tcpDueBatch[runEnd].device == devIndex) {
+            _tcpDueScratch.push_back(&_modbusRoot.devices[devIndex].datapoints[_tcpDueBatch[runEnd].datapoint]);
+            ++runEnd;
+        }
+        const ModbusDevice &dev = _modbusRoot.devices[devIndex];
+        if (!dev.health.isOnline() && (!dev.health.probeDue(now) || tcpProbeInFlight(devIndex))) {
+            // Held back until the next probe, or until the one on the wire
+            // is answered.
+            const uint32_t until = dev.health.probeDue(now) ? now + dev.health.probeDelayMs()
+                                                            : dev.health.nextProbeAtMs();
+            for (auto *dp: _tcpDueScratch) {
+                ModbusPollScheduler::deferUntil(*dp, until);
+            }
         } else {
-            // Dump captured RX bytes for diagnostics
-            const String rxDump = _bus.dumpRx();
-            _logger->logError((String("Modbus ERR - ") + String(dev.name) +
-                               ": func=" + functionToString(dp.function) +
-                               ", addr=" + String(dp.address) +
-                               ", regs=" + String(dp.numOfRegisters) +
-                               ", slave=" + String(dev.slaveId) +
-                               ", bus=" + String(_modbusRoot.bus.baud) + "," + _modbusRoot.bus.serialFormat +
-                               ", code=" + String(result) + " (" + statusToString(result) + ")" + rxDump).c_str());
-            incrementBusErrorCount();
-        }
-        ModbusPollScheduler::scheduleNext(dp, now);
+            sendTcpReads(devIndex, _tcpDueScratch, now);
+        }
+        // Datapoints left unsent (window full) keep their past deadline and
+        // go out on the next pass.
+        for (size_t i = runStart; i < runEnd; ++i) {
+            _tcpScheduler.requeue(_tcpDueBatch[i], *_tcpDueScratch[i - runStart]);
+        }
+        runStart = runEnd;
+    }
+}
+
+void ModbusManager::serviceTcpConnection(const uint8_t connection, const uint32_t nowMs) {
+    ModbusTcpConnection &link = _tcpConnections[connection];
+    TcpInFlight *flights = &_tcpInFlight[connection * ModbusTcpPipeline::kMaxOutstanding];
+
+    ModbusTcpResponse response{};
+    uint8_t slot = ModbusTcpPipeline::kNone;
+    while (link.receive(response, _tcpWords, kBlockBufferWords, slot)) {
+        TcpInFlight &flight = flights[slot];
+        if (!flight.used) continue;
+        flight.used = false;
+        ModbusDevice &dev = _modbusRoot.devices[flight.device];
+
+        uint8_t status = response.status;
+        const uint16_t wordsNeeded = ModbusReadPlanner::isBitFunction(flight.block.function)
+                                         ? static_cast<uint16_t>((flight.block.count + 15U) / 16U)
+                                         : flight.block.count;
+        if (response.unitId != dev.slaveId) {
+            status = ModbusRtuStatus::InvalidSlaveId;
+        } else if (response.function != flight.block.function ||
+                   (status == ModbusRtuStatus::Success && response.count < wordsNeeded)) {
+            status = ModbusRtuStatus::InvalidFunction;
+        }
+        if (status < ModbusRtuStatus::InvalidSlaveId) {
+            dev.responseTiming.record(micros() - flight.sentAtUs);
+        }
+        noteHealth(dev, status);
+
+        if (status == ModbusRtuStatus::Success) {
+            for (auto *dp: flight.members) {
+                publishFromBlock(dev, *dp, flight.block, _tcpWords, _tcpPayload);
+            }
+        } else {
+            LOGGER_ERROR(_logger, LOGMODULE_MODBUS,
+                         "Modbus TCP ERR - %s: func=%s, addr=%u, regs=%u, unit=%u, host=%s:%u, code=%u (%s)",
+                         dev.name.c_str(), functionToString(flight.block.function),
+                         static_cast<unsigned>(flight.block.address), static_cast<unsigned>(flight.block.count),
+                         static_cast<unsigned>(dev.slaveId), link.host().c_str(), static_cast<unsigned>(link.port()),
+                         static_cast<unsigned>(status), statusToString(status));
+        }
+    }
+    // Answers that arrived together make up one snapshot.
+    for (auto &dev: _modbusRoot.devices) {
+        if (dev.transport() == ModbusTransport::Tcp && dev.tcpConnection == connection) {
+            flushSnapshot(dev);
+        }
+    }
+
+    // Expired requests, or every one still outstanding once the socket is gone.
+    while ((slot = link.takeFailed(nowMs)) != ModbusTcpPipeline::kNone) {
+        TcpInFlight &flight = flights[slot];
+        if (!flight.used) continue;
+        flight.used = false;
+        ModbusDevice &dev = _modbusRoot.devices[flight.device];
+        dev.responseTiming.recordTimeout();
+        noteHealth(dev, ModbusRtuStatus::ResponseTimedOut);
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS,
+                     "ModbusManager::serviceTcpConnection - no answer from %s at %s:%u, addr=%u", dev.name.c_str(),
+                     link.host().c_str(), link.port(), flight.block.address);
+    }
+}
+
+void ModbusManager::sendTcpReads(const uint16_t devIndex,
+                                 const std::vector<ModbusDatapoint *> &dueDatapoints,
+                                 const uint32_t nowMs) {
+    ModbusDevice &dev = _modbusRoot.devices[devIndex];
+    ModbusTcpConnection &link = _tcpConnections[dev.tcpConnection];
+    if (!link.ensureConnected(nowMs)) {
+        // An unreachable server counts as a slave that did not answer.
+        noteHealth(dev, ModbusRtuStatus::ResponseTimedOut);
+        for (auto *dp: dueDatapoints) {
+            _tcpScheduler.recordPoll(*dp, nowMs);
+        }
+        return;
+    }
+
+    _tcpReadRequests.clear();
+    for (const auto *dpPtr: dueDatapoints) {
+        ModbusReadRequest req{};
+        req.function = dpPtr->function;
+        req.address = dpPtr->address;
+        req.count = dpPtr->numOfRegisters ? dpPtr->numOfRegisters : 1;
+        _tcpReadRequests.push_back(req);
+    }
+    ModbusReadPlanner::plan(_tcpReadRequests.data(), _tcpReadRequests.size(), readLimits(0), _tcpReadBlocks,
+                            _tcpReadMembers);
+
+    const uint32_t timeoutMs = (dev.responseTiming.timeoutUs(MODBUS_MIN_RESPONSE_TIMEOUT_MS * 1000UL,
+                                                             MODBUS_RESPONSE_TIMEOUT_MS * 1000UL) + 999UL) / 1000UL;
+    for (size_t b = 0; b < _tcpReadBlocks.size(); ++b) {
+        const ModbusReadBlock &block = _tcpReadBlocks[b];
+        if (!dev.health.isOnline() && b > 0) {
+            // A held-back device gets one block as its probe.
+            for (size_t m = 0; m < block.memberCount; ++m) {
+                ModbusPollScheduler::deferUntil(*dueDatapoints[_tcpReadMembers[block.firstMember + m]],
+                                                nowMs + dev.health.probeDelayMs());
+            }
+            continue;
+        }
+        if (link.full()) {
+            break;
+        }
+
+        ModbusTcpRequest request{};
+        request.unitId = dev.slaveId;
+        request.function = static_cast<uint8_t>(block.function);
+        request.address = block.address;
+        request.count = block.count;
+        const uint8_t slot = link.send(request, nowMs, timeoutMs);
+        if (slot == ModbusTcpPipeline::kNone) {
+            break;
+        }
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS,
+                     "ModbusManager::sendTcpReads - Func: %s, Addr: %u, Regs: %u, Datapoints: %u, Unit: %u, "
+                     "Host: %s:%u",
+                     functionToString(block.function), block.address, block.count,
+                     static_cast<unsigned>(block.memberCount), dev.slaveId, link.host().c_str(), link.port());
+
+        TcpInFlight &flight = _tcpInFlight[dev.tcpConnection * ModbusTcpPipeline::kMaxOutstanding + slot];
+        flight.used = true;
+        flight.device = devIndex;
+        flight.block = block;
+        flight.sentAtUs = micros();
+        flight.members.clear();
+        for (size_t m = 0; m < block.memberCount; ++m) {
+            ModbusDatapoint *dp = dueDatapoints[_tcpReadMembers[block.firstMember + m]];
+            flight.members.push_back(dp);
+            _tcpScheduler.recordPoll(*dp, nowMs);
+        }
     }
-    return successOnThisDevice;
 }
 
-bool ModbusManager::reconfigureFromFile() {
-    _logger->logInformation("ModbusManager::reconfigureFromFile - begin");
-    // Stop regular loop polling
-    _bus.setActive(false);
+bool ModbusManager::tcpProbeInFlight(const uint16_t devIndex) const {
+    for (const auto &flight: _tcpInFlight) {
+        if (flight.used && flight.device == devIndex) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ModbusReloadResult ModbusManager::reconfigureFromFile() {
+    LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager::reconfigureFromFile - begin");
+    // Stop the polling tasks from starting new reads
+    bool wasActive[MODBUS_MAX_BUSES];
+    for (uint8_t i = 0; i < MODBUS_MAX_BUSES; ++i) {
+        wasActive[i] = _lanes[i]->bus.isActive();
+        _lanes[i]->bus.setActive(false);
+    }
     // Wait briefly if a read is in progress
     for (int i = 0; i < 50; ++i) {
-        if (!_bus.isBusy()) break;
+        bool busy = false;
+        for (const auto &lane: _lanes) {
+            busy = busy || lane->bus.isBusy();
+        }
+        if (!busy) break;
         delay(5);
     }
 
+    if (!pausePolling(pdMS_TO_TICKS(MODBUS_PAUSE_WAIT_MS))) {
+        for (uint8_t i = 0; i < MODBUS_MAX_BUSES; ++i) {
+            _lanes[i]->bus.setActive(wasActive[i]);
+        }
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::reconfigureFromFile - polling did not pause within "
+                    "%ums; configuration not applied", static_cast<unsigned>(MODBUS_PAUSE_WAIT_MS));
+        wake();
+        return ModbusReloadResult::Busy;
+    }
     const bool ok = loadConfiguration();
+    _tcpActive.store(ok, std::memory_order_release);
     if (ok) {
-        _bus.begin(_modbusRoot.bus);
-        _bus.setActive(_modbusRoot.bus.enabled);
-        _logger->logInformation(_modbusRoot.bus.enabled
-            ? "ModbusManager::reconfigureFromFile - applied and active"
-            : "ModbusManager::reconfigureFromFile - applied and inactive");
+        for (uint8_t i = 0; i < _modbusRoot.busCount() && i < MODBUS_MAX_BUSES; ++i) {
+            BusLane &lane = *_lanes[i];
+            const Bus &busConfig = _modbusRoot.busAt(i);
+            if (!lane.pollTaskHandle && !startPollTask(lane)) {
+                LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusManager::reconfigureFromFile - failed to start polling "
+                             "task for RS485 bus %u", static_cast<unsigned>(i));
+            }
+            lane.bus.begin(busConfig);
+            lane.currentLine = 0;
+            lane.bus.setActive(busConfig.enabled);
+            LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusManager::reconfigureFromFile - RS485 bus %u applied and %s",
+                        static_cast<unsigned>(i), busConfig.enabled ? "active" : "inactive");
+        }
     } else {
-        _bus.setActive(false);
-        _logger->logError("ModbusManager::reconfigureFromFile - failed to load config; bus inactive");
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusManager::reconfigureFromFile - failed to load config; bus inactive");
+    }
+    resumePolling();
+    wake();
+    return ok ? ModbusReloadResult::Applied : ModbusReloadResult::Invalid;
+}
+
+bool ModbusManager::refreshMqttTopics() {
+    // The polling tasks publish with the topic table; pause them for the swap.
+    if (!pausePolling(pdMS_TO_TICKS(MODBUS_PAUSE_WAIT_MS))) {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::refreshMqttTopics - polling did not pause within %ums; "
+                    "topics not refreshed", static_cast<unsigned>(MODBUS_PAUSE_WAIT_MS));
+        return false;
+    }
+    _mqttBridge.onRootTopicChanged(_modbusRoot);
+    resumePolling();
+    return true;
+}
+
+bool ModbusManager::pausePolling(const TickType_t wait) {
+    // One budget for all the mutexes, not one each.
+    const TickType_t startTicks = xTaskGetTickCount();
+    const auto remaining = [&]() -> TickType_t {
+        if (wait == portMAX_DELAY) return portMAX_DELAY;
+        const TickType_t spent = xTaskGetTickCount() - startTicks;
+        return spent < wait ? wait - spent : 0;
+    };
+    uint8_t held = 0;
+    while (held < MODBUS_MAX_BUSES && xSemaphoreTake(_lanes[held]->pollMutex, remaining()) == pdTRUE) {
+        ++held;
+    }
+    if (held == MODBUS_MAX_BUSES && xSemaphoreTake(_tcpMutex, remaining()) == pdTRUE) {
+        return true;
+    }
+    while (held > 0) {
+        xSemaphoreGive(_lanes[--held]->pollMutex);
+    }
+    return false;
+}
+
+void ModbusManager::resumePolling() {
+    xSemaphoreGive(_tcpMutex);
+    for (auto &lane: _lanes) {
+        xSemaphoreGive(lane->pollMutex);
     }
-    return ok;
 }
 
 auto ModbusManager::statusToString(const uint8_t code) -> const char * {
@@ -216,7 +1097,9 @@ auto ModbusManager::functionToString(const ModbusFunctionType fn) -> const char
         case READ_INPUT: return "FC04-READ_INPUT";
         case WRITE_COIL: return "FC05-WRITE_COIL";
         case WRITE_HOLDING: return "FC06-WRITE_HOLDING";
+        case WRITE_MULTIPLE_COILS: return "FC15-WRITE_MULTIPLE_COILS";
         case WRITE_MULTIPLE_HOLDING: return "FC16-WRITE_MULTIPLE_HOLDING";
+        case READ_WRITE_MULTIPLE: return "FC23-READ_WRITE_MULTIPLE";
         default: return "FC-UNKNOWN";
     }
 }
@@ -237,97 +1120,272 @@ const ConfigurationRoot &ModbusManager::getConfiguration() const {
     return _modbusRoot;
 }
 
-uint8_t ModbusManager::executeCommand(const uint8_t slaveId,
+namespace {
+
+// Hand-off between executeCommand() on the caller's task and the command's
+// completion on the polling task. The caller may stop waiting before the
+// command completes, so it lives on the heap and the reply lands in words,
+// not in the caller's buffer.
+struct SyncCommand {
+    SemaphoreHandle_t done;
+    ModbusCommandReply reply;
+    String rxDump;
+    uint16_t words[ModbusRtuMaster::kMaxWords];
+    // The waiter and the completion; the last to let go frees it.
+    std::atomic<uint8_t> holders;
+};
+
+void releaseSyncCommand(SyncCommand *wait) {
+    if (wait->holders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        vSemaphoreDelete(wait->done);
+        delete wait;
+    }
+}
+
+void completeSyncCommand(void *context, const ModbusCommand &, const ModbusCommandResult &result) {
+    auto *wait = static_cast<SyncCommand *>(context);
+    wait->reply.capture(result);
+    wait->rxDump = result.rxDump ? result.rxDump : "";
+    xSemaphoreGive(wait->done);
+    releaseSyncCommand(wait);
+}
+
+} // namespace
+
+uint8_t ModbusManager::executeCommand(const uint8_t bus,
+                                      const uint8_t slaveId,
                                       const int function,
                                       const uint16_t addr,
                                       const uint16_t len,
-                                      const uint16_t writeValue,
-                                      const bool hasWriteValue,
+                                      const uint16_t *writeValues,
+                                      const uint16_t writeCount,
+                                      const uint16_t writeAddr,
                                       uint16_t *outBuf,
                                       const uint16_t outBufCap,
                                       uint16_t &outCount,
-                                      String &rxDump) {
+                                      String &rxDump,
+                                      const uint32_t maxAgeMs) {
 
-    _logger->logDebug("Execute called");
+    LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "Execute called");
     outCount = 0;
     rxDump = "";
-    const bool expectedWrite = (function == 5 || function == 6 || function == 16);
-    if (expectedWrite && !hasWriteValue) {
-        _logger->logError("hasWriteValue is false");
-        return ModbusMaster::ku8MBIllegalDataValue;
-    }
+    const bool expectedWrite = isWriteFunction(static_cast<ModbusFunctionType>(function));
     const bool expectedRead = (function >= 1 && function <= 4);
     if (!expectedRead && !expectedWrite) {
-        _logger->logError("function out of range");
-        return ModbusMaster::ku8MBIllegalFunction;
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "function out of range");
+        return ModbusRtuStatus::IllegalFunction;
+    }
+    if (expectedWrite) {
+        // Words the function takes from writeValues.
+        const uint16_t needed = function == 15 ? static_cast<uint16_t>((len + 15U) / 16U)
+                              : function == 16 ? len
+                              : function == 23 ? writeCount
+                              : 1;
+        if (!writeValues || needed == 0 || writeCount < needed || needed > ModbusCommand::kMaxValues) {
+            LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "write values missing or too many");
+            return ModbusRtuStatus::IllegalDataValue;
+        }
+    }
+    if (expectedRead && maxAgeMs > 0 && outBuf &&
+        readShadow(bus, slaveId, static_cast<uint8_t>(function), addr, len, maxAgeMs, outBuf, outBufCap, outCount)) {
+        return ModbusRtuStatus::Success;
+    }
+    BusLane *lane = laneFor(bus);
+    if (!lane) {
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "bus out of range");
+        return ModbusRtuStatus::IllegalDataValue;
     }
-    const uint16_t effectiveLen = (function == 16) ? 1 : len;
 
-    if (!_bus.isInitialized()) {
-        if (_modbusRoot.bus.baud == 0) {
-            _modbusRoot.bus.baud = DEFAULT_MODBUS_BAUD_RATE;
-            _modbusRoot.bus.serialFormat = DEFAULT_MODBUS_MODE;
+    ModbusCommand command{};
+    command.bus = bus;
+    command.slaveId = slaveId;
+    command.function = static_cast<uint8_t>(function);
+    command.address = addr;
+    command.count = (function == 5 || function == 6) ? 1 : len;
+    command.writeAddress = writeAddr;
+    command.writeCount = function == 23 ? writeCount : 0;
+    if (expectedWrite) {
+        const uint16_t n = writeCount < ModbusCommand::kMaxValues ? writeCount : ModbusCommand::kMaxValues;
+        for (uint16_t i = 0; i < n; ++i) {
+            command.values[i] = writeValues[i];
         }
-        _bus.begin(_modbusRoot.bus);
     }
+    command.submittedAtMs = millis();
 
-    auto guard = _bus.acquire();
-    if (!guard) {
-        return 0xE4; // busy
+    const bool wantsWords = (expectedRead || function == 23) && outBuf;
+
+    // Without a polling task to hand off to (or when called from it), run
+    // on the caller's task.
+    if (!lane->pollTaskHandle || xTaskGetCurrentTaskHandle() == lane->pollTaskHandle) {
+        auto guard = lane->bus.acquire();
+        if (!guard) {
+            return ModbusRtuStatus::Busy;
+        }
+        uint16_t count = 0;
+        const uint8_t status = runCommand(*lane, command, count);
+        const String dump = lane->bus.dumpRx();
+        const ModbusCommandResult result{status, static_cast<uint32_t>(millis() - command.submittedAtMs),
+                                         lane->commandWords, count, dump.c_str()};
+        ModbusCommandReply reply{wantsWords ? outBuf : nullptr, outBufCap, 0, ModbusRtuStatus::Busy};
+        reply.capture(result);
+        outCount = reply.outCount;
+        rxDump = dump;
+        return reply.status;
     }
 
-    _bus.enableCapture(true);
+    auto *wait = new SyncCommand();
+    wait->done = xSemaphoreCreateBinary();
+    if (!wait->done) {
+        delete wait;
+        return ModbusRtuStatus::Busy;
+    }
+    wait->reply.outWords = wantsWords ? wait->words : nullptr;
+    wait->reply.outCapacity = outBufCap < ModbusRtuMaster::kMaxWords ? outBufCap : ModbusRtuMaster::kMaxWords;
+    wait->reply.status = ModbusRtuStatus::Busy;
+    wait->holders.store(2, std::memory_order_relaxed);
+    command.onComplete = completeSyncCommand;
+    command.context = wait;
+    const ModbusCommandPriority priority = expectedWrite ? ModbusCommandPriority::Write
+                                                         : ModbusCommandPriority::Read;
+    if (!submitCommand(command, priority)) {
+        vSemaphoreDelete(wait->done);
+        delete wait;
+        return ModbusRtuStatus::Busy;
+    }
+    if (xSemaphoreTake(wait->done, pdMS_TO_TICKS(MODBUS_COMMAND_WAIT_MS)) != pdTRUE) {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::executeCommand - FC%u to slave %u on bus %u did not "
+                    "complete within %ums; answering busy", static_cast<unsigned>(function),
+                    static_cast<unsigned>(slaveId), static_cast<unsigned>(bus),
+                    static_cast<unsigned>(MODBUS_COMMAND_WAIT_MS));
+        releaseSyncCommand(wait);
+        return ModbusRtuStatus::Busy;
+    }
+    const ModbusCommandReply &reply = wait->reply;
+    for (uint16_t i = 0; i < reply.outCount; ++i) {
+        outBuf[i] = wait->words[i];
+    }
+    outCount = reply.outCount;
+    rxDump = wait->rxDump;
+    const uint8_t status = reply.status;
+    releaseSyncCommand(wait);
+    return status;
+}
 
-    ModbusMaster &node = _bus.node();
-    Stream &busStream = _bus.stream();
-    node.begin(slaveId, busStream);
+bool ModbusManager::submitCommand(const ModbusCommand &command, const ModbusCommandPriority priority) {
+    BusLane *lane = laneFor(command.bus);
+    if (!lane) {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::submitCommand - no RS485 bus %u",
+                    static_cast<unsigned>(command.bus));
+        return false;
+    }
+    const uint32_t nowMs = millis();
+    xSemaphoreTake(lane->commandMutex, portMAX_DELAY);
+    bool queued = priority == ModbusCommandPriority::Write && command.combineMs > 0 &&
+                  lane->combiner.hold(command, nowMs, command.combineMs);
+    if (!queued) {
+        // Writes already held for the slave go out ahead of this one.
+        lane->combiner.expedite(command.slaveId, nowMs);
+        queued = lane->commands.push(command, priority);
+    }
+    xSemaphoreGive(lane->commandMutex);
+    if (queued) {
+        if (lane->pollTaskHandle) {
+            xTaskNotifyGive(lane->pollTaskHandle);
+        }
+    } else {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusManager::submitCommand - command queue full");
+    }
+    return queued;
+}
 
-    uint8_t status;
-    switch (function) {
-        case 1: status = node.readCoils(addr, effectiveLen);
-            break;
-        case 2: status = node.readDiscreteInputs(addr, effectiveLen);
-            break;
-        case 3: status = node.readHoldingRegisters(addr, effectiveLen);
-            break;
-        case 4: status = node.readInputRegisters(addr, effectiveLen);
-            break;
-        case 5: {
-            const uint16_t v = writeValue ? 0xFF00 : 0x0000;
-            node.beginTransmission(addr);
-            node.send(v);
-            status = node.writeSingleCoil(addr, v);
+bool ModbusManager::hasPendingCommands(const BusLane &lane) const {
+    xSemaphoreTake(lane.commandMutex, portMAX_DELAY);
+    const bool pending = !lane.commands.empty() || lane.combiner.msUntilDue(millis()) == 0;
+    xSemaphoreGive(lane.commandMutex);
+    return pending;
+}
+
+uint32_t ModbusManager::msUntilCombinedWrite(const BusLane &lane) const {
+    xSemaphoreTake(lane.commandMutex, portMAX_DELAY);
+    const uint32_t waitMs = lane.combiner.msUntilDue(millis());
+    xSemaphoreGive(lane.commandMutex);
+    return waitMs;
+}
+
+bool ModbusManager::serviceCommands(BusLane &lane) {
+    bool ran = false;
+    for (;;) {
+        ModbusCommand command{};
+        xSemaphoreTake(lane.commandMutex, portMAX_DELAY);
+        const bool combined = lane.combiner.takeDue(millis(), command);
+        const bool popped = combined || lane.commands.pop(command);
+        xSemaphoreGive(lane.commandMutex);
+        if (!popped) {
             break;
         }
-        case 6: {
-            node.beginTransmission(addr);
-            node.send(writeValue);
-            status = node.writeSingleRegister(addr, writeValue);
-            break;
+
+        uint16_t count = 0;
+        const uint8_t status = runCommand(lane, command, count);
+        const String rxDump = lane.bus.dumpRx();
+        ran = true;
+        if (!combined) {
+            const ModbusCommandResult result{status, static_cast<uint32_t>(millis() - command.submittedAtMs),
+                                             lane.commandWords, count, rxDump.c_str()};
+            if (command.onComplete) {
+                command.onComplete(command.context, command, result);
+            }
+            continue;
         }
-        case 16: {
-            _logger->logDebug(("Execute F16 on addr: " + String(addr) + " with Data: " + String(writeValue)).c_str());
-            node.setTransmitBuffer(0, writeValue);
-            status = node.writeMultipleRegisters(addr, effectiveLen);
-            break;
+
+        // Each write that went into the transaction hears back once all of
+        // its registers have been sent.
+        xSemaphoreTake(lane.commandMutex, portMAX_DELAY);
+        const size_t finished = lane.combiner.complete(status, lane.combined);
+        xSemaphoreGive(lane.commandMutex);
+        for (size_t i = 0; i < finished; ++i) {
+            const ModbusCommand &original = lane.combined[i].command;
+            const ModbusCommandResult result{lane.combined[i].status,
+                                             static_cast<uint32_t>(millis() - original.submittedAtMs),
+                                             nullptr, 0, rxDump.c_str()};
+            if (original.onComplete) {
+                original.onComplete(original.context, original, result);
+            }
         }
-        default:
-            status = ModbusMaster::ku8MBIllegalFunction;
-            break;
     }
+    return ran;
+}
 
-    if (status == ModbusMaster::ku8MBSuccess && expectedRead && outBuf && outBufCap > 0) {
-        const uint16_t n = (effectiveLen < outBufCap) ? effectiveLen : outBufCap;
-        for (uint16_t i = 0; i < n; ++i) {
-            outBuf[i] = node.getResponseBuffer(i);
+uint8_t ModbusManager::runCommand(BusLane &lane, const ModbusCommand &command, uint16_t &outCount) {
+    outCount = 0;
+
+    if (!lane.bus.isInitialized()) {
+        Bus &busConfig = lane.bus.index() == 0 ? _modbusRoot.bus : _modbusRoot.additionalBuses[lane.bus.index() - 1];
+        if (busConfig.baud == 0) {
+            busConfig.baud = DEFAULT_MODBUS_BAUD_RATE;
+            busConfig.serialFormat = DEFAULT_MODBUS_MODE;
         }
-        outCount = n;
+        lane.bus.begin(busConfig);
+        lane.currentLine = 0;
     }
 
-    rxDump = _bus.dumpRx();
+    lane.bus.enableCapture(true);
 
-    if (status != ModbusMaster::ku8MBSuccess) {
-        incrementBusErrorCount();
+    if (isWriteFunction(static_cast<ModbusFunctionType>(command.function))) {
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "Execute %s on addr: %u, first value: %u",
+                     functionToString(static_cast<ModbusFunctionType>(command.function)),
+                     command.function == 23 ? command.writeAddress : command.address, command.values[0]);
+    }
+    const ModbusRtuRequest request{command.slaveId, command.function, command.address, command.count,
+                                   command.values, command.writeAddress, command.writeCount};
+    const bool isRead = command.function <= 4 || command.function == 23;
+
+    const uint32_t startedAtUs = micros();
+    const uint8_t status = transact(lane, request, isRead ? lane.commandWords : nullptr, kBlockBufferWords,
+                                    outCount);
+    recordBusTime(lane, startedAtUs);
+
+    if (status != ModbusRtuStatus::Success) {
+        incrementBusErrorCount(lane.bus);
     }
 
     return status;
@@ -380,9 +1438,107 @@ String ModbusManager::registersToAscii(const uint16_t *buf, const uint16_t count
     return out;
 }
 
-void ModbusManager::incrementBusErrorCount() {
-    _bus.incrementError();
-    _logger->logDebug(("Total errors: " + String(getBusErrorCount())).c_str());
+namespace {
+
+String stripBrackets(const String &list) {
+    if (list.startsWith("[") && list.endsWith("]")) {
+        String inner = list.substring(1, list.length() - 1);
+        inner.trim();
+        return inner;
+    }
+    return list;
+}
+
+// Steps through a comma separated list; false once it is exhausted.
+bool nextToken(const String &list, int &from, String &token) {
+    if (from > static_cast<int>(list.length())) {
+        return false;
+    }
+    int end = list.indexOf(',', from);
+    if (end < 0) {
+        end = static_cast<int>(list.length());
+    }
+    token = list.substring(from, end);
+    token.trim();
+    from = end + 1;
+    return true;
+}
+
+} // namespace
+
+uint16_t ModbusManager::coilsFromPayload(const String &payload, const uint16_t coils, uint16_t *words,
+                                         const uint16_t capacity) {
+    const String list = stripBrackets(payload);
+    const uint32_t maxCoils = 16UL * capacity;
+    for (uint16_t i = 0; i < capacity; ++i) {
+        words[i] = 0;
+    }
+    if (list.indexOf(',') < 0) {
+        if (coils == 0 || coils > maxCoils) {
+            return 0;
+        }
+        const bool all = list.equalsIgnoreCase("true");
+        const bool none = list.equalsIgnoreCase("false");
+        const auto mask = static_cast<uint32_t>(list.toInt());
+        for (uint16_t i = 0; i < coils; ++i) {
+            if (all || (!none && i < 32 && ((mask >> i) & 1U))) {
+                words[i / 16U] |= static_cast<uint16_t>(1U << (i % 16U));
+            }
+        }
+        return coils;
+    }
+    uint16_t count = 0;
+    int from = 0;
+    String token;
+    while (nextToken(list, from, token)) {
+        const bool on = token.equalsIgnoreCase("true") || token == "1";
+        if (count >= maxCoils || (!on && !token.equalsIgnoreCase("false") && token != "0")) {
+            return 0;
+        }
+        if (on) {
+            words[count / 16U] |= static_cast<uint16_t>(1U << (count % 16U));
+        }
+        ++count;
+    }
+    return count;
+}
+
+uint16_t ModbusManager::registersFromPayload(const String &payload,
+                                             const ModbusDataType dataType,
+                                             const ModbusWordOrder order,
+                                             const float scale,
+                                             const uint16_t textRegisters,
+                                             uint16_t *words,
+                                             const uint16_t capacity) {
+    if (dataType == TEXT) {
+        if (textRegisters == 0 || textRegisters > capacity || payload.length() > 2U * textRegisters) {
+            return 0;
+        }
+        for (uint16_t i = 0; i < textRegisters; ++i) {
+            const unsigned hi = 2U * i < payload.length() ? static_cast<uint8_t>(payload[2U * i]) : 0U;
+            const unsigned lo = 2U * i + 1U < payload.length() ? static_cast<uint8_t>(payload[2U * i + 1U]) : 0U;
+            words[i] = static_cast<uint16_t>((hi << 8U) | lo);
+        }
+        return textRegisters;
+    }
+    const String list = stripBrackets(payload);
+    const uint8_t width = ModbusValueDecoder::registerCount(dataType);
+    const double denom = (scale == 0.0f) ? 1.0 : static_cast<double>(scale);
+    uint16_t count = 0;
+    int from = 0;
+    String token;
+    while (nextToken(list, from, token)) {
+        if (!token.length() || count + width > capacity) {
+            return 0;
+        }
+        count += ModbusValueDecoder::encode(dataType, order, token.toDouble() / denom, words + count);
+    }
+    return count;
+}
+
+void ModbusManager::incrementBusErrorCount(ModbusBus &bus) {
+    bus.incrementError();
+    LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "Total errors: %lu", static_cast<unsigned long>(getBusErrorCount()));
 }
 
 uint32_t ModbusManager::getBusErrorCount() {
@@ -391,8 +1547,10 @@ uint32_t ModbusManager::getBusErrorCount() {
 
 void ModbusManager::setModbusEnabled(const bool enabled) {
     ModbusBus::setEnabled(enabled);
+    _tcpActive.store(enabled, std::memory_order_release);
+    wake();
 }
 
-bool ModbusManager::getBusState() {
-    return ModbusBus::isEnabled();
+bool ModbusManager::getBusState() const {
+    return ModbusBus::isEnabled() || _tcpActive.load(std::memory_order_acquire);
 }
@@ -0,0 +1,64 @@
+#include "logging/LogLevelSettings.h"
+
+#include <Preferences.h>
+#include <cstring>
+
+namespace {
+    constexpr auto kPrefsNamespace = "log";
+
+    constexpr const char *kModuleNames[] = {"core", "modbus", "mqtt", "web"};
+    constexpr const char *kLevelNames[] = {"debug", "info", "warn", "error"};
+
+    static_assert(sizeof(kModuleNames) / sizeof(kModuleNames[0]) == LOGMODULE_COUNT, "kModuleNames size mismatch");
+}
+
+Logger *LogLevelSettings::s_logger = nullptr;
+
+void LogLevelSettings::begin(Logger *logger) {
+    s_logger = logger;
+    Preferences prefs;
+    if (!prefs.begin(kPrefsNamespace, true)) {
+        return;
+    }
+    for (int m = 0; m < LOGMODULE_COUNT; ++m) {
+        const auto module = static_cast<LogModule>(m);
+        const uint8_t stored = prefs.getUChar(moduleName(module), LOGLEVEL_DEBUG);
+        if (stored <= LOGLEVEL_ERROR) {
+            s_logger->setModuleLevel(module, static_cast<LogLevel>(stored));
+        }
+    }
+    prefs.end();
+}
+
+LogLevel LogLevelSettings::get(const LogModule module) {
+    return s_logger ? s_logger->moduleLevel(module) : LOGLEVEL_DEBUG;
+}
+
+void LogLevelSettings::set(const LogModule module, const LogLevel level) {
+    if (!s_logger || module >= LOGMODULE_COUNT || s_logger->moduleLevel(module) == level) return;
+    s_logger->setModuleLevel(module, level);
+    Preferences prefs;
+    if (prefs.begin(kPrefsNamespace, false)) {
+        prefs.putUChar(moduleName(module), static_cast<uint8_t>(level));
+        prefs.end();
+    }
+}
+
+const char *LogLevelSettings::moduleName(const LogModule module) {
+    return module < LOGMODULE_COUNT ? kModuleNames[module] : "";
+}
+
+const char *LogLevelSettings::levelName(const LogLevel level) {
+    return level <= LOGLEVEL_ERROR ? kLevelNames[level] : "";
+}
+
+bool LogLevelSettings::parseLevel(const char *name, LogLevel &out) {
+    if (!name) return false;
+    for (int l = LOGLEVEL_DEBUG; l <= LOGLEVEL_ERROR; ++l) {
+        if (std::strcmp(name, kLevelNames[l]) == 0) {
+            out = static_cast<LogLevel>(l);
+            return true;
+        }
+    }
+    return false;
+}
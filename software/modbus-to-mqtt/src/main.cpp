@@ -12,6 +12,7 @@
 #include "services/ota/HttpOtaService.h"
 #include <esp_system.h>
 
+#include "logging/LogLevelSettings.h"
 #include "logging/MemoryLogger.h"
 
 #ifndef FW_VERSION
@@ -52,6 +53,7 @@ void setup() {
     setupEnvironment();
     logger.addTarget(&serial_logger);
     logger.addTarget(&memory_logger);
+    LogLevelSettings::begin(&logger);
     logger.logDebug("setup() - logger initialized");
 
     // Abnormal reset banner for UI visibility
@@ -103,7 +105,6 @@ void setup() {
 
 void loop() {
     MBXServer::loop();
-    modbus_manager.loop();
 #if OTA_HTTP_ENABLED
     HttpOtaService::loop();
 #endif
@@ -1,12 +1,19 @@
 #include "modbus/ModbusBus.h"
 
 #include <map>
+#include <driver/uart.h>
 
 #include "Config.h"
 #include "Logger.h"
 
 using SerialModeMap = std::map<String, uint32_t>;
 static const SerialModeMap kSerialModes = {
+    {"7N1", SERIAL_7N1},
+    {"7N2", SERIAL_7N2},
+    {"7E1", SERIAL_7E1},
+    {"7E2", SERIAL_7E2},
+    {"7O1", SERIAL_7O1},
+    {"7O2", SERIAL_7O2},
     {"8N1", SERIAL_8N1},
     {"8N2", SERIAL_8N2},
     {"8E1", SERIAL_8E1},
@@ -15,7 +22,16 @@ static const SerialModeMap kSerialModes = {
     {"8O2", SERIAL_8O2}
 };
 
-ModbusBus *ModbusBus::s_instance = nullptr;
+ModbusBus *ModbusBus::s_instances[MODBUS_MAX_BUSES] = {};
+
+static HardwareSerial &serialForBus(const uint8_t index) {
+#if MODBUS_MAX_BUSES > 1
+    if (index == 1) {
+        return Serial2;
+    }
+#endif
+    return Serial1;
+}
 
 ModbusBus::Guard::Guard(ModbusBus &bus, const bool owns)
     : _bus(&bus), _owns(owns) {
@@ -46,10 +62,37 @@ ModbusBus::Guard::~Guard() {
     }
 }
 
-ModbusBus::ModbusBus(Logger *logger) : _logger(logger) {
-    s_instance = this;
-    _node.preTransmission(preTransmitTrampoline);
-    _node.postTransmission(postTransmitTrampoline);
+namespace {
+
+struct Transaction {
+    bool done;
+    uint8_t status;
+    uint16_t *out;
+    uint16_t capacity;
+    uint16_t count;
+};
+
+void completeTransaction(void *context, const uint8_t status, const uint16_t *words, const uint16_t count) {
+    auto *t = static_cast<Transaction *>(context);
+    t->status = status;
+    t->count = 0;
+    if (t->out) {
+        t->count = count < t->capacity ? count : t->capacity;
+        for (uint16_t i = 0; i < t->count; ++i) {
+            t->out[i] = words[i];
+        }
+    }
+    t->done = true;
+}
+
+} // namespace
+
+ModbusBus::ModbusBus(Logger *logger, const uint8_t index)
+    : _logger(logger), _index(index), _serial(serialForBus(index)) {
+    if (index < MODBUS_MAX_BUSES) {
+        s_instances[index] = this;
+    }
+    _master.setPort(this);
 }
 
 bool ModbusBus::begin(const Bus &busConfig) {
@@ -58,6 +101,31 @@ bool ModbusBus::begin(const Bus &busConfig) {
     return true;
 }
 
+bool ModbusBus::setLine(const uint32_t baud, const String &serialFormat) {
+    const uint32_t mode = serialMode(serialFormat);
+    const uint32_t effectiveBaud = baud ? baud : DEFAULT_MODBUS_BAUD_RATE;
+    if (effectiveBaud == _baud && mode == _mode) {
+        return false;
+    }
+    // The transaction before has completed (the shift register is empty), so
+    // nothing on the wire is cut short. Arduino's SERIAL_* constants carry
+    // the IDF word length, parity and stop-bit values in their low bits.
+    const auto port = static_cast<uart_port_t>(_index + 1);
+    if (effectiveBaud != _baud) {
+        _serial.updateBaudRate(effectiveBaud);
+    }
+    if (mode != _mode) {
+        uart_set_word_length(port, static_cast<uart_word_length_t>((mode >> 2) & 0x3U));
+        uart_set_parity(port, static_cast<uart_parity_t>(mode & 0x3U));
+        uart_set_stop_bits(port, static_cast<uart_stop_bits_t>((mode >> 4) & 0x3U));
+    }
+    applyLineTiming(effectiveBaud, serialFormat);
+    _serial.setRxTimeout(ModbusBusTiming::idleSymbols(_line));
+    _baud = effectiveBaud;
+    _mode = mode;
+    return true;
+}
+
 auto ModbusBus::acquire() -> Guard {
     bool expected = false;
     if (!_busy.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
@@ -66,15 +134,40 @@ auto ModbusBus::acquire() -> Guard {
     return Guard(*this, true);
 }
 
-ModbusMaster &ModbusBus::node() {
-    return _node;
+uint8_t ModbusBus::transact(const ModbusRtuRequest &request,
+                            const uint32_t responseTimeoutUs,
+                            uint16_t *outWords,
+                            const uint16_t outCapacity,
+                            uint16_t &outCount,
+                            uint32_t &turnaroundUs) {
+    outCount = 0;
+    turnaroundUs = ModbusRtuMaster::kNoResponse;
+    Transaction transaction{false, ModbusRtuStatus::Busy, outWords, outCapacity, 0};
+    _master.setResponseTimeoutUs(responseTimeoutUs);
+    _waiter.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+    const uint8_t accepted = _master.start(request, micros(), completeTransaction, &transaction);
+    if (accepted != ModbusRtuStatus::Success) {
+        _waiter.store(nullptr, std::memory_order_release);
+        return accepted;
+    }
+    for (;;) {
+        const uint32_t waitUs = _master.poll(micros());
+        if (transaction.done) {
+            break;
+        }
+        waitForLine(waitUs);
+    }
+    _waiter.store(nullptr, std::memory_order_release);
+    outCount = transaction.count;
+    turnaroundUs = _master.lastTurnaroundUs();
+    return transaction.status;
 }
 
 Stream &ModbusBus::stream() {
     if (_tee) {
         return *_tee;
     }
-    return Serial1;
+    return _serial;
 }
 
 bool ModbusBus::isActive() const {
@@ -104,20 +197,34 @@ String ModbusBus::dumpRx() const {
     return String();
 }
 
+uint8_t ModbusBus::index() const {
+    return _index;
+}
+
 uint32_t ModbusBus::getErrorCount() {
-    if (s_instance == nullptr) {
-        return 0;
+    uint32_t total = 0;
+    for (const auto *bus: s_instances) {
+        if (bus) {
+            total += bus->errorCount();
+        }
     }
-    return s_instance->errorCount();
+    return total;
 }
 
 bool ModbusBus::isEnabled() {
-    return s_instance != nullptr && s_instance->isActive();
+    for (const auto *bus: s_instances) {
+        if (bus && bus->isActive()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void ModbusBus::setEnabled(const bool enabled) {
-    if (s_instance != nullptr) {
-        s_instance->setActive(enabled);
+    for (auto *bus: s_instances) {
+        if (bus) {
+            bus->setActive(enabled);
+        }
     }
 }
 
@@ -131,44 +238,125 @@ void ModbusBus::enableCapture(const bool enable) {
     }
 }
 
-void ModbusBus::initializeWiring(const Bus &busConfig) {
-    pinMode(RS485_DERE_PIN, OUTPUT);
-    digitalWrite(RS485_DERE_PIN, LOW);
+const ModbusLineTiming &ModbusBus::lineTiming() const {
+    return _line;
+}
+
+const ModbusGuardTimes &ModbusBus::guardTimes() const {
+    return _guards;
+}
+
+uint32_t ModbusBus::serialMode(const String &serialFormat) {
+    const auto formatIt = kSerialModes.find(serialFormat);
+    return (formatIt != kSerialModes.end()) ? formatIt->second : SERIAL_8N1;
+}
+
+void ModbusBus::applyLineTiming(const uint32_t baud, const String &serialFormat) {
+    _line = ModbusBusTiming::lineTiming(baud, serialFormat.c_str());
+    _guards = ModbusBusTiming::guardTimes(_line, RS485_HW_DIRECTION != 0, RS485_DIR_GUARD_US);
+    _master.setLineTiming(_line);
+}
 
-    const auto formatIt = kSerialModes.find(busConfig.serialFormat);
-    const uint32_t mode = (formatIt != kSerialModes.end()) ? formatIt->second : SERIAL_8N1;
+void ModbusBus::initializeWiring(const Bus &busConfig) {
+    const uint32_t mode = serialMode(busConfig.serialFormat);
     const uint32_t baud = busConfig.baud ? busConfig.baud : DEFAULT_MODBUS_BAUD_RATE;
 
-    Serial1.begin(baud, mode, RX2, TX2);
+    applyLineTiming(baud, busConfig.serialFormat);
+    _baud = baud;
+    _mode = mode;
+
+    // Only the first bus has board wiring to fall back on.
+    const bool boardWiring = _index == 0;
+    const int8_t rx = busConfig.rxPin >= 0 ? busConfig.rxPin : (boardWiring ? RX2 : -1);
+    const int8_t tx = busConfig.txPin >= 0 ? busConfig.txPin : (boardWiring ? TX2 : -1);
+    _dePin = busConfig.dePin >= 0 ? busConfig.dePin : (boardWiring ? RS485_DERE_PIN : -1);
+
+#if RS485_HW_DIRECTION
+    _serial.begin(baud, mode, rx, tx);
+    // The UART asserts RTS (DE/RE) for exactly the duration of each frame.
+    _serial.setPins(rx, tx, -1, _dePin);
+    if (!_serial.setMode(UART_MODE_RS485_HALF_DUPLEX) && _logger) {
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusBus::initializeWiring - failed to enable RS485 half-duplex mode");
+    }
+#else
+    if (_dePin >= 0) {
+        pinMode(_dePin, OUTPUT);
+        digitalWrite(_dePin, LOW);
+    }
+
+    _serial.begin(baud, mode, rx, tx);
+#endif
+    // Only the RX-timeout (idle line) event calls back, so a response is
+    // handed over once the slave stops sending rather than byte by byte.
+    _serial.setRxTimeout(ModbusBusTiming::idleSymbols(_line));
+    _serial.onReceive([this]() { onLineIdle(); }, true);
 
     if (!_tee) {
-        _tee = new TeeStream(Serial1, _logger);
+        _tee = new TeeStream(_serial, _logger);
     }
     _tee->enableCapture(true);
 }
 
-void ModbusBus::onPreTransmission() {
-    digitalWrite(RS485_DERE_PIN, HIGH);
+int ModbusBus::available() {
+    return stream().available();
+}
+
+int ModbusBus::read() {
+    return stream().read();
+}
+
+size_t ModbusBus::readAvailable(uint8_t *dst, const size_t capacity) {
+    if (_tee) {
+        return _tee->readAvailable(dst, capacity);
+    }
+    const int avail = _serial.available();
+    if (avail <= 0) {
+        return 0;
+    }
+    return _serial.read(dst, static_cast<size_t>(avail) < capacity ? static_cast<size_t>(avail) : capacity);
+}
+
+bool ModbusBus::takeLineIdle() {
+    return _lineIdle.exchange(false, std::memory_order_acq_rel);
+}
+
+void ModbusBus::transmit(const uint8_t *frame, const size_t length) {
+#if !RS485_HW_DIRECTION
+    if (_dePin >= 0) digitalWrite(_dePin, HIGH);
+#endif
     if (_tee) _tee->enableCapture(false);
-    delayMicroseconds(RS485_DIR_GUARD_US);
+    if (_guards.preUs) delayMicroseconds(_guards.preUs);
+    _lineIdle.store(false, std::memory_order_release);
+    _serial.write(frame, length);
 }
 
-void ModbusBus::onPostTransmission() {
-    Serial1.flush();
-    digitalWrite(RS485_DERE_PIN, LOW);
+bool ModbusBus::transmitDone() {
+    // Zero-tick poll of the shift register, where flush() would wait.
+    if (uart_wait_tx_done(static_cast<uart_port_t>(_index + 1), 0) != ESP_OK) {
+        return false;
+    }
+#if !RS485_HW_DIRECTION
+    if (_dePin >= 0) digitalWrite(_dePin, LOW);
+#endif
     if (_tee) _tee->enableCapture(true);
-    delayMicroseconds(RS485_DIR_GUARD_US);
+    if (_guards.postUs) delayMicroseconds(_guards.postUs);
+    return true;
 }
 
-void ModbusBus::preTransmitTrampoline() {
-    if (s_instance) {
-        s_instance->onPreTransmission();
+void ModbusBus::waitForLine(const uint32_t waitUs) {
+    const uint32_t tickUs = portTICK_PERIOD_MS * 1000UL;
+    if (waitUs >= tickUs) {
+        ulTaskNotifyTake(pdTRUE, waitUs / tickUs);
+    } else {
+        delayMicroseconds(waitUs);
     }
 }
 
-void ModbusBus::postTransmitTrampoline() {
-    if (s_instance) {
-        s_instance->onPostTransmission();
+void ModbusBus::onLineIdle() {
+    _lineIdle.store(true, std::memory_order_release);
+    TaskHandle_t waiter = _waiter.load(std::memory_order_acquire);
+    if (waiter) {
+        xTaskNotifyGive(waiter);
     }
 }
 
@@ -0,0 +1,112 @@
+#include "modbus/ModbusBusTiming.h"
+
+constexpr uint8_t ModbusBusTiming::kMaxIdleSymbols;
+
+ModbusLineTiming ModbusBusTiming::lineTiming(const uint32_t baud, const char *serialFormat) {
+    uint32_t dataBits = 8;
+    uint32_t parityBits = 0;
+    uint32_t stopBits = 1;
+    if (serialFormat && serialFormat[0] >= '5' && serialFormat[0] <= '8' && serialFormat[1] && serialFormat[2]) {
+        dataBits = static_cast<uint32_t>(serialFormat[0] - '0');
+        const char parity = serialFormat[1];
+        parityBits = (parity == 'E' || parity == 'e' || parity == 'O' || parity == 'o') ? 1 : 0;
+        stopBits = (serialFormat[2] == '2') ? 2 : 1;
+    }
+    const uint32_t bitsPerChar = 1 + dataBits + parityBits + stopBits;
+    const uint32_t safeBaud = baud ? baud : 9600;
+
+    ModbusLineTiming t{};
+    t.charUs = static_cast<uint32_t>((static_cast<uint64_t>(bitsPerChar) * 1000000ULL + safeBaud - 1) / safeBaud);
+    // Modbus over serial line spec: fixed 1.75 ms above 19200 baud.
+    t.interFrameUs = safeBaud > 19200 ? 1750U : (t.charUs * 7U + 1U) / 2U;
+    return t;
+}
+
+ModbusGuardTimes ModbusBusTiming::guardTimes(const ModbusLineTiming &line,
+                                             const bool hardwareDirection,
+                                             const uint32_t settleUs) {
+    ModbusGuardTimes g{};
+    g.interFrameUs = line.interFrameUs;
+    g.preUs = hardwareDirection ? 0 : settleUs;
+    g.postUs = hardwareDirection ? 0 : settleUs;
+    return g;
+}
+
+uint32_t ModbusBusTiming::silenceToWaitUs(const uint32_t interFrameUs, const uint32_t idleUs) {
+    return idleUs >= interFrameUs ? 0 : interFrameUs - idleUs;
+}
+
+uint8_t ModbusBusTiming::idleSymbols(const ModbusLineTiming &line) {
+    if (line.charUs == 0) {
+        return kMaxIdleSymbols;
+    }
+    const uint32_t symbols = (line.interFrameUs + line.charUs - 1U) / line.charUs;
+    if (symbols < 1U) return 1;
+    return symbols > kMaxIdleSymbols ? kMaxIdleSymbols : static_cast<uint8_t>(symbols);
+}
+
+uint16_t ModbusBusTiming::requestBytes(const ModbusFunctionType function, const uint16_t count) {
+    switch (function) {
+        case WRITE_MULTIPLE_COILS:
+            return static_cast<uint16_t>(9U + (count + 7U) / 8U);
+        case WRITE_MULTIPLE_HOLDING:
+            // id, fc, addr(2), qty(2), byte count, data, crc(2)
+            return static_cast<uint16_t>(9U + 2U * count);
+        case READ_WRITE_MULTIPLE:
+            // Only the read half is known from count; assume an equal write.
+            return static_cast<uint16_t>(13U + 2U * count);
+        case READ_COIL:
+        case READ_DISCRETE:
+        case READ_HOLDING:
+        case READ_INPUT:
+        case WRITE_COIL:
+        case WRITE_HOLDING:
+        default:
+            return 8;
+    }
+}
+
+uint16_t ModbusBusTiming::responseBytes(const ModbusFunctionType function, const uint16_t count) {
+    switch (function) {
+        case READ_COIL:
+        case READ_DISCRETE:
+            // id, fc, byte count, packed bits, crc(2)
+            return static_cast<uint16_t>(5U + (count + 7U) / 8U);
+        case READ_HOLDING:
+        case READ_INPUT:
+        case READ_WRITE_MULTIPLE:
+            return static_cast<uint16_t>(5U + 2U * count);
+        case WRITE_COIL:
+        case WRITE_HOLDING:
+        case WRITE_MULTIPLE_COILS:
+        case WRITE_MULTIPLE_HOLDING:
+        default:
+            return 8;
+    }
+}
+
+uint32_t ModbusBusTiming::transactionUs(const ModbusLineTiming &line,
+                                        const ModbusTurnaround &turnaround,
+                                        const ModbusFunctionType function,
+                                        const uint16_t count) {
+    const uint32_t chars = static_cast<uint32_t>(requestBytes(function, count)) + responseBytes(function, count);
+    return chars * line.charUs + 2U * turnaround.guardUs + turnaround.responseUs + line.interFrameUs;
+}
+
+uint64_t ModbusBusTiming::planUs(const ModbusLineTiming &line,
+                                 const ModbusTurnaround &turnaround,
+                                 const std::vector<ModbusReadBlock> &blocks) {
+    uint64_t total = 0;
+    for (const auto &block: blocks) {
+        total += transactionUs(line, turnaround, block.function, block.count);
+    }
+    return total;
+}
+
+uint16_t ModbusBusTiming::permille(const uint64_t busyUs, const uint64_t windowUs) {
+    if (windowUs == 0) {
+        return busyUs ? UINT16_MAX : 0;
+    }
+    const uint64_t p = busyUs * 1000ULL / windowUs;
+    return static_cast<uint16_t>(p > UINT16_MAX ? UINT16_MAX : p);
+}
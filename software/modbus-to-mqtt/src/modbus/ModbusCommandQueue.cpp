@@ -0,0 +1,56 @@
+#include "modbus/ModbusCommandQueue.h"
+
+constexpr uint16_t ModbusCommand::kMaxValues;
+constexpr size_t ModbusCommandQueue::kLaneCapacity;
+
+void ModbusCommandReply::capture(const ModbusCommandResult &result) {
+    status = result.status;
+    outCount = 0;
+    if (!outWords || !result.words) {
+        return;
+    }
+    const uint16_t n = result.count < outCapacity ? result.count : outCapacity;
+    for (uint16_t i = 0; i < n; ++i) {
+        outWords[i] = result.words[i];
+    }
+    outCount = n;
+}
+
+bool ModbusCommandQueue::push(const ModbusCommand &command, const ModbusCommandPriority priority) {
+    const auto index = static_cast<size_t>(priority);
+    if (index >= static_cast<size_t>(ModbusCommandPriority::Count)) {
+        return false;
+    }
+    Lane &lane = _lanes[index];
+    if (lane.count >= kLaneCapacity) {
+        return false;
+    }
+    lane.items[(lane.head + lane.count) % kLaneCapacity] = command;
+    ++lane.count;
+    return true;
+}
+
+bool ModbusCommandQueue::pop(ModbusCommand &out) {
+    for (auto &lane: _lanes) {
+        if (lane.count == 0) {
+            continue;
+        }
+        out = lane.items[lane.head];
+        lane.head = (lane.head + 1) % kLaneCapacity;
+        --lane.count;
+        return true;
+    }
+    return false;
+}
+
+size_t ModbusCommandQueue::size() const {
+    size_t total = 0;
+    for (const auto &lane: _lanes) {
+        total += lane.count;
+    }
+    return total;
+}
+
+bool ModbusCommandQueue::empty() const {
+    return size() == 0;
+}
@@ -3,34 +3,37 @@
 
 #include "modbus/ModbusConfigLoader.h"
 #include "Config.h"
+#include "modbus/ModbusFunctionUtils.h"
+#include "modbus/ModbusValueDecoder.h"
 #include "modbus/config_structs/ModbusDatapoint.h"
 #include "utils/StringUtils.h"
 
+#include <utility>
+
 bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, ConfigurationRoot &outConfig) {
     if (!path || !*path) path = ConfigFs::kModbusConfigFile;
 
     if (!ConfigFS.exists(path)) {
         if (logger) {
-            logger->logDebug(
-                (String("Configuration file not found '") + String(ConfigFs::kBasePath) + path + "'").c_str());
+            LOGGER_DEBUG(logger, LOGMODULE_MODBUS, "Configuration file not found '%s%s'", ConfigFs::kBasePath, path);
         }
         // fallback to defaults
         outConfig.bus.baud = DEFAULT_MODBUS_BAUD_RATE;
         outConfig.bus.serialFormat = DEFAULT_MODBUS_MODE;
+        outConfig.additionalBuses.clear();
         outConfig.devices.clear();
         return false;
     }
 
     if (logger) {
-        logger->logDebug((String("Found configuration file '") + String(ConfigFs::kBasePath) + path + "'").c_str());
+        LOGGER_DEBUG(logger, LOGMODULE_MODBUS, "Found configuration file '%s%s'", ConfigFs::kBasePath, path);
     }
 
     File f = ConfigFS.open(path, FILE_READ);
     if (!f) {
         if (logger) {
-            logger->logError(
-                (String("ModbusConfigLoader::loadConfiguration - Failed to open ") +
-                 String(ConfigFs::kBasePath) + path).c_str());
+            LOGGER_ERROR(logger, LOGMODULE_MODBUS, "ModbusConfigLoader::loadConfiguration - Failed to open %s%s",
+                         ConfigFs::kBasePath, path);
         }
         return false;
     }
@@ -40,7 +43,10 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
     JsonDocument doc;
     const DeserializationError err = deserializeJson(doc, json);
     if (err) {
-        if (logger) logger->logError((String("ModbusConfigLoader::loadConfiguration - JSON parse error: ") + err.c_str()).c_str());
+        if (logger) {
+            LOGGER_ERROR(logger, LOGMODULE_MODBUS, "ModbusConfigLoader::loadConfiguration - JSON parse error: %s",
+                         err.c_str());
+        }
         return false;
     }
 
@@ -52,7 +58,9 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
             case 4: return READ_INPUT;
             case 5: return WRITE_COIL;
             case 6: return WRITE_HOLDING;
+            case 15: return WRITE_MULTIPLE_COILS;
             case 16: return WRITE_MULTIPLE_HOLDING;
+            case 23: return READ_WRITE_MULTIPLE;
             default: return READ_HOLDING;
         }
     };
@@ -100,18 +108,82 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
         }
         return RegisterSlice::Full;
     };
+    auto parsePollPriority = [](const JsonVariant &v) -> ModbusPollPriority {
+        if (v.is<const char *>()) {
+            String s = v.as<const char *>();
+            s.toLowerCase();
+            if (s == "fast") return ModbusPollPriority::Fast;
+        }
+        return ModbusPollPriority::Slow;
+    };
+
+    auto parseDeadbandType = [](const JsonVariant &v) -> ModbusDeadbandType {
+        if (v.is<const char *>()) {
+            String s = v.as<const char *>();
+            s.toLowerCase();
+            if (s == "percent") return ModbusDeadbandType::Percent;
+        }
+        return ModbusDeadbandType::Absolute;
+    };
 
     // bus
     const JsonObject bus = doc["bus"].as<JsonObject>();
     if (bus.isNull()) {
-        if (logger) logger->logWarning("ModbusConfigLoader::loadConfiguration - missing 'bus' object; using defaults");
+        if (logger) {
+            LOGGER_WARN(logger, LOGMODULE_MODBUS,
+                        "ModbusConfigLoader::loadConfiguration - missing 'bus' object; using defaults");
+        }
         outConfig.bus.baud = DEFAULT_MODBUS_BAUD_RATE;
         outConfig.bus.serialFormat = DEFAULT_MODBUS_MODE;
         outConfig.bus.enabled = false;
+        outConfig.bus.readMaxGap = 0;
+        outConfig.bus.fixedRatePolling = true;
+        outConfig.bus.tcpServerEnabled = false;
+        outConfig.bus.tcpServerPort = DEFAULT_MODBUS_TCP_PORT;
+        outConfig.bus.tcpServerMaxAgeMs = 0;
     } else {
         outConfig.bus.baud = bus["baud"] | DEFAULT_MODBUS_BAUD_RATE;
         outConfig.bus.serialFormat = String(bus["serialFormat"] | DEFAULT_MODBUS_MODE);
         outConfig.bus.enabled = bus["enabled"] | false;
+        outConfig.bus.readMaxGap = static_cast<uint16_t>(bus["readMaxGap"] | 0);
+        outConfig.bus.fixedRatePolling = bus["fixedRatePolling"] | true;
+        outConfig.bus.tcpServerEnabled = bus["tcpServerEnabled"] | false;
+        outConfig.bus.tcpServerPort = static_cast<uint16_t>(bus["tcpServerPort"] | DEFAULT_MODBUS_TCP_PORT);
+        outConfig.bus.tcpServerMaxAgeMs = bus["tcpServerMaxAgeMs"] | 0U;
+        outConfig.bus.rxPin = static_cast<int8_t>(bus["rxPin"] | -1);
+        outConfig.bus.txPin = static_cast<int8_t>(bus["txPin"] | -1);
+        outConfig.bus.dePin = static_cast<int8_t>(bus["dePin"] | -1);
+    }
+
+    outConfig.additionalBuses.clear();
+    const JsonArray extraBuses = doc["additionalBuses"].as<JsonArray>();
+    if (!extraBuses.isNull()) {
+        for (JsonObject b : extraBuses) {
+            if (outConfig.busCount() >= MODBUS_MAX_BUSES) {
+                if (logger) {
+                    LOGGER_WARN(logger, LOGMODULE_MODBUS,
+                                "ModbusConfigLoader::loadConfiguration - more buses than UARTs; ignoring the rest");
+                }
+                break;
+            }
+            Bus extra{};
+            extra.baud = b["baud"] | DEFAULT_MODBUS_BAUD_RATE;
+            extra.serialFormat = String(b["serialFormat"] | DEFAULT_MODBUS_MODE);
+            extra.enabled = b["enabled"] | false;
+            extra.readMaxGap = static_cast<uint16_t>(b["readMaxGap"] | 0);
+            extra.fixedRatePolling = b["fixedRatePolling"] | true;
+            extra.rxPin = static_cast<int8_t>(b["rxPin"] | -1);
+            extra.txPin = static_cast<int8_t>(b["txPin"] | -1);
+            extra.dePin = static_cast<int8_t>(b["dePin"] | -1);
+            if (extra.rxPin < 0 || extra.txPin < 0) {
+                if (logger) {
+                    LOGGER_ERROR(logger, LOGMODULE_MODBUS,
+                                 "ModbusConfigLoader::loadConfiguration - additional bus without rxPin/txPin; disabled");
+                }
+                extra.enabled = false;
+            }
+            outConfig.additionalBuses.push_back(extra);
+        }
     }
 
     // devices
@@ -124,6 +196,19 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
             dev.name = String(d["name"] | "device");
             dev.name.trim();
             dev.slaveId = static_cast<uint8_t>(d["slaveId"] | 1);
+            dev.bus = static_cast<uint8_t>(d["bus"] | 0);
+            if (dev.bus >= outConfig.busCount()) {
+                if (logger) {
+                    LOGGER_WARN(logger, LOGMODULE_MODBUS, "ModbusConfigLoader::loadConfiguration - device '%s' names "
+                                "unknown bus %u; using bus 0", d["name"] | "device", static_cast<unsigned>(dev.bus));
+                }
+                dev.bus = 0;
+            }
+            dev.gatewayUnitId = static_cast<uint8_t>(d["gatewayUnitId"] | dev.slaveId);
+            dev.baud = d["baud"] | 0;
+            dev.serialFormat = String(d["serialFormat"] | "");
+            dev.serialFormat.trim();
+            dev.writeCombineMs = static_cast<uint16_t>(d["writeCombineMs"] | 0);
             dev.id = String(d["id"] | "");
             dev.id.trim();
             if (dev.id.isEmpty()) {
@@ -132,14 +217,21 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
                     dev.id = String("device_") + String(dev.slaveId);
                 }
             }
+            dev.host = String(d["host"] | "");
+            dev.host.trim();
+            dev.port = static_cast<uint16_t>(d["port"] | DEFAULT_MODBUS_TCP_PORT);
             dev.mqttEnabled = d["mqttEnabled"] | false;
             dev.homeassistantDiscoveryEnabled = d["homeassistantDiscoveryEnabled"] | false;
-            dev.haAvailabilityOnlinePublished = false;
+            dev.snapshotEnabled = d["snapshotEnabled"] | false;
+            dev.availabilityPublished = false;
             dev.haDiscoveryPublished = false;
 
             const JsonArray dps = d["dataPoints"].as<JsonArray>();
             if (!dps.isNull()) {
                 dev.datapoints.reserve(dps.size());
+                if (dev.snapshotEnabled) {
+                    dev.snapshot.entries.reserve(dps.size());
+                }
                 for (JsonObject p : dps) {
                     ModbusDatapoint dp{};
                     dp.id = String(p["id"] | "");
@@ -153,6 +245,24 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
                     dp.topic = String(p["topic"] | "");
                     dp.topic.trim();
                     dp.registerSlice = parseRegisterSlice(p["registerSlice"]);
+                    if (p["wordOrder"].is<const char *>() &&
+                        !ModbusValueDecoder::parseWordOrder(p["wordOrder"].as<const char *>(), dp.wordOrder) &&
+                        logger) {
+                        LOGGER_WARN(logger, LOGMODULE_MODBUS, "ModbusConfigLoader::loadConfiguration - unknown wordOrder "
+                                    "for %s; using ABCD", dp.id.c_str());
+                    }
+                    dp.decode = ModbusValueDecoder::select(dp.dataType, dp.wordOrder, dp.registerSlice);
+                    const uint8_t typeWidth = ModbusValueDecoder::registerCount(dp.dataType);
+                    const bool multiRegister = isReadOnlyFunction(dp.function) ||
+                                               dp.function == WRITE_MULTIPLE_HOLDING ||
+                                               dp.function == READ_WRITE_MULTIPLE;
+                    if (multiRegister && dp.numOfRegisters < typeWidth) {
+                        if (logger) {
+                            LOGGER_WARN(logger, LOGMODULE_MODBUS, "ModbusConfigLoader::loadConfiguration - %s needs %u "
+                                        "registers for its dataType", dp.id.c_str(), static_cast<unsigned>(typeWidth));
+                        }
+                        dp.numOfRegisters = typeWidth;
+                    }
                     // Optional per-datapoint poll interval (seconds in JSON) -> ms in runtime
                     if (p["poll_interval_ms"].is<unsigned long>()) {
                         const uint32_t ms = static_cast<uint32_t>(p["poll_interval_ms"].as<unsigned long>());
@@ -161,11 +271,20 @@ bool ModbusConfigLoader::loadConfiguration(Logger *logger, const char *path, Con
                         const uint32_t sec = static_cast<uint32_t>(p["poll_interval"].as<unsigned long>());
                         dp.pollIntervalMs = sec * 1000UL;
                     }
+                    dp.priority = parsePollPriority(p["priority"]);
                     dp.nextDueAtMs = 0;
+                    // Text has no magnitude for a deadband; onChange covers it.
+                    if (dp.dataType != TEXT) {
+                        dp.publishFilter.deadband = static_cast<float>(p["deadband"] | 0.0);
+                    }
+                    dp.publishFilter.onChange = p["onChange"] | false;
+                    dp.publishFilter.deadbandType = parseDeadbandType(p["deadbandType"]);
+                    dp.publishFilter.heartbeatMs = p["heartbeatMs"] | 0;
                     dev.datapoints.push_back(dp);
                 }
             }
-            outConfig.devices.push_back(dev);
+            // Moved so the capacity reserved for the poll path survives.
+            outConfig.devices.push_back(std::move(dev));
         }
     }
     return true;
@@ -0,0 +1,152 @@
+#include "modbus/ModbusDeadlineQueue.h"
+
+#include <algorithm>
+
+constexpr uint32_t ModbusDeadlineQueue::kNoDeadline;
+
+namespace {
+
+// Heap comparator: "a sorts below b", i.e. a is less urgent than b.
+bool lessUrgent(const ModbusDeadline &a, const ModbusDeadline &b) {
+    if (a.dueAtMs != b.dueAtMs) {
+        return ModbusDeadlineQueue::isBefore(b.dueAtMs, a.dueAtMs);
+    }
+    if (a.priority != b.priority) {
+        return a.priority > b.priority;
+    }
+    // Keep simultaneous entries of one device adjacent for groupByDevice.
+    return a.device > b.device;
+}
+
+} // namespace
+
+void ModbusDeadlineQueue::clear() {
+    _heap.clear();
+}
+
+void ModbusDeadlineQueue::reserve(const size_t capacity) {
+    _heap.reserve(capacity);
+}
+
+size_t ModbusDeadlineQueue::size() const {
+    return _heap.size();
+}
+
+bool ModbusDeadlineQueue::empty() const {
+    return _heap.empty();
+}
+
+void ModbusDeadlineQueue::push(const ModbusDeadline &entry) {
+    _heap.push_back(entry);
+    std::push_heap(_heap.begin(), _heap.end(), lessUrgent);
+}
+
+size_t ModbusDeadlineQueue::popDue(const uint32_t nowMs, std::vector<ModbusDeadline> &out) {
+    size_t popped = 0;
+    while (!_heap.empty() && !isBefore(nowMs, _heap.front().dueAtMs)) {
+        std::pop_heap(_heap.begin(), _heap.end(), lessUrgent);
+        out.push_back(_heap.back());
+        _heap.pop_back();
+        ++popped;
+    }
+    return popped;
+}
+
+uint32_t ModbusDeadlineQueue::msUntilNext(const uint32_t nowMs) const {
+    if (_heap.empty()) {
+        return kNoDeadline;
+    }
+    const uint32_t due = _heap.front().dueAtMs;
+    return isBefore(nowMs, due) ? due - nowMs : 0;
+}
+
+uint32_t ModbusDeadlineQueue::nextFixedRate(const uint32_t idealDueMs,
+                                            const uint32_t intervalMs,
+                                            const uint32_t nowMs) {
+    if (intervalMs == 0) {
+        return nowMs;
+    }
+    uint32_t next = idealDueMs + intervalMs;
+    if (!isBefore(nowMs, next)) {
+        const uint32_t behind = nowMs - next;
+        next += (behind / intervalMs + 1U) * intervalMs;
+    }
+    return next;
+}
+
+uint32_t ModbusDeadlineQueue::phaseOffset(const uint32_t intervalMs, const size_t slot, const size_t slots) {
+    if (slots < 2 || slot >= slots) {
+        return 0;
+    }
+    return static_cast<uint32_t>(static_cast<uint64_t>(intervalMs) * slot / slots);
+}
+
+void ModbusDeadlineQueue::groupByDevice(std::vector<ModbusDeadline> &batch,
+                                        const size_t deviceCount,
+                                        std::vector<uint16_t> &rankScratch) {
+    if (batch.size() < 2) {
+        return;
+    }
+    rankScratch.assign(deviceCount, UINT16_MAX);
+    uint16_t nextRank = 0;
+    for (const auto &entry: batch) {
+        if (entry.device < deviceCount && rankScratch[entry.device] == UINT16_MAX) {
+            rankScratch[entry.device] = nextRank++;
+        }
+    }
+    // Insertion sort keeps the batch's urgency order inside each device and
+    // needs no temporary buffer; popDue already yields ties grouped by device.
+    for (size_t i = 1; i < batch.size(); ++i) {
+        const ModbusDeadline entry = batch[i];
+        const uint16_t rank = entry.device < deviceCount ? rankScratch[entry.device] : UINT16_MAX;
+        size_t j = i;
+        while (j > 0) {
+            const ModbusDeadline &prev = batch[j - 1];
+            const uint16_t prevRank = prev.device < deviceCount ? rankScratch[prev.device] : UINT16_MAX;
+            if (prevRank <= rank) {
+                break;
+            }
+            batch[j] = prev;
+            --j;
+        }
+        batch[j] = entry;
+    }
+}
+
+void ModbusDeadlineQueue::groupByLine(std::vector<ModbusDeadline> &batch,
+                                      const std::vector<uint8_t> &deviceLine,
+                                      const uint8_t currentLine,
+                                      std::vector<uint16_t> &rankScratch) {
+    if (batch.size() < 2) {
+        return;
+    }
+    auto lineOf = [&deviceLine](const ModbusDeadline &entry) -> uint8_t {
+        return entry.device < deviceLine.size() ? deviceLine[entry.device] : 0;
+    };
+    rankScratch.assign(UINT8_MAX + 1, UINT16_MAX);
+    rankScratch[currentLine] = 0;
+    uint16_t nextRank = 1;
+    bool mixed = false;
+    for (const auto &entry: batch) {
+        const uint8_t line = lineOf(entry);
+        if (rankScratch[line] == UINT16_MAX) {
+            rankScratch[line] = nextRank++;
+        }
+        mixed = mixed || line != currentLine;
+    }
+    if (!mixed) {
+        return;
+    }
+    // Same insertion sort as groupByDevice: stable, so a device's run stays
+    // in one piece and urgency order survives inside each setting.
+    for (size_t i = 1; i < batch.size(); ++i) {
+        const ModbusDeadline entry = batch[i];
+        const uint16_t rank = rankScratch[lineOf(entry)];
+        size_t j = i;
+        while (j > 0 && rankScratch[lineOf(batch[j - 1])] > rank) {
+            batch[j] = batch[j - 1];
+            --j;
+        }
+        batch[j] = entry;
+    }
+}
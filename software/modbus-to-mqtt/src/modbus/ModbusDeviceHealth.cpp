@@ -0,0 +1,80 @@
+#include "modbus/ModbusDeviceHealth.h"
+
+#include "modbus/ModbusDeadlineQueue.h"
+
+constexpr uint8_t ModbusDeviceHealth::kSuspectAfterTimeouts;
+constexpr uint8_t ModbusDeviceHealth::kOfflineAfterProbes;
+constexpr uint32_t ModbusDeviceHealth::kFirstProbeDelayMs;
+constexpr uint32_t ModbusDeviceHealth::kMaxProbeDelayMs;
+
+bool ModbusDeviceHealth::recordAnswer() {
+    const bool changed = _state != ModbusHealthState::Online;
+    _state = ModbusHealthState::Online;
+    _timeouts = 0;
+    _failedProbes = 0;
+    _probeDelayMs = 0;
+    return changed;
+}
+
+bool ModbusDeviceHealth::recordTimeout(const uint32_t nowMs) {
+    switch (_state) {
+        case ModbusHealthState::Online:
+            if (++_timeouts < kSuspectAfterTimeouts) {
+                return false;
+            }
+            _state = ModbusHealthState::Suspect;
+            _probeDelayMs = kFirstProbeDelayMs;
+            holdBack(nowMs);
+            return true;
+        case ModbusHealthState::Suspect:
+            _probeDelayMs = _probeDelayMs >= kMaxProbeDelayMs / 2U ? kMaxProbeDelayMs : _probeDelayMs * 2U;
+            holdBack(nowMs);
+            if (++_failedProbes < kOfflineAfterProbes) {
+                return false;
+            }
+            _state = ModbusHealthState::Offline;
+            return true;
+        case ModbusHealthState::Offline:
+        default:
+            _probeDelayMs = _probeDelayMs >= kMaxProbeDelayMs / 2U ? kMaxProbeDelayMs : _probeDelayMs * 2U;
+            holdBack(nowMs);
+            return false;
+    }
+}
+
+void ModbusDeviceHealth::holdBack(const uint32_t nowMs) {
+    _nextProbeAtMs = nowMs + _probeDelayMs;
+}
+
+ModbusHealthState ModbusDeviceHealth::state() const {
+    return _state;
+}
+
+bool ModbusDeviceHealth::isOnline() const {
+    return _state == ModbusHealthState::Online;
+}
+
+bool ModbusDeviceHealth::isAvailable() const {
+    return _state != ModbusHealthState::Offline;
+}
+
+bool ModbusDeviceHealth::probeDue(const uint32_t nowMs) const {
+    return isOnline() || !ModbusDeadlineQueue::isBefore(nowMs, _nextProbeAtMs);
+}
+
+uint32_t ModbusDeviceHealth::nextProbeAtMs() const {
+    return _nextProbeAtMs;
+}
+
+uint32_t ModbusDeviceHealth::probeDelayMs() const {
+    return _probeDelayMs;
+}
+
+const char *ModbusDeviceHealth::stateName(const ModbusHealthState state) {
+    switch (state) {
+        case ModbusHealthState::Online: return "online";
+        case ModbusHealthState::Suspect: return "suspect";
+        case ModbusHealthState::Offline: return "offline";
+        default: return "unknown";
+    }
+}
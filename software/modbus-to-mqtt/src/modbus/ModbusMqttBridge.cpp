@@ -4,7 +4,33 @@
 #include "modbus/ModbusFunctionUtils.h"
 #include "modbus/ModbusManager.h"
 #include "modbus/ModbusTopicBuilder.h"
+#include "modbus/ModbusValueDecoder.h"
+#include "services/TimeService.h"
 #include <ArduinoJson.h>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+void appendJsonString(String &out, const char *text) {
+    out += '"';
+    for (const char *c = text; *c; ++c) {
+        const auto ch = static_cast<unsigned char>(*c);
+        if (ch == '"' || ch == '\\') {
+            out += '\\';
+            out += static_cast<char>(ch);
+        } else if (ch < 0x20) {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04X", ch);
+            out += escaped;
+        } else {
+            out += static_cast<char>(ch);
+        }
+    }
+    out += '"';
+}
+
+} // namespace
 
 ModbusMqttBridge::ModbusMqttBridge(Logger *logger, ModbusManager *modbus)
     : _logger(logger), _modbus(modbus) {
@@ -15,9 +41,14 @@ void ModbusMqttBridge::setMqttManager(MqttManager *mqtt) {
 }
 
 void ModbusMqttBridge::onConfigurationLoaded(ConfigurationRoot &root) {
+    _topics.rebuild(_mqtt ? _mqtt->getRootTopic() : String(), root.devices);
+    LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "ModbusMqttBridge::onConfigurationLoaded - topic table holds %u bytes",
+                 static_cast<unsigned>(_topics.poolBytes()));
+
     for (auto &device : root.devices) {
-        device.haAvailabilityOnlinePublished = false;
+        device.availabilityPublished = false;
         device.haDiscoveryPublished = false;
+        reserveSnapshot(device);
     }
 
     if (_mqtt) {
@@ -26,7 +57,7 @@ void ModbusMqttBridge::onConfigurationLoaded(ConfigurationRoot &root) {
         for (auto &device: root.devices) {
             if (device.mqttEnabled && device.homeassistantDiscoveryEnabled) {
                 if (willTopic.isEmpty()) {
-                    willTopic = buildAvailabilityTopic(device);
+                    willTopic = _topics.at(device.availabilityTopicId);
                 } else {
                     multipleDiscovery = true;
                 }
@@ -34,13 +65,13 @@ void ModbusMqttBridge::onConfigurationLoaded(ConfigurationRoot &root) {
         }
         if (willTopic.length()) {
             _mqtt->configureWill(willTopic, "offline", 1, true);
-            _logger->logDebug((String("[MQTT][HA] Set LWT topic to ") + willTopic).c_str());
+            LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "[MQTT][HA] Set LWT topic to %s", willTopic.c_str());
         } else {
             _mqtt->clearWill();
         }
         if (multipleDiscovery) {
-            _logger->logWarning(
-                "[MQTT][HA] Multiple devices requested Home Assistant discovery; LWT uses the first matched device");
+            LOGGER_WARN(_logger, LOGMODULE_MQTT,
+                        "[MQTT][HA] Multiple devices requested Home Assistant discovery; LWT uses the first matched device");
         }
     }
 
@@ -68,8 +99,8 @@ void ModbusMqttBridge::handleMqttConnected(ConfigurationRoot &root) {
         if (!device.mqttEnabled) {
             continue;
         }
+        publishAvailability(device);
         if (device.homeassistantDiscoveryEnabled) {
-            publishAvailabilityOnline(device);
             publishHomeAssistantDiscovery(device);
         }
     }
@@ -77,62 +108,126 @@ void ModbusMqttBridge::handleMqttConnected(ConfigurationRoot &root) {
 
 void ModbusMqttBridge::handleMqttDisconnected(ConfigurationRoot &root) {
     for (auto &device: root.devices) {
-        device.haAvailabilityOnlinePublished = false;
+        device.availabilityPublished = false;
         device.haDiscoveryPublished = false;
     }
 }
 
-String ModbusMqttBridge::buildDatapointTopic(const ModbusDevice &device, const ModbusDatapoint &dp) const {
-    const String rootTopic = _mqtt->getRootTopic();
-    const ModbusTopicBuilder builder(rootTopic);
-    return builder.datapointTopic(device, dp);
-}
-
-String ModbusMqttBridge::buildAvailabilityTopic(const ModbusDevice &device) const {
-    const String rootTopic = _mqtt->getRootTopic();
-    const ModbusTopicBuilder builder(rootTopic);
-    return builder.availabilityTopic(device);
+void ModbusMqttBridge::onRootTopicChanged(ConfigurationRoot &root) {
+    if (!_mqtt || _mqtt->getRootTopic() == _topics.rootTopic()) {
+        return;
+    }
+    // Topics, the will and discovery all move to the new root.
+    onConfigurationLoaded(root);
 }
 
-void ModbusMqttBridge::publishDatapoint(ModbusDevice &device,
-                                       const ModbusDatapoint &dp,
-                                       const String &payload) const {
+bool ModbusMqttBridge::readyToPublish(ModbusDevice &device) const {
     if (!device.mqttEnabled || !_mqtt) {
-        return;
+        return false;
     }
     if (!MqttManager::isMQTTEnabled()) {
-        return;
-    }
-    if (dp.id.isEmpty()) {
-        return;
+        return false;
     }
 
     if (device.homeassistantDiscoveryEnabled) {
-        if (!device.haAvailabilityOnlinePublished) {
-            publishAvailabilityOnline(device);
+        if (!device.availabilityPublished) {
+            publishAvailability(device);
         }
         if (!device.haDiscoveryPublished) {
             publishHomeAssistantDiscovery(device);
         }
-        if (!device.haAvailabilityOnlinePublished || !device.haDiscoveryPublished) {
-            return;
+        if (!device.availabilityPublished || !device.haDiscoveryPublished) {
+            return false;
         }
     }
+    return true;
+}
+
+bool ModbusMqttBridge::publishDatapoint(ModbusDevice &device,
+                                       const ModbusDatapoint &dp,
+                                       const char *payload) const {
+    if (dp.id.isEmpty() || !readyToPublish(device)) {
+        return false;
+    }
+
+    const char *topic = _topics.at(dp.topicId);
+    if (!*topic) {
+        LOGGER_WARN(_logger, LOGMODULE_MQTT, "ModbusMqttBridge::publishDatapoint - empty topic, skipping publish");
+        return false;
+    }
+
+    if (!_mqtt->mqttPublish(topic, payload)) {
+        LOGGER_WARN(_logger, LOGMODULE_MQTT, "MQTT publish failed for topic %s", topic);
+        return false;
+    }
+    LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "MQTT publish %s <= %s", topic, payload);
+    return true;
+}
 
-    String topic = buildDatapointTopic(device, dp);
-    topic.trim();
-    if (!topic.length()) {
-        _logger->logWarning("ModbusMqttBridge::publishDatapoint - empty topic, skipping publish");
+void ModbusMqttBridge::reserveSnapshot(ModbusDevice &device) const {
+    if (!device.snapshotEnabled) {
         return;
     }
+    size_t fields = 0;
+    for (const auto &dp: device.datapoints) {
+        // ,"segment": plus the value, quoted for TEXT.
+        fields += strlen(_topics.at(dp.segmentId)) + 4;
+        fields += dp.dataType == TEXT ? (dp.numOfRegisters ? dp.numOfRegisters : 1) * 2U + 2U
+                                      : ModbusValueDecoder::kValueChars;
+    }
+    device.snapshot.fields.reserve(fields);
+    // {"uptimeMs":4294967295,"ts":"2024-01-01T00:00:00Z",...}
+    device.snapshot.payload.reserve(fields + 56);
+}
 
-    if (!_mqtt->mqttPublish(topic.c_str(), payload.c_str())) {
-        _logger->logWarning((String("MQTT publish failed for topic ") + topic).c_str());
+void ModbusMqttBridge::addToSnapshot(ModbusDevice &device,
+                                     const ModbusDatapoint &dp,
+                                     const double value,
+                                     const char *payload) const {
+    String &fields = device.snapshot.fields;
+    if (fields.length()) {
+        fields += ',';
+    }
+    appendJsonString(fields, _topics.at(dp.segmentId));
+    fields += ':';
+    if (dp.dataType == TEXT) {
+        appendJsonString(fields, payload);
+    } else if (std::isfinite(value)) {
+        fields += payload;
     } else {
-        _logger->logDebug((String("MQTT publish ") + topic + " <= " + payload).c_str());
+        fields += "null";
     }
 }
 
+bool ModbusMqttBridge::publishSnapshot(ModbusDevice &device) const {
+    if (!readyToPublish(device)) {
+        return false;
+    }
+    const char *topic = _topics.at(device.snapshotTopicId);
+    char number[11];
+    char now[24];
+
+    String &payload = device.snapshot.payload;
+    payload = "";
+    payload += "{\"uptimeMs\":";
+    snprintf(number, sizeof(number), "%lu", static_cast<unsigned long>(device.snapshot.startedAtMs));
+    payload += number;
+    if (TimeService::nowIso(now, sizeof(now))) {
+        payload += ",\"ts\":";
+        appendJsonString(payload, now);
+    }
+    payload += ',';
+    payload += device.snapshot.fields;
+    payload += '}';
+
+    if (!_mqtt->mqttPublish(topic, payload.c_str())) {
+        LOGGER_WARN(_logger, LOGMODULE_MQTT, "MQTT publish failed for topic %s", topic);
+        return false;
+    }
+    LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "MQTT publish %s <= %s", topic, payload.c_str());
+    return true;
+}
+
 void ModbusMqttBridge::rebuildWriteSubscriptions(const ConfigurationRoot &root) {
     if (!_mqtt || !MqttManager::isMQTTEnabled()) return;
 
@@ -146,22 +241,26 @@ void ModbusMqttBridge::rebuildWriteSubscriptions(const ConfigurationRoot &root)
 
         for (const auto &dp: device.datapoints) {
             if (isReadOnlyFunction(dp.function)) continue;
+            if (device.transport() == ModbusTransport::Tcp) {
+                // Commands only run on the RS485 bus so far.
+                LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusMqttBridge::rebuildWriteSubscriptions - %s/%s: writes to "
+                            "Modbus TCP devices are not supported, skipping", device.name.c_str(), dp.name.c_str());
+                continue;
+            }
 
-            String topic = buildDatapointTopic(device, dp);
-            topic.trim();
+            const String topic = _topics.at(dp.topicId);
             if (!topic.length()) {
-                _logger->logWarning("ModbusMqttBridge::rebuildWriteSubscriptions - empty topic for write datapoint, skipping");
+                LOGGER_WARN(_logger, LOGMODULE_MODBUS,
+                            "ModbusMqttBridge::rebuildWriteSubscriptions - empty topic for write datapoint, skipping");
                 continue;
             }
 
-            const uint8_t slaveId = device.slaveId;
-            const auto fn = dp.function;
-            const uint16_t addr = dp.address;
-            const uint8_t numRegs = dp.numOfRegisters ? dp.numOfRegisters : 1;
-            const float scale = dp.scale;
+            const ModbusWriteTarget target{device.bus, device.slaveId, dp.function, dp.address,
+                                           static_cast<uint8_t>(dp.numOfRegisters ? dp.numOfRegisters : 1),
+                                           dp.scale, dp.dataType, dp.wordOrder, device.writeCombineMs};
 
-            _mqtt->addSubscriptionHandler(topic, [this, topic, slaveId, fn, addr, numRegs, scale](const String &payload) {
-                handleWriteCommand(topic, slaveId, fn, addr, numRegs, scale, payload);
+            _mqtt->addSubscriptionHandler(topic, [this, topic, target](const String &payload) {
+                handleWriteCommand(topic, target, payload);
             });
             _writeTopics.push_back(topic);
         }
@@ -169,111 +268,150 @@ void ModbusMqttBridge::rebuildWriteSubscriptions(const ConfigurationRoot &root)
 }
 
 void ModbusMqttBridge::handleWriteCommand(const String &topic,
-                                         const uint8_t slaveId,
-                                         const ModbusFunctionType fn,
-                                         const uint16_t addr,
-                                         const uint8_t numRegs,
-                                         const float scale,
+                                         const ModbusWriteTarget &target,
                                          const String &payload) const {
     if (!_modbus) {
-        _logger->logError("ModbusMqttBridge::handleWriteCommand - no ModbusManager assigned");
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusMqttBridge::handleWriteCommand - no ModbusManager assigned");
         return;
     }
 
     String trimmed = payload;
     trimmed.trim();
+    if (!trimmed.length()) {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusMqttBridge::handleWriteCommand - empty payload for topic [%s]",
+                    topic.c_str());
+        return;
+    }
 
-    uint16_t writeValue = 0;
-    bool hasWriteValue = false;
-
-    if (fn == WRITE_COIL) {
-        if (trimmed.equalsIgnoreCase("true") || trimmed == "1") {
-            writeValue = 1;
-            hasWriteValue = true;
-        } else if (trimmed.equalsIgnoreCase("false") || trimmed == "0") {
-            writeValue = 0;
-            hasWriteValue = true;
-        } else if (trimmed.length()) {
-            writeValue = static_cast<uint16_t>(trimmed.toInt());
-            writeValue = writeValue ? 1 : 0;
-            hasWriteValue = true;
+    ModbusCommand command{};
+    command.bus = target.bus;
+    command.slaveId = target.slaveId;
+    command.function = static_cast<uint8_t>(target.function);
+    command.address = target.address;
+
+    switch (target.function) {
+        case WRITE_COIL:
+            if (trimmed.equalsIgnoreCase("true") || trimmed == "1") {
+                command.values[0] = 1;
+            } else if (trimmed.equalsIgnoreCase("false") || trimmed == "0") {
+                command.values[0] = 0;
+            } else {
+                command.values[0] = trimmed.toInt() ? 1 : 0;
+            }
+            command.count = 1;
+            break;
+        case WRITE_HOLDING: {
+            // One register: 16-bit types keep their sign and byte order.
+            const ModbusDataType type = target.dataType == INT16 ? INT16 : UINT16;
+            const double denom = (target.scale == 0.0f) ? 1.0 : static_cast<double>(target.scale);
+            command.count = ModbusValueDecoder::encode(type, target.wordOrder, trimmed.toDouble() / denom,
+                                                       command.values);
+            break;
         }
-    } else if (fn == WRITE_HOLDING || fn == WRITE_MULTIPLE_HOLDING) {
-        if (!trimmed.length()) {
-            _logger->logWarning("ModbusMqttBridge::handleWriteCommand - empty payload for holding register write");
+        case WRITE_MULTIPLE_COILS:
+            command.count = ModbusManager::coilsFromPayload(trimmed, target.numRegs, command.values,
+                                                            ModbusCommand::kMaxValues);
+            break;
+        case WRITE_MULTIPLE_HOLDING:
+            command.count = ModbusManager::registersFromPayload(trimmed, target.dataType, target.wordOrder,
+                                                                target.scale, target.numRegs, command.values,
+                                                                ModbusCommand::kMaxValues);
+            break;
+        case READ_WRITE_MULTIPLE:
+            // Writes the value and reads the same registers back in one go.
+            command.writeAddress = target.address;
+            command.writeCount = ModbusManager::registersFromPayload(trimmed, target.dataType, target.wordOrder,
+                                                                     target.scale, target.numRegs,
+                                                                     command.values, ModbusCommand::kMaxValues);
+            command.count = command.writeCount ? target.numRegs : 0;
+            break;
+        default:
+            LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusMqttBridge::handleWriteCommand - unsupported function");
             return;
-        }
-        const float denom = (scale == 0.0f) ? 1.0f : scale;
-        const float requested = trimmed.toFloat();
-        const float raw = requested / denom;
-        float rounded = (raw >= 0.0f) ? (raw + 0.5f) : (raw - 0.5f);
-        if (rounded < 0.0f) rounded = 0.0f;
-        if (rounded > 65535.0f) rounded = 65535.0f;
-        writeValue = static_cast<uint16_t>(rounded);
-        hasWriteValue = true;
-    } else {
-        _logger->logWarning("ModbusMqttBridge::handleWriteCommand - unsupported function");
-        return;
     }
 
-    if (!hasWriteValue) {
-        _logger->logWarning(
-            (String("ModbusMqttBridge::handleWriteCommand - Unable to parse payload for topic [") + topic + "]").c_str());
+    if (command.count == 0) {
+        LOGGER_WARN(_logger, LOGMODULE_MODBUS,
+                    "ModbusMqttBridge::handleWriteCommand - Unable to parse payload for topic [%s]", topic.c_str());
         return;
     }
 
-    uint16_t outBuf[1]{};
-    uint16_t outCount = 0;
-    String rxDump;
-    const uint8_t effectiveLen = (fn == WRITE_MULTIPLE_HOLDING) ? 1 : numRegs;
-    const uint8_t status = _modbus->executeCommand(slaveId,
-                                                   static_cast<int>(fn),
-                                                   addr,
-                                                   effectiveLen,
-                                                   writeValue,
-                                                   true,
-                                                   outBuf,
-                                                   0,
-                                                   outCount,
-                                                   rxDump);
-
-    if (status == ModbusMaster::ku8MBSuccess) {
-        _logger->logDebug(
-            (String("Modbus write OK - topic=") + topic + ", addr=" + String(addr) + ", value=" +
-             String(writeValue)).c_str());
+    command.combineMs = target.combineMs;
+    command.submittedAtMs = millis();
+    command.onComplete = onWriteComplete;
+    command.context = _logger;
+
+    // Queued ahead of scheduled polls; the result is logged on completion.
+    if (!_modbus->submitCommand(command, ModbusCommandPriority::Write)) {
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "Modbus write ERR - topic=%s, addr=%u, command queue full; write dropped",
+                     topic.c_str(), static_cast<unsigned>(target.address));
+    }
+}
+
+void ModbusMqttBridge::onWriteComplete(void *context, const ModbusCommand &command,
+                                       const ModbusCommandResult &result) {
+    auto *logger = static_cast<Logger *>(context);
+    if (!logger) {
+        return;
+    }
+    const bool readWrite = command.function == READ_WRITE_MULTIPLE;
+    const uint16_t address = readWrite ? command.writeAddress : command.address;
+    if (result.status == ModbusRtuStatus::Success) {
+        if (!logger->enabled(LOGLEVEL_DEBUG, LOGMODULE_MODBUS)) {
+            return;
+        }
+        String readback;
+        if (readWrite && result.count > 0) {
+            readback = ", readback=[";
+            for (uint16_t i = 0; i < result.count; ++i) {
+                if (i) readback += ',';
+                readback += String(result.words[i]);
+            }
+            readback += ']';
+        }
+        LOGGER_DEBUG(logger, LOGMODULE_MODBUS,
+                     "Modbus write OK - slave=%u, addr=%u, fn=%u, count=%u, first=%u%s, latency=%lums",
+                     command.slaveId, address, command.function, readWrite ? command.writeCount : command.count,
+                     command.values[0], readback.c_str(), static_cast<unsigned long>(result.latencyMs));
     } else {
-        _logger->logError(
-            (String("Modbus write ERR - topic=") + topic + ", addr=" + String(addr) +
-             ", code=" + String(status) + " (" + ModbusManager::statusToString(status) + ")" +
-             (rxDump.length() ? String(", rx=") + rxDump : String(""))).c_str());
+        const bool hasRx = result.rxDump && result.rxDump[0];
+        LOGGER_ERROR(logger, LOGMODULE_MODBUS, "Modbus write ERR - slave=%u, addr=%u, code=%u (%s), latency=%lums%s%s",
+                     static_cast<unsigned>(command.slaveId), static_cast<unsigned>(address),
+                     static_cast<unsigned>(result.status), ModbusManager::statusToString(result.status),
+                     static_cast<unsigned long>(result.latencyMs), hasRx ? ", rx=" : "", hasRx ? result.rxDump : "");
     }
 }
 
-void ModbusMqttBridge::publishAvailabilityOnline(ModbusDevice &device) const {
-    if (!device.homeassistantDiscoveryEnabled || !device.mqttEnabled) {
+void ModbusMqttBridge::onAvailabilityChanged(ModbusDevice &device) const {
+    device.availabilityPublished = false;
+    publishAvailability(device);
+}
+
+void ModbusMqttBridge::publishAvailability(ModbusDevice &device) const {
+    if (!device.mqttEnabled) {
         return;
     }
     if (!MqttManager::isMQTTEnabled() || !_mqtt || !_mqtt->isConnected()) {
         return;
     }
 
-    String topic = buildAvailabilityTopic(device);
-    topic.trim();
-    if (!topic.length()) {
-        _logger->logWarning("[MQTT][HA] Availability topic empty, skipping publish");
+    const char *topic = _topics.at(device.availabilityTopicId);
+    if (!*topic) {
+        LOGGER_WARN(_logger, LOGMODULE_MQTT, "[MQTT] Availability topic empty, skipping publish");
         return;
     }
 
-    if (_mqtt->mqttPublish(topic.c_str(), "online", true)) {
-        device.haAvailabilityOnlinePublished = true;
-        _logger->logDebug((String("[MQTT][HA] Availability -> ") + topic + " <= online").c_str());
+    const char *payload = device.health.isAvailable() ? "online" : "offline";
+    if (_mqtt->mqttPublish(topic, payload, true)) {
+        device.availabilityPublished = true;
+        LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "[MQTT] Availability -> %s <= %s", topic, payload);
     } else {
-        _logger->logWarning((String("[MQTT][HA] Failed to publish availability topic ") + topic).c_str());
+        LOGGER_WARN(_logger, LOGMODULE_MQTT, "[MQTT] Failed to publish availability topic %s", topic);
     }
 }
 
 void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const {
-    _logger->logDebug((String("[MQTT][HA] Publishing discovery for device ") + device.id).c_str());
+    LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "[MQTT][HA] Publishing discovery for device %s", device.id.c_str());
     if (!device.homeassistantDiscoveryEnabled || !device.mqttEnabled) {
         return;
     }
@@ -282,8 +420,8 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
         return;
     }
 
-    const String deviceSegment = ModbusTopicBuilder::deviceSegment(device);
-    const String availabilityTopic = buildAvailabilityTopic(device);
+    const String deviceSegment = _topics.at(device.segmentId);
+    const char *availabilityTopic = _topics.at(device.availabilityTopicId);
     String deviceIdentifier = device.id;
     deviceIdentifier.trim();
     if (!deviceIdentifier.length()) {
@@ -293,18 +431,27 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
     bool anyEligible = false;
     bool anyPublished = false;
 
-    auto findStateTopicForCommand = [&](const String &commandTopic) -> String {
+    // Topics are interned, so equal topics have equal ids.
+    auto findStateForCommand = [&](const ModbusDatapoint &writer) -> const ModbusDatapoint * {
         for (const auto &candidate: device.datapoints) {
-            if (!isReadOnlyFunction(candidate.function)) {
-                continue;
-            }
-            String candidateTopic = buildDatapointTopic(device, candidate);
-            candidateTopic.trim();
-            if (candidateTopic == commandTopic) {
-                return candidateTopic;
+            if (isReadOnlyFunction(candidate.function) && candidate.topicId == writer.topicId) {
+                return &candidate;
             }
         }
-        return {};
+        return nullptr;
+    };
+
+    // In snapshot mode the value is a member of the snapshot; a snapshot
+    // without it (deadband, other poll interval) keeps the current state.
+    auto setStateTopic = [&](JsonDocument &doc, const ModbusDatapoint &reader) {
+        if (!device.snapshotEnabled) {
+            doc["state_topic"] = _topics.at(reader.topicId);
+            return;
+        }
+        const String key = _topics.at(reader.segmentId);
+        doc["state_topic"] = _topics.at(device.snapshotTopicId);
+        doc["value_template"] = String("{{ value_json['") + key + "'] if '" + key +
+                                "' in value_json else this.state }}";
     };
 
     for (const auto &dp: device.datapoints) {
@@ -315,13 +462,12 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
         }
         anyEligible = true;
 
-        String datapointTopic = buildDatapointTopic(device, dp);
-        datapointTopic.trim();
-        if (!datapointTopic.length()) {
+        const char *datapointTopic = _topics.at(dp.topicId);
+        if (!*datapointTopic) {
             continue;
         }
 
-        const String datapointSegment = ModbusTopicBuilder::datapointSegment(dp);
+        const String datapointSegment = _topics.at(dp.segmentId);
         const String baseUniqueId = deviceSegment + "_" + datapointSegment;
         String discoveryTopic;
 
@@ -348,7 +494,7 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
         if (readable) {
             discoveryTopic =
                 String("homeassistant/sensor/") + deviceSegment + "/" + datapointSegment + "/config";
-            doc["state_topic"] = datapointTopic;
+            setStateTopic(doc, dp);
             if (dp.unit.length()) {
                 doc["unit_of_measurement"] = dp.unit;
             }
@@ -361,9 +507,9 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
             doc["command_topic"] = datapointTopic;
             doc["payload_on"] = "1";
             doc["payload_off"] = "0";
-            const String stateTopic = findStateTopicForCommand(datapointTopic);
-            if (stateTopic.length()) {
-                doc["state_topic"] = stateTopic;
+            const ModbusDatapoint *reader = findStateForCommand(dp);
+            if (reader) {
+                setStateTopic(doc, *reader);
             } else {
                 doc["optimistic"] = true;
             }
@@ -371,9 +517,9 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
             discoveryTopic =
                 String("homeassistant/number/") + deviceSegment + "/" + datapointSegment + "/config";
             doc["command_topic"] = datapointTopic;
-            const String stateTopic = findStateTopicForCommand(datapointTopic);
-            if (stateTopic.length()) {
-                doc["state_topic"] = stateTopic;
+            const ModbusDatapoint *reader = findStateForCommand(dp);
+            if (reader) {
+                setStateTopic(doc, *reader);
             } else {
                 doc["optimistic"] = true;
             }
@@ -395,9 +541,10 @@ void ModbusMqttBridge::publishHomeAssistantDiscovery(ModbusDevice &device) const
         serializeJson(doc, payload);
         if (_mqtt->mqttPublish(discoveryTopic.c_str(), payload.c_str(), true)) {
             anyPublished = true;
-            _logger->logDebug((String("[MQTT][HA] Discovery -> ") + discoveryTopic).c_str());
+            LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "[MQTT][HA] Discovery -> %s", discoveryTopic.c_str());
         } else {
-            _logger->logWarning((String("[MQTT][HA] Failed to publish discovery topic ") + discoveryTopic).c_str());
+            LOGGER_WARN(_logger, LOGMODULE_MQTT, "[MQTT][HA] Failed to publish discovery topic %s",
+                        discoveryTopic.c_str());
         }
     }
 
@@ -2,6 +2,8 @@
 
 #include "modbus/ModbusFunctionUtils.h"
 
+constexpr uint32_t ModbusPollScheduler::kLateSlackMs;
+
 bool ModbusPollScheduler::isDue(const ModbusDatapoint &dp, const uint32_t nowMs) {
     if (!isReadOnlyFunction(dp.function)) {
         return false;
@@ -10,42 +12,138 @@ bool ModbusPollScheduler::isDue(const ModbusDatapoint &dp, const uint32_t nowMs)
         return true;
     }
 
-    return nowMs >= dp.nextDueAtMs;
+    return !ModbusDeadlineQueue::isBefore(nowMs, dp.nextDueAtMs);
 }
 
 void ModbusPollScheduler::scheduleNext(ModbusDatapoint &dp, const uint32_t nowMs) {
-    if (dp.pollIntervalMs > 0) {
-        dp.nextDueAtMs = nowMs + dp.pollIntervalMs;
+    dp.nextDueAtMs = nowMs + dp.pollIntervalMs;
+}
+
+void ModbusPollScheduler::scheduleNextFixedRate(ModbusDatapoint &dp, const uint32_t nowMs) {
+    dp.nextDueAtMs = ModbusDeadlineQueue::nextFixedRate(dp.nextDueAtMs, dp.pollIntervalMs, nowMs);
+}
+
+void ModbusPollScheduler::recordPoll(ModbusDatapoint &dp, const uint32_t nowMs) const {
+    const uint32_t lateness = ModbusDeadlineQueue::isBefore(nowMs, dp.nextDueAtMs) ? 0 : nowMs - dp.nextDueAtMs;
+    dp.lastLatenessMs = lateness;
+    dp.late = dp.pollIntervalMs > 0 && lateness > dp.pollIntervalMs / 10U + kLateSlackMs;
+    if (_fixedRate) {
+        scheduleNextFixedRate(dp, nowMs);
     } else {
-        dp.nextDueAtMs = 0;
+        scheduleNext(dp, nowMs);
     }
 }
 
-std::vector<ModbusDatapoint *> ModbusPollScheduler::dueReadDatapoints(ModbusDevice &device, const uint32_t nowMs) {
-    std::vector<ModbusDatapoint *> due;
-    due.reserve(device.datapoints.size());
-    collectDueReadDatapoints(device, nowMs, due);
-    return due;
+void ModbusPollScheduler::deferUntil(ModbusDatapoint &dp, const uint32_t atMs) {
+    dp.nextDueAtMs = atMs;
 }
 
-bool ModbusPollScheduler::hasDueReadDatapoints(const ModbusDevice &device, const uint32_t nowMs) {
-    for (const auto &dp : device.datapoints) {
-        if (isReadOnlyFunction(dp.function)) {
-            if (dp.pollIntervalMs == 0 || nowMs >= dp.nextDueAtMs) {
-                return true;
-            }
+bool ModbusPollScheduler::polls(const ModbusDevice &dev, const ModbusTransport transport, const uint8_t bus) {
+    return dev.transport() == transport && (transport != ModbusTransport::Rtu || dev.bus == bus);
+}
+
+void ModbusPollScheduler::assignPhases(const std::vector<ModbusDevice> &devices,
+                                       const ModbusTransport transport,
+                                       const uint8_t bus) {
+    _phases.clear();
+    for (size_t d = 0; d < devices.size(); ++d) {
+        if (!polls(devices[d], transport, bus)) continue;
+        for (const auto &dp: devices[d].datapoints) {
+            if (!isReadOnlyFunction(dp.function) || dp.pollIntervalMs == 0) continue;
+            if (phaseOf(static_cast<uint16_t>(d), dp.pollIntervalMs) != UINT32_MAX) continue;
+            PhaseGroup group{};
+            group.intervalMs = dp.pollIntervalMs;
+            group.device = static_cast<uint16_t>(d);
+            group.offsetMs = 0;
+            _phases.push_back(group);
+        }
+    }
+
+    // Spread groups sharing an interval evenly, in device order.
+    for (size_t g = 0; g < _phases.size(); ++g) {
+        size_t slot = 0;
+        size_t slots = 0;
+        for (size_t o = 0; o < _phases.size(); ++o) {
+            if (_phases[o].intervalMs != _phases[g].intervalMs) continue;
+            if (o < g) ++slot;
+            ++slots;
+        }
+        _phases[g].offsetMs = ModbusDeadlineQueue::phaseOffset(_phases[g].intervalMs, slot, slots);
+    }
+}
+
+uint32_t ModbusPollScheduler::phaseOf(const uint16_t device, const uint32_t intervalMs) const {
+    for (const auto &group: _phases) {
+        if (group.device == device && group.intervalMs == intervalMs) {
+            return group.offsetMs;
         }
     }
-    return false;
+    return UINT32_MAX;
 }
 
-size_t ModbusPollScheduler::collectDueReadDatapoints(ModbusDevice &device,
-                                                     const uint32_t nowMs,
-                                                     std::vector<ModbusDatapoint *> &out) {
-    for (auto &dp : device.datapoints) {
-        if (isDue(dp, nowMs)) {
-            out.push_back(&dp);
+void ModbusPollScheduler::rebuild(std::vector<ModbusDevice> &devices,
+                                  const uint32_t nowMs,
+                                  const bool fixedRate,
+                                  const ModbusTransport transport,
+                                  const uint8_t bus) {
+    _queue.clear();
+    _deviceCount = devices.size();
+    _fixedRate = fixedRate;
+    if (fixedRate) {
+        assignPhases(devices, transport, bus);
+    } else {
+        _phases.clear();
+    }
+
+    size_t reads = 0;
+    for (const auto &dev: devices) {
+        if (!polls(dev, transport, bus)) continue;
+        for (const auto &dp: dev.datapoints) {
+            if (isReadOnlyFunction(dp.function)) ++reads;
+        }
+    }
+    _queue.reserve(reads);
+    _deviceRank.reserve(_deviceCount);
+
+    for (size_t d = 0; d < devices.size(); ++d) {
+        if (!polls(devices[d], transport, bus)) continue;
+        auto &datapoints = devices[d].datapoints;
+        for (size_t i = 0; i < datapoints.size(); ++i) {
+            ModbusDatapoint &dp = datapoints[i];
+            if (!isReadOnlyFunction(dp.function)) {
+                continue;
+            }
+            const uint32_t phase = fixedRate ? phaseOf(static_cast<uint16_t>(d), dp.pollIntervalMs) : 0;
+            dp.nextDueAtMs = nowMs + (phase == UINT32_MAX ? 0 : phase);
+            dp.lastLatenessMs = 0;
+            dp.late = false;
+            ModbusDeadline entry{};
+            entry.dueAtMs = dp.nextDueAtMs;
+            entry.priority = static_cast<uint8_t>(dp.priority);
+            entry.device = static_cast<uint16_t>(d);
+            entry.datapoint = static_cast<uint16_t>(i);
+            _queue.push(entry);
         }
     }
-    return out.size();
+}
+
+size_t ModbusPollScheduler::takeDue(const uint32_t nowMs, std::vector<ModbusDeadline> &out) {
+    out.clear();
+    const size_t taken = _queue.popDue(nowMs, out);
+    ModbusDeadlineQueue::groupByDevice(out, _deviceCount, _deviceRank);
+    return taken;
+}
+
+void ModbusPollScheduler::requeue(const ModbusDeadline &entry, const ModbusDatapoint &dp) {
+    ModbusDeadline next = entry;
+    next.dueAtMs = dp.nextDueAtMs;
+    _queue.push(next);
+}
+
+uint32_t ModbusPollScheduler::msUntilNextDue(const uint32_t nowMs) const {
+    return _queue.msUntilNext(nowMs);
+}
+
+size_t ModbusPollScheduler::size() const {
+    return _queue.size();
 }
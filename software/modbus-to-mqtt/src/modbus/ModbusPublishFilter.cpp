@@ -0,0 +1,49 @@
+#include "modbus/ModbusPublishFilter.h"
+
+#include <cmath>
+
+bool ModbusPublishFilter::reportsByException() const {
+    return onChange || deadband > 0.0f || heartbeatMs > 0;
+}
+
+bool ModbusPublishFilter::heartbeatDue(const uint32_t nowMs) const {
+    return heartbeatMs > 0 && nowMs - _lastPublishedMs >= heartbeatMs;
+}
+
+bool ModbusPublishFilter::shouldPublish(const double value, const uint32_t nowMs) const {
+    if (!reportsByException() || !_hasPublished || heartbeatDue(nowMs)) {
+        return true;
+    }
+    const bool wasNan = std::isnan(_lastValue);
+    if (std::isnan(value) || wasNan) {
+        return std::isnan(value) != wasNan;
+    }
+    double band = deadband;
+    if (deadbandType == ModbusDeadbandType::Percent) {
+        band = std::fabs(_lastValue) * deadband / 100.0;
+    }
+    return std::fabs(value - _lastValue) > band;
+}
+
+bool ModbusPublishFilter::shouldPublishText(const char *text, const size_t length, const uint32_t nowMs) {
+    if (!reportsByException()) {
+        return true;
+    }
+    if (_hasPublished && !heartbeatDue(nowMs) && _lastText.compare(0, std::string::npos, text, length) == 0) {
+        return false;
+    }
+    // Both strings keep their capacity, so once warm this does not allocate.
+    _pendingText.assign(text, length);
+    _textPending = true;
+    return true;
+}
+
+void ModbusPublishFilter::published(const double value, const uint32_t nowMs) {
+    _hasPublished = true;
+    _lastValue = value;
+    _lastPublishedMs = nowMs;
+    if (_textPending) {
+        _lastText.swap(_pendingText);
+        _textPending = false;
+    }
+}
@@ -0,0 +1,94 @@
+#include "modbus/ModbusReadPlanner.h"
+
+#include <algorithm>
+
+#include "modbus/ModbusFunctionUtils.h"
+
+constexpr uint16_t ModbusReadPlanner::kMaxReadRegisters;
+constexpr uint16_t ModbusReadPlanner::kMaxReadBits;
+
+bool ModbusReadPlanner::isBitFunction(const ModbusFunctionType fn) {
+    return fn == READ_COIL || fn == READ_DISCRETE;
+}
+
+size_t ModbusReadPlanner::plan(const ModbusReadRequest *requests,
+                               const size_t count,
+                               const Limits &limits,
+                               std::vector<ModbusReadBlock> &blocks,
+                               std::vector<size_t> &members) {
+    blocks.clear();
+    members.clear();
+    if (!requests || count == 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        // A write datapoint has nothing to read back on a poll.
+        if (isReadOnlyFunction(requests[i].function)) {
+            members.push_back(i);
+        }
+    }
+
+    // Order by table, then address; wider requests first so a block always
+    // opens with the request that reaches furthest from its start.
+    std::sort(members.begin(), members.end(), [requests](const size_t a, const size_t b) {
+        const ModbusReadRequest &ra = requests[a];
+        const ModbusReadRequest &rb = requests[b];
+        if (ra.function != rb.function) return ra.function < rb.function;
+        if (ra.address != rb.address) return ra.address < rb.address;
+        return ra.count > rb.count;
+    });
+
+    auto widthOf = [](const ModbusReadRequest &r) -> uint32_t {
+        return r.count ? r.count : 1U;
+    };
+
+    uint32_t blockEnd = 0; // exclusive
+    for (size_t pos = 0; pos < members.size(); ++pos) {
+        const ModbusReadRequest &req = requests[members[pos]];
+        const uint32_t start = req.address;
+        const uint32_t end = start + widthOf(req);
+
+        if (!blocks.empty()) {
+            ModbusReadBlock &open = blocks.back();
+            const uint32_t maxSpan = isBitFunction(open.function) ? limits.maxBits : limits.maxRegisters;
+            const uint32_t gap = (start > blockEnd) ? (start - blockEnd) : 0U;
+            const uint32_t mergedEnd = std::max(blockEnd, end);
+            if (open.function == req.function &&
+                gap <= limits.maxGap &&
+                mergedEnd - open.address <= maxSpan) {
+                blockEnd = mergedEnd;
+                open.count = static_cast<uint16_t>(blockEnd - open.address);
+                ++open.memberCount;
+                continue;
+            }
+        }
+
+        ModbusReadBlock block{};
+        block.function = req.function;
+        block.address = req.address;
+        block.count = static_cast<uint16_t>(widthOf(req));
+        block.firstMember = pos;
+        block.memberCount = 1;
+        blocks.push_back(block);
+        blockEnd = end;
+    }
+    return blocks.size();
+}
+
+void ModbusReadPlanner::extractBits(const uint16_t *packed,
+                                    const uint16_t bitOffset,
+                                    const uint16_t count,
+                                    uint16_t *out) {
+    const uint16_t outWords = static_cast<uint16_t>((count + 15U) / 16U);
+    for (uint16_t w = 0; w < outWords; ++w) {
+        out[w] = 0;
+    }
+    for (uint16_t i = 0; i < count; ++i) {
+        const uint32_t src = static_cast<uint32_t>(bitOffset) + i;
+        const bool set = (packed[src / 16U] >> (src % 16U)) & 0x1U;
+        if (set) {
+            out[i / 16U] = static_cast<uint16_t>(out[i / 16U] | (1U << (i % 16U)));
+        }
+    }
+}
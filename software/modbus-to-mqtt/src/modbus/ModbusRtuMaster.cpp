@@ -0,0 +1,342 @@
+#include "modbus/ModbusRtuMaster.h"
+
+constexpr uint16_t ModbusRtuMaster::kMaxWords;
+constexpr uint16_t ModbusRtuMaster::kMaxWriteCoils;
+constexpr uint16_t ModbusRtuMaster::kMaxWriteRegisters;
+constexpr uint16_t ModbusRtuMaster::kMaxReadWriteRegisters;
+constexpr size_t ModbusRtuMaster::kMaxFrameBytes;
+constexpr uint32_t ModbusRtuMaster::kIdle;
+constexpr uint32_t ModbusRtuMaster::kNoResponse;
+
+namespace {
+
+constexpr uint16_t kMaxReadBits = 2000;
+constexpr uint16_t kMaxReadRegisters = 125;
+
+bool isReadFunction(const uint8_t function) {
+    return function >= 1 && function <= 4;
+}
+
+bool isBitRead(const uint8_t function) {
+    return function == 1 || function == 2;
+}
+
+// FC23 answers with the registers it read, like FC03.
+bool returnsData(const uint8_t function) {
+    return isReadFunction(function) || function == 23;
+}
+
+bool isSupported(const uint8_t function) {
+    return returnsData(function) || function == 5 || function == 6 || function == 15 || function == 16;
+}
+
+size_t putWord(uint8_t *out, size_t at, const uint16_t value) {
+    out[at++] = static_cast<uint8_t>(value >> 8U);
+    out[at++] = static_cast<uint8_t>(value & 0xFFU);
+    return at;
+}
+
+} // namespace
+
+size_t ModbusRtuPort::readAvailable(uint8_t *dst, const size_t capacity) {
+    size_t n = 0;
+    while (n < capacity && available() > 0) {
+        const int b = read();
+        if (b < 0) {
+            break;
+        }
+        dst[n++] = static_cast<uint8_t>(b);
+    }
+    return n;
+}
+
+void ModbusRtuMaster::setPort(ModbusRtuPort *port) {
+    _port = port;
+}
+
+void ModbusRtuMaster::setLineTiming(const ModbusLineTiming &line) {
+    _line = line;
+}
+
+void ModbusRtuMaster::setResponseTimeoutUs(const uint32_t timeoutUs) {
+    _responseTimeoutUs = timeoutUs;
+}
+
+uint8_t ModbusRtuMaster::start(const ModbusRtuRequest &request,
+                               const uint32_t nowUs,
+                               const ModbusRtuCallback onComplete,
+                               void *context) {
+    if (_state != State::Idle || _port == nullptr) {
+        return ModbusRtuStatus::Busy;
+    }
+    if (!isSupported(request.function)) {
+        return ModbusRtuStatus::IllegalFunction;
+    }
+    _txLength = encode(request, _tx, sizeof(_tx));
+    if (_txLength == 0) {
+        return ModbusRtuStatus::IllegalDataValue;
+    }
+    _slaveId = request.slaveId;
+    _function = request.function;
+    _readCount = request.count;
+    _expectedRxUs = ModbusBusTiming::responseBytes(static_cast<ModbusFunctionType>(request.function), request.count) *
+                    _line.charUs;
+    _onComplete = onComplete;
+    _context = context;
+    _rxLength = 0;
+    _state = State::Silence;
+    _stateSinceUs = nowUs;
+    return ModbusRtuStatus::Success;
+}
+
+uint32_t ModbusRtuMaster::poll(const uint32_t nowUs) {
+    for (;;) {
+        switch (_state) {
+            case State::Idle:
+                return kIdle;
+
+            case State::Silence: {
+                const uint32_t waitUs = _lineUsed
+                                            ? ModbusBusTiming::silenceToWaitUs(_line.interFrameUs, nowUs - _lastFrameEndUs)
+                                            : 0;
+                if (waitUs > 0) {
+                    return waitUs;
+                }
+                // Anything still buffered would be taken for the response.
+                while (_port->readAvailable(_rx, sizeof(_rx)) > 0) {
+                }
+                (void) _port->takeLineIdle();
+                _port->transmit(_tx, _txLength);
+                _state = State::Transmit;
+                _stateSinceUs = nowUs;
+                break;
+            }
+
+            case State::Transmit: {
+                if (!_port->transmitDone()) {
+                    const uint32_t elapsedUs = nowUs - _stateSinceUs;
+                    const uint32_t frameUs = static_cast<uint32_t>(_txLength) * _line.charUs;
+                    return elapsedUs < frameUs ? frameUs - elapsedUs : _line.charUs;
+                }
+                _state = State::Await;
+                _stateSinceUs = nowUs;
+                break;
+            }
+
+            case State::Await: {
+                receive();
+                // A gap ends the frame: catch bytes that landed alongside the
+                // event, then judge whatever arrived.
+                const bool lineIdle = _rxLength > 0 && _port->takeLineIdle();
+                if (lineIdle) {
+                    receive();
+                }
+                const size_t expected = expectedResponseBytes();
+                if (expected > 0 && _rxLength >= expected) {
+                    uint16_t wordCount = 0;
+                    const uint8_t status = parseResponse(wordCount);
+                    complete(status, wordCount, nowUs);
+                    break;
+                }
+                if (lineIdle) {
+                    // Too short to be the answer; no point waiting for more.
+                    complete(ModbusRtuStatus::InvalidCrc, 0, nowUs);
+                    break;
+                }
+                const uint32_t elapsedUs = nowUs - _stateSinceUs;
+                const uint32_t windowUs = _responseTimeoutUs + _expectedRxUs;
+                if (elapsedUs >= windowUs) {
+                    complete(ModbusRtuStatus::ResponseTimedOut, 0, nowUs);
+                    break;
+                }
+                return windowUs - elapsedUs;
+            }
+        }
+    }
+}
+
+bool ModbusRtuMaster::busy() const {
+    return _state != State::Idle;
+}
+
+ModbusRtuMaster::State ModbusRtuMaster::state() const {
+    return _state;
+}
+
+uint32_t ModbusRtuMaster::lastTurnaroundUs() const {
+    return _lastTurnaroundUs;
+}
+
+uint16_t ModbusRtuMaster::crc16(const uint8_t *data, const size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1U) ? static_cast<uint16_t>((crc >> 1U) ^ 0xA001U) : static_cast<uint16_t>(crc >> 1U);
+        }
+    }
+    return crc;
+}
+
+size_t ModbusRtuMaster::encode(const ModbusRtuRequest &request, uint8_t *out, const size_t capacity) {
+    const uint8_t fn = request.function;
+    size_t length = 0;
+    if (isReadFunction(fn)) {
+        const uint16_t limit = isBitRead(fn) ? kMaxReadBits : kMaxReadRegisters;
+        if (request.count == 0 || request.count > limit || capacity < 8) {
+            return 0;
+        }
+        out[length++] = request.slaveId;
+        out[length++] = fn;
+        length = putWord(out, length, request.address);
+        length = putWord(out, length, request.count);
+    } else if (fn == 5 || fn == 6) {
+        if (request.values == nullptr || capacity < 8) {
+            return 0;
+        }
+        const uint16_t value = (fn == 5) ? (request.values[0] ? 0xFF00 : 0x0000) : request.values[0];
+        out[length++] = request.slaveId;
+        out[length++] = fn;
+        length = putWord(out, length, request.address);
+        length = putWord(out, length, value);
+    } else if (fn == 15) {
+        const uint16_t bytes = static_cast<uint16_t>((request.count + 7U) / 8U);
+        const size_t needed = 9U + bytes;
+        if (request.values == nullptr || request.count == 0 || request.count > kMaxWriteCoils || capacity < needed) {
+            return 0;
+        }
+        out[length++] = request.slaveId;
+        out[length++] = fn;
+        length = putWord(out, length, request.address);
+        length = putWord(out, length, request.count);
+        out[length++] = static_cast<uint8_t>(bytes);
+        for (uint16_t b = 0; b < bytes; ++b) {
+            out[length++] = static_cast<uint8_t>((request.values[b / 2U] >> (8U * (b % 2U))) & 0xFFU);
+        }
+    } else if (fn == 16) {
+        const size_t needed = 9U + 2U * request.count;
+        if (request.values == nullptr || request.count == 0 || request.count > kMaxWriteRegisters ||
+            capacity < needed) {
+            return 0;
+        }
+        out[length++] = request.slaveId;
+        out[length++] = fn;
+        length = putWord(out, length, request.address);
+        length = putWord(out, length, request.count);
+        out[length++] = static_cast<uint8_t>(request.count * 2U);
+        for (uint16_t i = 0; i < request.count; ++i) {
+            length = putWord(out, length, request.values[i]);
+        }
+    } else if (fn == 23) {
+        const size_t needed = 13U + 2U * request.writeCount;
+        if (request.values == nullptr || request.count == 0 || request.count > kMaxReadRegisters ||
+            request.writeCount == 0 || request.writeCount > kMaxReadWriteRegisters || capacity < needed) {
+            return 0;
+        }
+        out[length++] = request.slaveId;
+        out[length++] = fn;
+        length = putWord(out, length, request.address);
+        length = putWord(out, length, request.count);
+        length = putWord(out, length, request.writeAddress);
+        length = putWord(out, length, request.writeCount);
+        out[length++] = static_cast<uint8_t>(request.writeCount * 2U);
+        for (uint16_t i = 0; i < request.writeCount; ++i) {
+            length = putWord(out, length, request.values[i]);
+        }
+    } else {
+        return 0;
+    }
+    const uint16_t crc = crc16(out, length);
+    out[length++] = static_cast<uint8_t>(crc & 0xFFU);
+    out[length++] = static_cast<uint8_t>(crc >> 8U);
+    return length;
+}
+
+void ModbusRtuMaster::receive() {
+    if (_rxLength < sizeof(_rx)) {
+        _rxLength += _port->readAvailable(_rx + _rxLength, sizeof(_rx) - _rxLength);
+    }
+}
+
+size_t ModbusRtuMaster::expectedResponseBytes() const {
+    if (_rxLength < 2) {
+        return 0;
+    }
+    if (_rx[1] & 0x80U) {
+        return 5;
+    }
+    if (!returnsData(_function)) {
+        return 8;
+    }
+    if (_rxLength < 3) {
+        return 0;
+    }
+    const size_t length = 5U + _rx[2];
+    // An oversized byte count cannot be a valid answer; let the CRC reject it.
+    return length < sizeof(_rx) ? length : sizeof(_rx);
+}
+
+uint8_t ModbusRtuMaster::parseResponse(uint16_t &wordCount) {
+    wordCount = 0;
+    const size_t length = expectedResponseBytes();
+    const uint16_t crc = crc16(_rx, length - 2);
+    if (_rx[length - 2] != static_cast<uint8_t>(crc & 0xFFU) || _rx[length - 1] != static_cast<uint8_t>(crc >> 8U)) {
+        return ModbusRtuStatus::InvalidCrc;
+    }
+    if (_rx[0] != _slaveId) {
+        return ModbusRtuStatus::InvalidSlaveId;
+    }
+    if ((_rx[1] & 0x7FU) != _function) {
+        return ModbusRtuStatus::InvalidFunction;
+    }
+    if (_rx[1] & 0x80U) {
+        return _rx[2];
+    }
+    if (!returnsData(_function)) {
+        return ModbusRtuStatus::Success;
+    }
+
+    const uint8_t bytes = _rx[2];
+    // A short answer would leave the tail of the block stale.
+    const uint32_t expected = isBitRead(_function) ? (_readCount + 7UL) / 8UL : 2UL * _readCount;
+    if (bytes != expected) {
+        return ModbusRtuStatus::InvalidFunction;
+    }
+    const uint8_t *data = _rx + 3;
+    if (isBitRead(_function)) {
+        // Bits pack from the low byte up, as ModbusMaster delivered them.
+        const uint16_t words = static_cast<uint16_t>((bytes + 1U) / 2U);
+        wordCount = words < kMaxWords ? words : kMaxWords;
+        for (uint16_t i = 0; i < wordCount; ++i) {
+            const size_t lo = 2U * i;
+            const uint16_t high = (lo + 1U < bytes) ? data[lo + 1U] : 0U;
+            _words[i] = static_cast<uint16_t>((high << 8U) | data[lo]);
+        }
+    } else {
+        const uint16_t words = static_cast<uint16_t>(bytes / 2U);
+        wordCount = words < kMaxWords ? words : kMaxWords;
+        for (uint16_t i = 0; i < wordCount; ++i) {
+            _words[i] = static_cast<uint16_t>((data[2U * i] << 8U) | data[2U * i + 1U]);
+        }
+    }
+    return ModbusRtuStatus::Success;
+}
+
+void ModbusRtuMaster::complete(const uint8_t status, const uint16_t wordCount, const uint32_t nowUs) {
+    _lastTurnaroundUs = kNoResponse;
+    if (_rxLength > 0) {
+        const uint32_t elapsedUs = nowUs - _stateSinceUs;
+        const uint32_t frameUs = static_cast<uint32_t>(_rxLength) * _line.charUs;
+        _lastTurnaroundUs = elapsedUs > frameUs ? elapsedUs - frameUs : 0;
+    }
+    _state = State::Idle;
+    _lastFrameEndUs = nowUs;
+    _lineUsed = true;
+    const ModbusRtuCallback callback = _onComplete;
+    void *context = _context;
+    _onComplete = nullptr;
+    _context = nullptr;
+    if (callback) {
+        callback(context, status, _words, wordCount);
+    }
+}
@@ -0,0 +1,141 @@
+#include "modbus/ModbusShadowImage.h"
+
+constexpr size_t ModbusShadowImage::kMaxItems;
+
+namespace {
+
+enum ShadowTable : int {
+    Coils = 0,
+    DiscreteInputs = 1,
+    HoldingRegisters = 2,
+    InputRegisters = 3,
+};
+
+bool isShadowBitTable(const int table) {
+    return table == Coils || table == DiscreteInputs;
+}
+
+} // namespace
+
+int ModbusShadowImage::tableOf(const uint8_t function) {
+    switch (function) {
+        case 1:
+        case 5:
+        case 15:
+            return Coils;
+        case 2:
+            return DiscreteInputs;
+        case 3:
+        case 6:
+        case 16:
+        case 23:
+            return HoldingRegisters;
+        case 4:
+            return InputRegisters;
+        default:
+            return -1;
+    }
+}
+
+uint32_t ModbusShadowImage::keyOf(const uint8_t slaveId, const int table, const uint16_t address) {
+    return (static_cast<uint32_t>(slaveId) << 18U) | (static_cast<uint32_t>(table) << 16U) | address;
+}
+
+size_t ModbusShadowImage::lowerBound(const uint32_t key) const {
+    size_t lo = 0;
+    size_t hi = _items.size();
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2U;
+        if (_items[mid].key < key) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void ModbusShadowImage::store(const uint8_t slaveId, const uint8_t function, const uint16_t address,
+                              const uint16_t count, const uint16_t *words, const uint32_t nowMs) {
+    const int table = tableOf(function);
+    if (table < 0 || !words || count == 0 || static_cast<uint32_t>(address) + count > 0x10000U) {
+        return;
+    }
+    const bool bits = isShadowBitTable(table);
+    const uint32_t first = keyOf(slaveId, table, address);
+    size_t pos = lowerBound(first);
+    for (uint16_t i = 0; i < count; ++i, ++pos) {
+        const uint32_t key = first + i;
+        const uint16_t value = bits ? static_cast<uint16_t>((words[i / 16U] >> (i % 16U)) & 1U) : words[i];
+        if (pos == _items.size() || _items[pos].key != key) {
+            if (_items.size() >= kMaxItems) {
+                return;
+            }
+            _items.insert(_items.begin() + static_cast<std::ptrdiff_t>(pos), Item{key, 0, 0, false});
+        }
+        Item &item = _items[pos];
+        item.value = value;
+        item.updatedAtMs = nowMs;
+        item.valid = true;
+    }
+}
+
+bool ModbusShadowImage::lookup(const uint8_t slaveId, const uint8_t function, const uint16_t address,
+                               const uint16_t count, const uint32_t nowMs, const uint32_t maxAgeMs,
+                               uint16_t *outWords, const uint16_t outCapacity, uint16_t &outCount) const {
+    const int table = tableOf(function);
+    if (table < 0 || function > 4 || count == 0 || !outWords) {
+        return false;
+    }
+    const bool bits = isShadowBitTable(table);
+    const uint16_t words = bits ? static_cast<uint16_t>((count + 15U) / 16U) : count;
+    if (words > outCapacity) {
+        return false;
+    }
+    const uint32_t first = keyOf(slaveId, table, address);
+    const size_t pos = lowerBound(first);
+    if (pos + count > _items.size()) {
+        return false;
+    }
+    for (uint16_t i = 0; i < count; ++i) {
+        const Item &item = _items[pos + i];
+        if (item.key != first + i || !item.valid || nowMs - item.updatedAtMs >= maxAgeMs) {
+            return false;
+        }
+    }
+
+    if (bits) {
+        for (uint16_t w = 0; w < words; ++w) {
+            outWords[w] = 0;
+        }
+        for (uint16_t i = 0; i < count; ++i) {
+            outWords[i / 16U] = static_cast<uint16_t>(outWords[i / 16U] | (_items[pos + i].value << (i % 16U)));
+        }
+    } else {
+        for (uint16_t i = 0; i < count; ++i) {
+            outWords[i] = _items[pos + i].value;
+        }
+    }
+    outCount = words;
+    return true;
+}
+
+void ModbusShadowImage::invalidate(const uint8_t slaveId, const uint8_t function, const uint16_t address,
+                                   const uint16_t count) {
+    const int table = tableOf(function);
+    if (table < 0) {
+        return;
+    }
+    const uint32_t first = keyOf(slaveId, table, address);
+    for (size_t pos = lowerBound(first); pos < _items.size() && _items[pos].key < first + count; ++pos) {
+        _items[pos].valid = false;
+    }
+}
+
+void ModbusShadowImage::clear() {
+    _items.clear();
+}
+
+size_t ModbusShadowImage::size() const {
+    return _items.size();
+}
@@ -0,0 +1,310 @@
+#include "modbus/ModbusTcpAdu.h"
+
+#include "modbus/ModbusReadPlanner.h"
+#include "modbus/ModbusRtuMaster.h"
+
+constexpr uint16_t ModbusTcpAdu::kDefaultPort;
+constexpr size_t ModbusTcpAdu::kHeaderBytes;
+constexpr size_t ModbusTcpAdu::kMaxAduBytes;
+
+namespace {
+
+uint16_t mbapWord(const uint8_t *buf) {
+    return static_cast<uint16_t>((buf[0] << 8U) | buf[1]);
+}
+
+size_t putMbapWord(uint8_t *out, const size_t at, const uint16_t value) {
+    out[at] = static_cast<uint8_t>(value >> 8U);
+    out[at + 1U] = static_cast<uint8_t>(value & 0xFFU);
+    return at + 2U;
+}
+
+// MBAP header with the length field covering the unit id and pduBytes.
+size_t putHeader(const ModbusTcpRequest &request, const size_t pduBytes, uint8_t *out) {
+    size_t at = putMbapWord(out, 0, request.transactionId);
+    at = putMbapWord(out, at, 0);
+    at = putMbapWord(out, at, static_cast<uint16_t>(pduBytes + 1U));
+    out[at++] = request.unitId;
+    return at;
+}
+
+} // namespace
+
+bool ModbusTcpAdu::isRead(const uint8_t function) {
+    return function >= 1 && function <= 4;
+}
+
+ModbusTcpParse ModbusTcpAdu::parse(const uint8_t *buf, const size_t length, ModbusTcpRequest &out,
+                                   uint8_t &exceptionCode, size_t &consumed) {
+    consumed = 0;
+    exceptionCode = 0;
+    if (length < kHeaderBytes) {
+        return ModbusTcpParse::Incomplete;
+    }
+    const uint16_t protocolId = mbapWord(buf + 2);
+    const uint16_t mbapLength = mbapWord(buf + 4);
+    // The length covers the unit id and a PDU of at least a function code.
+    if (protocolId != 0 || mbapLength < 2 || kHeaderBytes - 1U + mbapLength > kMaxAduBytes) {
+        return ModbusTcpParse::Malformed;
+    }
+    const size_t total = kHeaderBytes - 1U + mbapLength;
+    if (length < total) {
+        return ModbusTcpParse::Incomplete;
+    }
+    consumed = total;
+
+    out = ModbusTcpRequest{};
+    out.transactionId = mbapWord(buf);
+    out.unitId = buf[6];
+    out.function = buf[7];
+    const uint8_t *pdu = buf + 8;
+    const size_t pduData = total - 8U;
+
+    auto refuse = [&exceptionCode](const uint8_t code) {
+        exceptionCode = code;
+        return ModbusTcpParse::Exception;
+    };
+
+    switch (out.function) {
+        case 1:
+        case 2:
+        case 3:
+        case 4: {
+            if (pduData != 4) return refuse(ModbusTcpException::IllegalDataValue);
+            out.address = mbapWord(pdu);
+            out.count = mbapWord(pdu + 2);
+            const uint16_t limit = out.function <= 2 ? ModbusReadPlanner::kMaxReadBits : ModbusReadPlanner::kMaxReadRegisters;
+            if (out.count == 0 || out.count > limit) return refuse(ModbusTcpException::IllegalDataValue);
+            break;
+        }
+        case 5:
+        case 6:
+            if (pduData != 4) return refuse(ModbusTcpException::IllegalDataValue);
+            out.address = mbapWord(pdu);
+            out.value = mbapWord(pdu + 2);
+            out.count = 1;
+            if (out.function == 5 && out.value != 0x0000 && out.value != 0xFF00) {
+                return refuse(ModbusTcpException::IllegalDataValue);
+            }
+            break;
+        case 15:
+        case 16: {
+            if (pduData < 5) return refuse(ModbusTcpException::IllegalDataValue);
+            out.address = mbapWord(pdu);
+            out.count = mbapWord(pdu + 2);
+            const bool coils = out.function == 15;
+            const uint16_t limit = coils ? ModbusRtuMaster::kMaxWriteCoils : ModbusRtuMaster::kMaxWriteRegisters;
+            const size_t bytes = coils ? (out.count + 7U) / 8U : 2U * out.count;
+            if (out.count == 0 || out.count > limit || pdu[4] != bytes || pduData != 5U + bytes) {
+                return refuse(ModbusTcpException::IllegalDataValue);
+            }
+            out.writeData = pdu + 5;
+            break;
+        }
+        case 23:
+            if (pduData < 9) return refuse(ModbusTcpException::IllegalDataValue);
+            out.address = mbapWord(pdu);
+            out.count = mbapWord(pdu + 2);
+            out.writeAddress = mbapWord(pdu + 4);
+            out.writeCount = mbapWord(pdu + 6);
+            if (out.count == 0 || out.count > ModbusReadPlanner::kMaxReadRegisters || out.writeCount == 0 ||
+                out.writeCount > ModbusRtuMaster::kMaxReadWriteRegisters || pdu[8] != 2U * out.writeCount ||
+                pduData != 9U + 2U * out.writeCount) {
+                return refuse(ModbusTcpException::IllegalDataValue);
+            }
+            out.writeData = pdu + 9;
+            break;
+        default:
+            return refuse(ModbusTcpException::IllegalFunction);
+    }
+    if (out.unitId == 0) {
+        // Broadcasts get no answer on RTU, so there is nothing to relay.
+        return refuse(ModbusTcpException::GatewayPathUnavailable);
+    }
+    return ModbusTcpParse::Request;
+}
+
+size_t ModbusTcpAdu::encodeResponse(const ModbusTcpRequest &request, const uint8_t status, const uint16_t *words,
+                                    const uint16_t count, uint8_t *out, const size_t capacity) {
+    if (status != ModbusRtuStatus::Success) {
+        return encodeException(request, exceptionFor(status), out, capacity);
+    }
+
+    // FC23 answers with the registers it read.
+    if (isRead(request.function) || request.function == 23) {
+        const bool bits = request.function <= 2;
+        const size_t dataBytes = bits ? (request.count + 7U) / 8U : 2U * request.count;
+        const size_t total = kHeaderBytes + 2U + dataBytes;
+        if (capacity < total) {
+            return 0;
+        }
+        size_t at = putHeader(request, 2U + dataBytes, out);
+        out[at++] = request.function;
+        out[at++] = static_cast<uint8_t>(dataBytes);
+        for (size_t i = 0; i < dataBytes; ++i) {
+            uint8_t byte = 0;
+            const size_t word = i / 2U;
+            if (words && word < count) {
+                // Registers go out big-endian; the RTU master packed bit
+                // bytes into words low byte first.
+                const bool high = bits ? (i % 2U) != 0 : (i % 2U) == 0;
+                byte = static_cast<uint8_t>(high ? words[word] >> 8U : words[word] & 0xFFU);
+            }
+            out[at++] = byte;
+        }
+        return at;
+    }
+
+    // Write responses echo the address with the value (FC05/06) or quantity.
+    const bool multiple = request.function == 15 || request.function == 16;
+    const size_t total = kHeaderBytes + 5U;
+    if (capacity < total) {
+        return 0;
+    }
+    size_t at = putHeader(request, 5U, out);
+    out[at++] = request.function;
+    at = putMbapWord(out, at, request.address);
+    at = putMbapWord(out, at, multiple ? request.count : request.value);
+    return at;
+}
+
+size_t ModbusTcpAdu::encodeException(const ModbusTcpRequest &request, const uint8_t code, uint8_t *out,
+                                     const size_t capacity) {
+    if (capacity < kHeaderBytes + 2U) {
+        return 0;
+    }
+    size_t at = putHeader(request, 2U, out);
+    out[at++] = static_cast<uint8_t>(request.function | 0x80U);
+    out[at++] = code;
+    return at;
+}
+
+size_t ModbusTcpAdu::encodeRequest(const ModbusTcpRequest &request, uint8_t *out, const size_t capacity) {
+    if (capacity < kHeaderBytes + 5U) {
+        return 0;
+    }
+    if (request.function == 16) {
+        if (capacity < kHeaderBytes + 8U) {
+            return 0;
+        }
+        size_t at = putHeader(request, 8U, out);
+        out[at++] = request.function;
+        at = putMbapWord(out, at, request.address);
+        at = putMbapWord(out, at, 1);
+        out[at++] = 2;
+        return putMbapWord(out, at, request.value);
+    }
+    size_t at = putHeader(request, 5U, out);
+    out[at++] = request.function;
+    at = putMbapWord(out, at, request.address);
+    return putMbapWord(out, at, isRead(request.function) ? request.count : request.value);
+}
+
+ModbusTcpParse ModbusTcpAdu::parseResponse(const uint8_t *buf, const size_t length, ModbusTcpResponse &out,
+                                           uint16_t *words, const uint16_t capacity, size_t &consumed) {
+    consumed = 0;
+    if (length < kHeaderBytes) {
+        return ModbusTcpParse::Incomplete;
+    }
+    const uint16_t mbapLength = mbapWord(buf + 4);
+    if (mbapWord(buf + 2) != 0 || mbapLength < 3 || kHeaderBytes - 1U + mbapLength > kMaxAduBytes) {
+        return ModbusTcpParse::Malformed;
+    }
+    const size_t total = kHeaderBytes - 1U + mbapLength;
+    if (length < total) {
+        return ModbusTcpParse::Incomplete;
+    }
+    consumed = total;
+
+    out = ModbusTcpResponse{};
+    out.transactionId = mbapWord(buf);
+    out.unitId = buf[6];
+    out.function = static_cast<uint8_t>(buf[7] & 0x7FU);
+    const uint8_t *pdu = buf + 8;
+    const size_t pduData = total - 8U;
+
+    if (buf[7] & 0x80U) {
+        const uint8_t code = pdu[0];
+        if (code >= ModbusRtuStatus::IllegalFunction && code <= ModbusRtuStatus::SlaveDeviceFailure) {
+            out.status = code;
+        } else if (code == ModbusTcpException::GatewayPathUnavailable ||
+                   code == ModbusTcpException::GatewayTargetFailed) {
+            out.status = ModbusRtuStatus::ResponseTimedOut;
+        } else {
+            out.status = ModbusRtuStatus::SlaveDeviceFailure;
+        }
+        return ModbusTcpParse::Response;
+    }
+
+    out.status = ModbusRtuStatus::Success;
+    if (!isRead(out.function)) {
+        // Write echoes carry nothing to deliver.
+        return pduData == 4 ? ModbusTcpParse::Response : ModbusTcpParse::Malformed;
+    }
+    const uint8_t bytes = pdu[0];
+    if (pduData != 1U + bytes || (out.function > 2 && (bytes % 2U) != 0)) {
+        return ModbusTcpParse::Malformed;
+    }
+    const uint8_t *data = pdu + 1;
+    const uint16_t available = static_cast<uint16_t>((bytes + 1U) / 2U);
+    out.count = available < capacity ? available : capacity;
+    for (uint16_t i = 0; i < out.count; ++i) {
+        const size_t at = 2U * i;
+        const uint16_t second = (at + 1U < bytes) ? data[at + 1U] : 0U;
+        // Bits pack low byte first, as from the RTU master; registers are
+        // big-endian on the wire.
+        words[i] = out.function <= 2 ? static_cast<uint16_t>((second << 8U) | data[at])
+                                     : static_cast<uint16_t>((data[at] << 8U) | second);
+    }
+    return ModbusTcpParse::Response;
+}
+
+uint16_t ModbusTcpAdu::unpackValues(const ModbusTcpRequest &request, uint16_t *words, const uint16_t capacity) {
+    if (request.function == 5 || request.function == 6) {
+        if (capacity < 1) {
+            return 0;
+        }
+        words[0] = request.value;
+        return 1;
+    }
+    if (!request.writeData) {
+        return 0;
+    }
+    if (request.function == 15) {
+        const uint16_t bytes = static_cast<uint16_t>((request.count + 7U) / 8U);
+        const uint16_t n = static_cast<uint16_t>((bytes + 1U) / 2U);
+        if (n > capacity) {
+            return 0;
+        }
+        for (uint16_t i = 0; i < n; ++i) {
+            words[i] = 0;
+        }
+        for (uint16_t b = 0; b < bytes; ++b) {
+            words[b / 2U] |= static_cast<uint16_t>(request.writeData[b] << (8U * (b % 2U)));
+        }
+        return n;
+    }
+    const uint16_t n = request.function == 23 ? request.writeCount : request.function == 16 ? request.count : 0;
+    if (n == 0 || n > capacity) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < n; ++i) {
+        words[i] = mbapWord(request.writeData + 2U * i);
+    }
+    return n;
+}
+
+uint8_t ModbusTcpAdu::exceptionFor(const uint8_t rtuStatus) {
+    switch (rtuStatus) {
+        case ModbusRtuStatus::IllegalFunction:
+        case ModbusRtuStatus::IllegalDataAddress:
+        case ModbusRtuStatus::IllegalDataValue:
+        case ModbusRtuStatus::SlaveDeviceFailure:
+            return rtuStatus;
+        case ModbusRtuStatus::Busy:
+            return ModbusTcpException::SlaveDeviceBusy;
+        default:
+            // Timeouts and frames that never arrived intact.
+            return ModbusTcpException::GatewayTargetFailed;
+    }
+}
@@ -0,0 +1,118 @@
+#include "modbus/ModbusTcpConnection.h"
+
+#include <cstring>
+
+// Connects run on the TCP polling task, so a dead host stalls it for at most
+// this long per attempt.
+static constexpr int32_t MODBUS_TCP_CONNECT_TIMEOUT_MS = 1000;
+static constexpr uint32_t MODBUS_TCP_RECONNECT_MS = 5000;
+
+ModbusTcpConnection::ModbusTcpConnection(String host, const uint16_t port)
+    : _host(std::move(host)), _port(port) {
+}
+
+bool ModbusTcpConnection::matches(const String &host, const uint16_t port) const {
+    return _port == port && _host.equalsIgnoreCase(host);
+}
+
+const String &ModbusTcpConnection::host() const {
+    return _host;
+}
+
+uint16_t ModbusTcpConnection::port() const {
+    return _port;
+}
+
+bool ModbusTcpConnection::ensureConnected(const uint32_t nowMs) {
+    if (_client.connected()) {
+        return true;
+    }
+    if (WiFi.status() != WL_CONNECTED) {
+        return false;
+    }
+    if (_attempted && nowMs - _lastConnectAttemptMs < MODBUS_TCP_RECONNECT_MS) {
+        return false;
+    }
+    _attempted = true;
+    _lastConnectAttemptMs = nowMs;
+    _rxLength = 0;
+    if (!_client.connect(_host.c_str(), _port, MODBUS_TCP_CONNECT_TIMEOUT_MS)) {
+        _client.stop();
+        return false;
+    }
+    _client.setNoDelay(true);
+    return true;
+}
+
+bool ModbusTcpConnection::connected() {
+    return _client.connected();
+}
+
+bool ModbusTcpConnection::full() const {
+    return _pipeline.full();
+}
+
+uint8_t ModbusTcpConnection::send(ModbusTcpRequest request, const uint32_t nowMs, const uint32_t timeoutMs) {
+    const uint8_t slot = _pipeline.begin(nowMs, timeoutMs, request.transactionId);
+    if (slot == ModbusTcpPipeline::kNone) {
+        return slot;
+    }
+    uint8_t frame[ModbusTcpAdu::kMaxAduBytes];
+    const size_t length = ModbusTcpAdu::encodeRequest(request, frame, sizeof(frame));
+    if (!length || _client.write(frame, length) != length) {
+        _pipeline.finish(slot);
+        close();
+        return ModbusTcpPipeline::kNone;
+    }
+    return slot;
+}
+
+bool ModbusTcpConnection::receive(ModbusTcpResponse &response, uint16_t *words, const uint16_t capacity,
+                                  uint8_t &slot) {
+    for (;;) {
+        const int available = _client.available();
+        if (available > 0 && _rxLength < sizeof(_rx)) {
+            const size_t room = sizeof(_rx) - _rxLength;
+            const size_t wanted = static_cast<size_t>(available) < room ? static_cast<size_t>(available) : room;
+            const int got = _client.read(_rx + _rxLength, wanted);
+            if (got > 0) {
+                _rxLength += static_cast<size_t>(got);
+            }
+        }
+
+        size_t consumed = 0;
+        const ModbusTcpParse parsed = ModbusTcpAdu::parseResponse(_rx, _rxLength, response, words, capacity, consumed);
+        if (parsed == ModbusTcpParse::Incomplete) {
+            return false;
+        }
+        if (parsed == ModbusTcpParse::Malformed) {
+            // Out of step with the server; only a fresh socket recovers.
+            close();
+            return false;
+        }
+        memmove(_rx, _rx + consumed, _rxLength - consumed);
+        _rxLength -= consumed;
+
+        slot = _pipeline.match(response.transactionId);
+        if (slot != ModbusTcpPipeline::kNone) {
+            _pipeline.finish(slot);
+            return true;
+        }
+    }
+}
+
+uint8_t ModbusTcpConnection::takeFailed(const uint32_t nowMs) {
+    if (!_client.connected()) {
+        return _pipeline.takeAny();
+    }
+    return _pipeline.takeExpired(nowMs);
+}
+
+size_t ModbusTcpConnection::outstanding() const {
+    return _pipeline.outstanding();
+}
+
+void ModbusTcpConnection::close() {
+    _client.stop();
+    _rxLength = 0;
+}
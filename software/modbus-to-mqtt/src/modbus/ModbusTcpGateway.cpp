@@ -0,0 +1,140 @@
+#include "modbus/ModbusTcpGateway.h"
+
+constexpr size_t ModbusTcpGateway::kMaxClients;
+constexpr size_t ModbusTcpGateway::kMaxFlights;
+constexpr size_t ModbusTcpGateway::kMaxWaiters;
+constexpr size_t ModbusTcpGateway::kMaxWaitersPerClient;
+
+bool ModbusTcpGateway::sameRead(const ModbusTcpRequest &a, const ModbusTcpRequest &b) {
+    return ModbusTcpAdu::isRead(a.function) && a.function == b.function && a.unitId == b.unitId &&
+           a.address == b.address && a.count == b.count;
+}
+
+ModbusTcpGateway::Admission ModbusTcpGateway::admit(const uint8_t client, const ModbusTcpRequest &request,
+                                                    uint8_t &flight) {
+    Waiter *waiter = nullptr;
+    for (auto &candidate: _waiters) {
+        if (!candidate.used) {
+            waiter = &candidate;
+            break;
+        }
+    }
+    if (!waiter || client >= kMaxClients || pendingFor(client) >= kMaxWaitersPerClient) {
+        return Admission::Busy;
+    }
+
+    Admission admission = Admission::Joined;
+    size_t chosen = kMaxFlights;
+    for (size_t f = 0; f < kMaxFlights && chosen == kMaxFlights; ++f) {
+        if (_flights[f].used && !_flights[f].done && sameRead(_flights[f].request, request)) {
+            chosen = f;
+        }
+    }
+    if (chosen == kMaxFlights) {
+        for (size_t f = 0; f < kMaxFlights && chosen == kMaxFlights; ++f) {
+            if (!_flights[f].used) {
+                chosen = f;
+            }
+        }
+        if (chosen == kMaxFlights) {
+            return Admission::Busy;
+        }
+        Flight &fresh = _flights[chosen];
+        fresh.used = true;
+        fresh.done = false;
+        fresh.waiters = 0;
+        fresh.status = 0;
+        fresh.count = 0;
+        fresh.request = request;
+        admission = Admission::Submit;
+    }
+
+    waiter->used = true;
+    waiter->client = client;
+    waiter->flight = static_cast<uint8_t>(chosen);
+    waiter->transactionId = request.transactionId;
+    ++_flights[chosen].waiters;
+    flight = static_cast<uint8_t>(chosen);
+    return admission;
+}
+
+const ModbusTcpRequest &ModbusTcpGateway::flightRequest(const uint8_t flight) const {
+    return _flights[flight].request;
+}
+
+void ModbusTcpGateway::complete(const uint8_t flight, const uint8_t status, const uint16_t *words,
+                                const uint16_t count) {
+    if (flight >= kMaxFlights || !_flights[flight].used) {
+        return;
+    }
+    Flight &done = _flights[flight];
+    done.done = true;
+    done.status = status;
+    done.count = 0;
+    if (status == ModbusRtuStatus::Success && words) {
+        done.count = count < ModbusRtuMaster::kMaxWords ? count : ModbusRtuMaster::kMaxWords;
+        for (uint16_t i = 0; i < done.count; ++i) {
+            done.words[i] = words[i];
+        }
+    }
+    if (done.waiters == 0) {
+        // Every client that asked has gone away.
+        done.used = false;
+    }
+}
+
+size_t ModbusTcpGateway::takeResponse(const uint8_t client, uint8_t *out, const size_t capacity) {
+    for (auto &waiter: _waiters) {
+        if (!waiter.used || waiter.client != client || !_flights[waiter.flight].done) {
+            continue;
+        }
+        const Flight &flight = _flights[waiter.flight];
+        ModbusTcpRequest request = flight.request;
+        request.transactionId = waiter.transactionId;
+        const size_t length = ModbusTcpAdu::encodeResponse(request, flight.status, flight.words, flight.count,
+                                                           out, capacity);
+        releaseWaiter(waiter);
+        return length;
+    }
+    return 0;
+}
+
+void ModbusTcpGateway::dropClient(const uint8_t client) {
+    for (auto &waiter: _waiters) {
+        if (waiter.used && waiter.client == client) {
+            releaseWaiter(waiter);
+        }
+    }
+}
+
+void ModbusTcpGateway::releaseWaiter(Waiter &waiter) {
+    Flight &flight = _flights[waiter.flight];
+    waiter.used = false;
+    if (flight.waiters > 0) {
+        --flight.waiters;
+    }
+    // A flight still on the bus is released by complete().
+    if (flight.waiters == 0 && flight.done) {
+        flight.used = false;
+    }
+}
+
+size_t ModbusTcpGateway::pendingFor(const uint8_t client) const {
+    size_t pending = 0;
+    for (const auto &waiter: _waiters) {
+        if (waiter.used && waiter.client == client) {
+            ++pending;
+        }
+    }
+    return pending;
+}
+
+size_t ModbusTcpGateway::flightsInUse() const {
+    size_t used = 0;
+    for (const auto &flight: _flights) {
+        if (flight.used) {
+            ++used;
+        }
+    }
+    return used;
+}
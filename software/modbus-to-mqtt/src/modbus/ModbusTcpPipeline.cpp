@@ -0,0 +1,79 @@
+#include "modbus/ModbusTcpPipeline.h"
+
+constexpr uint8_t ModbusTcpPipeline::kMaxOutstanding;
+constexpr uint8_t ModbusTcpPipeline::kNone;
+
+uint8_t ModbusTcpPipeline::begin(const uint32_t nowMs, const uint32_t timeoutMs, uint16_t &transactionId) {
+    for (uint8_t s = 0; s < kMaxOutstanding; ++s) {
+        Slot &slot = _slots[s];
+        if (slot.used) {
+            continue;
+        }
+        slot.used = true;
+        slot.transactionId = _nextTransactionId++;
+        slot.sentAtMs = nowMs;
+        slot.timeoutMs = timeoutMs;
+        transactionId = slot.transactionId;
+        return s;
+    }
+    return kNone;
+}
+
+uint8_t ModbusTcpPipeline::match(const uint16_t transactionId) const {
+    for (uint8_t s = 0; s < kMaxOutstanding; ++s) {
+        if (_slots[s].used && _slots[s].transactionId == transactionId) {
+            return s;
+        }
+    }
+    return kNone;
+}
+
+void ModbusTcpPipeline::finish(const uint8_t slot) {
+    if (slot < kMaxOutstanding) {
+        _slots[slot].used = false;
+    }
+}
+
+uint8_t ModbusTcpPipeline::takeExpired(const uint32_t nowMs) {
+    for (uint8_t s = 0; s < kMaxOutstanding; ++s) {
+        if (_slots[s].used && nowMs - _slots[s].sentAtMs >= _slots[s].timeoutMs) {
+            _slots[s].used = false;
+            return s;
+        }
+    }
+    return kNone;
+}
+
+uint8_t ModbusTcpPipeline::takeAny() {
+    for (uint8_t s = 0; s < kMaxOutstanding; ++s) {
+        if (_slots[s].used) {
+            _slots[s].used = false;
+            return s;
+        }
+    }
+    return kNone;
+}
+
+uint32_t ModbusTcpPipeline::sentAtMs(const uint8_t slot) const {
+    return slot < kMaxOutstanding ? _slots[slot].sentAtMs : 0;
+}
+
+size_t ModbusTcpPipeline::outstanding() const {
+    size_t used = 0;
+    for (const auto &slot: _slots) {
+        if (slot.used) {
+            ++used;
+        }
+    }
+    return used;
+}
+
+bool ModbusTcpPipeline::full() const {
+    return outstanding() >= kMaxOutstanding;
+}
+
+void ModbusTcpPipeline::clear() {
+    for (auto &slot: _slots) {
+        slot.used = false;
+    }
+}
@@ -0,0 +1,287 @@
+#include "modbus/ModbusTcpServer.h"
+
+#include <cstring>
+
+#include "Logger.h"
+#include "modbus/ModbusManager.h"
+
+static constexpr auto MODBUS_TCP_TASK_STACK = 4096;
+// Below the polling task: a slow socket must never delay the bus.
+static constexpr auto MODBUS_TCP_TASK_PRIORITY = 1;
+// Longest a request waits in a socket buffer before it is read.
+static constexpr uint32_t MODBUS_TCP_SERVICE_MS = 10;
+static constexpr uint32_t MODBUS_TCP_LISTEN_RETRY_MS = 1000;
+
+ModbusTcpServer::ModbusTcpServer(Logger *logger, ModbusManager *modbus)
+    : _logger(logger), _modbus(modbus) {
+    _mutex = xSemaphoreCreateMutex();
+    for (size_t f = 0; f < ModbusTcpGateway::kMaxFlights; ++f) {
+        _tags[f].server = this;
+        _tags[f].flight = static_cast<uint8_t>(f);
+    }
+}
+
+void ModbusTcpServer::configure(const uint16_t port, const uint32_t maxAgeMs) {
+    _maxAgeMs.store(maxAgeMs);
+    _port.store(port);
+    if (!port || _task) {
+        if (_task) {
+            xTaskNotifyGive(_task);
+        }
+        return;
+    }
+    const BaseType_t result = xTaskCreatePinnedToCore(
+        taskRunner,
+        "ModbusTcp",
+        MODBUS_TCP_TASK_STACK,
+        this,
+        MODBUS_TCP_TASK_PRIORITY,
+        &_task,
+        1
+    );
+    if (result != pdPASS) {
+        _task = nullptr;
+        LOGGER_ERROR(_logger, LOGMODULE_MODBUS, "ModbusTcpServer::configure - failed to start task");
+    }
+}
+
+void ModbusTcpServer::mapUnits(const std::vector<ModbusDevice> &devices) {
+    // Built aside so requests never see a half-filled table.
+    ModbusUnitRoutes routes;
+    for (const auto &dev: devices) {
+        if (dev.transport() != ModbusTransport::Rtu) continue;
+        if (!routes.add(dev.gatewayUnitId, dev.bus, dev.slaveId)) {
+            LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusTcpServer::mapUnits - %s: unit id %u is taken or invalid, "
+                        "not reachable over TCP", dev.name.c_str(), static_cast<unsigned>(dev.gatewayUnitId));
+        }
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _routes = routes;
+    xSemaphoreGive(_mutex);
+}
+
+[[noreturn]] void ModbusTcpServer::taskRunner(void *param) {
+    auto *self = static_cast<ModbusTcpServer *>(param);
+    for (;;) {
+        self->serviceOnce();
+        // Completed flights wake the task so answers go out straight away.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MODBUS_TCP_SERVICE_MS));
+    }
+}
+
+void ModbusTcpServer::serviceOnce() {
+    updateListener();
+    if (!_listeningPort) {
+        return;
+    }
+    acceptClients();
+    for (uint8_t slot = 0; slot < ModbusTcpGateway::kMaxClients; ++slot) {
+        if (!_clients[slot].active) {
+            continue;
+        }
+        readClient(slot);
+        if (_clients[slot].active) {
+            flushResponses(slot);
+        }
+    }
+}
+
+void ModbusTcpServer::updateListener() {
+    const uint16_t port = _port.load();
+    if (_listeningPort && _listeningPort != port) {
+        for (uint8_t slot = 0; slot < ModbusTcpGateway::kMaxClients; ++slot) {
+            closeClient(slot);
+        }
+        _server.end();
+        LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusTcpServer - stopped listening on port %u",
+                    static_cast<unsigned>(_listeningPort));
+        _listeningPort = 0;
+    }
+    if (!port || _listeningPort) {
+        return;
+    }
+    // The socket cannot be opened before the network stack is up.
+    if (WiFi.status() != WL_CONNECTED || millis() - _lastListenAttemptMs < MODBUS_TCP_LISTEN_RETRY_MS) {
+        return;
+    }
+    _lastListenAttemptMs = millis();
+    _server.begin(port);
+    _server.setNoDelay(true);
+    if (_server) {
+        _listeningPort = port;
+        LOGGER_INFO(_logger, LOGMODULE_MODBUS, "ModbusTcpServer - listening on port %u", static_cast<unsigned>(port));
+    }
+}
+
+void ModbusTcpServer::acceptClients() {
+    while (_server.hasClient()) {
+        WiFiClient incoming = _server.accept();
+        uint8_t slot = 0;
+        while (slot < ModbusTcpGateway::kMaxClients && _clients[slot].active) {
+            ++slot;
+        }
+        if (slot == ModbusTcpGateway::kMaxClients) {
+            LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusTcpServer - connection refused, all client slots in use");
+            incoming.stop();
+            continue;
+        }
+        incoming.setNoDelay(true);
+        _clients[slot].client = incoming;
+        _clients[slot].active = true;
+        _clients[slot].rxLength = 0;
+        LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "ModbusTcpServer - client %u connected from %s",
+                     static_cast<unsigned>(slot), incoming.remoteIP().toString().c_str());
+    }
+}
+
+void ModbusTcpServer::readClient(const uint8_t slot) {
+    ClientSlot &c = _clients[slot];
+    if (!c.client.connected()) {
+        closeClient(slot);
+        return;
+    }
+    const int available = c.client.available();
+    if (available > 0 && c.rxLength < sizeof(c.rx)) {
+        const size_t room = sizeof(c.rx) - c.rxLength;
+        const size_t wanted = static_cast<size_t>(available) < room ? static_cast<size_t>(available) : room;
+        const int got = c.client.read(c.rx + c.rxLength, wanted);
+        if (got > 0) {
+            c.rxLength += static_cast<size_t>(got);
+        }
+    }
+
+    for (;;) {
+        ModbusTcpRequest request{};
+        uint8_t exceptionCode = 0;
+        size_t consumed = 0;
+        const ModbusTcpParse parsed = ModbusTcpAdu::parse(c.rx, c.rxLength, request, exceptionCode, consumed);
+        if (parsed == ModbusTcpParse::Incomplete) {
+            return;
+        }
+        if (parsed == ModbusTcpParse::Malformed) {
+            LOGGER_WARN(_logger, LOGMODULE_MODBUS, "ModbusTcpServer - client %u sent a malformed frame, closing",
+                        static_cast<unsigned>(slot));
+            closeClient(slot);
+            return;
+        }
+        if (parsed == ModbusTcpParse::Exception) {
+            uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+            const size_t length = ModbusTcpAdu::encodeException(request, exceptionCode, out, sizeof(out));
+            c.client.write(out, length);
+        } else {
+            handleRequest(slot, request);
+        }
+        memmove(c.rx, c.rx + consumed, c.rxLength - consumed);
+        c.rxLength -= consumed;
+    }
+}
+
+void ModbusTcpServer::handleRequest(const uint8_t slot, const ModbusTcpRequest &request) {
+    ModbusUnitRoutes::Route route{};
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const bool routed = _routes.find(request.unitId, route);
+    xSemaphoreGive(_mutex);
+    if (!routed) {
+        uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+        const size_t length = ModbusTcpAdu::encodeException(request, ModbusTcpException::GatewayTargetFailed, out,
+                                                            sizeof(out));
+        _clients[slot].client.write(out, length);
+        return;
+    }
+
+    const bool isRead = ModbusTcpAdu::isRead(request.function);
+    const uint32_t maxAgeMs = _maxAgeMs.load();
+    if (isRead && maxAgeMs) {
+        uint16_t words[ModbusRtuMaster::kMaxWords];
+        uint16_t count = 0;
+        if (_modbus->readShadow(route.bus, route.slaveId, request.function, request.address, request.count, maxAgeMs,
+                                words, ModbusRtuMaster::kMaxWords, count)) {
+            uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+            const size_t length = ModbusTcpAdu::encodeResponse(request, ModbusRtuStatus::Success, words, count, out,
+                                                               sizeof(out));
+            _clients[slot].client.write(out, length);
+            return;
+        }
+    }
+
+    ModbusCommand command{};
+    command.bus = route.bus;
+    command.slaveId = route.slaveId;
+    command.function = request.function;
+    command.address = request.address;
+    command.count = request.count;
+    command.writeAddress = request.writeAddress;
+    command.writeCount = request.writeCount;
+    if (!isRead && ModbusTcpAdu::unpackValues(request, command.values, ModbusCommand::kMaxValues) == 0) {
+        // Larger than a bus command carries.
+        uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+        const size_t length = ModbusTcpAdu::encodeException(request, ModbusTcpException::IllegalDataValue, out,
+                                                            sizeof(out));
+        _clients[slot].client.write(out, length);
+        return;
+    }
+
+    uint8_t flight = 0;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const ModbusTcpGateway::Admission admission = _gateway.admit(slot, request, flight);
+    xSemaphoreGive(_mutex);
+
+    if (admission == ModbusTcpGateway::Admission::Busy) {
+        uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+        const size_t length = ModbusTcpAdu::encodeException(request, ModbusTcpException::SlaveDeviceBusy, out,
+                                                            sizeof(out));
+        _clients[slot].client.write(out, length);
+        return;
+    }
+    if (admission == ModbusTcpGateway::Admission::Joined) {
+        return;
+    }
+
+    command.submittedAtMs = millis();
+    command.onComplete = onFlightComplete;
+    command.context = &_tags[flight];
+    if (!_modbus->submitCommand(command, isRead ? ModbusCommandPriority::Read : ModbusCommandPriority::Write)) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        _gateway.complete(flight, ModbusRtuStatus::Busy, nullptr, 0);
+        xSemaphoreGive(_mutex);
+    }
+}
+
+void ModbusTcpServer::flushResponses(const uint8_t slot) {
+    uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+    for (;;) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        const size_t length = _gateway.takeResponse(slot, out, sizeof(out));
+        xSemaphoreGive(_mutex);
+        if (!length) {
+            return;
+        }
+        _clients[slot].client.write(out, length);
+    }
+}
+
+void ModbusTcpServer::closeClient(const uint8_t slot) {
+    ClientSlot &c = _clients[slot];
+    if (!c.active) {
+        return;
+    }
+    c.client.stop();
+    c.active = false;
+    c.rxLength = 0;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _gateway.dropClient(slot);
+    xSemaphoreGive(_mutex);
+    LOGGER_DEBUG(_logger, LOGMODULE_MODBUS, "ModbusTcpServer - client %u disconnected", static_cast<unsigned>(slot));
+}
+
+void ModbusTcpServer::onFlightComplete(void *context, const ModbusCommand & /*command*/,
+                                       const ModbusCommandResult &result) {
+    const auto *tag = static_cast<FlightTag *>(context);
+    ModbusTcpServer *self = tag->server;
+    xSemaphoreTake(self->_mutex, portMAX_DELAY);
+    self->_gateway.complete(tag->flight, result.status, result.words, result.count);
+    xSemaphoreGive(self->_mutex);
+    if (self->_task) {
+        xTaskNotifyGive(self->_task);
+    }
+}
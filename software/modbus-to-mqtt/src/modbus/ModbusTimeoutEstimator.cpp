@@ -0,0 +1,89 @@
+#include "modbus/ModbusTimeoutEstimator.h"
+
+constexpr uint16_t ModbusTimeoutEstimator::kWarmupSamples;
+constexpr size_t ModbusTimeoutEstimator::kBuckets;
+constexpr uint32_t ModbusTimeoutEstimator::kFirstBucketUs;
+constexpr uint16_t ModbusTimeoutEstimator::kDecayAt;
+constexpr uint8_t ModbusTimeoutEstimator::kMaxBackoffShift;
+
+void ModbusTimeoutEstimator::record(const uint32_t turnaroundUs) {
+    if (_samples == 0) {
+        _smoothedUs = turnaroundUs;
+        _deviationUs = turnaroundUs / 2U;
+    } else {
+        // RFC 6298 gains: 1/8 for the mean, 1/4 for the deviation.
+        const uint32_t error = turnaroundUs > _smoothedUs ? turnaroundUs - _smoothedUs : _smoothedUs - turnaroundUs;
+        _deviationUs = static_cast<uint32_t>((3ULL * _deviationUs + error) / 4U);
+        _smoothedUs = static_cast<uint32_t>((7ULL * _smoothedUs + turnaroundUs) / 8U);
+    }
+    if (_samples < UINT16_MAX) {
+        ++_samples;
+    }
+
+    ++_histogram[bucketOf(turnaroundUs)];
+    if (++_histogramTotal >= kDecayAt) {
+        _histogramTotal = 0;
+        for (auto &count: _histogram) {
+            count = static_cast<uint16_t>(count / 2U);
+            _histogramTotal = static_cast<uint16_t>(_histogramTotal + count);
+        }
+    }
+    _backoffShift = 0;
+}
+
+void ModbusTimeoutEstimator::recordTimeout() {
+    if (_backoffShift < kMaxBackoffShift) {
+        ++_backoffShift;
+    }
+}
+
+uint32_t ModbusTimeoutEstimator::timeoutUs(const uint32_t floorUs, const uint32_t ceilingUs) const {
+    if (_samples < kWarmupSamples) {
+        return ceilingUs;
+    }
+    uint64_t base = static_cast<uint64_t>(_smoothedUs) + 4ULL * _deviationUs;
+    const uint32_t p99 = percentileUs(990);
+    if (p99 > base) {
+        base = p99;
+    }
+    const uint64_t timeout = base << _backoffShift;
+    if (timeout < floorUs) return floorUs;
+    return timeout > ceilingUs ? ceilingUs : static_cast<uint32_t>(timeout);
+}
+
+uint32_t ModbusTimeoutEstimator::percentileUs(const uint16_t permille) const {
+    if (_histogramTotal == 0) {
+        return 0;
+    }
+    const uint32_t needed = (static_cast<uint32_t>(_histogramTotal) * permille + 999U) / 1000U;
+    uint32_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        seen += _histogram[b];
+        if (seen >= needed) {
+            return kFirstBucketUs << b;
+        }
+    }
+    return kFirstBucketUs << (kBuckets - 1);
+}
+
+uint32_t ModbusTimeoutEstimator::smoothedUs() const {
+    return _smoothedUs;
+}
+
+uint32_t ModbusTimeoutEstimator::deviationUs() const {
+    return _deviationUs;
+}
+
+uint16_t ModbusTimeoutEstimator::samples() const {
+    return _samples;
+}
+
+size_t ModbusTimeoutEstimator::bucketOf(const uint32_t turnaroundUs) {
+    size_t bucket = 0;
+    uint32_t scaled = turnaroundUs / kFirstBucketUs;
+    while (scaled > 0 && bucket < kBuckets - 1) {
+        scaled >>= 1U;
+        ++bucket;
+    }
+    return bucket;
+}
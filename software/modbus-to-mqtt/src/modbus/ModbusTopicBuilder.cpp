@@ -9,44 +9,34 @@ ModbusTopicBuilder::ModbusTopicBuilder(String rootTopic) : _rootTopic(std::move(
 String ModbusTopicBuilder::datapointTopic(const ModbusDevice &device, const ModbusDatapoint &dp) const {
     String topic = dp.topic;
     topic.trim();
-    if (topic.length()) {
-        return topic;
-    }
-
-    const String deviceSeg = deviceSegment(device);
-    const String dpSeg = datapointSegment(dp);
-
-    String resolved;
-    resolved.reserve(_rootTopic.length() + deviceSeg.length() + dpSeg.length() + 2);
-    if (_rootTopic.length()) {
-        resolved = _rootTopic;
-        if (!resolved.endsWith("/")) {
-            resolved += "/";
-        }
-        resolved += deviceSeg;
-    } else {
-        resolved = deviceSeg;
-    }
-    resolved += "/";
-    resolved += dpSeg;
-    return resolved;
+    return expand(topic.length() ? topic : String("{root}/{device}/{dp}"), device, &dp);
 }
 
 String ModbusTopicBuilder::availabilityTopic(const ModbusDevice &device) const {
-    const String deviceSeg = deviceSegment(device);
+    return expand("{root}/{device}/status", device, nullptr);
+}
 
-    String topic;
-    if (_rootTopic.length()) {
-        topic = _rootTopic;
-        if (!topic.endsWith("/")) {
-            topic += "/";
-        }
-        topic += deviceSeg;
-    } else {
-        topic = deviceSeg;
+String ModbusTopicBuilder::snapshotTopic(const ModbusDevice &device) const {
+    return expand("{root}/{device}/snapshot", device, nullptr);
+}
+
+String ModbusTopicBuilder::expand(String pattern, const ModbusDevice &device, const ModbusDatapoint *dp) const {
+    if (pattern.indexOf('{') < 0) {
+        return pattern;
+    }
+    String root = _rootTopic;
+    while (root.endsWith("/")) {
+        root.remove(root.length() - 1);
+    }
+    if (!root.length()) {
+        pattern.replace("{root}/", "");
+    }
+    pattern.replace("{root}", root);
+    pattern.replace("{device}", deviceSegment(device));
+    if (dp) {
+        pattern.replace("{dp}", datapointSegment(*dp));
     }
-    topic += "/status";
-    return topic;
+    return pattern;
 }
 
 String ModbusTopicBuilder::deviceSegment(const ModbusDevice &device) {
@@ -0,0 +1,56 @@
+#include "modbus/ModbusTopicTable.h"
+
+#include <cstring>
+
+#include "modbus/ModbusTopicBuilder.h"
+
+ModbusTopicTable::ModbusTopicTable() {
+    intern(String());
+}
+
+void ModbusTopicTable::rebuild(const String &rootTopic, std::vector<ModbusDevice> &devices) {
+    _rootTopic = rootTopic;
+    _pool.clear();
+    _offsets.clear();
+    intern(String());
+
+    const ModbusTopicBuilder builder(rootTopic);
+    for (auto &device: devices) {
+        device.segmentId = intern(ModbusTopicBuilder::deviceSegment(device));
+        device.availabilityTopicId = intern(builder.availabilityTopic(device));
+        device.snapshotTopicId = device.snapshotEnabled ? intern(builder.snapshotTopic(device)) : 0;
+        for (auto &dp: device.datapoints) {
+            String topic = builder.datapointTopic(device, dp);
+            topic.trim();
+            dp.topicId = intern(topic);
+            dp.segmentId = intern(ModbusTopicBuilder::datapointSegment(dp));
+        }
+    }
+    _pool.shrink_to_fit();
+    _offsets.shrink_to_fit();
+}
+
+const String &ModbusTopicTable::rootTopic() const {
+    return _rootTopic;
+}
+
+size_t ModbusTopicTable::poolBytes() const {
+    return _pool.size() + _offsets.size() * sizeof(uint32_t);
+}
+
+uint16_t ModbusTopicTable::intern(const String &text) {
+    const size_t length = text.length();
+    for (size_t id = 0; id < _offsets.size(); ++id) {
+        const char *stored = _pool.data() + _offsets[id];
+        if (strlen(stored) == length && memcmp(stored, text.c_str(), length) == 0) {
+            return static_cast<uint16_t>(id);
+        }
+    }
+    if (_offsets.size() > UINT16_MAX) {
+        // Out of ids; such a configuration would not fit in RAM anyway.
+        return 0;
+    }
+    _offsets.push_back(static_cast<uint32_t>(_pool.size()));
+    _pool.insert(_pool.end(), text.c_str(), text.c_str() + length + 1);
+    return static_cast<uint16_t>(_offsets.size() - 1);
+}
@@ -0,0 +1,28 @@
+#include "modbus/ModbusUnitRoutes.h"
+
+void ModbusUnitRoutes::clear() {
+    for (auto &route: _routes) {
+        route = 0;
+    }
+}
+
+bool ModbusUnitRoutes::add(const uint8_t unitId, const uint8_t bus, const uint8_t slaveId) {
+    if (unitId == 0 || unitId > kMaxUnitId || bus == 0xFF) {
+        return false;
+    }
+    const auto packed = static_cast<uint16_t>(((bus + 1U) << 8U) | slaveId);
+    if (_routes[unitId] && _routes[unitId] != packed) {
+        return false;
+    }
+    _routes[unitId] = packed;
+    return true;
+}
+
+bool ModbusUnitRoutes::find(const uint8_t unitId, Route &out) const {
+    if (unitId > kMaxUnitId || !_routes[unitId]) {
+        return false;
+    }
+    out.bus = static_cast<uint8_t>((_routes[unitId] >> 8U) - 1U);
+    out.slaveId = static_cast<uint8_t>(_routes[unitId] & 0xFFU);
+    return true;
+}
@@ -0,0 +1,254 @@
+#include "modbus/ModbusValueDecoder.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+constexpr size_t ModbusValueDecoder::kValueChars;
+
+namespace {
+
+constexpr bool wordsReversed(const ModbusWordOrder order) {
+    return order == ModbusWordOrder::CDAB || order == ModbusWordOrder::DCBA;
+}
+
+constexpr bool bytesSwapped(const ModbusWordOrder order) {
+    return order == ModbusWordOrder::BADC || order == ModbusWordOrder::DCBA;
+}
+
+// Folds N registers into one big-endian integer in a single pass.
+template <ModbusWordOrder Order, unsigned N>
+uint64_t assemble(const uint16_t *words) {
+    uint64_t raw = 0;
+    for (unsigned i = 0; i < N; ++i) {
+        uint16_t word = words[wordsReversed(Order) ? (N - 1U - i) : i];
+        if (bytesSwapped(Order)) {
+            word = static_cast<uint16_t>((word << 8U) | (word >> 8U));
+        }
+        raw = (raw << 16U) | word;
+    }
+    return raw;
+}
+
+template <ModbusWordOrder Order, RegisterSlice Slice>
+uint16_t assemble16(const uint16_t *words) {
+    const auto word = static_cast<uint16_t>(assemble<Order, 1>(words));
+    return Slice == RegisterSlice::LowByte ? static_cast<uint16_t>(word & 0x00FFU)
+         : Slice == RegisterSlice::HighByte ? static_cast<uint16_t>(word >> 8U)
+         : word;
+}
+
+template <ModbusWordOrder Order, RegisterSlice Slice>
+double decodeUint16(const uint16_t *words) {
+    return static_cast<double>(assemble16<Order, Slice>(words));
+}
+
+// A sliced byte is reported unsigned, as it was before signed decoding.
+template <ModbusWordOrder Order, RegisterSlice Slice>
+double decodeInt16(const uint16_t *words) {
+    const uint16_t raw = assemble16<Order, Slice>(words);
+    return Slice == RegisterSlice::Full ? static_cast<double>(static_cast<int16_t>(raw))
+                                        : static_cast<double>(raw);
+}
+
+template <ModbusWordOrder Order>
+double decodeUint32(const uint16_t *words) {
+    return static_cast<double>(static_cast<uint32_t>(assemble<Order, 2>(words)));
+}
+
+template <ModbusWordOrder Order>
+double decodeInt32(const uint16_t *words) {
+    return static_cast<double>(static_cast<int32_t>(static_cast<uint32_t>(assemble<Order, 2>(words))));
+}
+
+template <ModbusWordOrder Order>
+double decodeUint64(const uint16_t *words) {
+    return static_cast<double>(assemble<Order, 4>(words));
+}
+
+template <ModbusWordOrder Order>
+double decodeInt64(const uint16_t *words) {
+    return static_cast<double>(static_cast<int64_t>(assemble<Order, 4>(words)));
+}
+
+template <ModbusWordOrder Order>
+double decodeFloat32(const uint16_t *words) {
+    const auto bits = static_cast<uint32_t>(assemble<Order, 2>(words));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return static_cast<double>(value);
+}
+
+// Rounds to the nearest integer within [lo, hi]; NaN becomes 0.
+double clampRound(const double value, const double lo, const double hi) {
+    if (std::isnan(value)) {
+        return 0.0;
+    }
+    const double rounded = std::round(value);
+    return rounded < lo ? lo : (rounded > hi ? hi : rounded);
+}
+
+// Big-endian two's complement image of value as dataType.
+uint64_t rawOf(const ModbusDataType dataType, const double value) {
+    // 2^63 and 2^64 are exact as doubles; the largest integers below them
+    // are not, so the upper ends are checked before converting.
+    constexpr double kTwo63 = 9223372036854775808.0;
+    constexpr double kTwo64 = 18446744073709551616.0;
+    switch (dataType) {
+        case INT16:
+            return static_cast<uint16_t>(static_cast<int16_t>(clampRound(value, -32768.0, 32767.0)));
+        case UINT16:
+            return static_cast<uint16_t>(clampRound(value, 0.0, 65535.0));
+        case INT32:
+            return static_cast<uint32_t>(static_cast<int32_t>(clampRound(value, -2147483648.0, 2147483647.0)));
+        case UINT32:
+            return static_cast<uint32_t>(clampRound(value, 0.0, 4294967295.0));
+        case INT64: {
+            const double v = clampRound(value, -kTwo63, kTwo63);
+            return v >= kTwo63 ? static_cast<uint64_t>(INT64_MAX)
+                               : static_cast<uint64_t>(static_cast<int64_t>(v));
+        }
+        case UINT64: {
+            const double v = clampRound(value, 0.0, kTwo64);
+            return v >= kTwo64 ? UINT64_MAX : static_cast<uint64_t>(v);
+        }
+        case FLOAT32: {
+            const auto f = static_cast<float>(value);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+        case TEXT:
+        default:
+            return 0;
+    }
+}
+
+template <ModbusWordOrder Order, RegisterSlice Slice>
+ModbusDecodeFn select16(const ModbusDataType dataType) {
+    return dataType == INT16 ? &decodeInt16<Order, Slice> : &decodeUint16<Order, Slice>;
+}
+
+template <ModbusWordOrder Order>
+ModbusDecodeFn selectForOrder(const ModbusDataType dataType, const RegisterSlice slice) {
+    switch (dataType) {
+        case INT16:
+        case UINT16:
+            switch (slice) {
+                case RegisterSlice::LowByte: return select16<Order, RegisterSlice::LowByte>(dataType);
+                case RegisterSlice::HighByte: return select16<Order, RegisterSlice::HighByte>(dataType);
+                case RegisterSlice::Full:
+                default: return select16<Order, RegisterSlice::Full>(dataType);
+            }
+        case INT32: return &decodeInt32<Order>;
+        case UINT32: return &decodeUint32<Order>;
+        case INT64: return &decodeInt64<Order>;
+        case UINT64: return &decodeUint64<Order>;
+        case FLOAT32: return &decodeFloat32<Order>;
+        case TEXT:
+        default: return nullptr;
+    }
+}
+
+} // namespace
+
+ModbusDecodeFn ModbusValueDecoder::select(const ModbusDataType dataType,
+                                          const ModbusWordOrder order,
+                                          const RegisterSlice slice) {
+    switch (order) {
+        case ModbusWordOrder::CDAB: return selectForOrder<ModbusWordOrder::CDAB>(dataType, slice);
+        case ModbusWordOrder::BADC: return selectForOrder<ModbusWordOrder::BADC>(dataType, slice);
+        case ModbusWordOrder::DCBA: return selectForOrder<ModbusWordOrder::DCBA>(dataType, slice);
+        case ModbusWordOrder::ABCD:
+        default: return selectForOrder<ModbusWordOrder::ABCD>(dataType, slice);
+    }
+}
+
+uint8_t ModbusValueDecoder::registerCount(const ModbusDataType dataType) {
+    switch (dataType) {
+        case INT16:
+        case UINT16: return 1;
+        case INT32:
+        case UINT32:
+        case FLOAT32: return 2;
+        case INT64:
+        case UINT64: return 4;
+        case TEXT:
+        default: return 0;
+    }
+}
+
+uint8_t ModbusValueDecoder::encode(const ModbusDataType dataType,
+                                   const ModbusWordOrder order,
+                                   const double value,
+                                   uint16_t *words) {
+    const uint8_t n = registerCount(dataType);
+    const uint64_t raw = rawOf(dataType, value);
+    for (uint8_t i = 0; i < n; ++i) {
+        auto word = static_cast<uint16_t>(raw >> (16U * (n - 1U - i)));
+        if (bytesSwapped(order)) {
+            word = static_cast<uint16_t>((word << 8U) | (word >> 8U));
+        }
+        words[wordsReversed(order) ? (n - 1U - i) : i] = word;
+    }
+    return n;
+}
+
+size_t ModbusValueDecoder::formatValue(const double value, char *out, const size_t capacity) {
+    if (!out || capacity == 0) {
+        return 0;
+    }
+    const int n = std::snprintf(out, capacity, std::fabs(value) < 1e15 ? "%.2f" : "%g", value);
+    if (n < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return static_cast<size_t>(n) < capacity ? static_cast<size_t>(n) : capacity - 1;
+}
+
+size_t ModbusValueDecoder::formatText(const uint16_t *words, const uint16_t count, char *out, const size_t capacity) {
+    if (!out || capacity == 0) {
+        return 0;
+    }
+    size_t len = 0;
+    for (uint16_t i = 0; words && i < count; ++i) {
+        const char bytes[2] = {static_cast<char>(words[i] >> 8U), static_cast<char>(words[i] & 0xFFU)};
+        for (const char c: bytes) {
+            if (c != '\0' && len + 1 < capacity) {
+                out[len++] = c;
+            }
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+bool ModbusValueDecoder::parseWordOrder(const char *text, ModbusWordOrder &out) {
+    if (!text) {
+        return false;
+    }
+    char upper[5]{};
+    size_t len = 0;
+    for (; text[len] != '\0'; ++len) {
+        if (len >= 4) {
+            return false;
+        }
+        upper[len] = static_cast<char>(std::toupper(static_cast<unsigned char>(text[len])));
+    }
+    if (std::strcmp(upper, "ABCD") == 0) { out = ModbusWordOrder::ABCD; return true; }
+    if (std::strcmp(upper, "CDAB") == 0) { out = ModbusWordOrder::CDAB; return true; }
+    if (std::strcmp(upper, "BADC") == 0) { out = ModbusWordOrder::BADC; return true; }
+    if (std::strcmp(upper, "DCBA") == 0) { out = ModbusWordOrder::DCBA; return true; }
+    return false;
+}
+
+const char *ModbusValueDecoder::wordOrderToString(const ModbusWordOrder order) {
+    switch (order) {
+        case ModbusWordOrder::CDAB: return "CDAB";
+        case ModbusWordOrder::BADC: return "BADC";
+        case ModbusWordOrder::DCBA: return "DCBA";
+        case ModbusWordOrder::ABCD:
+        default: return "ABCD";
+    }
+}
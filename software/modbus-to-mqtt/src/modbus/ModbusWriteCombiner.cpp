@@ -0,0 +1,217 @@
+#include "modbus/ModbusWriteCombiner.h"
+
+#include "modbus/ModbusRtuMaster.h"
+
+constexpr size_t ModbusWriteCombiner::kMaxHeld;
+constexpr size_t ModbusWriteCombiner::kMaxRegisters;
+constexpr uint32_t ModbusWriteCombiner::kNothingHeld;
+
+namespace {
+
+bool reached(const uint32_t nowMs, const uint32_t dueAtMs) {
+    return static_cast<int32_t>(nowMs - dueAtMs) >= 0;
+}
+
+uint16_t registersOf(const ModbusCommand &command) {
+    return command.function == 6 ? 1 : command.count;
+}
+
+// Registers [a, a + aCount) shares with [b, b + bCount).
+uint16_t overlap(const uint16_t a, const uint16_t aCount, const uint16_t b, const uint16_t bCount) {
+    const uint32_t lo = a > b ? a : b;
+    const uint32_t aEnd = static_cast<uint32_t>(a) + aCount;
+    const uint32_t bEnd = static_cast<uint32_t>(b) + bCount;
+    const uint32_t hi = aEnd < bEnd ? aEnd : bEnd;
+    return hi > lo ? static_cast<uint16_t>(hi - lo) : 0;
+}
+
+} // namespace
+
+bool ModbusWriteCombiner::combinable(const ModbusCommand &command) {
+    return command.function == 6 ||
+           (command.function == 16 && command.count > 0 && command.count <= ModbusCommand::kMaxValues);
+}
+
+ModbusWriteCombiner::Register *ModbusWriteCombiner::find(const uint8_t slaveId, const uint16_t address) {
+    for (auto &reg: _registers) {
+        if (reg.used && reg.slaveId == slaveId && reg.address == address) {
+            return &reg;
+        }
+    }
+    return nullptr;
+}
+
+bool ModbusWriteCombiner::hold(const ModbusCommand &command, const uint32_t nowMs, const uint32_t windowMs) {
+    if (windowMs == 0 || !combinable(command)) {
+        return false;
+    }
+    const uint16_t count = registersOf(command);
+    if (static_cast<uint32_t>(command.address) + count > 0x10000UL) {
+        return false;
+    }
+    Held *slot = nullptr;
+    for (auto &held: _held) {
+        if (!held.used) {
+            slot = &held;
+            break;
+        }
+    }
+    if (!slot) {
+        return false;
+    }
+
+    // Joins the slave's open window, if it has one.
+    uint32_t dueAtMs = nowMs + windowMs;
+    size_t free = 0;
+    for (const auto &reg: _registers) {
+        if (!reg.used) {
+            ++free;
+        } else if (reg.slaveId == command.slaveId) {
+            dueAtMs = reg.dueAtMs;
+        }
+    }
+    size_t fresh = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        if (!find(command.slaveId, static_cast<uint16_t>(command.address + i))) {
+            ++fresh;
+        }
+    }
+    if (fresh > free) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < count; ++i) {
+        const auto address = static_cast<uint16_t>(command.address + i);
+        Register *reg = find(command.slaveId, address);
+        if (!reg) {
+            for (auto &candidate: _registers) {
+                if (!candidate.used) {
+                    reg = &candidate;
+                    break;
+                }
+            }
+            reg->used = true;
+            reg->slaveId = command.slaveId;
+            reg->address = address;
+            reg->dueAtMs = dueAtMs;
+        }
+        // The latest write to a register wins.
+        reg->value = command.values[i];
+    }
+    slot->used = true;
+    slot->command = command;
+    slot->remaining = count;
+    slot->inFlight = 0;
+    slot->status = ModbusRtuStatus::Success;
+    return true;
+}
+
+void ModbusWriteCombiner::expedite(const uint8_t slaveId, const uint32_t nowMs) {
+    for (auto &reg: _registers) {
+        if (reg.used && reg.slaveId == slaveId && !reached(nowMs, reg.dueAtMs)) {
+            reg.dueAtMs = nowMs;
+        }
+    }
+}
+
+uint32_t ModbusWriteCombiner::msUntilDue(const uint32_t nowMs) const {
+    uint32_t soonest = kNothingHeld;
+    for (const auto &reg: _registers) {
+        if (!reg.used) {
+            continue;
+        }
+        const uint32_t waitMs = reached(nowMs, reg.dueAtMs) ? 0 : reg.dueAtMs - nowMs;
+        if (waitMs < soonest) {
+            soonest = waitMs;
+        }
+    }
+    return soonest;
+}
+
+bool ModbusWriteCombiner::takeDue(const uint32_t nowMs, ModbusCommand &out) {
+    // The slave whose window closed first, from its lowest address.
+    const Register *first = nullptr;
+    for (const auto &reg: _registers) {
+        if (!reg.used || !reached(nowMs, reg.dueAtMs)) {
+            continue;
+        }
+        if (!first || static_cast<int32_t>(reg.dueAtMs - first->dueAtMs) < 0 ||
+            (reg.slaveId == first->slaveId && reg.address < first->address)) {
+            first = &reg;
+        }
+    }
+    if (!first) {
+        return false;
+    }
+    const uint8_t slaveId = first->slaveId;
+    uint16_t start = first->address;
+    for (const auto &reg: _registers) {
+        if (reg.used && reg.slaveId == slaveId && reg.address < start) {
+            start = reg.address;
+        }
+    }
+
+    out = ModbusCommand{};
+    out.slaveId = slaveId;
+    out.address = start;
+    uint16_t count = 0;
+    while (count < ModbusCommand::kMaxValues && static_cast<uint32_t>(start) + count <= 0xFFFFUL) {
+        Register *reg = find(slaveId, static_cast<uint16_t>(start + count));
+        if (!reg) {
+            break;
+        }
+        out.values[count++] = reg->value;
+        reg->used = false;
+    }
+    out.count = count;
+    out.function = count == 1 ? 6 : 16;
+
+    bool firstMember = true;
+    for (auto &held: _held) {
+        if (!held.used || held.command.slaveId != slaveId) {
+            continue;
+        }
+        held.inFlight = overlap(held.command.address, registersOf(held.command), start, count);
+        if (!held.inFlight) {
+            continue;
+        }
+        // Its latency counts from the oldest write it carries.
+        if (firstMember || static_cast<int32_t>(held.command.submittedAtMs - out.submittedAtMs) < 0) {
+            out.submittedAtMs = held.command.submittedAtMs;
+        }
+        out.bus = held.command.bus;
+        firstMember = false;
+    }
+    return true;
+}
+
+size_t ModbusWriteCombiner::complete(const uint8_t status, Finished *out) {
+    size_t finished = 0;
+    for (auto &held: _held) {
+        if (!held.used || held.inFlight == 0) {
+            continue;
+        }
+        held.remaining = static_cast<uint16_t>(held.remaining - held.inFlight);
+        held.inFlight = 0;
+        if (status != ModbusRtuStatus::Success && held.status == ModbusRtuStatus::Success) {
+            held.status = status;
+        }
+        if (held.remaining == 0) {
+            out[finished].command = held.command;
+            out[finished].status = held.status;
+            ++finished;
+            held.used = false;
+        }
+    }
+    return finished;
+}
+
+size_t ModbusWriteCombiner::heldCount() const {
+    size_t count = 0;
+    for (const auto &held: _held) {
+        if (held.used) {
+            ++count;
+        }
+    }
+    return count;
+}
@@ -22,6 +22,32 @@ static constexpr auto default_mqtt_root_topic = "mbx_root";
 static const String system_subscription_network_reset = "/system/network/reset";
 static const String system_subscription_echo = "/system/log/echo";
 
+namespace {
+    // Holds the client mutex for one short run of PubSubClient calls.
+    class ClientLock {
+    public:
+        explicit ClientLock(const SemaphoreHandle_t handle, const TickType_t wait = portMAX_DELAY)
+            : _handle(handle), _locked(xSemaphoreTake(handle, wait) == pdTRUE) {
+        }
+
+        ~ClientLock() {
+            if (_locked) {
+                xSemaphoreGive(_handle);
+            }
+        }
+
+        ClientLock(const ClientLock &) = delete;
+
+        ClientLock &operator=(const ClientLock &) = delete;
+
+        bool locked() const { return _locked; }
+
+    private:
+        SemaphoreHandle_t _handle;
+        bool _locked;
+    };
+}
+
 static String buildDefaultClientId() {
     const uint64_t mac = ESP.getEfuseMac();
     char buf[13];
@@ -34,17 +60,21 @@ MqttManager::MqttManager(MqttSubscriptionHandler *subscriptionHandler, PubSubCli
     : _mqttClient(mqttClient),
       _logger(logger),
       _mqttTaskHandle(nullptr),
+      _clientMutex(xSemaphoreCreateMutex()),
       _subscriptionHandler(subscriptionHandler){
     s_activeMqttManager = this;
 }
 
 auto MqttManager::begin() -> bool {
-    _mqttClient->setBufferSize(MQTT_BUFFER_SIZE);
     loadMQTTConfig();
 
     const char *broker = {_mqttBroker};
-    _mqttClient->setServer(broker, atoi(_mqttPort));
-    _mqttClient->setCallback(handleMqttMessage);
+    {
+        ClientLock lock(_clientMutex);
+        _mqttClient->setBufferSize(MQTT_BUFFER_SIZE);
+        _mqttClient->setServer(broker, atoi(_mqttPort));
+        _mqttClient->setCallback(handleMqttMessage);
+    }
     addSystemSubscriptionHandlers(_mqttRootTopic);
 
     // Do NOT attempt connection here; Wi‑Fi/LWIP may not be initialized yet.
@@ -117,9 +147,8 @@ void MqttManager::loadMQTTConfig() {
         _mqttUser[0] = '\0';
     }
 
-    _logger->logDebug(("[MQTT] Loaded configuration; User: "
-        + String(_mqttUser) + ", Broker: " + String(_mqttBroker)
-        + ", Port: " + String(_mqttPort) + ", Root Topic: " + String(_mqttRootTopic)  ).c_str());
+    LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "[MQTT] Loaded configuration; User: %s, Broker: %s, Port: %s, Root Topic: %s",
+                 _mqttUser, _mqttBroker, _mqttPort, _mqttRootTopic.c_str());
     // _mqttEnabledConfigured now holds the persisted user setting.
 
     preferences.begin(MQTT_PREFS_NAMESPACE, false);
@@ -146,31 +175,41 @@ auto MqttManager::ensureMQTTConnection() -> bool {
     }
     _clientId = clientId;
     bool connected = false;
+    int state = 0;
     const bool hasUser = (_mqttUser[0] != '\0');
-    if (_hasWill && _willTopic.length() && _willMessage.length()) {
-        const char *willTopic = _willTopic.c_str();
-        const char *willMessage = _willMessage.c_str();
-        if (hasUser) {
-            connected = _mqttClient->connect(_clientId.c_str(), _mqttUser, _mqttPassword, willTopic, _willQos, _willRetain, willMessage);
-        } else {
-            connected = _mqttClient->connect(_clientId.c_str(), willTopic, _willQos, _willRetain, willMessage);
-        }
-    } else {
-        if (hasUser) {
-            connected = _mqttClient->connect(_clientId.c_str(), _mqttUser, _mqttPassword);
+    {
+        // Publishers give up after MQTT_PUBLISH_WAIT_MS rather than wait out
+        // the connect.
+        ClientLock lock(_clientMutex);
+        if (_hasWill && _willTopic.length() && _willMessage.length()) {
+            const char *willTopic = _willTopic.c_str();
+            const char *willMessage = _willMessage.c_str();
+            if (hasUser) {
+                connected = _mqttClient->connect(_clientId.c_str(), _mqttUser, _mqttPassword, willTopic, _willQos, _willRetain, willMessage);
+            } else {
+                connected = _mqttClient->connect(_clientId.c_str(), willTopic, _willQos, _willRetain, willMessage);
+            }
         } else {
-            connected = _mqttClient->connect(_clientId.c_str());
+            if (hasUser) {
+                connected = _mqttClient->connect(_clientId.c_str(), _mqttUser, _mqttPassword);
+            } else {
+                connected = _mqttClient->connect(_clientId.c_str());
+            }
         }
+        state = _mqttClient->state();
     }
 
     if (!connected) {
-        _logger->logError((String("MQTT connect failed, rc=") + String(_mqttClient->state())).c_str());
+        _logger->logError((String("MQTT connect failed, rc=") + String(state)).c_str());
     } else {
         IndicatorService::instance().setMqttConnected(true);
     }
 
     for (const auto &topic: _subscriptionHandler->getHandlerTopics()) {
-        _mqttClient->subscribe(topic.c_str());
+        {
+            ClientLock lock(_clientMutex);
+            _mqttClient->subscribe(topic.c_str());
+        }
         _logger->logInformation(("MQTT subscribe to: " + topic).c_str());
     }
     return connected;
@@ -178,11 +217,28 @@ auto MqttManager::ensureMQTTConnection() -> bool {
 
 void MqttManager::handleMqttMessage(char *topic, const byte *payload, const unsigned int length) {
     if (s_activeMqttManager != nullptr) {
-        const auto topicStr = String(topic);
-        s_activeMqttManager->onMqttMessage(topicStr, payload, length);
+        s_activeMqttManager->queueMessage(topic, payload, length);
     }
 }
 
+void MqttManager::queueMessage(const char *topic, const byte *payload, const unsigned int length) {
+    // payload points into the client's buffer, reused by the next call.
+    String message;
+    message.reserve(length);
+    for (unsigned int i = 0; i < length; i++) {
+        message += static_cast<char>(payload[i]);
+    }
+    _inbox.emplace_back(String(topic), std::move(message));
+}
+
+void MqttManager::dispatchMessages() {
+    for (const auto &entry: _inbox) {
+        _subscriptionHandler->handle(entry.first, entry.second);
+        LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "MqttManager::dispatchMessages - Received MQTT message");
+    }
+    _inbox.clear();
+}
+
 void MqttManager::addSystemSubscriptionHandlers(const String &rootTopic) const {
     _subscriptionHandler->addHandler(rootTopic + system_subscription_network_reset, [this](const String &) {
         _logger->logInformation("[MQTT][Subscriptions] Network reset requested by MQTT message");
@@ -196,9 +252,15 @@ void MqttManager::addSystemSubscriptionHandlers(const String &rootTopic) const {
 
 void MqttManager::addSubscriptionHandler(const String &topic, MqttSubscriptionHandler::TopicHandlerFunc handler) const {
     _subscriptionHandler->addHandler(topic, std::move(handler));
-    if (_mqttClient->connected()) {
-        _mqttClient->subscribe(topic.c_str());
-        _logger->logDebug((String("[MQTT][Subscriptions] Subscribed to dynamic topic: ") + topic).c_str());
+    bool subscribed = false;
+    {
+        ClientLock lock(_clientMutex);
+        if (_mqttClient->connected()) {
+            subscribed = _mqttClient->subscribe(topic.c_str());
+        }
+    }
+    if (subscribed) {
+        LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "[MQTT][Subscriptions] Subscribed to dynamic topic: %s", topic.c_str());
     }
 }
 
@@ -223,7 +285,11 @@ void MqttManager::removeSubscriptionHandlers(const std::vector<String> &topics)
             continue;
         }
 
-        const bool connectedNow = mqtt_manager->_mqttClient->connected();
+        bool connectedNow;
+        {
+            ClientLock lock(mqtt_manager->_clientMutex);
+            connectedNow = mqtt_manager->_mqttClient->connected();
+        }
         IndicatorService::instance().setMqttConnected(connectedNow);
         if (!connectedNow) {
             mqtt_manager->_logger->logError("MQTT disconnected, attempting reconnect");
@@ -235,7 +301,11 @@ void MqttManager::removeSubscriptionHandlers(const std::vector<String> &topics)
                 }
             }
         }
-        mqtt_manager->_mqttClient->loop();
+        {
+            ClientLock lock(mqtt_manager->_clientMutex);
+            mqtt_manager->_mqttClient->loop();
+        }
+        mqtt_manager->dispatchMessages();
         vTaskDelay(delayTicks);
     }
 }
@@ -261,7 +331,8 @@ bool MqttManager::mqttPublish(const char *topic, const char *payload, const bool
     if (!_mqttClient) {
         return false;
     }
-    return _mqttClient->publish(topic, payload, retain);
+    const ClientLock lock(_clientMutex, pdMS_TO_TICKS(MQTT_PUBLISH_WAIT_MS));
+    return lock.locked() && _mqttClient->publish(topic, payload, retain);
 }
 
 void MqttManager::configureWill(const String &topic, const String &payload, const uint8_t qos, const bool retain) {
@@ -283,17 +354,9 @@ void MqttManager::clearWill() {
 }
 
 bool MqttManager::isConnected() const {
-    return _mqttClient->connected();
-}
-
-void MqttManager::onMqttMessage(const String &topic, const uint8_t *payload, const size_t length) const {
-    String message;
-    message.reserve(length);
-    for (size_t i = 0; i < length; i++) {
-        message += static_cast<char>(payload[i]);
-    }
-    _subscriptionHandler->handle(topic, message);
-    _logger->logDebug("MqttManager::onMqttMessage - Received MQTT message");
+    // Held for longer only while connecting, so not connected yet.
+    const ClientLock lock(_clientMutex, pdMS_TO_TICKS(MQTT_PUBLISH_WAIT_MS));
+    return lock.locked() && _mqttClient->connected();
 }
 
 char *MqttManager::getMqttBroker() {
@@ -301,7 +364,8 @@ char *MqttManager::getMqttBroker() {
 }
 
 int MqttManager::getMQTTState() const {
-    return _mqttClient->state();
+    const ClientLock lock(_clientMutex, pdMS_TO_TICKS(MQTT_PUBLISH_WAIT_MS));
+    return lock.locked() ? _mqttClient->state() : MQTT_DISCONNECTED;
 }
 
 char *MqttManager::getMQTTUser() {
@@ -325,7 +389,10 @@ bool MqttManager::testConnectOnce() {
     loadMQTTConfig();
     const char *broker = {_mqttBroker};
     _logger->logInformation((String("Test connect to MQTT [") + broker + ":" + String(_mqttPort) + "]").c_str());
-    _mqttClient->setServer(broker, atoi(_mqttPort));
+    {
+        ClientLock lock(_clientMutex);
+        _mqttClient->setServer(broker, atoi(_mqttPort));
+    }
     if (WiFiClass::status() != WL_CONNECTED) {
         _logger->logError("MQTT test connect requested but Wi-Fi not connected");
         return false;
@@ -341,8 +408,11 @@ void MqttManager::reconfigureFromFile() {
     vTaskDelay(50 / portTICK_PERIOD_MS);
 
     // Disconnect if currently connected
-    if (_mqttClient->connected()) {
-        _mqttClient->disconnect();
+    {
+        ClientLock lock(_clientMutex);
+        if (_mqttClient->connected()) {
+            _mqttClient->disconnect();
+        }
     }
 
     // Reload configuration from SPIFFS/NVS
@@ -350,7 +420,10 @@ void MqttManager::reconfigureFromFile() {
 
     // Point client to new broker/port
     const char *broker = {_mqttBroker};
-    _mqttClient->setServer(broker, atoi(_mqttPort));
+    {
+        ClientLock lock(_clientMutex);
+        _mqttClient->setServer(broker, atoi(_mqttPort));
+    }
 
     // Rebuild subscriptions for new root topic
     _subscriptionHandler->clear();
@@ -36,7 +36,8 @@ void MqttSubscriptionHandler::handle(const String& topic, const String& message)
     auto foundHandler = false;
     for (auto &entry : _handlers) {
         if (entry.topic.equals(topic)) {
-            _logger->logDebug((String("MqttSubscriptionHandler::handle - Matched handler for topic [") + topic + "]").c_str());
+            LOGGER_DEBUG(_logger, LOGMODULE_MQTT, "MqttSubscriptionHandler::handle - Matched handler for topic [%s]",
+                         topic.c_str());
             entry.handlerFunc(message);
             foundHandler = true;
             break;
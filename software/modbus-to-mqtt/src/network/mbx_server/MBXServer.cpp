@@ -115,6 +115,17 @@ void MBXServer::configureRoutes() const {
         MBXServerHandlers::getLogs(req);
     });
 
+    server->on(Routes::LOG_SETTINGS, HTTP_GET, [this](AsyncWebServerRequest *req) {
+        logRequest(req);
+        MBXServerHandlers::handleGetLogSettings(req);
+    });
+
+    server->on(Routes::LOG_SETTINGS, HTTP_POST, [this](const AsyncWebServerRequest *req) {
+        logRequest(req);
+    }, nullptr, [](AsyncWebServerRequest *req, const uint8_t *data, const size_t len, const size_t index, const size_t total) {
+        MBXServerHandlers::handlePutLogSettingsBody(req, data, len, index, total);
+    });
+
     server->on(Routes::RESET_NETWORK, HTTP_GET, [this](AsyncWebServerRequest *req) {
         logRequest(req);
         serveFsFile(req, SPIFFS, "/pages/reset_result.html", MBXServerHandlers::handleNetworkReset, HttpMediaTypes::HTML,
@@ -354,7 +365,7 @@ auto MBXServer::tryConnectWithStoredCreds() const -> bool {
 void MBXServer::serveFsFile(AsyncWebServerRequest *reqPtr, FS &fs, const char *path,
                             const std::function<void()> &onServed, const char *contentType, const Logger *logger) {
     if (fs.exists(path)) {
-        logger->logDebug(("Serving file: " + String(path)).c_str());
+        LOGGER_DEBUG(logger, LOGMODULE_WEB, "Serving file: %s", path);
         reqPtr->send(fs, path, contentType);
         if (onServed) {
             reqPtr->onDisconnect([onServed] {
@@ -362,15 +373,14 @@ void MBXServer::serveFsFile(AsyncWebServerRequest *reqPtr, FS &fs, const char *p
             });
         }
     } else {
-        logger->logDebug(("File not found: " + String(path)).c_str());
+        LOGGER_DEBUG(logger, LOGMODULE_WEB, "File not found: %s", path);
         reqPtr->send(HttpResponseCodes::NOT_FOUND, HttpMediaTypes::PLAIN_TEXT, "Page not found");
     }
 }
 
 void MBXServer::logRequest(const AsyncWebServerRequest *request) const {
-    _logger->logDebug(
-        ("MBXServer: - Processing request: " + String(request->methodToString()) + ": " + String(request->url())).
-        c_str());
+    LOGGER_DEBUG(_logger, LOGMODULE_WEB, "MBXServer: - Processing request: %s: %s", request->methodToString(),
+                 request->url().c_str());
 }
 
 void MBXServer::ensureConfigFile() const {
@@ -21,7 +21,9 @@
 #include "services/OtaService.h"
 #include "services/ota/HttpOtaService.h"
 #include "services/IndicatorService.h"
+#include "logging/LogLevelSettings.h"
 #include "modbus/ModbusManager.h"
+#include "modbus/ModbusValueDecoder.h"
 
 auto constexpr OTA_FS_UPLOAD_BEGIN_FAIL_RESP = R"({"error":"ota_begin_failed"})";
 auto constexpr OTA_FW_UPLOAD_BEGIN_FAIL_RESP = R"({"error":"ota_begin_failed"})";
@@ -29,6 +31,8 @@ auto constexpr OTA_END_FAIL_RESP = R"({"error":"ota_end_failed"})";
 auto constexpr OTA_END_FW_UPLOAD_OK = R"({"ok":true,"type":"firmware"})";
 auto constexpr OTA_END_FS_UPLOAD_OK = R"({"ok":true,"type":"filesystem"})";
 auto constexpr BAD_REQUEST_RESP = R"({"error":"bad_request"})";
+auto constexpr TCP_DEVICE_UNSUPPORTED_RESP = R"({"error":"tcp_device_unsupported"})";
+auto constexpr MODBUS_BUSY_RESP = R"({"error":"modbus_busy"})";
 auto constexpr WIFI_HANDLER_OK_RESP = "{\"ok\":true}";
 auto constexpr WIFI_ALREADY_CONNECTING_RESP = R"({"error":"already_connecting"})";
 
@@ -570,17 +574,21 @@ void MBXServerHandlers::handlePutModbusConfigBody(AsyncWebServerRequest *req, co
             req->send(HttpResponseCodes::INTERNAL_SERVER_ERROR, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
             return;
         }
-        // Hot-reload Modbus configuration
+        // Hot-reload Modbus configuration. The file is saved either way; a
+        // busy answer means it is applied on the next reload or restart.
         if (auto *mb = g_mb.load(std::memory_order_acquire)) {
-            mb->reconfigureFromFile();
+            if (mb->reconfigureFromFile() == ModbusReloadResult::Busy) {
+                req->send(HttpResponseCodes::SERVICE_UNAVAILABLE, HttpMediaTypes::JSON, MODBUS_BUSY_RESP);
+                return;
+            }
         }
         req->send(HttpResponseCodes::NO_CONTENT);
     }
 }
 
 void MBXServerHandlers::handleModbusDisable(AsyncWebServerRequest *req, bool state) {
-        if (const auto *mb = g_mb.load(std::memory_order_acquire)) {
-            ModbusManager::setModbusEnabled(state);
+        if (auto *mb = g_mb.load(std::memory_order_acquire)) {
+            mb->setModbusEnabled(state);
         }
         req->send(HttpResponseCodes::OK);
 }
@@ -615,6 +623,13 @@ void MBXServerHandlers::handlePutMqttConfigBody(AsyncWebServerRequest *req, cons
     if (auto *link = g_comm.load(std::memory_order_acquire)) {
         link->reconfigureFromFile();
     }
+    // The root topic may have changed.
+    if (auto *mb = g_mb.load(std::memory_order_acquire)) {
+        if (!mb->refreshMqttTopics()) {
+            req->send(HttpResponseCodes::SERVICE_UNAVAILABLE, HttpMediaTypes::JSON, MODBUS_BUSY_RESP);
+            return;
+        }
+    }
 
     req->send(HttpResponseCodes::NO_CONTENT);
 }
@@ -718,9 +733,8 @@ void MBXServerHandlers::handleWifiApOff(AsyncWebServerRequest *req) {
 }
 
 void MBXServerHandlers::getSystemStats(AsyncWebServerRequest *req, const Logger *logger) {
-    logger->logDebug(
-        ("MBX Server: Started processing "
-         + String(req->methodToString()) + " request on " + req->url()).c_str());
+    LOGGER_DEBUG(logger, LOGMODULE_WEB, "MBX Server: Started processing %s request on %s", req->methodToString(),
+                 req->url().c_str());
 
     JsonDocument doc;
     doc = StatService::appendSystemStats(doc, logger);
@@ -731,8 +745,8 @@ void MBXServerHandlers::getSystemStats(AsyncWebServerRequest *req, const Logger
     doc = StatService::appendHealthStats(doc);
 
     sendJson(req, doc);
-    logger->logDebug(
-        ("MBX Server: Finished processing " + String(req->methodToString()) + " request on " + req->url()).c_str());
+    LOGGER_DEBUG(logger, LOGMODULE_WEB, "MBX Server: Finished processing %s request on %s", req->methodToString(),
+                 req->url().c_str());
 }
 
 void MBXServerHandlers::getLogs(AsyncWebServerRequest *req) {
@@ -760,6 +774,57 @@ void MBXServerHandlers::getLogs(AsyncWebServerRequest *req) {
     }
 }
 
+void MBXServerHandlers::handleGetLogSettings(AsyncWebServerRequest *req) {
+    JsonDocument doc;
+    for (int m = 0; m < LOGMODULE_COUNT; ++m) {
+        const auto module = static_cast<LogModule>(m);
+        doc[LogLevelSettings::moduleName(module)] = LogLevelSettings::levelName(LogLevelSettings::get(module));
+    }
+    sendJson(req, doc);
+}
+
+void MBXServerHandlers::handlePutLogSettingsBody(AsyncWebServerRequest *req, const uint8_t *data, const size_t len,
+                                                 const size_t index, const size_t total) {
+    char *body = BodyAccumulator::append(req->_tempObject, data, len, index, total);
+    if (body == nullptr) {
+        if (index + len == total) {
+            logHandlerError("POST /api/logs/settings: out of memory accumulating request body");
+            req->send(HttpResponseCodes::INTERNAL_SERVER_ERROR, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
+        }
+        return;
+    }
+
+    JsonDocument doc;
+    if (deserializeJson(doc, body, total) || !doc.is<JsonObject>()) {
+        req->send(HttpResponseCodes::BAD_REQUEST, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
+        return;
+    }
+    // Any subset of modules; nothing is applied unless every field is valid.
+    LogLevel levels[LOGMODULE_COUNT];
+    bool given[LOGMODULE_COUNT] = {};
+    size_t known = 0;
+    for (int m = 0; m < LOGMODULE_COUNT; ++m) {
+        const JsonVariantConst field = doc[LogLevelSettings::moduleName(static_cast<LogModule>(m))];
+        if (field.isNull()) continue;
+        if (!LogLevelSettings::parseLevel(field.as<const char *>(), levels[m])) {
+            req->send(HttpResponseCodes::BAD_REQUEST, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
+            return;
+        }
+        given[m] = true;
+        ++known;
+    }
+    if (known != doc.as<JsonObjectConst>().size()) {
+        req->send(HttpResponseCodes::BAD_REQUEST, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
+        return;
+    }
+    for (int m = 0; m < LOGMODULE_COUNT; ++m) {
+        if (given[m]) {
+            LogLevelSettings::set(static_cast<LogModule>(m), levels[m]);
+        }
+    }
+    req->send(HttpResponseCodes::NO_CONTENT);
+}
+
 void MBXServerHandlers::handleMqttTestConnection(AsyncWebServerRequest *req) {
     auto *link = MBXServerHandlers::getMqttManager();
     JsonDocument doc;
@@ -803,15 +868,26 @@ void MBXServerHandlers::handleModbusExecute(AsyncWebServerRequest *req) {
     const long addr = sAddr.toInt();
     long len = sLen.toInt();
     const long slaveOverride = hasSlaveOverride ? sSlave.toInt() : 0;
+    // Optional: a read may be answered from data polled at most this long ago.
+    String sMaxAge;
+    const long maxAgeMs = getParam("maxAgeMs", sMaxAge) ? sMaxAge.toInt() : 0;
     const bool slaveOverrideValid = slaveOverride > 0 && slaveOverride <= 247;
-    if (func <= 0 || addr < 0 || len <= 0) {
+    if (func <= 0 || addr < 0 || len <= 0 || maxAgeMs < 0) {
         req->send(HttpResponseCodes::BAD_REQUEST, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
         return;
     }
 
-    // Optional value for write operations (ignored here but echoed back)
+    // Value(s) for write operations: a comma separated list for FC15/16/23.
     String sValue;
     if (req->hasParam("value")) sValue = req->getParam("value")->value();
+    sValue.trim();
+    // FC23 writes here and reads addr/len back; defaults to addr.
+    String sWriteAddr;
+    const long writeAddr = getParam("writeAddr", sWriteAddr) ? sWriteAddr.toInt() : addr;
+    if (writeAddr < 0) {
+        req->send(HttpResponseCodes::BAD_REQUEST, HttpMediaTypes::JSON, BAD_REQUEST_RESP);
+        return;
+    }
 
     // Execute against Modbus
     JsonDocument doc;
@@ -826,41 +902,66 @@ void MBXServerHandlers::handleModbusExecute(AsyncWebServerRequest *req) {
     // Resolve slave id by datapoint
     const ModbusDevice *dpDevice = nullptr;
     const ModbusDatapoint *dpMeta = mb->findDatapointById(dpId, &dpDevice);
-    uint8_t slave = 0;
-    if (slaveOverrideValid) {
-        slave = static_cast<uint8_t>(slaveOverride);
-    } else if (dpDevice) {
-        slave = dpDevice->slaveId;
-    } else {
+    if (!dpDevice) {
         const ConfigurationRoot &cfg = mb->getConfiguration();
         for (const auto &dev: cfg.devices) {
             if (dev.id == devId) {
-                slave = dev.slaveId;
+                dpDevice = &dev;
                 break;
             }
         }
     }
+    if (dpDevice && dpDevice->transport() == ModbusTransport::Tcp) {
+        // Commands only run on the RS485 buses so far; sent there, this one
+        // would reach whichever slave shares the unit id.
+        if (auto *mem = g_memlog.load(std::memory_order_acquire)) {
+            mem->logWarning((String("POST /api/modbus/execute: ") + dpDevice->name +
+                             " is a Modbus TCP device, commands are not supported, rejected").c_str());
+        }
+        req->send(HttpResponseCodes::BAD_REQUEST, HttpMediaTypes::JSON, TCP_DEVICE_UNSUPPORTED_RESP);
+        return;
+    }
+    uint8_t slave = 0;
+    if (slaveOverrideValid) {
+        slave = static_cast<uint8_t>(slaveOverride);
+    } else if (dpDevice) {
+        slave = dpDevice->slaveId;
+    }
+    const uint8_t bus = dpDevice ? dpDevice->bus : 0;
     if (slave == 0) slave = MODBUS_SLAVE_ID;
 
-    uint16_t outBuf[16]{};
+    // Room for the largest reply a read can carry (125 registers or 2000 coils).
+    uint16_t outBuf[ModbusRtuMaster::kMaxWords]{};
     uint16_t outCount = 0;
     String rxDump;
-    uint16_t writeVal = 0;
-    bool hasWriteVal = false;
+    // Values are raw (unscaled). Registers take the datapoint's type and
+    // word order when it has one, plain 16-bit words otherwise.
+    uint16_t writeVals[ModbusCommand::kMaxValues]{};
+    uint16_t writeCount = 0;
     if (sValue.length()) {
-        if (sValue.equalsIgnoreCase("true") || sValue == "1") writeVal = 1;
-        else if (sValue.equalsIgnoreCase("false") || sValue == "0") writeVal = 0;
-        else writeVal = static_cast<uint16_t>(sValue.toInt());
-        hasWriteVal = true;
+        const ModbusDataType type = dpMeta ? dpMeta->dataType : UINT16;
+        const ModbusWordOrder order = dpMeta ? dpMeta->wordOrder : ModbusWordOrder::ABCD;
+        if (func == 15) {
+            len = ModbusManager::coilsFromPayload(sValue, (uint16_t) len, writeVals, ModbusCommand::kMaxValues);
+            writeCount = static_cast<uint16_t>((len + 15) / 16);
+        } else if (func == 16 || func == 23) {
+            writeCount = ModbusManager::registersFromPayload(sValue, type, order, 1.0f, (uint16_t) len, writeVals,
+                                                             ModbusCommand::kMaxValues);
+            if (func == 16) len = writeCount;
+        } else {
+            if (sValue.equalsIgnoreCase("true") || sValue == "1") writeVals[0] = 1;
+            else if (sValue.equalsIgnoreCase("false") || sValue == "0") writeVals[0] = 0;
+            else writeVals[0] = static_cast<uint16_t>(sValue.toInt());
+            writeCount = 1;
+        }
     }
-
-    if (func == 5 || func == 6 || func == 16) {
-        len = 1; // single write workaround even for FC16
+    if (func == 5 || func == 6) {
+        len = 1;
     }
 
-    const uint8_t status = mb->executeCommand(slave, (int) func, (uint16_t) addr, (uint16_t) len,
-                                              writeVal, hasWriteVal,
-                                              outBuf, 16, outCount, rxDump);
+    const uint8_t status = mb->executeCommand(bus, slave, (int) func, (uint16_t) addr, (uint16_t) len,
+                                              writeVals, writeCount, (uint16_t) writeAddr,
+                                              outBuf, ModbusRtuMaster::kMaxWords, outCount, rxDump, (uint32_t) maxAgeMs);
 
     doc["ok"] = (status == 0);
     doc["code"] = status;
@@ -871,6 +972,8 @@ void MBXServerHandlers::handleModbusExecute(AsyncWebServerRequest *req) {
     doc["request"]["addr"] = addr;
     doc["request"]["len"] = len;
     if (sValue.length()) doc["request"]["value"] = sValue;
+    if (func == 23) doc["request"]["writeAddr"] = writeAddr;
+    if (maxAgeMs > 0) doc["request"]["maxAgeMs"] = maxAgeMs;
     if (rxDump.length()) doc["rx_dump"] = rxDump;
     if (outCount > 0) {
         JsonArray raw = doc["result"]["raw"].to<JsonArray>();
@@ -879,6 +982,9 @@ void MBXServerHandlers::handleModbusExecute(AsyncWebServerRequest *req) {
         }
         if (dpMeta && dpMeta->dataType == TEXT) {
             doc["result"]["value"] = ModbusManager::registersToAscii(outBuf, outCount);
+        } else if (dpMeta && dpMeta->decode &&
+                   outCount >= ModbusValueDecoder::registerCount(dpMeta->dataType)) {
+            doc["result"]["value"] = dpMeta->decode(outBuf) * dpMeta->scale;
         } else if (dpMeta) {
             const uint16_t rawWord = outCount > 0 ? outBuf[0] : 0;
             const uint16_t sliced = ModbusManager::sliceRegister(rawWord, dpMeta->registerSlice);
@@ -95,18 +95,37 @@ JsonDocument StatService::appendModbusStats(JsonDocument &document) {
 
     const auto config = modbusManager->getConfiguration();
 
-    document["buses"] = 1;
+    document["buses"] = config.busCount();
     document["devices"] =  config.devices.size();
     size_t totalDatapoints = 0;
+    size_t lateDatapoints = 0;
+    const auto lateIds = document["lateDatapointIds"].to<JsonArray>();
     for (const auto &dev : config.devices) {
         totalDatapoints += dev.datapoints.size();
+        for (const auto &dp : dev.datapoints) {
+            if (!dp.late) continue;
+            // Keep the stats payload bounded on large configs.
+            if (lateDatapoints < 16) lateIds.add(dp.id);
+            ++lateDatapoints;
+        }
     }
 
-    const bool enabled = ModbusManager::getBusState();
+    const bool enabled = modbusManager->getBusState();
+    const ModbusBusLoad load = modbusManager->getBusLoad();
+    const ModbusReadCacheStats cache = modbusManager->getReadCacheStats();
+    const ModbusPublishStats publish = modbusManager->getPublishStats();
 
     document["mbusEnabled"] = enabled;
     document["datapoints"] = totalDatapoints;
     document["modbusErrorCount"] = ModbusManager::getBusErrorCount();
+    document["busLoadProjectedPct"] = static_cast<float>(load.projectedPermille) / 10.0f;
+    document["busLoadPct"] = static_cast<float>(load.measuredPermille) / 10.0f;
+    document["busLineSwitches"] = load.lineSwitches;
+    document["lateDatapoints"] = lateDatapoints;
+    document["readCacheHits"] = cache.hits;
+    document["readCacheMisses"] = cache.misses;
+    document["publishedValues"] = publish.published;
+    document["suppressedValues"] = publish.suppressed;
     return document;
 }
 
@@ -71,3 +71,13 @@ String TimeService::nowIso() {
     if (now < TIME_VALID_THRESHOLD) return "";
     return formatIso(now);
 }
+
+size_t TimeService::nowIso(char *out, const size_t capacity) {
+    if (!out || capacity == 0) return 0;
+    out[0] = '\0';
+    const time_t now = time(nullptr);
+    if (now < TIME_VALID_THRESHOLD) return 0;
+    tm tm{};
+    gmtime_r(&now, &tm);
+    return strftime(out, capacity, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
@@ -41,6 +41,30 @@ int TeeStream::available() {
     return _inner.available();
 }
 
+size_t TeeStream::readAvailable(uint8_t *dst, const size_t capacity) {
+    const int avail = available();
+    if (avail <= 0 || capacity == 0) return 0;
+    size_t n = static_cast<size_t>(avail) < capacity ? static_cast<size_t>(avail) : capacity;
+    n = _inner.readBytes(reinterpret_cast<char *>(dst), n);
+#if RS485_DROP_LEADING_ZERO
+    if (_capture && !_sawFirstByte) {
+        size_t skip = 0;
+        while (skip < n && dst[skip] == 0x00) ++skip;
+        if (skip > 0) {
+            memmove(dst, dst + skip, n - skip);
+            n -= skip;
+        }
+    }
+#endif
+    if (_capture) {
+        for (size_t i = 0; i < n && _bufLen < sizeof(_buf); ++i) {
+            _buf[_bufLen++] = dst[i];
+        }
+        if (n > 0) _sawFirstByte = true;
+    }
+    return n;
+}
+
 int TeeStream::read() {
     int b = _inner.read();
 #if RS485_DROP_LEADING_ZERO
@@ -0,0 +1,144 @@
+// Native-host tests for the ModbusBusTiming wire-time model.
+//
+// The model only depends on the planner's block type, so both translation
+// units are included directly.
+
+#include "../../src/modbus/ModbusBusTiming.cpp"
+#include "../../src/modbus/ModbusReadPlanner.cpp"
+
+#include <unity.h>
+#include <vector>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Character time follows the frame format; t3.5 is fixed above 19200 baud.
+// ---------------------------------------------------------------------------
+void test_line_timing_follows_baud_and_format(void) {
+    const ModbusLineTiming slow = ModbusBusTiming::lineTiming(9600, "8N1");
+    TEST_ASSERT_EQUAL_UINT32(1042, slow.charUs);
+    TEST_ASSERT_EQUAL_UINT32(3647, slow.interFrameUs);
+
+    const ModbusLineTiming parity = ModbusBusTiming::lineTiming(19200, "8E1");
+    TEST_ASSERT_EQUAL_UINT32(573, parity.charUs);
+    TEST_ASSERT_EQUAL_UINT32(2006, parity.interFrameUs);
+
+    const ModbusLineTiming fast = ModbusBusTiming::lineTiming(115200, "8N2");
+    TEST_ASSERT_EQUAL_UINT32(96, fast.charUs);
+    TEST_ASSERT_EQUAL_UINT32(1750, fast.interFrameUs);
+
+    const ModbusLineTiming fallback = ModbusBusTiming::lineTiming(9600, "bogus");
+    TEST_ASSERT_EQUAL_UINT32(slow.charUs, fallback.charUs);
+}
+
+// ---------------------------------------------------------------------------
+// RTU frame sizes for reads and writes.
+// ---------------------------------------------------------------------------
+void test_frame_sizes(void) {
+    TEST_ASSERT_EQUAL_UINT16(8, ModbusBusTiming::requestBytes(READ_HOLDING, 10));
+    TEST_ASSERT_EQUAL_UINT16(25, ModbusBusTiming::responseBytes(READ_HOLDING, 10));
+    TEST_ASSERT_EQUAL_UINT16(6, ModbusBusTiming::responseBytes(READ_COIL, 1));
+    TEST_ASSERT_EQUAL_UINT16(7, ModbusBusTiming::responseBytes(READ_DISCRETE, 9));
+    TEST_ASSERT_EQUAL_UINT16(13, ModbusBusTiming::requestBytes(WRITE_MULTIPLE_HOLDING, 2));
+    TEST_ASSERT_EQUAL_UINT16(8, ModbusBusTiming::responseBytes(WRITE_HOLDING, 1));
+}
+
+// ---------------------------------------------------------------------------
+// A transaction is both frames plus guards, slave turnaround and t3.5, and a
+// plan is the sum of its blocks.
+// ---------------------------------------------------------------------------
+void test_transaction_and_plan_time(void) {
+    const ModbusLineTiming line = ModbusBusTiming::lineTiming(9600, "8N1");
+    const ModbusTurnaround turnaround{1000, 3000};
+
+    const uint32_t one = ModbusBusTiming::transactionUs(line, turnaround, READ_HOLDING, 10);
+    TEST_ASSERT_EQUAL_UINT32(33U * 1042U + 2000U + 3000U + 3647U, one);
+
+    std::vector<ModbusReadBlock> blocks = {
+        {READ_HOLDING, 0, 10, 0, 1},
+        {READ_HOLDING, 100, 10, 1, 1},
+    };
+    TEST_ASSERT_EQUAL_UINT64(2ULL * one, ModbusBusTiming::planUs(line, turnaround, blocks));
+}
+
+// ---------------------------------------------------------------------------
+// Guards follow t3.5 rather than a fixed delay: hardware direction control
+// drops the settle time, and the pre-send wait only covers silence still owed.
+// ---------------------------------------------------------------------------
+void test_guards_follow_line_timing(void) {
+    const ModbusLineTiming line = ModbusBusTiming::lineTiming(9600, "8N1");
+
+    const ModbusGuardTimes gpio = ModbusBusTiming::guardTimes(line, false, 50);
+    TEST_ASSERT_EQUAL_UINT32(3647, gpio.interFrameUs);
+    TEST_ASSERT_EQUAL_UINT32(50, gpio.preUs);
+    TEST_ASSERT_EQUAL_UINT32(50, gpio.postUs);
+
+    const ModbusGuardTimes hw = ModbusBusTiming::guardTimes(line, true, 50);
+    TEST_ASSERT_EQUAL_UINT32(3647, hw.interFrameUs);
+    TEST_ASSERT_EQUAL_UINT32(0, hw.preUs);
+    TEST_ASSERT_EQUAL_UINT32(0, hw.postUs);
+
+    TEST_ASSERT_EQUAL_UINT32(3647, ModbusBusTiming::silenceToWaitUs(hw.interFrameUs, 0));
+    TEST_ASSERT_EQUAL_UINT32(647, ModbusBusTiming::silenceToWaitUs(hw.interFrameUs, 3000));
+    TEST_ASSERT_EQUAL_UINT32(0, ModbusBusTiming::silenceToWaitUs(hw.interFrameUs, 3647));
+    TEST_ASSERT_EQUAL_UINT32(0, ModbusBusTiming::silenceToWaitUs(hw.interFrameUs, 100000));
+
+    // At 115200 baud the old fixed 1 ms guards cost more than the frames.
+    const ModbusLineTiming fast = ModbusBusTiming::lineTiming(115200, "8N1");
+    const ModbusTurnaround fixedGuards{1000, 3000};
+    const ModbusTurnaround hwGuards{ModbusBusTiming::guardTimes(fast, true, 0).preUs, 3000};
+    const uint32_t before = ModbusBusTiming::transactionUs(fast, fixedGuards, READ_HOLDING, 10);
+    const uint32_t after = ModbusBusTiming::transactionUs(fast, hwGuards, READ_HOLDING, 10);
+    TEST_ASSERT_EQUAL_UINT32(2000, before - after);
+}
+
+// ---------------------------------------------------------------------------
+// The UART idle threshold covers t3.5 in whole characters, within range.
+// ---------------------------------------------------------------------------
+void test_idle_symbols_cover_inter_frame_gap(void) {
+    TEST_ASSERT_EQUAL_UINT8(4, ModbusBusTiming::idleSymbols(ModbusBusTiming::lineTiming(9600, "8N1")));
+    TEST_ASSERT_EQUAL_UINT8(21, ModbusBusTiming::idleSymbols(ModbusBusTiming::lineTiming(115200, "8N1")));
+    TEST_ASSERT_EQUAL_UINT8(ModbusBusTiming::kMaxIdleSymbols,
+                            ModbusBusTiming::idleSymbols(ModbusBusTiming::lineTiming(921600, "8N1")));
+    TEST_ASSERT_EQUAL_UINT8(1, ModbusBusTiming::idleSymbols(ModbusLineTiming{1000, 0}));
+}
+
+// ---------------------------------------------------------------------------
+// Fifty single registers every second at 9600 baud: per-datapoint polling
+// overloads the bus, the coalesced plan fits comfortably.
+// ---------------------------------------------------------------------------
+void test_projection_flags_overload(void) {
+    const ModbusLineTiming line = ModbusBusTiming::lineTiming(9600, "8N1");
+    const ModbusTurnaround turnaround{1000, 3000};
+
+    std::vector<ModbusReadRequest> requests;
+    std::vector<ModbusReadBlock> perDatapoint;
+    for (uint16_t i = 0; i < 50; ++i) {
+        requests.push_back({READ_HOLDING, i, 1});
+        perDatapoint.push_back({READ_HOLDING, i, 1, i, 1});
+    }
+    std::vector<ModbusReadBlock> planned;
+    std::vector<size_t> members;
+    ModbusReadPlanner::plan(requests.data(), requests.size(), {}, planned, members);
+
+    const uint16_t naive = ModbusBusTiming::permille(ModbusBusTiming::planUs(line, turnaround, perDatapoint), 1000000);
+    const uint16_t merged = ModbusBusTiming::permille(ModbusBusTiming::planUs(line, turnaround, planned), 1000000);
+    TEST_ASSERT_TRUE(naive > 1000);
+    TEST_ASSERT_TRUE(merged < 200);
+
+    TEST_ASSERT_EQUAL_UINT16(500, ModbusBusTiming::permille(5000, 10000));
+    TEST_ASSERT_EQUAL_UINT16(0, ModbusBusTiming::permille(0, 0));
+    TEST_ASSERT_EQUAL_UINT16(UINT16_MAX, ModbusBusTiming::permille(1000000000ULL, 1));
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_line_timing_follows_baud_and_format);
+    RUN_TEST(test_frame_sizes);
+    RUN_TEST(test_transaction_and_plan_time);
+    RUN_TEST(test_guards_follow_line_timing);
+    RUN_TEST(test_idle_symbols_cover_inter_frame_gap);
+    RUN_TEST(test_projection_flags_overload);
+    return UNITY_END();
+}
@@ -0,0 +1,131 @@
+// Native-host tests for ModbusCommandQueue.
+//
+// The queue has no Arduino dependencies, so its translation unit is included
+// directly.
+
+#include "../../src/modbus/ModbusCommandQueue.cpp"
+
+#include <unity.h>
+
+namespace {
+
+ModbusCommandQueue queue;
+
+ModbusCommand command(const uint16_t address, const uint8_t function = 3) {
+    ModbusCommand c{};
+    c.slaveId = 1;
+    c.function = function;
+    c.address = address;
+    c.count = 1;
+    return c;
+}
+
+}  // namespace
+
+void setUp(void) {
+    ModbusCommand drained{};
+    while (queue.pop(drained)) {
+    }
+}
+
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Writes jump ahead of reads queued earlier; each lane stays FIFO.
+// ---------------------------------------------------------------------------
+void test_writes_are_served_before_reads(void) {
+    TEST_ASSERT_TRUE(queue.push(command(10), ModbusCommandPriority::Read));
+    TEST_ASSERT_TRUE(queue.push(command(11), ModbusCommandPriority::Read));
+    TEST_ASSERT_TRUE(queue.push(command(20, 6), ModbusCommandPriority::Write));
+    TEST_ASSERT_TRUE(queue.push(command(21, 6), ModbusCommandPriority::Write));
+    TEST_ASSERT_EQUAL_UINT(4, queue.size());
+
+    const uint16_t expected[] = {20, 21, 10, 11};
+    for (const uint16_t address: expected) {
+        ModbusCommand out{};
+        TEST_ASSERT_TRUE(queue.pop(out));
+        TEST_ASSERT_EQUAL_UINT16(address, out.address);
+    }
+    ModbusCommand out{};
+    TEST_ASSERT_FALSE(queue.pop(out));
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+// ---------------------------------------------------------------------------
+// A full lane rejects further commands without affecting the other lane, and
+// the ring wraps once drained.
+// ---------------------------------------------------------------------------
+void test_full_lane_rejects_without_blocking_other_lane(void) {
+    for (uint16_t i = 0; i < ModbusCommandQueue::kLaneCapacity; ++i) {
+        TEST_ASSERT_TRUE(queue.push(command(i), ModbusCommandPriority::Read));
+    }
+    TEST_ASSERT_FALSE(queue.push(command(99), ModbusCommandPriority::Read));
+    TEST_ASSERT_TRUE(queue.push(command(500, 6), ModbusCommandPriority::Write));
+
+    ModbusCommand out{};
+    TEST_ASSERT_TRUE(queue.pop(out));
+    TEST_ASSERT_EQUAL_UINT16(500, out.address);
+    TEST_ASSERT_TRUE(queue.pop(out));
+    TEST_ASSERT_EQUAL_UINT16(0, out.address);
+
+    TEST_ASSERT_TRUE(queue.push(command(100), ModbusCommandPriority::Read));
+    for (uint16_t i = 1; i < ModbusCommandQueue::kLaneCapacity; ++i) {
+        TEST_ASSERT_TRUE(queue.pop(out));
+        TEST_ASSERT_EQUAL_UINT16(i, out.address);
+    }
+    TEST_ASSERT_TRUE(queue.pop(out));
+    TEST_ASSERT_EQUAL_UINT16(100, out.address);
+}
+
+// ---------------------------------------------------------------------------
+// The callback and its context travel with the command.
+// ---------------------------------------------------------------------------
+void test_callback_travels_with_command(void) {
+    static int calls = 0;
+    static uint32_t seenLatency = 0;
+    ModbusCommand c = command(7, 6);
+    c.context = &calls;
+    c.onComplete = [](void *context, const ModbusCommand &cmd, const ModbusCommandResult &result) {
+        ++*static_cast<int *>(context);
+        seenLatency = result.latencyMs;
+        TEST_ASSERT_EQUAL_UINT16(7, cmd.address);
+    };
+    TEST_ASSERT_TRUE(queue.push(c, ModbusCommandPriority::Write));
+
+    ModbusCommand out{};
+    TEST_ASSERT_TRUE(queue.pop(out));
+    const ModbusCommandResult result{0, 42, nullptr, 0, ""};
+    out.onComplete(out.context, out, result);
+    TEST_ASSERT_EQUAL_INT(1, calls);
+    TEST_ASSERT_EQUAL_UINT32(42, seenLatency);
+}
+
+// ---------------------------------------------------------------------------
+// A command run inline on the caller's task hands its outcome straight to
+// the reply: words are clamped to the caller's buffer, and a write with no
+// buffer only reports its status.
+// ---------------------------------------------------------------------------
+void test_reply_captures_inline_completion(void) {
+    const uint16_t words[] = {10, 20, 30};
+    uint16_t out[2]{};
+    ModbusCommandReply reply{out, 2, 0, 0xE4};
+    reply.capture(ModbusCommandResult{0, 5, words, 3, ""});
+    TEST_ASSERT_EQUAL_UINT8(0, reply.status);
+    TEST_ASSERT_EQUAL_UINT16(2, reply.outCount);
+    TEST_ASSERT_EQUAL_UINT16(10, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(20, out[1]);
+
+    ModbusCommandReply write{nullptr, 0, 7, 0xE4};
+    write.capture(ModbusCommandResult{0x02, 5, words, 3, ""});
+    TEST_ASSERT_EQUAL_UINT8(0x02, write.status);
+    TEST_ASSERT_EQUAL_UINT16(0, write.outCount);
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_writes_are_served_before_reads);
+    RUN_TEST(test_full_lane_rejects_without_blocking_other_lane);
+    RUN_TEST(test_callback_travels_with_command);
+    RUN_TEST(test_reply_captures_inline_completion);
+    return UNITY_END();
+}
@@ -0,0 +1,240 @@
+// Native-host tests and scan-cost benchmark for ModbusDeadlineQueue.
+//
+// The queue has no Arduino dependencies, so its translation unit is included
+// directly.
+
+#include "../../src/modbus/ModbusDeadlineQueue.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+ModbusDeadlineQueue queue;
+std::vector<ModbusDeadline> due;
+
+ModbusDeadline entry(const uint32_t dueAtMs, const uint16_t device, const uint16_t datapoint,
+                     const uint8_t priority = 1) {
+    return ModbusDeadline{dueAtMs, priority, device, datapoint};
+}
+
+}  // namespace
+
+void setUp(void) {
+    queue.clear();
+    due.clear();
+}
+
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Only entries whose deadline has passed are popped, earliest first, and the
+// caller learns exactly how long it may sleep.
+// ---------------------------------------------------------------------------
+void test_pops_due_entries_in_deadline_order(void) {
+    queue.push(entry(300, 0, 0));
+    queue.push(entry(100, 0, 1));
+    queue.push(entry(200, 0, 2));
+
+    TEST_ASSERT_EQUAL_UINT32(50, queue.msUntilNext(50));
+    TEST_ASSERT_EQUAL_UINT(0, queue.popDue(99, due));
+
+    TEST_ASSERT_EQUAL_UINT(2, queue.popDue(200, due));
+    TEST_ASSERT_EQUAL_UINT16(1, due[0].datapoint);
+    TEST_ASSERT_EQUAL_UINT16(2, due[1].datapoint);
+    TEST_ASSERT_EQUAL_UINT32(100, queue.msUntilNext(200));
+    TEST_ASSERT_EQUAL_UINT32(0, queue.msUntilNext(400));
+
+    queue.clear();
+    TEST_ASSERT_EQUAL_UINT32(ModbusDeadlineQueue::kNoDeadline, queue.msUntilNext(0));
+}
+
+// ---------------------------------------------------------------------------
+// Deadlines straddling the 2^32 ms millis() wrap stay in order.
+// ---------------------------------------------------------------------------
+void test_ordering_survives_millis_wrap(void) {
+    const uint32_t nearWrap = 0xFFFFFF00U;
+    queue.push(entry(nearWrap + 0x200U, 0, 0)); // wraps to 0x100
+    queue.push(entry(nearWrap + 0x80U, 0, 1));
+
+    TEST_ASSERT_TRUE(ModbusDeadlineQueue::isBefore(nearWrap, 0x100U));
+    TEST_ASSERT_FALSE(ModbusDeadlineQueue::isBefore(0x100U, nearWrap));
+    TEST_ASSERT_EQUAL_UINT32(0x80U, queue.msUntilNext(nearWrap));
+
+    TEST_ASSERT_EQUAL_UINT(1, queue.popDue(0x10U, due));
+    TEST_ASSERT_EQUAL_UINT16(1, due[0].datapoint);
+    TEST_ASSERT_EQUAL_UINT32(0xF0U, queue.msUntilNext(0x10U));
+}
+
+// ---------------------------------------------------------------------------
+// Equal deadlines pop fast-priority entries first.
+// ---------------------------------------------------------------------------
+void test_priority_breaks_deadline_ties(void) {
+    queue.push(entry(500, 0, 0, 1));
+    queue.push(entry(500, 0, 1, 0));
+    queue.push(entry(499, 0, 2, 1));
+
+    TEST_ASSERT_EQUAL_UINT(3, queue.popDue(500, due));
+    TEST_ASSERT_EQUAL_UINT16(2, due[0].datapoint); // earlier deadline still wins
+    TEST_ASSERT_EQUAL_UINT16(1, due[1].datapoint);
+    TEST_ASSERT_EQUAL_UINT16(0, due[2].datapoint);
+}
+
+// ---------------------------------------------------------------------------
+// A popped batch is grouped per device, most urgent device first, keeping
+// urgency order inside each device.
+// ---------------------------------------------------------------------------
+void test_batch_is_grouped_by_device(void) {
+    std::vector<ModbusDeadline> batch = {
+        entry(10, 2, 0), entry(11, 0, 0), entry(12, 2, 1), entry(13, 1, 0), entry(14, 0, 1),
+    };
+    std::vector<uint16_t> rank;
+    ModbusDeadlineQueue::groupByDevice(batch, 3, rank);
+
+    const uint16_t devices[] = {2, 2, 0, 0, 1};
+    const uint16_t datapoints[] = {0, 1, 0, 1, 0};
+    for (size_t i = 0; i < batch.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT16(devices[i], batch[i].device);
+        TEST_ASSERT_EQUAL_UINT16(datapoints[i], batch[i].datapoint);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Device runs on one serial setting are brought together, the setting the
+// UART already runs with first, so a pass switches it as rarely as possible.
+// ---------------------------------------------------------------------------
+void test_batch_is_grouped_by_line(void) {
+    std::vector<ModbusDeadline> batch = {
+        entry(10, 2, 0), entry(11, 2, 1), entry(12, 0, 0), entry(13, 3, 0), entry(14, 1, 0), entry(15, 1, 1),
+    };
+    // Devices 0 and 3 on setting 0, devices 1 and 2 on setting 1.
+    const std::vector<uint8_t> deviceLine = {0, 1, 1, 0};
+    std::vector<uint16_t> rank;
+    ModbusDeadlineQueue::groupByLine(batch, deviceLine, 0, rank);
+
+    const uint16_t devices[] = {0, 3, 2, 2, 1, 1};
+    const uint16_t datapoints[] = {0, 0, 0, 1, 0, 1};
+    for (size_t i = 0; i < batch.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT16(devices[i], batch[i].device);
+        TEST_ASSERT_EQUAL_UINT16(datapoints[i], batch[i].datapoint);
+    }
+
+    // Already on setting 1: those devices go first instead.
+    ModbusDeadlineQueue::groupByLine(batch, deviceLine, 1, rank);
+    const uint16_t onLine1[] = {2, 2, 1, 1, 0, 3};
+    for (size_t i = 0; i < batch.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT16(onLine1[i], batch[i].device);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Fixed-rate re-arming keeps the ideal grid despite late polls, and skips
+// missed slots instead of bursting to catch up, also across the wrap.
+// ---------------------------------------------------------------------------
+void test_fixed_rate_keeps_ideal_grid(void) {
+    TEST_ASSERT_EQUAL_UINT32(2000, ModbusDeadlineQueue::nextFixedRate(1000, 1000, 1040));
+    TEST_ASSERT_EQUAL_UINT32(4000, ModbusDeadlineQueue::nextFixedRate(1000, 1000, 3500));
+    TEST_ASSERT_EQUAL_UINT32(4000, ModbusDeadlineQueue::nextFixedRate(1000, 1000, 3000));
+    TEST_ASSERT_EQUAL_UINT32(0x00000064U, ModbusDeadlineQueue::nextFixedRate(0xFFFFFFCEU, 150, 0xFFFFFFD0U));
+    TEST_ASSERT_EQUAL_UINT32(777, ModbusDeadlineQueue::nextFixedRate(5, 0, 777));
+
+    // A poll that always runs 7 ms late drifts 7 ms per period when re-armed
+    // from "now", and not at all on the fixed-rate grid.
+    uint32_t delayDue = 0;
+    uint32_t rateDue = 0;
+    for (int i = 0; i < 100; ++i) {
+        delayDue = (delayDue + 7U) + 1000U;
+        rateDue = ModbusDeadlineQueue::nextFixedRate(rateDue, 1000, rateDue + 7U);
+    }
+    TEST_ASSERT_EQUAL_UINT32(100700, delayDue);
+    TEST_ASSERT_EQUAL_UINT32(100000, rateDue);
+}
+
+// ---------------------------------------------------------------------------
+// Groups sharing an interval are spaced evenly across it.
+// ---------------------------------------------------------------------------
+void test_phase_offsets_spread_groups(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, ModbusDeadlineQueue::phaseOffset(1000, 0, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, ModbusDeadlineQueue::phaseOffset(1000, 0, 4));
+    TEST_ASSERT_EQUAL_UINT32(250, ModbusDeadlineQueue::phaseOffset(1000, 1, 4));
+    TEST_ASSERT_EQUAL_UINT32(750, ModbusDeadlineQueue::phaseOffset(1000, 3, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, ModbusDeadlineQueue::phaseOffset(1000, 4, 4));
+    TEST_ASSERT_EQUAL_UINT32(2863311530U, ModbusDeadlineQueue::phaseOffset(UINT32_MAX, 2, 3));
+
+    // Four groups at 1 s: the boot burst becomes one group per 250 ms.
+    for (size_t slot = 0; slot < 4; ++slot) {
+        queue.push(entry(ModbusDeadlineQueue::phaseOffset(1000, slot, 4), static_cast<uint16_t>(slot), 0));
+    }
+    TEST_ASSERT_EQUAL_UINT(1, queue.popDue(0, due));
+    TEST_ASSERT_EQUAL_UINT(0, queue.popDue(249, due));
+    TEST_ASSERT_EQUAL_UINT(1, queue.popDue(250, due));
+    TEST_ASSERT_EQUAL_UINT32(250, queue.msUntilNext(250));
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: 2,000 datapoints, one due per pass. The old loop scanned every
+// datapoint on each pass; the heap only touches what is due.
+// ---------------------------------------------------------------------------
+void test_benchmark_sparse_due_set(void) {
+    const uint16_t total = 2000;
+    std::vector<uint32_t> deadlines(total);
+    for (uint16_t i = 0; i < total; ++i) {
+        deadlines[i] = 1000U + i * 10U;
+        queue.push(entry(deadlines[i], static_cast<uint16_t>(i / 50), static_cast<uint16_t>(i % 50)));
+    }
+    due.reserve(total);
+
+    const uint32_t passes = 20000;
+    volatile size_t scanned = 0;
+    const auto scanStart = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < passes; ++p) {
+        const uint32_t now = 1000U + p * 10U;
+        for (uint16_t i = 0; i < total; ++i) {
+            if (!ModbusDeadlineQueue::isBefore(now, deadlines[i])) {
+                scanned = scanned + 1;
+                deadlines[i] = now + total * 10U;
+            }
+        }
+    }
+    const auto scanEnd = std::chrono::steady_clock::now();
+
+    size_t popped = 0;
+    for (uint32_t p = 0; p < passes; ++p) {
+        const uint32_t now = 1000U + p * 10U;
+        due.clear();
+        popped += queue.popDue(now, due);
+        for (const auto &e: due) {
+            ModbusDeadline next = e;
+            next.dueAtMs = now + total * 10U;
+            queue.push(next);
+        }
+    }
+    const auto heapEnd = std::chrono::steady_clock::now();
+
+    const auto scanUs = std::chrono::duration_cast<std::chrono::microseconds>(scanEnd - scanStart).count();
+    const auto heapUs = std::chrono::duration_cast<std::chrono::microseconds>(heapEnd - scanEnd).count();
+    char line[128];
+    std::snprintf(line, sizeof(line), "%u passes over %u datapoints: full scan %lld us, heap %lld us",
+                  static_cast<unsigned>(passes), static_cast<unsigned>(total),
+                  static_cast<long long>(scanUs), static_cast<long long>(heapUs));
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT(passes, popped);
+    TEST_ASSERT_EQUAL_UINT(passes, scanned);
+    TEST_ASSERT_EQUAL_UINT(total, queue.size());
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pops_due_entries_in_deadline_order);
+    RUN_TEST(test_ordering_survives_millis_wrap);
+    RUN_TEST(test_priority_breaks_deadline_ties);
+    RUN_TEST(test_batch_is_grouped_by_device);
+    RUN_TEST(test_batch_is_grouped_by_line);
+    RUN_TEST(test_fixed_rate_keeps_ideal_grid);
+    RUN_TEST(test_phase_offsets_spread_groups);
+    RUN_TEST(test_benchmark_sparse_due_set);
+    return UNITY_END();
+}
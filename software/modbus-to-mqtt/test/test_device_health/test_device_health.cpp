@@ -0,0 +1,88 @@
+// Native-host tests for ModbusDeviceHealth.
+//
+// The tracker has no Arduino dependencies, so its translation unit is
+// included directly.
+
+#include "../../src/modbus/ModbusDeviceHealth.cpp"
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// A single timeout is tolerated; the second holds the slave back.
+// ---------------------------------------------------------------------------
+void test_timeouts_mark_suspect(void) {
+    ModbusDeviceHealth health;
+    TEST_ASSERT_TRUE(health.isOnline());
+    TEST_ASSERT_TRUE(health.probeDue(0));
+
+    TEST_ASSERT_FALSE(health.recordTimeout(1000));
+    TEST_ASSERT_TRUE(health.isOnline());
+    TEST_ASSERT_FALSE(health.recordAnswer());
+
+    TEST_ASSERT_FALSE(health.recordTimeout(2000));
+    TEST_ASSERT_TRUE(health.recordTimeout(3000));
+    TEST_ASSERT_EQUAL(static_cast<int>(ModbusHealthState::Suspect), static_cast<int>(health.state()));
+    TEST_ASSERT_TRUE(health.isAvailable());
+    TEST_ASSERT_FALSE(health.probeDue(3999));
+    TEST_ASSERT_TRUE(health.probeDue(4000));
+}
+
+// ---------------------------------------------------------------------------
+// Failed probes double the delay up to the cap and eventually report the
+// slave offline; one answer restores it.
+// ---------------------------------------------------------------------------
+void test_probe_back_off_and_recovery(void) {
+    ModbusDeviceHealth health;
+    uint32_t now = 0;
+    health.recordTimeout(now);
+    health.recordTimeout(now);
+    TEST_ASSERT_EQUAL_UINT32(ModbusDeviceHealth::kFirstProbeDelayMs, health.probeDelayMs());
+
+    uint32_t expected = ModbusDeviceHealth::kFirstProbeDelayMs;
+    for (uint8_t probe = 1; probe < ModbusDeviceHealth::kOfflineAfterProbes; ++probe) {
+        now = health.nextProbeAtMs();
+        TEST_ASSERT_FALSE(health.recordTimeout(now));
+        expected *= 2U;
+        TEST_ASSERT_EQUAL_UINT32(expected, health.probeDelayMs());
+        TEST_ASSERT_EQUAL_UINT32(now + expected, health.nextProbeAtMs());
+    }
+    now = health.nextProbeAtMs();
+    TEST_ASSERT_TRUE(health.recordTimeout(now));
+    TEST_ASSERT_EQUAL(static_cast<int>(ModbusHealthState::Offline), static_cast<int>(health.state()));
+    TEST_ASSERT_FALSE(health.isAvailable());
+
+    for (int i = 0; i < 20; ++i) {
+        TEST_ASSERT_FALSE(health.recordTimeout(health.nextProbeAtMs()));
+    }
+    TEST_ASSERT_EQUAL_UINT32(ModbusDeviceHealth::kMaxProbeDelayMs, health.probeDelayMs());
+
+    TEST_ASSERT_TRUE(health.recordAnswer());
+    TEST_ASSERT_TRUE(health.isOnline());
+    TEST_ASSERT_TRUE(health.isAvailable());
+    TEST_ASSERT_FALSE(health.recordTimeout(health.nextProbeAtMs()));
+    TEST_ASSERT_TRUE(health.isOnline());
+}
+
+// ---------------------------------------------------------------------------
+// The probe deadline survives the millis() wrap.
+// ---------------------------------------------------------------------------
+void test_probe_due_across_wrap(void) {
+    ModbusDeviceHealth health;
+    const uint32_t now = UINT32_MAX - 200;
+    health.recordTimeout(now);
+    health.recordTimeout(now);
+    TEST_ASSERT_FALSE(health.probeDue(UINT32_MAX));
+    TEST_ASSERT_FALSE(health.probeDue(798));
+    TEST_ASSERT_TRUE(health.probeDue(799));
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_timeouts_mark_suspect);
+    RUN_TEST(test_probe_back_off_and_recovery);
+    RUN_TEST(test_probe_due_across_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,302 @@
+// Native-host check that a steady-state poll cycle does not touch the heap.
+//
+// Runs the Arduino-free stages of a cycle the way a bus task does: due reads
+// from the deadline queue, block planning, the RTU transaction, the shadow
+// image, decoding, the publish filter and payload formatting. Global
+// operator new is replaced to count allocations; after one warm-up cycle
+// every further cycle must count none.
+
+#include "../../src/modbus/ModbusBusTiming.cpp"
+#include "../../src/modbus/ModbusDeadlineQueue.cpp"
+#include "../../src/modbus/ModbusPublishFilter.cpp"
+#include "../../src/modbus/ModbusReadPlanner.cpp"
+#include "../../src/modbus/ModbusRtuMaster.cpp"
+#include "../../src/modbus/ModbusShadowImage.cpp"
+#include "../../src/modbus/ModbusValueDecoder.cpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+
+} // namespace
+
+void *operator new(const size_t size) {
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+constexpr uint32_t kIntervalMs = 1000;
+constexpr uint16_t kBlockWords = ModbusRtuMaster::kMaxWords;
+constexpr size_t kPayloadChars = kBlockWords * 2U + 1U;
+
+// Answers reads from a fixed register map, like a slave on the line.
+class LoopbackSlave : public ModbusRtuPort {
+public:
+    int available() override { return static_cast<int>(length - position); }
+
+    int read() override { return position < length ? rx[position++] : -1; }
+
+    void transmit(const uint8_t *frame, size_t) override {
+        const uint8_t function = frame[1];
+        const auto address = static_cast<uint16_t>((frame[2] << 8U) | frame[3]);
+        const auto count = static_cast<uint16_t>((frame[4] << 8U) | frame[5]);
+        length = 0;
+        position = 0;
+        rx[length++] = frame[0];
+        rx[length++] = function;
+        if (function == 1) {
+            const auto bytes = static_cast<uint8_t>((count + 7U) / 8U);
+            rx[length++] = bytes;
+            for (uint8_t b = 0; b < bytes; ++b) {
+                uint8_t packed = 0;
+                for (uint8_t bit = 0; bit < 8 && b * 8U + bit < count; ++bit) {
+                    packed = static_cast<uint8_t>(packed | ((coils[address + b * 8U + bit] & 1U) << bit));
+                }
+                rx[length++] = packed;
+            }
+        } else {
+            rx[length++] = static_cast<uint8_t>(count * 2U);
+            for (uint16_t i = 0; i < count; ++i) {
+                rx[length++] = static_cast<uint8_t>(registers[address + i] >> 8U);
+                rx[length++] = static_cast<uint8_t>(registers[address + i] & 0xFFU);
+            }
+        }
+        const uint16_t crc = ModbusRtuMaster::crc16(rx, length);
+        rx[length++] = static_cast<uint8_t>(crc & 0xFFU);
+        rx[length++] = static_cast<uint8_t>(crc >> 8U);
+    }
+
+    bool transmitDone() override { return true; }
+
+    uint16_t registers[64]{};
+    uint8_t coils[16]{};
+
+private:
+    uint8_t rx[ModbusRtuMaster::kMaxFrameBytes]{};
+    size_t length{0};
+    size_t position{0};
+};
+
+struct Point {
+    ModbusFunctionType function;
+    uint16_t address;
+    uint16_t count;
+    ModbusDataType dataType;
+    ModbusDecodeFn decode;
+    ModbusPublishFilter filter;
+    char published[kPayloadChars];
+};
+
+struct Block {
+    uint8_t status{0xFF};
+    uint16_t words[kBlockWords]{};
+};
+
+void onBlock(void *context, const uint8_t status, const uint16_t *words, const uint16_t count) {
+    auto *block = static_cast<Block *>(context);
+    block->status = status;
+    for (uint16_t i = 0; i < count && i < kBlockWords; ++i) {
+        block->words[i] = words[i];
+    }
+}
+
+// One device's poll state, preallocated the way loadConfiguration() does.
+struct Poller {
+    LoopbackSlave slave;
+    ModbusRtuMaster master;
+    ModbusDeadlineQueue queue;
+    ModbusShadowImage shadow;
+    std::vector<Point> points;
+    std::vector<ModbusDeadline> due;
+    std::vector<ModbusReadRequest> requests;
+    std::vector<ModbusReadBlock> blocks;
+    std::vector<size_t> members;
+    Block block;
+    char payload[kPayloadChars]{};
+    uint32_t nowUs{0};
+    size_t publishes{0};
+
+    void addPoint(const ModbusFunctionType function, const uint16_t address, const uint16_t count,
+                  const ModbusDataType dataType) {
+        Point point{};
+        point.function = function;
+        point.address = address;
+        point.count = count;
+        point.dataType = dataType;
+        point.decode = ModbusValueDecoder::select(dataType, ModbusWordOrder::ABCD, RegisterSlice::Full);
+        points.push_back(point);
+    }
+
+    void load() {
+        master.setPort(&slave);
+        master.setLineTiming(ModbusBusTiming::lineTiming(19200, "8N1"));
+        master.setResponseTimeoutUs(100000);
+        queue.reserve(points.size());
+        due.reserve(points.size());
+        requests.reserve(points.size());
+        blocks.reserve(points.size());
+        members.reserve(points.size());
+        for (uint16_t i = 0; i < points.size(); ++i) {
+            queue.push(ModbusDeadline{0, 0, 0, i});
+        }
+    }
+
+    uint8_t transact(const ModbusReadBlock &read) {
+        const ModbusRtuRequest request{1, static_cast<uint8_t>(read.function), read.address, read.count, nullptr,
+                                       0, 0};
+        block.status = 0xFF;
+        if (master.start(request, nowUs, onBlock, &block) != ModbusRtuStatus::Success) {
+            return ModbusRtuStatus::Busy;
+        }
+        for (int step = 0; step < 1000 && master.busy(); ++step) {
+            nowUs += 500;
+            master.poll(nowUs);
+        }
+        return block.status;
+    }
+
+    void cycle(const uint32_t nowMs) {
+        due.clear();
+        queue.popDue(nowMs, due);
+        requests.clear();
+        for (const auto &deadline: due) {
+            const Point &point = points[deadline.datapoint];
+            requests.push_back(ModbusReadRequest{point.function, point.address, point.count});
+        }
+        ModbusReadPlanner::plan(requests.data(), requests.size(), ModbusReadPlanner::Limits{}, blocks, members);
+
+        for (const auto &read: blocks) {
+            if (transact(read) != ModbusRtuStatus::Success) {
+                continue;
+            }
+            shadow.store(1, static_cast<uint8_t>(read.function), read.address, read.count, block.words, nowMs);
+            for (size_t m = 0; m < read.memberCount; ++m) {
+                Point &point = points[due[members[read.firstMember + m]].datapoint];
+                publish(point, read);
+            }
+        }
+        for (auto deadline: due) {
+            deadline.dueAtMs = ModbusDeadlineQueue::nextFixedRate(deadline.dueAtMs, kIntervalMs, nowMs);
+            queue.push(deadline);
+        }
+    }
+
+    // What ModbusManager::publishFromBlock() does short of the broker.
+    void publish(Point &point, const ModbusReadBlock &read) {
+        uint16_t words[kBlockWords]{};
+        const auto offset = static_cast<uint16_t>(point.address - read.address);
+        if (ModbusReadPlanner::isBitFunction(point.function)) {
+            ModbusReadPlanner::extractBits(block.words, offset, point.count, words);
+        } else {
+            for (uint16_t i = 0; i < point.count; ++i) {
+                words[i] = block.words[offset + i];
+            }
+        }
+        double value = 0.0;
+        bool publish;
+        if (point.decode) {
+            value = point.decode(words);
+            ModbusValueDecoder::formatValue(value, payload, sizeof(payload));
+            publish = point.filter.shouldPublish(value, 0);
+        } else {
+            const size_t length = ModbusValueDecoder::formatText(words, point.count, payload, sizeof(payload));
+            publish = point.filter.shouldPublishText(payload, length, 0);
+        }
+        if (publish) {
+            point.filter.published(value, 0);
+            std::memcpy(point.published, payload, sizeof(payload));
+            ++publishes;
+        }
+    }
+};
+
+} // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// The counter sees what the containers allocate, so a zero below means
+// something.
+// ---------------------------------------------------------------------------
+void test_counter_sees_allocations(void) {
+    const size_t before = allocations;
+    std::vector<uint16_t> words(8);
+    TEST_ASSERT_EQUAL_UINT(before + 1, allocations);
+    words.push_back(1);
+    TEST_ASSERT_TRUE(allocations > before + 1);
+}
+
+// ---------------------------------------------------------------------------
+// After the first cycle has populated the shadow image, polling a mixed
+// device - merged register blocks, coils and on-change text - allocates
+// nothing.
+// ---------------------------------------------------------------------------
+void test_steady_state_cycle_does_not_allocate(void) {
+    Poller poller;
+    poller.slave.registers[0] = 0x4148;   // 12.5f
+    poller.slave.registers[2] = 0xFFFE;   // -2
+    poller.slave.registers[10] = 0x4F4B;  // "OK"
+    poller.slave.coils[3] = 1;
+    poller.addPoint(READ_HOLDING, 0, 2, FLOAT32);
+    poller.addPoint(READ_HOLDING, 2, 1, INT16);
+    poller.addPoint(READ_HOLDING, 10, 2, TEXT);
+    poller.addPoint(READ_COIL, 3, 1, UINT16);
+    poller.points[2].filter.onChange = true;
+    poller.load();
+
+    poller.cycle(0);
+    TEST_ASSERT_EQUAL_UINT(4, poller.publishes);
+    TEST_ASSERT_EQUAL_STRING("12.50", poller.points[0].published);
+    TEST_ASSERT_EQUAL_STRING("-2.00", poller.points[1].published);
+    TEST_ASSERT_EQUAL_STRING("OK", poller.points[2].published);
+    TEST_ASSERT_EQUAL_STRING("1.00", poller.points[3].published);
+
+    poller.slave.registers[2] = 7;
+    const size_t before = allocations;
+    for (uint32_t cycle = 1; cycle <= 10; ++cycle) {
+        poller.cycle(cycle * kIntervalMs);
+    }
+    TEST_ASSERT_EQUAL_UINT(0, allocations - before);
+    // The unchanged text is held back.
+    TEST_ASSERT_EQUAL_UINT(34, poller.publishes);
+    TEST_ASSERT_EQUAL_STRING("7.00", poller.points[1].published);
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counter_sees_allocations);
+    RUN_TEST(test_steady_state_cycle_does_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,156 @@
+// Native-host tests for ModbusPublishFilter.
+//
+// The filter has no Arduino dependencies, so its translation unit is included
+// directly.
+
+#include "../../src/modbus/ModbusPublishFilter.cpp"
+
+#include <cstring>
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Unconfigured datapoints publish every reading, as before.
+// ---------------------------------------------------------------------------
+void test_unconfigured_publishes_everything(void) {
+    ModbusPublishFilter filter;
+    TEST_ASSERT_FALSE(filter.reportsByException());
+    filter.published(20.0, 0);
+    TEST_ASSERT_TRUE(filter.shouldPublish(20.0, 1));
+}
+
+// ---------------------------------------------------------------------------
+// An absolute deadband holds back readings within it of the last published
+// value, so slow drift still gets out once it adds up.
+// ---------------------------------------------------------------------------
+void test_absolute_deadband(void) {
+    ModbusPublishFilter filter;
+    filter.deadband = 0.5f;
+    TEST_ASSERT_TRUE(filter.shouldPublish(20.0, 0));
+    filter.published(20.0, 0);
+
+    TEST_ASSERT_FALSE(filter.shouldPublish(20.0, 1000));
+    TEST_ASSERT_FALSE(filter.shouldPublish(20.5, 2000));
+    TEST_ASSERT_FALSE(filter.shouldPublish(19.6, 3000));
+    TEST_ASSERT_TRUE(filter.shouldPublish(20.6, 4000));
+    TEST_ASSERT_TRUE(filter.shouldPublish(19.4, 4000));
+    filter.published(20.6, 4000);
+    TEST_ASSERT_FALSE(filter.shouldPublish(20.2, 5000));
+}
+
+// ---------------------------------------------------------------------------
+// A percent deadband scales with the last published value.
+// ---------------------------------------------------------------------------
+void test_percent_deadband(void) {
+    ModbusPublishFilter filter;
+    filter.deadband = 2.0f;
+    filter.deadbandType = ModbusDeadbandType::Percent;
+    filter.published(1000.0, 0);
+    TEST_ASSERT_FALSE(filter.shouldPublish(1019.0, 1));
+    TEST_ASSERT_TRUE(filter.shouldPublish(1021.0, 1));
+    TEST_ASSERT_TRUE(filter.shouldPublish(979.0, 1));
+
+    filter.published(0.0, 1);
+    TEST_ASSERT_FALSE(filter.shouldPublish(0.0, 2));
+    TEST_ASSERT_TRUE(filter.shouldPublish(0.01, 2));
+}
+
+// ---------------------------------------------------------------------------
+// The heartbeat republishes an unchanged value after the silence interval;
+// alone it still publishes every change.
+// ---------------------------------------------------------------------------
+void test_heartbeat(void) {
+    ModbusPublishFilter filter;
+    filter.heartbeatMs = 60000;
+    TEST_ASSERT_TRUE(filter.reportsByException());
+    filter.published(5.0, 0xFFFF0000UL);
+    TEST_ASSERT_FALSE(filter.shouldPublish(5.0, 0xFFFF0000UL + 59999));
+    TEST_ASSERT_TRUE(filter.shouldPublish(5.0, 0xFFFF0000UL + 60000));
+    TEST_ASSERT_TRUE(filter.shouldPublish(5.01, 0xFFFF0000UL + 1));
+
+    filter.deadband = 1.0f;
+    TEST_ASSERT_FALSE(filter.shouldPublish(5.5, 0xFFFF0000UL + 1));
+    TEST_ASSERT_TRUE(filter.shouldPublish(5.5, 0xFFFF0000UL + 60000));
+}
+
+// ---------------------------------------------------------------------------
+// NaN readings publish when they start and stop.
+// ---------------------------------------------------------------------------
+void test_nan(void) {
+    ModbusPublishFilter filter;
+    filter.deadband = 1.0f;
+    filter.published(1.0, 0);
+    TEST_ASSERT_TRUE(filter.shouldPublish(NAN, 1));
+    filter.published(NAN, 1);
+    TEST_ASSERT_FALSE(filter.shouldPublish(NAN, 2));
+    TEST_ASSERT_TRUE(filter.shouldPublish(1.0, 2));
+}
+
+// ---------------------------------------------------------------------------
+// onChange is opt-in: without it a number publishes on every read, with it
+// only a reading that differs at all.
+// ---------------------------------------------------------------------------
+void test_on_change(void) {
+    ModbusPublishFilter filter;
+    filter.published(3.0, 0);
+    TEST_ASSERT_TRUE(filter.shouldPublish(3.0, 1));
+
+    filter.onChange = true;
+    TEST_ASSERT_TRUE(filter.reportsByException());
+    TEST_ASSERT_FALSE(filter.shouldPublish(3.0, 3600000));
+    TEST_ASSERT_TRUE(filter.shouldPublish(3.001, 3600000));
+}
+
+// ---------------------------------------------------------------------------
+// Text publishes on every read unless asked otherwise; with onChange it
+// compares the text itself, and records it only once published.
+// ---------------------------------------------------------------------------
+void test_text(void) {
+    ModbusPublishFilter plain;
+    TEST_ASSERT_TRUE(plain.shouldPublishText("v1.2", 4, 0));
+    plain.published(0.0, 0);
+    TEST_ASSERT_TRUE(plain.shouldPublishText("v1.2", 4, 1));
+
+    ModbusPublishFilter text;
+    text.onChange = true;
+    TEST_ASSERT_TRUE(text.shouldPublishText("v1.2", 4, 0));
+    text.published(0.0, 0);
+    TEST_ASSERT_FALSE(text.shouldPublishText("v1.2", 4, 3600000));
+    TEST_ASSERT_TRUE(text.shouldPublishText("v1.3", 4, 3600000));
+    // Not published, so v1.2 is still what subscribers have.
+    TEST_ASSERT_FALSE(text.shouldPublishText("v1.2", 4, 3600001));
+    TEST_ASSERT_TRUE(text.shouldPublishText("v1.2 ", 5, 3600001));
+    TEST_ASSERT_TRUE(text.shouldPublishText("v1", 2, 3600001));
+    text.published(0.0, 3600001);
+    TEST_ASSERT_FALSE(text.shouldPublishText("v1", 2, 3600002));
+}
+
+// ---------------------------------------------------------------------------
+// A heartbeat republishes unchanged text too.
+// ---------------------------------------------------------------------------
+void test_text_heartbeat(void) {
+    ModbusPublishFilter text;
+    text.onChange = true;
+    text.heartbeatMs = 1000;
+    const char *serial = "SN-1234";
+    TEST_ASSERT_TRUE(text.shouldPublishText(serial, strlen(serial), 0));
+    text.published(0.0, 0);
+    TEST_ASSERT_FALSE(text.shouldPublishText("SN-1234", 7, 10));
+    TEST_ASSERT_TRUE(text.shouldPublishText("SN-1235", 7, 10));
+    TEST_ASSERT_TRUE(text.shouldPublishText("SN-1234", 7, 1000));
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unconfigured_publishes_everything);
+    RUN_TEST(test_absolute_deadband);
+    RUN_TEST(test_percent_deadband);
+    RUN_TEST(test_heartbeat);
+    RUN_TEST(test_nan);
+    RUN_TEST(test_on_change);
+    RUN_TEST(test_text);
+    RUN_TEST(test_text_heartbeat);
+    return UNITY_END();
+}
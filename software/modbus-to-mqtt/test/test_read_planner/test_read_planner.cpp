@@ -0,0 +1,210 @@
+// Native-host tests and transaction-count benchmark for ModbusReadPlanner.
+//
+// The planner only depends on ModbusFunctionType, so its translation unit is
+// included directly, the same way sample_test.cpp pulls in BodyAccumulator.
+
+#include "../../src/modbus/ModbusReadPlanner.cpp"
+
+#include <cstdio>
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+std::vector<ModbusReadBlock> blocks;
+std::vector<size_t> members;
+
+size_t planAll(const std::vector<ModbusReadRequest> &requests, const ModbusReadPlanner::Limits &limits) {
+    return ModbusReadPlanner::plan(requests.data(), requests.size(), limits, blocks, members);
+}
+
+ModbusReadRequest holding(const uint16_t address, const uint16_t count = 1) {
+    return ModbusReadRequest{READ_HOLDING, address, count};
+}
+
+}  // namespace
+
+void setUp(void) {
+    blocks.clear();
+    members.clear();
+}
+
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// 40 contiguous single-register datapoints collapse into one transaction.
+// ---------------------------------------------------------------------------
+void test_contiguous_registers_become_one_block(void) {
+    std::vector<ModbusReadRequest> requests;
+    for (uint16_t i = 0; i < 40; ++i) {
+        requests.push_back(holding(static_cast<uint16_t>(100 + i)));
+    }
+
+    TEST_ASSERT_EQUAL_UINT(1, planAll(requests, {}));
+    TEST_ASSERT_EQUAL_UINT16(100, blocks[0].address);
+    TEST_ASSERT_EQUAL_UINT16(40, blocks[0].count);
+    TEST_ASSERT_EQUAL_UINT(40, blocks[0].memberCount);
+}
+
+// ---------------------------------------------------------------------------
+// Two datapoints reading the same register (e.g. low/high byte slices) share
+// a single one-register read.
+// ---------------------------------------------------------------------------
+void test_same_register_twice_is_read_once(void) {
+    const std::vector<ModbusReadRequest> requests = {holding(7), holding(7)};
+
+    TEST_ASSERT_EQUAL_UINT(1, planAll(requests, {}));
+    TEST_ASSERT_EQUAL_UINT16(1, blocks[0].count);
+    TEST_ASSERT_EQUAL_UINT(2, blocks[0].memberCount);
+}
+
+// ---------------------------------------------------------------------------
+// Gaps split blocks unless maxGap allows reading through them.
+// ---------------------------------------------------------------------------
+void test_gap_is_bridged_only_within_max_gap(void) {
+    const std::vector<ModbusReadRequest> requests = {holding(0, 2), holding(12, 2)};
+
+    ModbusReadPlanner::Limits strict;
+    TEST_ASSERT_EQUAL_UINT(2, planAll(requests, strict));
+
+    ModbusReadPlanner::Limits loose;
+    loose.maxGap = 10;
+    TEST_ASSERT_EQUAL_UINT(1, planAll(requests, loose));
+    TEST_ASSERT_EQUAL_UINT16(0, blocks[0].address);
+    TEST_ASSERT_EQUAL_UINT16(14, blocks[0].count);
+
+    loose.maxGap = 9;
+    TEST_ASSERT_EQUAL_UINT(2, planAll(requests, loose));
+}
+
+// ---------------------------------------------------------------------------
+// Blocks never exceed the register limit; overflow opens a new block.
+// ---------------------------------------------------------------------------
+void test_register_limit_splits_blocks(void) {
+    std::vector<ModbusReadRequest> requests;
+    for (uint16_t i = 0; i < 130; ++i) {
+        requests.push_back(holding(i));
+    }
+
+    TEST_ASSERT_EQUAL_UINT(2, planAll(requests, {}));
+    TEST_ASSERT_EQUAL_UINT16(125, blocks[0].count);
+    TEST_ASSERT_EQUAL_UINT16(125, blocks[1].address);
+    TEST_ASSERT_EQUAL_UINT16(5, blocks[1].count);
+
+    ModbusReadPlanner::Limits small;
+    small.maxRegisters = 64;
+    TEST_ASSERT_EQUAL_UINT(3, planAll(requests, small));
+}
+
+// ---------------------------------------------------------------------------
+// Different function codes never share a block, and every member of a block
+// lies inside its span.
+// ---------------------------------------------------------------------------
+void test_function_codes_are_kept_apart(void) {
+    const std::vector<ModbusReadRequest> requests = {
+        {READ_INPUT, 10, 2}, holding(10, 2), {READ_INPUT, 12, 1}, holding(9, 1),
+    };
+
+    TEST_ASSERT_EQUAL_UINT(2, planAll(requests, {}));
+    for (const auto &block: blocks) {
+        for (size_t m = 0; m < block.memberCount; ++m) {
+            const ModbusReadRequest &r = requests[members[block.firstMember + m]];
+            TEST_ASSERT_EQUAL(block.function, r.function);
+            TEST_ASSERT_TRUE(r.address >= block.address);
+            TEST_ASSERT_TRUE(r.address + r.count <= block.address + block.count);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Write-only requests are never planned, even where they would bridge two
+// reads of the same table.
+// ---------------------------------------------------------------------------
+void test_write_functions_are_not_read(void) {
+    const std::vector<ModbusReadRequest> requests = {
+        holding(0), {WRITE_HOLDING, 1, 1}, holding(2), {WRITE_MULTIPLE_COILS, 0, 8}, {READ_WRITE_MULTIPLE, 1, 1},
+    };
+
+    TEST_ASSERT_EQUAL_UINT(2, planAll(requests, {}));
+    TEST_ASSERT_EQUAL_UINT(2, members.size());
+    for (const auto &block: blocks) {
+        TEST_ASSERT_EQUAL(READ_HOLDING, block.function);
+        TEST_ASSERT_EQUAL_UINT16(1, block.count);
+    }
+
+    const std::vector<ModbusReadRequest> writesOnly = {{WRITE_COIL, 4, 1}, {WRITE_HOLDING, 5, 1}};
+    TEST_ASSERT_EQUAL_UINT(0, planAll(writesOnly, {}));
+    TEST_ASSERT_TRUE(members.empty());
+}
+
+// ---------------------------------------------------------------------------
+// Coil reads use the bit limit, and extractBits re-packs a member's bits
+// from bit 0 as a standalone read would.
+// ---------------------------------------------------------------------------
+void test_coils_use_bit_limit_and_unpack(void) {
+    std::vector<ModbusReadRequest> requests;
+    for (uint16_t i = 0; i < 2001; ++i) {
+        requests.push_back({READ_COIL, i, 1});
+    }
+    TEST_ASSERT_EQUAL_UINT(2, planAll(requests, {}));
+    TEST_ASSERT_EQUAL_UINT16(2000, blocks[0].count);
+
+    // Bits 4, 13 and 15 set in word 0; bit 17 set in word 1.
+    const uint16_t packed[2] = {0xA010, 0x0002};
+    uint16_t out[1]{};
+    ModbusReadPlanner::extractBits(packed, 4, 1, out);
+    TEST_ASSERT_EQUAL_HEX16(0x0001, out[0]);
+    ModbusReadPlanner::extractBits(packed, 5, 1, out);
+    TEST_ASSERT_EQUAL_HEX16(0x0000, out[0]);
+    ModbusReadPlanner::extractBits(packed, 13, 5, out);
+    TEST_ASSERT_EQUAL_HEX16(0x0015, out[0]);
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: a typical energy meter map polled per datapoint vs. planned.
+// ---------------------------------------------------------------------------
+void test_benchmark_energy_meter_transactions(void) {
+    std::vector<ModbusReadRequest> requests;
+    // 40 contiguous 16-bit values (voltages, currents, powers...).
+    for (uint16_t i = 0; i < 40; ++i) {
+        requests.push_back({READ_INPUT, static_cast<uint16_t>(0x0000 + i), 1});
+    }
+    // 12 two-register counters with a reserved register between each.
+    for (uint16_t i = 0; i < 12; ++i) {
+        requests.push_back({READ_INPUT, static_cast<uint16_t>(0x0100 + i * 3), 2});
+    }
+    // A status word read twice through low/high byte slices, plus 8 coils.
+    requests.push_back(holding(0x2000));
+    requests.push_back(holding(0x2000));
+    for (uint16_t i = 0; i < 8; ++i) {
+        requests.push_back({READ_COIL, i, 1});
+    }
+
+    const size_t before = requests.size();
+    ModbusReadPlanner::Limits limits;
+    const size_t strict = planAll(requests, limits);
+    limits.maxGap = 1;
+    const size_t bridged = planAll(requests, limits);
+
+    char line[96];
+    std::snprintf(line, sizeof(line), "transactions per cycle: %u per-datapoint, %u planned, %u with maxGap=1",
+                  static_cast<unsigned>(before), static_cast<unsigned>(strict), static_cast<unsigned>(bridged));
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT(62, before);
+    TEST_ASSERT_EQUAL_UINT(15, strict);
+    TEST_ASSERT_EQUAL_UINT(4, bridged);
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_contiguous_registers_become_one_block);
+    RUN_TEST(test_same_register_twice_is_read_once);
+    RUN_TEST(test_gap_is_bridged_only_within_max_gap);
+    RUN_TEST(test_register_limit_splits_blocks);
+    RUN_TEST(test_function_codes_are_kept_apart);
+    RUN_TEST(test_write_functions_are_not_read);
+    RUN_TEST(test_coils_use_bit_limit_and_unpack);
+    RUN_TEST(test_benchmark_energy_meter_transactions);
+    return UNITY_END();
+}
@@ -0,0 +1,347 @@
+// Native-host tests for ModbusRtuMaster driven against a scripted port.
+//
+// The master has no Arduino dependencies, so its translation unit is included
+// directly.
+
+#include "../../src/modbus/ModbusRtuMaster.cpp"
+#include "../../src/modbus/ModbusBusTiming.cpp"
+
+#include <deque>
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+// Records what the master sends and plays back whatever the test queues.
+class ScriptedPort : public ModbusRtuPort {
+public:
+    int available() override { return static_cast<int>(rx.size()); }
+
+    int read() override {
+        if (rx.empty()) return -1;
+        const int b = rx.front();
+        rx.pop_front();
+        return b;
+    }
+
+    void transmit(const uint8_t *frame, const size_t length) override {
+        sent.assign(frame, frame + length);
+        ++transmissions;
+    }
+
+    bool transmitDone() override { return txDone; }
+
+    bool takeLineIdle() override {
+        const bool was = idle;
+        idle = false;
+        return was;
+    }
+
+    void feed(std::vector<uint8_t> bytes, const bool appendCrc = false) {
+        if (appendCrc) {
+            const uint16_t crc = ModbusRtuMaster::crc16(bytes.data(), bytes.size());
+            bytes.push_back(static_cast<uint8_t>(crc & 0xFF));
+            bytes.push_back(static_cast<uint8_t>(crc >> 8));
+        }
+        rx.insert(rx.end(), bytes.begin(), bytes.end());
+    }
+
+    std::deque<uint8_t> rx;
+    std::vector<uint8_t> sent;
+    int transmissions{0};
+    bool txDone{true};
+    bool idle{false};
+};
+
+struct Outcome {
+    int calls{0};
+    uint8_t status{0xFF};
+    std::vector<uint16_t> words;
+};
+
+void record(void *context, const uint8_t status, const uint16_t *words, const uint16_t count) {
+    auto *outcome = static_cast<Outcome *>(context);
+    ++outcome->calls;
+    outcome->status = status;
+    outcome->words.assign(words, words + count);
+}
+
+ScriptedPort port;
+ModbusRtuMaster master;
+Outcome outcome;
+
+ModbusRtuRequest request(const uint8_t function, const uint16_t address, const uint16_t count,
+                         const uint16_t *values = nullptr) {
+    return ModbusRtuRequest{1, function, address, count, values, 0, 0};
+}
+
+} // namespace
+
+void setUp(void) {
+    port = ScriptedPort();
+    master = ModbusRtuMaster();
+    master.setPort(&port);
+    master.setLineTiming(ModbusBusTiming::lineTiming(9600, "8N1"));
+    master.setResponseTimeoutUs(100000);
+    outcome = Outcome();
+}
+
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Request frames match the reference encoding, CRC low byte first.
+// ---------------------------------------------------------------------------
+void test_encodes_reference_frames(void) {
+    uint8_t frame[ModbusRtuMaster::kMaxFrameBytes];
+    const uint8_t read[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD};
+    TEST_ASSERT_EQUAL_UINT(8, ModbusRtuMaster::encode(request(3, 0, 10), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(read, frame, 8);
+
+    const uint16_t on = 1;
+    const uint8_t coil[] = {0x01, 0x05, 0x00, 0xAC, 0xFF, 0x00, 0x4C, 0x1B};
+    TEST_ASSERT_EQUAL_UINT(8, ModbusRtuMaster::encode(request(5, 0xAC, 1, &on), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(coil, frame, 8);
+
+    const uint16_t values[] = {0x000A, 0x0102};
+    TEST_ASSERT_EQUAL_UINT(13, ModbusRtuMaster::encode(request(16, 1, 2, values), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8(0x04, frame[6]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, frame[9]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, frame[10]);
+
+    TEST_ASSERT_EQUAL_UINT(0, ModbusRtuMaster::encode(request(3, 0, 126), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT(0, ModbusRtuMaster::encode(request(6, 0, 1), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::IllegalFunction, master.start(request(7, 0, 1), 0, record, &outcome));
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::IllegalDataValue, master.start(request(3, 0, 0), 0, record, &outcome));
+    TEST_ASSERT_FALSE(master.busy());
+}
+
+// ---------------------------------------------------------------------------
+// A read walks through every state without blocking: the response arrives in
+// pieces and completes only once the byte count is satisfied.
+// ---------------------------------------------------------------------------
+void test_read_completes_across_partial_responses(void) {
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, master.start(request(3, 0x10, 2), 0, record, &outcome));
+    TEST_ASSERT_TRUE(master.busy());
+
+    port.txDone = false;
+    TEST_ASSERT_EQUAL_UINT32(8U * 1042U, master.poll(0));
+    TEST_ASSERT_TRUE(master.state() == ModbusRtuMaster::State::Transmit);
+    TEST_ASSERT_EQUAL_INT(1, port.transmissions);
+
+    // The response window is the timeout plus the answer's 9 bytes on the wire.
+    port.txDone = true;
+    TEST_ASSERT_EQUAL_UINT32(100000 + 9U * 1042U, master.poll(9000));
+    TEST_ASSERT_TRUE(master.state() == ModbusRtuMaster::State::Await);
+
+    port.feed({0x01, 0x03, 0x04, 0x12});
+    TEST_ASSERT_EQUAL_UINT32(90000 + 9U * 1042U, master.poll(19000));
+    TEST_ASSERT_EQUAL_INT(0, outcome.calls);
+
+    std::vector<uint8_t> whole = {0x01, 0x03, 0x04, 0x12, 0x34, 0xAB, 0xCD};
+    const uint16_t crc = ModbusRtuMaster::crc16(whole.data(), whole.size());
+    port.feed({0x34, 0xAB, 0xCD, static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)});
+    TEST_ASSERT_EQUAL_UINT32(ModbusRtuMaster::kIdle, master.poll(20000));
+    // 11 ms in Await less 9 bytes of frame time.
+    TEST_ASSERT_EQUAL_UINT32(11000U - 9U * 1042U, master.lastTurnaroundUs());
+
+    TEST_ASSERT_EQUAL_INT(1, outcome.calls);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(2, outcome.words.size());
+    TEST_ASSERT_EQUAL_HEX16(0x1234, outcome.words[0]);
+    TEST_ASSERT_EQUAL_HEX16(0xABCD, outcome.words[1]);
+    TEST_ASSERT_FALSE(master.busy());
+}
+
+// ---------------------------------------------------------------------------
+// A silent slave times out; the next request first waits out t3.5 and a
+// second start while busy is refused.
+// ---------------------------------------------------------------------------
+void test_timeout_then_inter_frame_silence(void) {
+    const uint32_t windowUs = 100000 + 7U * 1042U;
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, master.start(request(4, 0, 1), 0, record, &outcome));
+    TEST_ASSERT_EQUAL_UINT32(windowUs, master.poll(0));
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Busy, master.start(request(4, 0, 1), 10, record, &outcome));
+    TEST_ASSERT_EQUAL_UINT32(windowUs - 50000, master.poll(50000));
+    TEST_ASSERT_EQUAL_UINT32(ModbusRtuMaster::kIdle, master.poll(windowUs));
+    TEST_ASSERT_EQUAL_INT(1, outcome.calls);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::ResponseTimedOut, outcome.status);
+    TEST_ASSERT_EQUAL_UINT32(ModbusRtuMaster::kNoResponse, master.lastTurnaroundUs());
+
+    // Stale bytes from the dead transaction are dropped before transmitting.
+    port.feed({0x55, 0x66});
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, master.start(request(4, 0, 1), windowUs + 1000, record, &outcome));
+    TEST_ASSERT_EQUAL_UINT32(2647, master.poll(windowUs + 1000));
+    TEST_ASSERT_EQUAL_INT(1, port.transmissions);
+    master.poll(windowUs + 3647);
+    TEST_ASSERT_EQUAL_INT(2, port.transmissions);
+    TEST_ASSERT_TRUE(port.rx.empty());
+}
+
+// ---------------------------------------------------------------------------
+// Exceptions, bad CRCs and foreign replies map to ModbusMaster's codes.
+// ---------------------------------------------------------------------------
+void test_error_responses(void) {
+    master.start(request(3, 0, 1), 0, record, &outcome);
+    master.poll(0);
+    port.feed({0x01, 0x83, 0x02}, true);
+    master.poll(1000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::IllegalDataAddress, outcome.status);
+
+    master.start(request(3, 0, 1), 10000, record, &outcome);
+    master.poll(10000);
+    port.feed({0x01, 0x03, 0x02, 0x00, 0x01, 0x00, 0x00});
+    master.poll(11000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::InvalidCrc, outcome.status);
+
+    master.start(request(3, 0, 1), 20000, record, &outcome);
+    master.poll(20000);
+    port.feed({0x02, 0x03, 0x02, 0x00, 0x01}, true);
+    master.poll(21000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::InvalidSlaveId, outcome.status);
+
+    master.start(request(3, 0, 1), 30000, record, &outcome);
+    master.poll(30000);
+    port.feed({0x01, 0x04, 0x02, 0x00, 0x01}, true);
+    master.poll(31000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::InvalidFunction, outcome.status);
+    TEST_ASSERT_EQUAL_INT(4, outcome.calls);
+}
+
+// ---------------------------------------------------------------------------
+// A reply carrying fewer registers or coils than asked for is refused rather
+// than delivered short.
+// ---------------------------------------------------------------------------
+void test_short_reply_is_refused(void) {
+    master.start(request(3, 0, 2), 0, record, &outcome);
+    master.poll(0);
+    port.feed({0x01, 0x03, 0x02, 0x00, 0x01}, true);
+    master.poll(1000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::InvalidFunction, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(0, outcome.words.size());
+
+    master.start(request(1, 0, 19), 10000, record, &outcome);
+    master.poll(10000);
+    port.feed({0x01, 0x01, 0x02, 0xCD, 0x6B}, true);
+    master.poll(11000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::InvalidFunction, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(0, outcome.words.size());
+    TEST_ASSERT_FALSE(master.busy());
+}
+
+// ---------------------------------------------------------------------------
+// Coils pack low byte first like ModbusMaster; writes complete on the echo.
+// ---------------------------------------------------------------------------
+void test_coils_and_write_echo(void) {
+    master.start(request(1, 0, 19), 0, record, &outcome);
+    master.poll(0);
+    port.feed({0x01, 0x01, 0x03, 0xCD, 0x6B, 0x05}, true);
+    master.poll(1000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(2, outcome.words.size());
+    TEST_ASSERT_EQUAL_HEX16(0x6BCD, outcome.words[0]);
+    TEST_ASSERT_EQUAL_HEX16(0x0005, outcome.words[1]);
+
+    const uint16_t value = 0x0003;
+    master.start(request(6, 1, 1, &value), 10000, record, &outcome);
+    master.poll(10000);
+    port.feed({0x01, 0x06, 0x00, 0x01, 0x00}, false);
+    master.poll(11000);
+    TEST_ASSERT_EQUAL_INT(1, outcome.calls);
+    port.feed({0x03});
+    const uint16_t crc = ModbusRtuMaster::crc16(port.sent.data(), 6);
+    port.feed({static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)});
+    master.poll(12000);
+    TEST_ASSERT_EQUAL_INT(2, outcome.calls);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(0, outcome.words.size());
+}
+
+// ---------------------------------------------------------------------------
+// FC15 packs coils from the low byte of the first word up; FC23 writes its
+// block and answers with the registers it read back.
+// ---------------------------------------------------------------------------
+void test_multiple_coils_and_read_write(void) {
+    uint8_t frame[ModbusRtuMaster::kMaxFrameBytes];
+    const uint16_t coils[] = {0x01CD};
+    const uint8_t coilFrame[] = {0x01, 0x0F, 0x00, 0x13, 0x00, 0x0A, 0x02, 0xCD, 0x01};
+    TEST_ASSERT_EQUAL_UINT(11, ModbusRtuMaster::encode(request(15, 0x13, 10, coils), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(coilFrame, frame, sizeof(coilFrame));
+    TEST_ASSERT_EQUAL_UINT(0, ModbusRtuMaster::encode(request(15, 0, 1969, coils), frame, sizeof(frame)));
+
+    const uint16_t values[] = {0x00FF, 0x00FF, 0x00FF};
+    ModbusRtuRequest readWrite = request(23, 3, 2, values);
+    readWrite.writeAddress = 0x0E;
+    readWrite.writeCount = 3;
+    const uint8_t rwFrame[] = {0x01, 0x17, 0x00, 0x03, 0x00, 0x02, 0x00, 0x0E, 0x00, 0x03, 0x06,
+                               0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF};
+    TEST_ASSERT_EQUAL_UINT(19, ModbusRtuMaster::encode(readWrite, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(rwFrame, frame, sizeof(rwFrame));
+    readWrite.writeCount = 0;
+    TEST_ASSERT_EQUAL_UINT(0, ModbusRtuMaster::encode(readWrite, frame, sizeof(frame)));
+    readWrite.writeCount = 3;
+
+    master.start(request(15, 0x13, 10, coils), 0, record, &outcome);
+    master.poll(0);
+    port.feed({0x01, 0x0F, 0x00, 0x13, 0x00, 0x0A}, true);
+    master.poll(1000);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(0, outcome.words.size());
+
+    master.start(readWrite, 10000, record, &outcome);
+    master.poll(10000);
+    port.feed({0x01, 0x17, 0x04, 0x00, 0xFE, 0x0A, 0xCD}, true);
+    master.poll(11000);
+    TEST_ASSERT_EQUAL_INT(2, outcome.calls);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, outcome.status);
+    TEST_ASSERT_EQUAL_UINT(2, outcome.words.size());
+    TEST_ASSERT_EQUAL_HEX16(0x00FE, outcome.words[0]);
+    TEST_ASSERT_EQUAL_HEX16(0x0ACD, outcome.words[1]);
+}
+
+// ---------------------------------------------------------------------------
+// An idle line ends the frame: a truncated answer fails at once instead of
+// holding the bus for the response timeout, while a complete one is parsed
+// even if its last bytes arrive alongside the idle event.
+// ---------------------------------------------------------------------------
+void test_idle_line_ends_frame(void) {
+    master.start(request(3, 0, 2), 0, record, &outcome);
+    master.poll(0);
+    port.feed({0x01, 0x03, 0x04, 0x00});
+    TEST_ASSERT_EQUAL_UINT32(99000 + 9U * 1042U, master.poll(1000));
+    port.idle = true;
+    TEST_ASSERT_EQUAL_UINT32(ModbusRtuMaster::kIdle, master.poll(2000));
+    TEST_ASSERT_EQUAL_INT(1, outcome.calls);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::InvalidCrc, outcome.status);
+
+    // A stale idle flag from before the request is ignored.
+    port.idle = true;
+    master.start(request(3, 0, 1), 10000, record, &outcome);
+    master.poll(10000);
+    TEST_ASSERT_FALSE(port.idle);
+    port.feed({0x01, 0x03, 0x02, 0x00, 0x07}, true);
+    port.idle = true;
+    master.poll(11000);
+    TEST_ASSERT_EQUAL_INT(2, outcome.calls);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, outcome.status);
+    TEST_ASSERT_EQUAL_HEX16(0x0007, outcome.words[0]);
+
+    // Idle with nothing received does not end the wait.
+    master.start(request(3, 0, 1), 20000, record, &outcome);
+    master.poll(20000);
+    port.idle = true;
+    TEST_ASSERT_EQUAL_UINT32(99000 + 7U * 1042U, master.poll(21000));
+    TEST_ASSERT_TRUE(master.busy());
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_encodes_reference_frames);
+    RUN_TEST(test_read_completes_across_partial_responses);
+    RUN_TEST(test_timeout_then_inter_frame_silence);
+    RUN_TEST(test_error_responses);
+    RUN_TEST(test_short_reply_is_refused);
+    RUN_TEST(test_coils_and_write_echo);
+    RUN_TEST(test_multiple_coils_and_read_write);
+    RUN_TEST(test_idle_line_ends_frame);
+    return UNITY_END();
+}
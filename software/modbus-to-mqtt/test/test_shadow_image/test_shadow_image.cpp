@@ -0,0 +1,98 @@
+// Native-host tests for ModbusShadowImage.
+//
+// The image has no Arduino dependencies, so its translation unit is included
+// directly.
+
+#include "../../src/modbus/ModbusShadowImage.cpp"
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Registers read from the bus answer any read inside the polled range while
+// they are fresh; anything older, wider or from another table misses.
+// ---------------------------------------------------------------------------
+void test_registers_answer_within_max_age(void) {
+    ModbusShadowImage image;
+    const uint16_t polled[4] = {0x1111, 0x2222, 0x3333, 0x4444};
+    image.store(7, 3, 100, 4, polled, 1000);
+    TEST_ASSERT_EQUAL_UINT(4, image.size());
+
+    uint16_t out[8] = {};
+    uint16_t count = 0;
+    TEST_ASSERT_TRUE(image.lookup(7, 3, 101, 2, 1499, 500, out, 8, count));
+    TEST_ASSERT_EQUAL_UINT16(2, count);
+    TEST_ASSERT_EQUAL_HEX16(0x2222, out[0]);
+    TEST_ASSERT_EQUAL_HEX16(0x3333, out[1]);
+
+    TEST_ASSERT_FALSE(image.lookup(7, 3, 101, 2, 1500, 500, out, 8, count));
+    TEST_ASSERT_FALSE(image.lookup(7, 3, 102, 3, 1100, 500, out, 8, count));
+    TEST_ASSERT_FALSE(image.lookup(7, 4, 100, 1, 1100, 500, out, 8, count));
+    TEST_ASSERT_FALSE(image.lookup(8, 3, 100, 1, 1100, 500, out, 8, count));
+    TEST_ASSERT_FALSE(image.lookup(7, 3, 100, 4, 1100, 500, out, 2, count));
+
+    // A later poll of an overlapping range refreshes and extends it.
+    const uint16_t again[3] = {0xAAAA, 0xBBBB, 0xCCCC};
+    image.store(7, 3, 102, 3, again, 2000);
+    TEST_ASSERT_EQUAL_UINT(5, image.size());
+    TEST_ASSERT_TRUE(image.lookup(7, 3, 102, 3, 2100, 500, out, 8, count));
+    TEST_ASSERT_EQUAL_HEX16(0xCCCC, out[2]);
+    TEST_ASSERT_FALSE(image.lookup(7, 3, 100, 4, 2100, 500, out, 8, count));
+}
+
+// ---------------------------------------------------------------------------
+// Bits are stored one per item and repacked for the range asked for.
+// ---------------------------------------------------------------------------
+void test_bits_repack_from_any_offset(void) {
+    ModbusShadowImage image;
+    // Coils 0..19: 0b1010'0000'0000'0001'0110 from bit 0.
+    const uint16_t polled[2] = {0x0016, 0x000A};
+    image.store(1, 1, 0, 20, polled, 0);
+
+    uint16_t out[2] = {};
+    uint16_t count = 0;
+    TEST_ASSERT_TRUE(image.lookup(1, 1, 1, 3, 10, 100, out, 2, count));
+    TEST_ASSERT_EQUAL_UINT16(1, count);
+    TEST_ASSERT_EQUAL_HEX16(0x0003, out[0]);
+
+    TEST_ASSERT_TRUE(image.lookup(1, 1, 4, 16, 10, 100, out, 2, count));
+    TEST_ASSERT_EQUAL_UINT16(1, count);
+    TEST_ASSERT_EQUAL_HEX16(0xA001, out[0]);
+
+    TEST_ASSERT_FALSE(image.lookup(1, 2, 0, 1, 10, 100, out, 2, count));
+}
+
+// ---------------------------------------------------------------------------
+// A write forgets what it touched; the rest of the image stays usable.
+// ---------------------------------------------------------------------------
+void test_writes_invalidate(void) {
+    ModbusShadowImage image;
+    const uint16_t polled[3] = {1, 2, 3};
+    image.store(2, 3, 10, 3, polled, 0);
+    const uint16_t coils[1] = {0x0001};
+    image.store(2, 1, 10, 1, coils, 0);
+
+    image.invalidate(2, 6, 11, 1);
+    uint16_t out[3] = {};
+    uint16_t count = 0;
+    TEST_ASSERT_FALSE(image.lookup(2, 3, 10, 3, 1, 100, out, 3, count));
+    TEST_ASSERT_TRUE(image.lookup(2, 3, 12, 1, 1, 100, out, 3, count));
+    TEST_ASSERT_TRUE(image.lookup(2, 1, 10, 1, 1, 100, out, 3, count));
+
+    image.invalidate(2, 5, 10, 1);
+    TEST_ASSERT_FALSE(image.lookup(2, 1, 10, 1, 1, 100, out, 3, count));
+
+    image.store(2, 3, 11, 1, polled, 5);
+    TEST_ASSERT_TRUE(image.lookup(2, 3, 10, 3, 6, 100, out, 3, count));
+    TEST_ASSERT_EQUAL_UINT(4, image.size());
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_registers_answer_within_max_age);
+    RUN_TEST(test_bits_repack_from_any_offset);
+    RUN_TEST(test_writes_invalidate);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+// Native-host tests for the Modbus TCP client side: request encoding,
+// response decoding and the per-connection pipeline.
+//
+// Neither has Arduino dependencies, so the translation units are included
+// directly.
+
+#include "../../src/modbus/ModbusTcpAdu.cpp"
+#include "../../src/modbus/ModbusTcpPipeline.cpp"
+#include "../../src/modbus/ModbusReadPlanner.cpp"
+
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+ModbusTcpRequest poll(const uint16_t tid, const uint8_t function, const uint16_t address, const uint16_t count) {
+    ModbusTcpRequest request{};
+    request.transactionId = tid;
+    request.unitId = 3;
+    request.function = function;
+    request.address = address;
+    request.count = count;
+    return request;
+}
+
+} // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// What the client sends is what the server side decodes, and the server's
+// answer decodes back into the words the RTU master would have delivered.
+// ---------------------------------------------------------------------------
+void test_requests_and_responses_round_trip(void) {
+    uint8_t frame[ModbusTcpAdu::kMaxAduBytes];
+    const uint8_t read[] = {0x00, 0x2A, 0x00, 0x00, 0x00, 0x06, 0x03, 0x04, 0x00, 0x64, 0x00, 0x02};
+    TEST_ASSERT_EQUAL_UINT(sizeof(read), ModbusTcpAdu::encodeRequest(poll(42, 4, 100, 2), frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(read, frame, sizeof(read));
+
+    ModbusTcpRequest decoded{};
+    uint8_t code = 0;
+    size_t consumed = 0;
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(frame, sizeof(read), decoded, code, consumed) == ModbusTcpParse::Request);
+    TEST_ASSERT_EQUAL_UINT16(100, decoded.address);
+
+    const uint16_t registers[] = {0x1234, 0xFFFE};
+    const size_t length = ModbusTcpAdu::encodeResponse(decoded, 0, registers, 2, frame, sizeof(frame));
+    ModbusTcpResponse response{};
+    uint16_t words[ModbusReadPlanner::kMaxReadRegisters]{};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(frame, length, response, words, 125, consumed) ==
+                     ModbusTcpParse::Response);
+    TEST_ASSERT_EQUAL_UINT(length, consumed);
+    TEST_ASSERT_EQUAL_UINT16(42, response.transactionId);
+    TEST_ASSERT_EQUAL_UINT8(3, response.unitId);
+    TEST_ASSERT_EQUAL_UINT8(0, response.status);
+    TEST_ASSERT_EQUAL_UINT16(2, response.count);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, words[0]);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFE, words[1]);
+
+    // Eleven coils: 0x01 then 0x06 on the wire, packed low byte first.
+    const uint8_t coils[] = {0x00, 0x07, 0x00, 0x00, 0x00, 0x05, 0x03, 0x01, 0x02, 0x01, 0x06};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(coils, sizeof(coils), response, words, 125, consumed) ==
+                     ModbusTcpParse::Response);
+    TEST_ASSERT_EQUAL_UINT16(1, response.count);
+    TEST_ASSERT_EQUAL_HEX16(0x0601, words[0]);
+
+    ModbusTcpRequest write = poll(8, 16, 7, 1);
+    write.value = 0xABCD;
+    const uint8_t fc16[] = {0x00, 0x08, 0x00, 0x00, 0x00, 0x09, 0x03, 0x10, 0x00, 0x07, 0x00, 0x01, 0x02, 0xAB, 0xCD};
+    TEST_ASSERT_EQUAL_UINT(sizeof(fc16), ModbusTcpAdu::encodeRequest(write, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(fc16, frame, sizeof(fc16));
+}
+
+// ---------------------------------------------------------------------------
+// Exceptions become status codes; a frame that cannot be Modbus TCP asks for
+// the connection to be reset; a split answer waits.
+// ---------------------------------------------------------------------------
+void test_exceptions_and_framing(void) {
+    ModbusTcpResponse response{};
+    uint16_t words[4]{};
+    size_t consumed = 0;
+
+    const uint8_t illegal[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0x03, 0x83, 0x02};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(illegal, sizeof(illegal), response, words, 4, consumed) ==
+                     ModbusTcpParse::Response);
+    TEST_ASSERT_EQUAL_UINT8(3, response.function);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::IllegalDataAddress, response.status);
+
+    const uint8_t noTarget[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0x03, 0x83, 0x0B};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(noTarget, sizeof(noTarget), response, words, 4, consumed) ==
+                     ModbusTcpParse::Response);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::ResponseTimedOut, response.status);
+
+    const uint8_t split[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x07, 0x03, 0x03, 0x04, 0x00};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(split, sizeof(split), response, words, 4, consumed) ==
+                     ModbusTcpParse::Incomplete);
+
+    const uint8_t badCount[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x05, 0x03, 0x03, 0x04, 0x00, 0x01};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(badCount, sizeof(badCount), response, words, 4, consumed) ==
+                     ModbusTcpParse::Malformed);
+
+    const uint8_t http[] = {'H', 'T', 'T', 'P', '/', '1', '.', '1'};
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parseResponse(http, sizeof(http), response, words, 4, consumed) ==
+                     ModbusTcpParse::Malformed);
+}
+
+// ---------------------------------------------------------------------------
+// Several requests share a connection; answers match by transaction id in
+// any order, and overdue ones are handed back once.
+// ---------------------------------------------------------------------------
+void test_pipeline_matches_out_of_order(void) {
+    ModbusTcpPipeline pipeline;
+    uint16_t tids[ModbusTcpPipeline::kMaxOutstanding]{};
+    uint8_t slots[ModbusTcpPipeline::kMaxOutstanding]{};
+    for (uint8_t i = 0; i < ModbusTcpPipeline::kMaxOutstanding; ++i) {
+        slots[i] = pipeline.begin(1000 + i, 500, tids[i]);
+        TEST_ASSERT_TRUE(slots[i] != ModbusTcpPipeline::kNone);
+    }
+    uint16_t extra = 0;
+    TEST_ASSERT_TRUE(pipeline.full());
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpPipeline::kNone, pipeline.begin(1010, 500, extra));
+    TEST_ASSERT_TRUE(tids[0] != tids[1]);
+
+    TEST_ASSERT_EQUAL_UINT8(slots[2], pipeline.match(tids[2]));
+    pipeline.finish(slots[2]);
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpPipeline::kNone, pipeline.match(tids[2]));
+    TEST_ASSERT_EQUAL_UINT8(slots[0], pipeline.match(tids[0]));
+    pipeline.finish(slots[0]);
+    TEST_ASSERT_EQUAL_UINT(2, pipeline.outstanding());
+
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpPipeline::kNone, pipeline.takeExpired(1499));
+    TEST_ASSERT_EQUAL_UINT8(slots[1], pipeline.takeExpired(1501));
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpPipeline::kNone, pipeline.takeExpired(1501));
+    TEST_ASSERT_EQUAL_UINT8(slots[3], pipeline.takeAny());
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpPipeline::kNone, pipeline.takeAny());
+    TEST_ASSERT_EQUAL_UINT(0, pipeline.outstanding());
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_and_responses_round_trip);
+    RUN_TEST(test_exceptions_and_framing);
+    RUN_TEST(test_pipeline_matches_out_of_order);
+    return UNITY_END();
+}
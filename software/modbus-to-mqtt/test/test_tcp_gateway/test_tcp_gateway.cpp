@@ -0,0 +1,420 @@
+// Native-host tests for the Modbus TCP gateway: MBAP framing, single-flight
+// merging and transaction id fan-out, end to end through the RTU master
+// against a simulated slave.
+//
+// None of these have Arduino dependencies, so their translation units are
+// included directly.
+
+#include "../../src/modbus/ModbusTcpAdu.cpp"
+#include "../../src/modbus/ModbusTcpGateway.cpp"
+#include "../../src/modbus/ModbusRtuMaster.cpp"
+#include "../../src/modbus/ModbusBusTiming.cpp"
+#include "../../src/modbus/ModbusUnitRoutes.cpp"
+
+#include <deque>
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+// An RTU slave with 64 holding registers and 64 coils, answering over the
+// port the master transmits on. Stays silent while offline.
+class SimulatedSlave : public ModbusRtuPort {
+public:
+    int available() override { return static_cast<int>(rx.size()); }
+
+    int read() override {
+        if (rx.empty()) return -1;
+        const int b = rx.front();
+        rx.pop_front();
+        return b;
+    }
+
+    bool transmitDone() override { return true; }
+
+    void transmit(const uint8_t *frame, const size_t length) override {
+        ++transactions;
+        if (offline || length < 8 || frame[0] != slaveId) return;
+        const uint8_t fn = frame[1];
+        const uint16_t addr = static_cast<uint16_t>((frame[2] << 8) | frame[3]);
+        const uint16_t arg = static_cast<uint16_t>((frame[4] << 8) | frame[5]);
+        std::vector<uint8_t> out = {slaveId, fn};
+        auto readHolding = [&]() {
+            out.push_back(static_cast<uint8_t>(arg * 2));
+            for (uint16_t i = 0; i < arg; ++i) {
+                out.push_back(static_cast<uint8_t>(holding[addr + i] >> 8));
+                out.push_back(static_cast<uint8_t>(holding[addr + i] & 0xFF));
+            }
+        };
+        const uint16_t writeAddr = static_cast<uint16_t>((frame[6] << 8) | frame[7]);
+        const uint16_t writeCount = static_cast<uint16_t>((frame[8] << 8) | frame[9]);
+        if (fn == 3 && addr + arg <= 64) {
+            readHolding();
+        } else if (fn == 16 && addr + arg <= 64) {
+            for (uint16_t i = 0; i < arg; ++i) {
+                holding[addr + i] = static_cast<uint16_t>((frame[7 + 2 * i] << 8) | frame[8 + 2 * i]);
+            }
+            out.assign(frame, frame + 6);
+        } else if (fn == 15 && addr + arg <= 64) {
+            for (uint16_t i = 0; i < arg; ++i) {
+                coils[addr + i] = ((frame[7 + i / 8] >> (i % 8)) & 1) != 0;
+            }
+            out.assign(frame, frame + 6);
+        } else if (fn == 23 && addr + arg <= 64 && writeAddr + writeCount <= 64) {
+            for (uint16_t i = 0; i < writeCount; ++i) {
+                holding[writeAddr + i] = static_cast<uint16_t>((frame[11 + 2 * i] << 8) | frame[12 + 2 * i]);
+            }
+            readHolding();
+        } else if (fn == 1 && addr + arg <= 64) {
+            const uint8_t bytes = static_cast<uint8_t>((arg + 7) / 8);
+            out.push_back(bytes);
+            for (uint8_t b = 0; b < bytes; ++b) {
+                uint8_t packed = 0;
+                for (uint8_t bit = 0; bit < 8 && b * 8 + bit < arg; ++bit) {
+                    if (coils[addr + b * 8 + bit]) packed |= static_cast<uint8_t>(1U << bit);
+                }
+                out.push_back(packed);
+            }
+        } else if (fn == 6 && addr < 64) {
+            holding[addr] = arg;
+            out.assign(frame, frame + 6);
+        } else {
+            out = {slaveId, static_cast<uint8_t>(fn | 0x80), 0x02};
+        }
+        const uint16_t crc = ModbusRtuMaster::crc16(out.data(), out.size());
+        out.push_back(static_cast<uint8_t>(crc & 0xFF));
+        out.push_back(static_cast<uint8_t>(crc >> 8));
+        rx.insert(rx.end(), out.begin(), out.end());
+    }
+
+    uint8_t slaveId{7};
+    bool offline{false};
+    int transactions{0};
+    uint16_t holding[64]{};
+    bool coils[64]{};
+    std::deque<uint8_t> rx;
+};
+
+SimulatedSlave slave;
+ModbusRtuMaster master;
+ModbusTcpGateway gateway;
+uint32_t nowUs = 0;
+
+void finishFlight(void *context, const uint8_t status, const uint16_t *words, const uint16_t count) {
+    gateway.complete(*static_cast<uint8_t *>(context), status, words, count);
+}
+
+// Puts one flight on the simulated bus and runs the master until it is done.
+// Block writes pass the values unpacked while their ADU was still around.
+void runFlight(uint8_t flight, const uint16_t *values = nullptr) {
+    const ModbusTcpRequest &tcp = gateway.flightRequest(flight);
+    const uint16_t single[1] = {tcp.value};
+    const ModbusRtuRequest request{tcp.unitId, tcp.function, tcp.address, tcp.count, values ? values : single,
+                                   tcp.writeAddress, tcp.writeCount};
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, master.start(request, nowUs, finishFlight, &flight));
+    while (master.busy()) {
+        const uint32_t waitUs = master.poll(nowUs);
+        nowUs += waitUs == ModbusRtuMaster::kIdle ? 1000 : (waitUs < 1000 ? waitUs + 1 : 1000);
+    }
+}
+
+// A Modbus TCP client's request as it arrives on the socket.
+std::vector<uint8_t> adu(const uint16_t tid, const uint8_t unit, std::vector<uint8_t> pdu) {
+    std::vector<uint8_t> out = {static_cast<uint8_t>(tid >> 8), static_cast<uint8_t>(tid & 0xFF), 0, 0,
+                                0, static_cast<uint8_t>(pdu.size() + 1), unit};
+    out.insert(out.end(), pdu.begin(), pdu.end());
+    return out;
+}
+
+// Decodes an ADU the tests know to be valid; a refusal leaves function 0,
+// which the gateway assertions then trip over.
+ModbusTcpRequest parsed(const std::vector<uint8_t> &bytes) {
+    ModbusTcpRequest request{};
+    uint8_t code = 0;
+    size_t consumed = 0;
+    if (ModbusTcpAdu::parse(bytes.data(), bytes.size(), request, code, consumed) != ModbusTcpParse::Request) {
+        request.function = 0;
+    }
+    return request;
+}
+
+std::vector<uint8_t> response(const uint8_t client) {
+    uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+    const size_t length = gateway.takeResponse(client, out, sizeof(out));
+    return std::vector<uint8_t>(out, out + length);
+}
+
+} // namespace
+
+void setUp(void) {
+    slave = SimulatedSlave();
+    master = ModbusRtuMaster();
+    master.setPort(&slave);
+    master.setLineTiming(ModbusBusTiming::lineTiming(115200, "8N1"));
+    master.setResponseTimeoutUs(50000);
+    gateway = ModbusTcpGateway();
+    nowUs = 0;
+}
+
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// MBAP framing: partial input waits, garbage drops the connection, refused
+// PDUs are answered with an exception in the client's transaction.
+// ---------------------------------------------------------------------------
+void test_parse_frames_and_refusals(void) {
+    ModbusTcpRequest request{};
+    uint8_t code = 0;
+    size_t consumed = 0;
+
+    const std::vector<uint8_t> read = adu(0x1234, 7, {0x03, 0x00, 0x10, 0x00, 0x02});
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(read.data(), 9, request, code, consumed) == ModbusTcpParse::Incomplete);
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(read.data(), read.size(), request, code, consumed) ==
+                     ModbusTcpParse::Request);
+    TEST_ASSERT_EQUAL_UINT(read.size(), consumed);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, request.transactionId);
+    TEST_ASSERT_EQUAL_UINT8(7, request.unitId);
+    TEST_ASSERT_EQUAL_UINT16(0x10, request.address);
+    TEST_ASSERT_EQUAL_UINT16(2, request.count);
+
+    std::vector<uint8_t> wrongProtocol = read;
+    wrongProtocol[3] = 1;
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(wrongProtocol.data(), wrongProtocol.size(), request, code, consumed) ==
+                     ModbusTcpParse::Malformed);
+
+    const std::vector<uint8_t> diagnostics = adu(9, 7, {0x08, 0x00, 0x00, 0x00, 0x00});
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(diagnostics.data(), diagnostics.size(), request, code, consumed) ==
+                     ModbusTcpParse::Exception);
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpException::IllegalFunction, code);
+    TEST_ASSERT_EQUAL_UINT(diagnostics.size(), consumed);
+    uint8_t out[ModbusTcpAdu::kMaxAduBytes];
+    const uint8_t refused[] = {0x00, 0x09, 0x00, 0x00, 0x00, 0x03, 0x07, 0x88, 0x01};
+    TEST_ASSERT_EQUAL_UINT(sizeof(refused), ModbusTcpAdu::encodeException(request, code, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(refused, out, sizeof(refused));
+
+    const std::vector<uint8_t> badCoil = adu(10, 7, {0x05, 0x00, 0x01, 0x12, 0x34});
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(badCoil.data(), badCoil.size(), request, code, consumed) ==
+                     ModbusTcpParse::Exception);
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpException::IllegalDataValue, code);
+
+    const std::vector<uint8_t> tooMany = adu(11, 7, {0x03, 0x00, 0x00, 0x00, 0x7E});
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(tooMany.data(), tooMany.size(), request, code, consumed) ==
+                     ModbusTcpParse::Exception);
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpException::IllegalDataValue, code);
+}
+
+// ---------------------------------------------------------------------------
+// Two clients asking for the same registers share one bus transaction and
+// each get the answer under their own transaction id.
+// ---------------------------------------------------------------------------
+void test_identical_reads_share_one_transaction(void) {
+    slave.holding[16] = 0xBEEF;
+    slave.holding[17] = 0x0102;
+
+    uint8_t first = 0xFF;
+    uint8_t joined = 0xFF;
+    uint8_t other = 0xFF;
+    TEST_ASSERT_TRUE(gateway.admit(0, parsed(adu(0x0001, 7, {0x03, 0x00, 0x10, 0x00, 0x02})), first) ==
+                     ModbusTcpGateway::Admission::Submit);
+    TEST_ASSERT_TRUE(gateway.admit(1, parsed(adu(0x0777, 7, {0x03, 0x00, 0x10, 0x00, 0x02})), joined) ==
+                     ModbusTcpGateway::Admission::Joined);
+    TEST_ASSERT_EQUAL_UINT8(first, joined);
+    TEST_ASSERT_TRUE(gateway.admit(1, parsed(adu(0x0778, 7, {0x03, 0x00, 0x11, 0x00, 0x01})), other) ==
+                     ModbusTcpGateway::Admission::Submit);
+    TEST_ASSERT_TRUE(first != other);
+    TEST_ASSERT_EQUAL_UINT(0, response(0).size());
+
+    runFlight(first);
+    runFlight(other);
+    TEST_ASSERT_EQUAL_INT(2, slave.transactions);
+
+    const uint8_t toFirst[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x07, 0x07, 0x03, 0x04, 0xBE, 0xEF, 0x01, 0x02};
+    std::vector<uint8_t> answer = response(0);
+    TEST_ASSERT_EQUAL_UINT(sizeof(toFirst), answer.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(toFirst, answer.data(), sizeof(toFirst));
+    TEST_ASSERT_EQUAL_UINT(0, response(0).size());
+
+    answer = response(1);
+    TEST_ASSERT_EQUAL_UINT(sizeof(toFirst), answer.size());
+    TEST_ASSERT_EQUAL_HEX8(0x07, answer[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x77, answer[1]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(toFirst + 2, answer.data() + 2, sizeof(toFirst) - 2);
+    answer = response(1);
+    TEST_ASSERT_EQUAL_UINT(11, answer.size());
+    TEST_ASSERT_EQUAL_HEX8(0x78, answer[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, answer[9]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, answer[10]);
+    TEST_ASSERT_EQUAL_UINT(0, gateway.flightsInUse());
+
+    // Once answered, the same read goes back to the bus.
+    TEST_ASSERT_TRUE(gateway.admit(0, parsed(adu(0x0002, 7, {0x03, 0x00, 0x10, 0x00, 0x02})), first) ==
+                     ModbusTcpGateway::Admission::Submit);
+}
+
+// ---------------------------------------------------------------------------
+// Writes are never merged; coils come back in wire order.
+// ---------------------------------------------------------------------------
+void test_writes_and_coils_round_trip(void) {
+    uint8_t a = 0xFF;
+    uint8_t b = 0xFF;
+    TEST_ASSERT_TRUE(gateway.admit(0, parsed(adu(1, 7, {0x06, 0x00, 0x05, 0x12, 0x34})), a) ==
+                     ModbusTcpGateway::Admission::Submit);
+    TEST_ASSERT_TRUE(gateway.admit(1, parsed(adu(2, 7, {0x06, 0x00, 0x05, 0x12, 0x34})), b) ==
+                     ModbusTcpGateway::Admission::Submit);
+    runFlight(a);
+    runFlight(b);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, slave.holding[5]);
+    const uint8_t echoed[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x07, 0x06, 0x00, 0x05, 0x12, 0x34};
+    const std::vector<uint8_t> answer = response(0);
+    TEST_ASSERT_EQUAL_UINT(sizeof(echoed), answer.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(echoed, answer.data(), sizeof(echoed));
+    TEST_ASSERT_EQUAL_UINT(sizeof(echoed), response(1).size());
+
+    slave.coils[0] = true;
+    slave.coils[9] = true;
+    slave.coils[10] = true;
+    TEST_ASSERT_TRUE(gateway.admit(0, parsed(adu(3, 7, {0x01, 0x00, 0x00, 0x00, 0x0B})), a) ==
+                     ModbusTcpGateway::Admission::Submit);
+    runFlight(a);
+    const uint8_t bits[] = {0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x07, 0x01, 0x02, 0x01, 0x06};
+    const std::vector<uint8_t> coils = response(0);
+    TEST_ASSERT_EQUAL_UINT(sizeof(bits), coils.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(bits, coils.data(), sizeof(bits));
+}
+
+// ---------------------------------------------------------------------------
+// FC15/FC16 blocks reach the slave in one transaction and echo their
+// quantity; FC23 answers with the registers it read after writing.
+// ---------------------------------------------------------------------------
+void test_block_writes_and_read_write(void) {
+    uint8_t flight = 0xFF;
+    uint16_t values[32]{};
+
+    const std::vector<uint8_t> block = adu(1, 7, {0x10, 0x00, 0x08, 0x00, 0x02, 0x04, 0x12, 0x34, 0x56, 0x78});
+    const ModbusTcpRequest registers = parsed(block);
+    TEST_ASSERT_EQUAL_UINT16(0, ModbusTcpAdu::unpackValues(registers, values, 1));
+    TEST_ASSERT_EQUAL_UINT16(2, ModbusTcpAdu::unpackValues(registers, values, 32));
+    TEST_ASSERT_TRUE(gateway.admit(0, registers, flight) == ModbusTcpGateway::Admission::Submit);
+    runFlight(flight, values);
+    TEST_ASSERT_EQUAL_INT(1, slave.transactions);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, slave.holding[8]);
+    TEST_ASSERT_EQUAL_HEX16(0x5678, slave.holding[9]);
+    const uint8_t blockEcho[] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x07, 0x10, 0x00, 0x08, 0x00, 0x02};
+    std::vector<uint8_t> answer = response(0);
+    TEST_ASSERT_EQUAL_UINT(sizeof(blockEcho), answer.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(blockEcho, answer.data(), sizeof(blockEcho));
+
+    const std::vector<uint8_t> coilBlock = adu(2, 7, {0x0F, 0x00, 0x03, 0x00, 0x0A, 0x02, 0xCD, 0x01});
+    const ModbusTcpRequest coils = parsed(coilBlock);
+    TEST_ASSERT_EQUAL_UINT16(1, ModbusTcpAdu::unpackValues(coils, values, 32));
+    TEST_ASSERT_EQUAL_HEX16(0x01CD, values[0]);
+    TEST_ASSERT_TRUE(gateway.admit(0, coils, flight) == ModbusTcpGateway::Admission::Submit);
+    runFlight(flight, values);
+    TEST_ASSERT_TRUE(slave.coils[3]);
+    TEST_ASSERT_FALSE(slave.coils[4]);
+    TEST_ASSERT_TRUE(slave.coils[6]);
+    TEST_ASSERT_TRUE(slave.coils[11]);
+    TEST_ASSERT_FALSE(slave.coils[12]);
+    answer = response(0);
+    TEST_ASSERT_EQUAL_UINT(12, answer.size());
+    TEST_ASSERT_EQUAL_HEX8(0x0A, answer[11]);
+
+    const std::vector<uint8_t> readWrite =
+        adu(3, 7, {0x17, 0x00, 0x08, 0x00, 0x02, 0x00, 0x09, 0x00, 0x01, 0x02, 0xAB, 0xCD});
+    const ModbusTcpRequest rw = parsed(readWrite);
+    TEST_ASSERT_EQUAL_UINT16(1, ModbusTcpAdu::unpackValues(rw, values, 32));
+    TEST_ASSERT_TRUE(gateway.admit(0, rw, flight) == ModbusTcpGateway::Admission::Submit);
+    runFlight(flight, values);
+    const uint8_t readBack[] = {0x00, 0x03, 0x00, 0x00, 0x00, 0x07, 0x07, 0x17, 0x04, 0x12, 0x34, 0xAB, 0xCD};
+    answer = response(0);
+    TEST_ASSERT_EQUAL_UINT(sizeof(readBack), answer.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(readBack, answer.data(), sizeof(readBack));
+
+    ModbusTcpRequest request{};
+    uint8_t code = 0;
+    size_t consumed = 0;
+    const std::vector<uint8_t> shortBlock = adu(4, 7, {0x10, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x01});
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(shortBlock.data(), shortBlock.size(), request, code, consumed) ==
+                     ModbusTcpParse::Exception);
+    TEST_ASSERT_EQUAL_UINT8(ModbusTcpException::IllegalDataValue, code);
+    const std::vector<uint8_t> noWrite = adu(5, 7, {0x17, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00});
+    TEST_ASSERT_TRUE(ModbusTcpAdu::parse(noWrite.data(), noWrite.size(), request, code, consumed) ==
+                     ModbusTcpParse::Exception);
+}
+
+// ---------------------------------------------------------------------------
+// Bus failures become gateway exceptions, clients that vanish are forgotten
+// and a client cannot hog every slot.
+// ---------------------------------------------------------------------------
+void test_failures_disconnects_and_limits(void) {
+    slave.offline = true;
+    uint8_t flight = 0xFF;
+    TEST_ASSERT_TRUE(gateway.admit(0, parsed(adu(5, 7, {0x03, 0x00, 0x00, 0x00, 0x01})), flight) ==
+                     ModbusTcpGateway::Admission::Submit);
+    runFlight(flight);
+    const std::vector<uint8_t> failed = response(0);
+    TEST_ASSERT_EQUAL_UINT(9, failed.size());
+    TEST_ASSERT_EQUAL_HEX8(0x83, failed[7]);
+    TEST_ASSERT_EQUAL_HEX8(ModbusTcpException::GatewayTargetFailed, failed[8]);
+
+    slave.offline = false;
+    TEST_ASSERT_TRUE(gateway.admit(2, parsed(adu(6, 7, {0x03, 0x00, 0x02, 0x00, 0x01})), flight) ==
+                     ModbusTcpGateway::Admission::Submit);
+    gateway.dropClient(2);
+    TEST_ASSERT_EQUAL_UINT(1, gateway.flightsInUse());
+    runFlight(flight);
+    TEST_ASSERT_EQUAL_UINT(0, gateway.flightsInUse());
+    TEST_ASSERT_EQUAL_UINT(0, response(2).size());
+
+    for (uint16_t i = 0; i < ModbusTcpGateway::kMaxWaitersPerClient; ++i) {
+        TEST_ASSERT_TRUE(gateway.admit(3, parsed(adu(i, 7, {0x03, 0x00, static_cast<uint8_t>(i), 0x00, 0x01})),
+                                       flight) == ModbusTcpGateway::Admission::Submit);
+    }
+    TEST_ASSERT_TRUE(gateway.admit(3, parsed(adu(99, 7, {0x03, 0x00, 0x00, 0x00, 0x01})), flight) ==
+                     ModbusTcpGateway::Admission::Busy);
+    TEST_ASSERT_EQUAL_UINT(ModbusTcpGateway::kMaxWaitersPerClient, gateway.pendingFor(3));
+
+    gateway.complete(0, ModbusRtuStatus::Busy, nullptr, 0);
+    const std::vector<uint8_t> busy = response(3);
+    TEST_ASSERT_EQUAL_UINT(9, busy.size());
+    TEST_ASSERT_EQUAL_HEX8(ModbusTcpException::SlaveDeviceBusy, busy[8]);
+}
+
+// ---------------------------------------------------------------------------
+// Unit ids reach the bus and slave they were mapped to; unknown ones and a
+// second slave claiming a taken unit id find nothing.
+// ---------------------------------------------------------------------------
+void test_unit_routes(void) {
+    ModbusUnitRoutes routes;
+    TEST_ASSERT_TRUE(routes.add(5, 0, 5));
+    TEST_ASSERT_TRUE(routes.add(5, 0, 5));
+    TEST_ASSERT_FALSE(routes.add(5, 1, 5));
+    TEST_ASSERT_TRUE(routes.add(105, 1, 5));
+    TEST_ASSERT_FALSE(routes.add(0, 0, 1));
+    TEST_ASSERT_FALSE(routes.add(248, 0, 1));
+
+    ModbusUnitRoutes::Route route{};
+    TEST_ASSERT_TRUE(routes.find(5, route));
+    TEST_ASSERT_EQUAL_UINT8(0, route.bus);
+    TEST_ASSERT_EQUAL_UINT8(5, route.slaveId);
+    TEST_ASSERT_TRUE(routes.find(105, route));
+    TEST_ASSERT_EQUAL_UINT8(1, route.bus);
+    TEST_ASSERT_EQUAL_UINT8(5, route.slaveId);
+    TEST_ASSERT_FALSE(routes.find(6, route));
+    TEST_ASSERT_FALSE(routes.find(0, route));
+    TEST_ASSERT_FALSE(routes.find(255, route));
+
+    routes.clear();
+    TEST_ASSERT_FALSE(routes.find(5, route));
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_frames_and_refusals);
+    RUN_TEST(test_identical_reads_share_one_transaction);
+    RUN_TEST(test_writes_and_coils_round_trip);
+    RUN_TEST(test_block_writes_and_read_write);
+    RUN_TEST(test_failures_disconnects_and_limits);
+    RUN_TEST(test_unit_routes);
+    return UNITY_END();
+}
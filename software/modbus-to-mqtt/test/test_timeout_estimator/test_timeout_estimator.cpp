@@ -0,0 +1,109 @@
+// Native-host tests for ModbusTimeoutEstimator and the retry policy.
+//
+// Neither has Arduino dependencies, so the translation unit is included
+// directly.
+
+#include "../../src/modbus/ModbusTimeoutEstimator.cpp"
+#include "../../include/modbus/ModbusRetryPolicy.h"
+
+#include <unity.h>
+
+namespace {
+
+constexpr uint32_t kFloorUs = 5000;
+constexpr uint32_t kCeilingUs = 2000000;
+
+} // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Until it has seen enough answers a slave gets the ceiling; a steady 15 ms
+// meter then settles just above its turnaround.
+// ---------------------------------------------------------------------------
+void test_warmup_then_tracks_fast_slave(void) {
+    ModbusTimeoutEstimator fast;
+    for (uint16_t i = 0; i < ModbusTimeoutEstimator::kWarmupSamples - 1; ++i) {
+        fast.record(15000);
+        TEST_ASSERT_EQUAL_UINT32(kCeilingUs, fast.timeoutUs(kFloorUs, kCeilingUs));
+    }
+    fast.record(15000);
+    TEST_ASSERT_EQUAL_UINT32(15000, fast.smoothedUs());
+    TEST_ASSERT_EQUAL_UINT32(1000, fast.deviationUs());
+    TEST_ASSERT_EQUAL_UINT32(19000, fast.timeoutUs(kFloorUs, kCeilingUs));
+    TEST_ASSERT_EQUAL_UINT32(20000, fast.timeoutUs(20000, kCeilingUs));
+
+    ModbusTimeoutEstimator slow;
+    for (int i = 0; i < 20; ++i) {
+        slow.record(i % 2 ? 380000 : 420000);
+    }
+    TEST_ASSERT_TRUE(slow.timeoutUs(kFloorUs, kCeilingUs) > 420000);
+    TEST_ASSERT_TRUE(slow.timeoutUs(kFloorUs, kCeilingUs) < 1100000);
+    TEST_ASSERT_EQUAL_UINT32(500000, slow.timeoutUs(kFloorUs, 500000));
+}
+
+// ---------------------------------------------------------------------------
+// Rare slow answers stay covered by the percentile after the smoothed mean
+// has forgotten them.
+// ---------------------------------------------------------------------------
+void test_percentile_covers_rare_outliers(void) {
+    ModbusTimeoutEstimator meter;
+    for (int i = 0; i < 100; ++i) {
+        meter.record(15000);
+    }
+    meter.record(300000);
+    meter.record(300000);
+    for (int i = 0; i < 50; ++i) {
+        meter.record(15000);
+    }
+    TEST_ASSERT_TRUE(meter.smoothedUs() + 4U * meter.deviationUs() < 20000);
+    TEST_ASSERT_EQUAL_UINT32(16384, meter.percentileUs(500));
+    TEST_ASSERT_EQUAL_UINT32(524288, meter.percentileUs(990));
+    TEST_ASSERT_EQUAL_UINT32(524288, meter.timeoutUs(kFloorUs, kCeilingUs));
+
+    TEST_ASSERT_EQUAL_UINT(0, ModbusTimeoutEstimator::bucketOf(900));
+    TEST_ASSERT_EQUAL_UINT(1, ModbusTimeoutEstimator::bucketOf(1024));
+    TEST_ASSERT_EQUAL_UINT(ModbusTimeoutEstimator::kBuckets - 1, ModbusTimeoutEstimator::bucketOf(UINT32_MAX));
+}
+
+// ---------------------------------------------------------------------------
+// Timeouts double the next timeout up to a limit; an answer resets it.
+// ---------------------------------------------------------------------------
+void test_timeouts_back_off_until_answer(void) {
+    ModbusTimeoutEstimator meter;
+    for (uint16_t i = 0; i < ModbusTimeoutEstimator::kWarmupSamples; ++i) {
+        meter.record(15000);
+    }
+    meter.recordTimeout();
+    TEST_ASSERT_EQUAL_UINT32(38000, meter.timeoutUs(kFloorUs, kCeilingUs));
+    meter.recordTimeout();
+    TEST_ASSERT_EQUAL_UINT32(76000, meter.timeoutUs(kFloorUs, kCeilingUs));
+    for (int i = 0; i < 10; ++i) {
+        meter.recordTimeout();
+    }
+    TEST_ASSERT_EQUAL_UINT32(19000U << ModbusTimeoutEstimator::kMaxBackoffShift, meter.timeoutUs(kFloorUs, kCeilingUs));
+
+    meter.record(15000);
+    TEST_ASSERT_EQUAL_UINT32(15000 + 4 * 750, meter.timeoutUs(kFloorUs, kCeilingUs));
+}
+
+// ---------------------------------------------------------------------------
+// Only a first CRC failure is retried.
+// ---------------------------------------------------------------------------
+void test_retry_policy(void) {
+    TEST_ASSERT_TRUE(shouldRetryTransaction(ModbusRtuStatus::InvalidCrc, 0));
+    TEST_ASSERT_FALSE(shouldRetryTransaction(ModbusRtuStatus::InvalidCrc, 1));
+    TEST_ASSERT_FALSE(shouldRetryTransaction(ModbusRtuStatus::ResponseTimedOut, 0));
+    TEST_ASSERT_FALSE(shouldRetryTransaction(ModbusRtuStatus::IllegalDataAddress, 0));
+    TEST_ASSERT_FALSE(shouldRetryTransaction(ModbusRtuStatus::Success, 0));
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_warmup_then_tracks_fast_slave);
+    RUN_TEST(test_percentile_covers_rare_outliers);
+    RUN_TEST(test_timeouts_back_off_until_answer);
+    RUN_TEST(test_retry_policy);
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+// Native-host tests for ModbusValueDecoder.
+//
+// The decoder has no Arduino dependencies, so its translation unit is
+// included directly.
+
+#include "../../src/modbus/ModbusValueDecoder.cpp"
+
+#include <unity.h>
+
+namespace {
+
+double decode(const ModbusDataType type, const ModbusWordOrder order, const uint16_t *words,
+              const RegisterSlice slice = RegisterSlice::Full) {
+    const ModbusDecodeFn fn = ModbusValueDecoder::select(type, order, slice);
+    return fn ? fn(words) : -1.0;
+}
+
+}  // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// 12.5f is 0x41480000; each order lays the same bytes out differently.
+// ---------------------------------------------------------------------------
+void test_float32_in_all_word_orders(void) {
+    const uint16_t abcd[2] = {0x4148, 0x0000};
+    const uint16_t cdab[2] = {0x0000, 0x4148};
+    const uint16_t badc[2] = {0x4841, 0x0000};
+    const uint16_t dcba[2] = {0x0000, 0x4841};
+
+    TEST_ASSERT_EQUAL_DOUBLE(12.5, decode(FLOAT32, ModbusWordOrder::ABCD, abcd));
+    TEST_ASSERT_EQUAL_DOUBLE(12.5, decode(FLOAT32, ModbusWordOrder::CDAB, cdab));
+    TEST_ASSERT_EQUAL_DOUBLE(12.5, decode(FLOAT32, ModbusWordOrder::BADC, badc));
+    TEST_ASSERT_EQUAL_DOUBLE(12.5, decode(FLOAT32, ModbusWordOrder::DCBA, dcba));
+}
+
+// ---------------------------------------------------------------------------
+// 32-bit integers keep their sign and full range.
+// ---------------------------------------------------------------------------
+void test_int32_and_uint32(void) {
+    const uint16_t minusTwo[2] = {0xFFFF, 0xFFFE};
+    const uint16_t big[2] = {0x0000, 0x8765};  // CDAB for 0x87650000
+
+    TEST_ASSERT_EQUAL_DOUBLE(-2.0, decode(INT32, ModbusWordOrder::ABCD, minusTwo));
+    TEST_ASSERT_EQUAL_DOUBLE(4294967294.0, decode(UINT32, ModbusWordOrder::ABCD, minusTwo));
+    TEST_ASSERT_EQUAL_DOUBLE(2271543296.0, decode(UINT32, ModbusWordOrder::CDAB, big));
+}
+
+// ---------------------------------------------------------------------------
+// Four-register values assemble in one pass for every order.
+// ---------------------------------------------------------------------------
+void test_int64_and_uint64(void) {
+    const uint16_t abcd[4] = {0x0001, 0x0002, 0x0003, 0x0004};
+    const uint16_t cdab[4] = {0x0004, 0x0003, 0x0002, 0x0001};
+    const uint16_t dcba[4] = {0x0400, 0x0300, 0x0200, 0x0100};
+    const double expected = static_cast<double>(0x0001000200030004ULL);
+
+    TEST_ASSERT_EQUAL_DOUBLE(expected, decode(UINT64, ModbusWordOrder::ABCD, abcd));
+    TEST_ASSERT_EQUAL_DOUBLE(expected, decode(UINT64, ModbusWordOrder::CDAB, cdab));
+    TEST_ASSERT_EQUAL_DOUBLE(expected, decode(UINT64, ModbusWordOrder::DCBA, dcba));
+
+    const uint16_t minusOne[4] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF};
+    TEST_ASSERT_EQUAL_DOUBLE(-1.0, decode(INT64, ModbusWordOrder::BADC, minusOne));
+}
+
+// ---------------------------------------------------------------------------
+// 16-bit types: INT16 is signed, slices pick a byte after byte-order swap.
+// ---------------------------------------------------------------------------
+void test_16bit_types_and_slices(void) {
+    const uint16_t word[1] = {0xFF85};
+
+    TEST_ASSERT_EQUAL_DOUBLE(-123.0, decode(INT16, ModbusWordOrder::ABCD, word));
+    TEST_ASSERT_EQUAL_DOUBLE(65413.0, decode(UINT16, ModbusWordOrder::ABCD, word));
+    TEST_ASSERT_EQUAL_DOUBLE(0x85, decode(UINT16, ModbusWordOrder::ABCD, word, RegisterSlice::LowByte));
+    TEST_ASSERT_EQUAL_DOUBLE(0xFF, decode(INT16, ModbusWordOrder::ABCD, word, RegisterSlice::HighByte));
+    TEST_ASSERT_EQUAL_DOUBLE(0x85FF, decode(UINT16, ModbusWordOrder::BADC, word));
+}
+
+// ---------------------------------------------------------------------------
+// TEXT has no numeric decoder; widths and order names round-trip.
+// ---------------------------------------------------------------------------
+void test_text_widths_and_order_names(void) {
+    TEST_ASSERT_NULL(ModbusValueDecoder::select(TEXT, ModbusWordOrder::ABCD, RegisterSlice::Full));
+    TEST_ASSERT_EQUAL_UINT8(0, ModbusValueDecoder::registerCount(TEXT));
+    TEST_ASSERT_EQUAL_UINT8(1, ModbusValueDecoder::registerCount(INT16));
+    TEST_ASSERT_EQUAL_UINT8(2, ModbusValueDecoder::registerCount(FLOAT32));
+    TEST_ASSERT_EQUAL_UINT8(4, ModbusValueDecoder::registerCount(UINT64));
+
+    ModbusWordOrder order = ModbusWordOrder::ABCD;
+    TEST_ASSERT_TRUE(ModbusValueDecoder::parseWordOrder("cdab", order));
+    TEST_ASSERT_TRUE(order == ModbusWordOrder::CDAB);
+    TEST_ASSERT_EQUAL_STRING("CDAB", ModbusValueDecoder::wordOrderToString(order));
+    TEST_ASSERT_FALSE(ModbusValueDecoder::parseWordOrder("ABCDE", order));
+    TEST_ASSERT_FALSE(ModbusValueDecoder::parseWordOrder("big", order));
+    TEST_ASSERT_TRUE(order == ModbusWordOrder::CDAB);
+}
+
+// ---------------------------------------------------------------------------
+// encode() lays a value out exactly as decode reads it back, and clamps
+// integers to their type.
+// ---------------------------------------------------------------------------
+void test_encode_round_trips_every_order(void) {
+    const ModbusWordOrder orders[] = {ModbusWordOrder::ABCD, ModbusWordOrder::CDAB, ModbusWordOrder::BADC,
+                                      ModbusWordOrder::DCBA};
+    for (const ModbusWordOrder order: orders) {
+        uint16_t words[4]{};
+        TEST_ASSERT_EQUAL_UINT8(2, ModbusValueDecoder::encode(FLOAT32, order, 12.5, words));
+        TEST_ASSERT_EQUAL_DOUBLE(12.5, decode(FLOAT32, order, words));
+        ModbusValueDecoder::encode(INT32, order, -123456.0, words);
+        TEST_ASSERT_EQUAL_DOUBLE(-123456.0, decode(INT32, order, words));
+        TEST_ASSERT_EQUAL_UINT8(4, ModbusValueDecoder::encode(INT64, order, -5000000000.0, words));
+        TEST_ASSERT_EQUAL_DOUBLE(-5000000000.0, decode(INT64, order, words));
+        ModbusValueDecoder::encode(INT16, order, -2.4, words);
+        TEST_ASSERT_EQUAL_DOUBLE(-2.0, decode(INT16, order, words));
+    }
+
+    uint16_t cdab[2]{};
+    ModbusValueDecoder::encode(UINT32, ModbusWordOrder::CDAB, 2271543296.0, cdab);
+    TEST_ASSERT_EQUAL_HEX16(0x0000, cdab[0]);
+    TEST_ASSERT_EQUAL_HEX16(0x8765, cdab[1]);
+
+    uint16_t words[4]{};
+    ModbusValueDecoder::encode(UINT16, ModbusWordOrder::ABCD, 70000.0, words);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, words[0]);
+    ModbusValueDecoder::encode(UINT16, ModbusWordOrder::ABCD, -3.0, words);
+    TEST_ASSERT_EQUAL_HEX16(0x0000, words[0]);
+    ModbusValueDecoder::encode(INT64, ModbusWordOrder::ABCD, 1e30, words);
+    TEST_ASSERT_EQUAL_HEX16(0x7FFF, words[0]);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, words[3]);
+    TEST_ASSERT_EQUAL_UINT8(0, ModbusValueDecoder::encode(TEXT, ModbusWordOrder::ABCD, 1.0, words));
+}
+
+// ---------------------------------------------------------------------------
+// Payloads read as before: two decimals, exponent notation for huge values,
+// and text with its NUL padding dropped, cut to the buffer.
+// ---------------------------------------------------------------------------
+void test_format_value_and_text(void) {
+    char out[ModbusValueDecoder::kValueChars];
+    TEST_ASSERT_EQUAL_UINT(5, ModbusValueDecoder::formatValue(21.5, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("21.50", out);
+    ModbusValueDecoder::formatValue(-1234567.891, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("-1234567.89", out);
+    ModbusValueDecoder::formatValue(-1.8446744073709552e19, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("-1.84467e+19", out);
+    ModbusValueDecoder::formatValue(-999999999999999.0, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("-999999999999999.00", out);
+
+    const uint16_t words[] = {0x4142, 0x0043, 0x4400, 0x0000};
+    TEST_ASSERT_EQUAL_UINT(4, ModbusValueDecoder::formatText(words, 4, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("ABCD", out);
+    char small[3];
+    TEST_ASSERT_EQUAL_UINT(2, ModbusValueDecoder::formatText(words, 4, small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("AB", small);
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_float32_in_all_word_orders);
+    RUN_TEST(test_int32_and_uint32);
+    RUN_TEST(test_int64_and_uint64);
+    RUN_TEST(test_16bit_types_and_slices);
+    RUN_TEST(test_text_widths_and_order_names);
+    RUN_TEST(test_encode_round_trips_every_order);
+    RUN_TEST(test_format_value_and_text);
+    return UNITY_END();
+}
@@ -0,0 +1,183 @@
+// Native-host tests for ModbusWriteCombiner.
+//
+// The combiner has no Arduino dependencies, so its translation unit is
+// included directly.
+
+#include "../../src/modbus/ModbusWriteCombiner.cpp"
+
+#include <unity.h>
+
+namespace {
+
+ModbusCommand single(const uint16_t address, const uint16_t value, const uint32_t submittedAtMs = 0,
+                     const uint8_t slaveId = 1) {
+    ModbusCommand c{};
+    c.bus = 0;
+    c.slaveId = slaveId;
+    c.function = 6;
+    c.address = address;
+    c.count = 1;
+    c.values[0] = value;
+    c.submittedAtMs = submittedAtMs;
+    return c;
+}
+
+ModbusCommand block(const uint16_t address, const uint16_t count, const uint16_t firstValue) {
+    ModbusCommand c{};
+    c.slaveId = 1;
+    c.function = 16;
+    c.address = address;
+    c.count = count;
+    for (uint16_t i = 0; i < count; ++i) {
+        c.values[i] = static_cast<uint16_t>(firstValue + i);
+    }
+    return c;
+}
+
+} // namespace
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// A slider burst to one register collapses to its last value; every
+// original write is finished by the one transaction.
+// ---------------------------------------------------------------------------
+void test_repeated_writes_collapse_to_last_value(void) {
+    ModbusWriteCombiner combiner;
+    TEST_ASSERT_TRUE(combiner.hold(single(100, 1, 1000), 1000, 50));
+    TEST_ASSERT_TRUE(combiner.hold(single(100, 2, 1010), 1010, 50));
+    TEST_ASSERT_TRUE(combiner.hold(single(100, 3, 1020), 1020, 50));
+    TEST_ASSERT_EQUAL_UINT(3, combiner.heldCount());
+
+    ModbusCommand out{};
+    TEST_ASSERT_FALSE(combiner.takeDue(1049, out));
+    TEST_ASSERT_TRUE(combiner.takeDue(1050, out));
+    TEST_ASSERT_EQUAL_UINT8(6, out.function);
+    TEST_ASSERT_EQUAL_UINT16(100, out.address);
+    TEST_ASSERT_EQUAL_UINT16(1, out.count);
+    TEST_ASSERT_EQUAL_UINT16(3, out.values[0]);
+    TEST_ASSERT_EQUAL_UINT32(1000, out.submittedAtMs);
+    TEST_ASSERT_FALSE(combiner.takeDue(1050, out));
+
+    ModbusWriteCombiner::Finished finished[ModbusWriteCombiner::kMaxHeld];
+    TEST_ASSERT_EQUAL_UINT(3, combiner.complete(ModbusRtuStatus::Success, finished));
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, finished[0].status);
+    TEST_ASSERT_EQUAL_UINT(0, combiner.heldCount());
+}
+
+// ---------------------------------------------------------------------------
+// Adjacent single and block writes go out as one FC16 in address order; a
+// gap starts another transaction.
+// ---------------------------------------------------------------------------
+void test_adjacent_writes_merge_into_one_block(void) {
+    ModbusWriteCombiner combiner;
+    TEST_ASSERT_TRUE(combiner.hold(single(12, 120), 0, 20));
+    TEST_ASSERT_TRUE(combiner.hold(single(10, 100), 5, 20));
+    TEST_ASSERT_TRUE(combiner.hold(block(13, 2, 130), 6, 20));
+    TEST_ASSERT_TRUE(combiner.hold(single(11, 110), 7, 20));
+    TEST_ASSERT_TRUE(combiner.hold(single(40, 400), 8, 20));
+
+    ModbusCommand out{};
+    TEST_ASSERT_TRUE(combiner.takeDue(20, out));
+    TEST_ASSERT_EQUAL_UINT8(16, out.function);
+    TEST_ASSERT_EQUAL_UINT16(10, out.address);
+    TEST_ASSERT_EQUAL_UINT16(5, out.count);
+    const uint16_t expected[] = {100, 110, 120, 130, 131};
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, out.values, 5);
+
+    ModbusWriteCombiner::Finished finished[ModbusWriteCombiner::kMaxHeld];
+    TEST_ASSERT_EQUAL_UINT(4, combiner.complete(ModbusRtuStatus::Success, finished));
+
+    TEST_ASSERT_TRUE(combiner.takeDue(20, out));
+    TEST_ASSERT_EQUAL_UINT8(6, out.function);
+    TEST_ASSERT_EQUAL_UINT16(40, out.address);
+    TEST_ASSERT_EQUAL_UINT(1, combiner.complete(ModbusRtuStatus::Success, finished));
+    TEST_ASSERT_EQUAL_UINT16(40, finished[0].command.address);
+}
+
+// ---------------------------------------------------------------------------
+// The window opens at a slave's first held write and is per slave;
+// expedite() closes it early.
+// ---------------------------------------------------------------------------
+void test_window_is_per_slave_and_can_be_expedited(void) {
+    ModbusWriteCombiner combiner;
+    TEST_ASSERT_EQUAL_UINT32(ModbusWriteCombiner::kNothingHeld, combiner.msUntilDue(0));
+
+    TEST_ASSERT_TRUE(combiner.hold(single(1, 1, 0, 1), 0, 100));
+    TEST_ASSERT_TRUE(combiner.hold(single(2, 2, 90, 1), 90, 100));
+    TEST_ASSERT_TRUE(combiner.hold(single(1, 1, 30, 2), 30, 100));
+    TEST_ASSERT_EQUAL_UINT32(10, combiner.msUntilDue(90));
+
+    combiner.expedite(2, 40);
+    TEST_ASSERT_EQUAL_UINT32(0, combiner.msUntilDue(40));
+    ModbusCommand out{};
+    TEST_ASSERT_TRUE(combiner.takeDue(40, out));
+    TEST_ASSERT_EQUAL_UINT8(2, out.slaveId);
+    ModbusWriteCombiner::Finished finished[ModbusWriteCombiner::kMaxHeld];
+    TEST_ASSERT_EQUAL_UINT(1, combiner.complete(ModbusRtuStatus::Success, finished));
+
+    TEST_ASSERT_FALSE(combiner.takeDue(99, out));
+    TEST_ASSERT_TRUE(combiner.takeDue(100, out));
+    TEST_ASSERT_EQUAL_UINT8(1, out.slaveId);
+    TEST_ASSERT_EQUAL_UINT16(2, out.count);
+}
+
+// ---------------------------------------------------------------------------
+// A failed transaction fails every write it carried, including one that was
+// split across two transactions.
+// ---------------------------------------------------------------------------
+void test_failure_reaches_every_original(void) {
+    ModbusWriteCombiner combiner;
+    TEST_ASSERT_TRUE(combiner.hold(block(0, 32, 0), 0, 10));
+    TEST_ASSERT_TRUE(combiner.hold(single(32, 7), 0, 10));
+    TEST_ASSERT_TRUE(combiner.hold(block(20, 2, 9), 0, 10));
+
+    ModbusCommand out{};
+    ModbusWriteCombiner::Finished finished[ModbusWriteCombiner::kMaxHeld];
+    TEST_ASSERT_TRUE(combiner.takeDue(10, out));
+    TEST_ASSERT_EQUAL_UINT16(ModbusCommand::kMaxValues, out.count);
+    TEST_ASSERT_EQUAL_UINT16(9, out.values[20]);
+    TEST_ASSERT_EQUAL_UINT(2, combiner.complete(ModbusRtuStatus::ResponseTimedOut, finished));
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::ResponseTimedOut, finished[0].status);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::ResponseTimedOut, finished[1].status);
+
+    TEST_ASSERT_TRUE(combiner.takeDue(10, out));
+    TEST_ASSERT_EQUAL_UINT16(32, out.address);
+    TEST_ASSERT_EQUAL_UINT(1, combiner.complete(ModbusRtuStatus::Success, finished));
+    TEST_ASSERT_EQUAL_UINT16(32, finished[0].command.address);
+    TEST_ASSERT_EQUAL_UINT8(ModbusRtuStatus::Success, finished[0].status);
+}
+
+// ---------------------------------------------------------------------------
+// Only FC06/FC16 are held, and only while there is room.
+// ---------------------------------------------------------------------------
+void test_hold_refuses_when_full_or_not_combinable(void) {
+    ModbusWriteCombiner combiner;
+    ModbusCommand coil = single(0, 1);
+    coil.function = 5;
+    TEST_ASSERT_FALSE(combiner.hold(coil, 0, 10));
+    TEST_ASSERT_FALSE(combiner.hold(single(0, 1), 0, 0));
+
+    for (uint16_t i = 0; i < ModbusWriteCombiner::kMaxHeld; ++i) {
+        TEST_ASSERT_TRUE(combiner.hold(single(i, i), 0, 10));
+    }
+    TEST_ASSERT_FALSE(combiner.hold(single(0, 9), 0, 10));
+    TEST_ASSERT_EQUAL_UINT(ModbusWriteCombiner::kMaxHeld, combiner.heldCount());
+
+    ModbusWriteCombiner registers;
+    TEST_ASSERT_TRUE(registers.hold(block(0, 32, 0), 0, 10));
+    TEST_ASSERT_TRUE(registers.hold(block(100, 32, 0), 0, 10));
+    TEST_ASSERT_FALSE(registers.hold(single(200, 1), 0, 10));
+    TEST_ASSERT_TRUE(registers.hold(single(5, 1), 0, 10));
+}
+
+int main(int /*argc*/, char ** /*argv*/) {
+    UNITY_BEGIN();
+    RUN_TEST(test_repeated_writes_collapse_to_last_value);
+    RUN_TEST(test_adjacent_writes_merge_into_one_block);
+    RUN_TEST(test_window_is_per_slave_and_can_be_expedited);
+    RUN_TEST(test_failure_reaches_every_original);
+    RUN_TEST(test_hold_refuses_when_full_or_not_combinable);
+    return UNITY_END();
+}